@@ -0,0 +1,166 @@
+//***************************************************************************************
+// CascadedShadows.cpp
+//***************************************************************************************
+
+#include "CascadedShadows.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+void ComputeCascadeSplits(float nearZ, float farZ, uint32_t count, float lambda, float* splits)
+{
+    assert(count > 0 && nearZ > 0.0f && farZ > nearZ);
+
+    splits[0] = nearZ;
+    for(uint32_t i = 1; i < count; ++i)
+    {
+        float p = (float)i / (float)count;
+        float logSplit = nearZ * std::pow(farZ / nearZ, p);
+        float uniformSplit = nearZ + (farZ - nearZ) * p;
+        splits[i] = lambda * logSplit + (1.0f - lambda) * uniformSplit;
+    }
+    splits[count] = farZ;
+}
+
+namespace
+{
+    // Light view with the eye at the world origin.  It only depends on the light
+    // direction, so texel snapping in this space is independent of the camera.
+    XMMATRIX BuildLightView(const XMFLOAT3& lightDir)
+    {
+        XMVECTOR dir = XMVector3Normalize(XMLoadFloat3(&lightDir));
+
+        // Any up vector works as long as it is not parallel to the light.
+        XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+        if(std::fabs(XMVectorGetY(dir)) > 0.99f)
+            up = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+
+        return XMMatrixLookToLH(XMVectorZero(), dir, up);
+    }
+
+    // World-space bounding sphere of the camera frustum between two view depths.
+    BoundingSphere FitFrustumSlice(const CascadeCameraDesc& camera, XMMATRIX invView,
+        float sliceNear, float sliceFar)
+    {
+        float tanHalfFovY = std::tan(0.5f * camera.FovY);
+        float tanHalfFovX = tanHalfFovY * camera.Aspect;
+
+        XMVECTOR corners[8];
+        const float depths[2] = { sliceNear, sliceFar };
+        for(int d = 0; d < 2; ++d)
+        {
+            float y = depths[d] * tanHalfFovY;
+            float x = depths[d] * tanHalfFovX;
+            corners[d*4 + 0] = XMVectorSet(-x, -y, depths[d], 1.0f);
+            corners[d*4 + 1] = XMVectorSet(+x, -y, depths[d], 1.0f);
+            corners[d*4 + 2] = XMVectorSet(-x, +y, depths[d], 1.0f);
+            corners[d*4 + 3] = XMVectorSet(+x, +y, depths[d], 1.0f);
+        }
+
+        XMVECTOR center = XMVectorZero();
+        for(int i = 0; i < 8; ++i)
+        {
+            corners[i] = XMVector3TransformCoord(corners[i], invView);
+            center += corners[i];
+        }
+        center /= 8.0f;
+
+        float radius = 0.0f;
+        for(int i = 0; i < 8; ++i)
+            radius = std::max(radius, XMVectorGetX(XMVector3Length(corners[i] - center)));
+
+        // The corners move rigidly with the camera, so this radius only changes with the
+        // projection.  Round it so float noise cannot change the texel size either.
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        BoundingSphere sphere;
+        XMStoreFloat3(&sphere.Center, center);
+        sphere.Radius = radius;
+        return sphere;
+    }
+
+    // Fills in everything that follows from LightView, LightCenterLS, the receiver
+    // radius and the depth range.
+    void BuildCascadeProjection(ShadowCascade& cascade, float n, float f)
+    {
+        XMMATRIX lightView = XMLoadFloat4x4(&cascade.LightView);
+        XMMATRIX invLightView = XMMatrixTranspose(lightView);
+        float cx = cascade.LightCenterLS.x;
+        float cy = cascade.LightCenterLS.y;
+        float radius = cascade.ReceiverBounds.Radius;
+
+        XMMATRIX lightProj = XMMatrixOrthographicOffCenterLH(
+            cx - radius, cx + radius,
+            cy - radius, cy + radius,
+            n, f);
+
+        // Transform NDC space [-1,+1]^2 to texture space [0,1]^2
+        XMMATRIX T(
+            0.5f, 0.0f, 0.0f, 0.0f,
+            0.0f, -0.5f, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.5f, 0.5f, 0.0f, 1.0f);
+
+        XMStoreFloat4x4(&cascade.LightProj, lightProj);
+        XMStoreFloat4x4(&cascade.ShadowTransform, lightView * lightProj * T);
+        cascade.LightNearZ = n;
+        cascade.LightFarZ = f;
+
+        XMVECTOR eyeLS = XMVectorSet(cx, cy, n, 1.0f);
+        XMStoreFloat3(&cascade.LightPosW, XMVector3TransformCoord(eyeLS, invLightView));
+    }
+}
+
+void ComputeShadowCascades(
+    const CascadeCameraDesc& camera,
+    const XMFLOAT3& lightDir,
+    const BoundingSphere& sceneBounds,
+    const CascadeSettings& settings,
+    ShadowCascade* cascades)
+{
+    assert(settings.CascadeCount > 0 && settings.CascadeCount <= MaxShadowCascades);
+
+    float shadowFar = std::min(camera.FarZ, settings.MaxShadowDistance);
+
+    float splits[MaxShadowCascades + 1];
+    ComputeCascadeSplits(camera.NearZ, shadowFar, settings.CascadeCount, settings.SplitLambda, splits);
+
+    XMMATRIX invView = XMLoadFloat4x4(&camera.InvView);
+    XMMATRIX lightView = BuildLightView(lightDir);
+
+    XMFLOAT3 sceneCenterLS;
+    XMStoreFloat3(&sceneCenterLS, XMVector3TransformCoord(XMLoadFloat3(&sceneBounds.Center), lightView));
+
+    for(uint32_t i = 0; i < settings.CascadeCount; ++i)
+    {
+        ShadowCascade& cascade = cascades[i];
+        cascade.SplitNear = splits[i];
+        cascade.SplitFar = splits[i + 1];
+        cascade.ReceiverBounds = FitFrustumSlice(camera, invView, cascade.SplitNear, cascade.SplitFar);
+
+        float radius = cascade.ReceiverBounds.Radius;
+        XMFLOAT3 centerLS;
+        XMStoreFloat3(&centerLS, XMVector3TransformCoord(XMLoadFloat3(&cascade.ReceiverBounds.Center), lightView));
+
+        // Snap the center to the texel grid so the projection only moves in whole texels.
+        float texelSize = 2.0f * radius / (float)settings.Resolution;
+        centerLS.x = std::floor(centerLS.x / texelSize) * texelSize;
+        centerLS.y = std::floor(centerLS.y / texelSize) * texelSize;
+
+        float n = std::min(centerLS.z - radius, sceneCenterLS.z - sceneBounds.Radius);
+        float f = centerLS.z + radius;
+
+        XMStoreFloat4x4(&cascade.LightView, lightView);
+        cascade.LightCenterLS = XMFLOAT2(centerLS.x, centerLS.y);
+        BuildCascadeProjection(cascade, n, f);
+    }
+}
+
+void SetCascadeDepthRange(ShadowCascade& cascade, float nearZ, float farZ)
+{
+    assert(farZ > nearZ);
+    BuildCascadeProjection(cascade, nearZ, farZ);
+}
@@ -0,0 +1,91 @@
+//***************************************************************************************
+// CascadedShadows.h
+//
+// CPU side of cascaded shadow maps for a single directional light.
+//   -The camera frustum is split along view depth with the "practical" scheme: a blend
+//    of logarithmic and uniform splits controlled by SplitLambda.
+//   -Each cascade is fitted with a bounding sphere of its frustum slice.  The sphere
+//    radius does not change when the camera rotates and the light-space center is
+//    snapped to whole shadow map texels, so shadow edges do not shimmer as the
+//    camera moves.
+//   -The light projection is pulled back toward the light to the scene bounds, so
+//    casters outside the slice still land in the depth range.
+//
+// Only DirectXMath/DirectXCollision are used; nothing here touches D3D12.
+//***************************************************************************************
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+
+static const uint32_t MaxShadowCascades = 4;
+
+struct CascadeSettings
+{
+    uint32_t CascadeCount = MaxShadowCascades;
+
+    // 0 = uniform splits, 1 = logarithmic splits.
+    float SplitLambda = 0.75f;
+
+    // Shadows end at min(camera far plane, MaxShadowDistance).
+    float MaxShadowDistance = 150.0f;
+
+    // Edge length, in texels, of the shadow map region each cascade renders into.
+    uint32_t Resolution = 1024;
+};
+
+// What the cascade fit needs to know about the camera.
+struct CascadeCameraDesc
+{
+    // View to world transform (the inverse view matrix).
+    DirectX::XMFLOAT4X4 InvView;
+
+    float FovY = 0.0f;
+    float Aspect = 0.0f;
+    float NearZ = 0.0f;
+    float FarZ = 0.0f;
+};
+
+struct ShadowCascade
+{
+    // View-space depth range of the camera covered by this cascade.
+    float SplitNear = 0.0f;
+    float SplitFar = 0.0f;
+
+    DirectX::XMFLOAT4X4 LightView;
+    DirectX::XMFLOAT4X4 LightProj;
+
+    // World space to [0,1]^2 texture space of this cascade, with depth in z.
+    DirectX::XMFLOAT4X4 ShadowTransform;
+
+    // Light-space depth range of LightProj.
+    float LightNearZ = 0.0f;
+    float LightFarZ = 0.0f;
+
+    // Light-space x/y center of LightProj, snapped to the texel grid.  The projection
+    // spans ReceiverBounds.Radius around it.
+    DirectX::XMFLOAT2 LightCenterLS;
+
+    // Point on the near plane of LightProj, used as the "eye" of the shadow pass.
+    DirectX::XMFLOAT3 LightPosW;
+
+    // World-space bounding sphere of the frustum slice (the receivers).
+    DirectX::BoundingSphere ReceiverBounds;
+};
+
+// Writes count+1 view depths: splits[0] = nearZ, splits[count] = farZ.
+void ComputeCascadeSplits(float nearZ, float farZ, uint32_t count, float lambda, float* splits);
+
+// Fills cascades[0..settings.CascadeCount).  lightDir is the direction the light travels.
+void ComputeShadowCascades(
+    const CascadeCameraDesc& camera,
+    const DirectX::XMFLOAT3& lightDir,
+    const DirectX::BoundingSphere& sceneBounds,
+    const CascadeSettings& settings,
+    ShadowCascade* cascades);
+
+// Rebuilds the cascade's projection for a new light-space depth range, keeping its
+// footprint.  LightProj, ShadowTransform and LightPosW are updated.
+void SetCascadeDepthRange(ShadowCascade& cascade, float nearZ, float farZ);
@@ -1,16 +1,14 @@
 #include "FrameResource.h"
 
-FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT skinnedObjectCount, UINT materialCount)
+FrameResource::FrameResource(ID3D12Device* device, UINT64 uploadBytes, size_t transientBytes)
 {
     ThrowIfFailed(device->CreateCommandAllocator(
         D3D12_COMMAND_LIST_TYPE_DIRECT,
 		IID_PPV_ARGS(CmdListAlloc.GetAddressOf())));
 
-    PassCB = std::make_unique<UploadBuffer<PassConstants>>(device, passCount, true);
-    SsaoCB = std::make_unique<UploadBuffer<SsaoConstants>>(device, 1, true);
-	MaterialBuffer = std::make_unique<UploadBuffer<MaterialData>>(device, materialCount, false);
-    ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, true);
-    SkinnedCB = std::make_unique<UploadBuffer<SkinnedConstants>>(device, skinnedObjectCount, true);
+    Uploads = std::make_unique<UploadRing>(std::make_unique<UploadHeapRingBacking>(device, uploadBytes));
+
+    FrameAlloc = std::make_unique<LinearAllocator>(transientBytes);
 }
 
 FrameResource::~FrameResource()
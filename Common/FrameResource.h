@@ -3,6 +3,8 @@
 #include "d3dUtil.h"
 #include "MathHelper.h"
 #include "UploadBuffer.h"
+#include "LinearAllocator.h"
+#include "CascadedShadows.h"
 
 struct ObjectConstants
 {
@@ -28,7 +30,6 @@ struct PassConstants
     DirectX::XMFLOAT4X4 ViewProj = MathHelper::Identity4x4();
     DirectX::XMFLOAT4X4 InvViewProj = MathHelper::Identity4x4();
     DirectX::XMFLOAT4X4 ViewProjTex = MathHelper::Identity4x4();
-    DirectX::XMFLOAT4X4 ShadowTransform = MathHelper::Identity4x4();
     DirectX::XMFLOAT3 EyePosW = { 0.0f, 0.0f, 0.0f };
     float cbPerObjectPad1 = 0.0f;
     DirectX::XMFLOAT2 RenderTargetSize = { 0.0f, 0.0f };
@@ -45,6 +46,16 @@ struct PassConstants
     // indices [NUM_DIR_LIGHTS+NUM_POINT_LIGHTS, NUM_DIR_LIGHTS+NUM_POINT_LIGHT+NUM_SPOT_LIGHTS)
     // are spot lights for a maximum of MaxLights per object.
     Light Lights[MaxLights];
+
+    // World to shadow map atlas texture space, one per cascade.
+    DirectX::XMFLOAT4X4 CascadeShadowTransforms[MaxShadowCascades];
+
+    // View-space depth where each cascade ends.
+    DirectX::XMFLOAT4 CascadeSplits = { 0.0f, 0.0f, 0.0f, 0.0f };
+    UINT CascadeCount = 0;
+    UINT CascadePad0 = 0;
+    UINT CascadePad1 = 0;
+    UINT CascadePad2 = 0;
 };
 
 struct SsaoConstants
@@ -105,7 +116,7 @@ struct FrameResource
 {
 public:
     
-    FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT skinnedObjectCount, UINT materialCount);
+    FrameResource(ID3D12Device* device, UINT64 uploadBytes = 4 << 20, size_t transientBytes = 1 << 20);
     FrameResource(const FrameResource& rhs) = delete;
     FrameResource& operator=(const FrameResource& rhs) = delete;
     ~FrameResource();
@@ -115,12 +126,30 @@ public:
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdListAlloc;
 
     // We cannot update a cbuffer until the GPU is done processing the commands
-    // that reference it.  So each frame needs their own cbuffers.
-    std::unique_ptr<UploadBuffer<PassConstants>> PassCB = nullptr;
-    std::unique_ptr<UploadBuffer<ObjectConstants>> ObjectCB = nullptr;
-    std::unique_ptr<UploadBuffer<SkinnedConstants>> SkinnedCB = nullptr;
-    std::unique_ptr<UploadBuffer<SsaoConstants>> SsaoCB = nullptr;
-	std::unique_ptr<UploadBuffer<MaterialData>> MaterialBuffer = nullptr;
+    // that reference it.  So each frame needs their own cbuffers.  They are all
+    // suballocated from this ring, so object counts may change from frame to frame.
+    std::unique_ptr<UploadRing> Uploads = nullptr;
+
+    // Where this frame's constants landed in Uploads.  Arrays are indexed the
+    // same way the fixed buffers were: ObjectCB by ObjCBIndex, SkinnedCB by
+    // SkinnedCBIndex, MaterialBuffer by MatCBIndex.  ShadowPassCB holds one pass
+    // per shadow cascade, CalcConstantBufferByteSize(sizeof(PassConstants)) apart.
+    D3D12_GPU_VIRTUAL_ADDRESS PassCB = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS ShadowPassCB = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS ObjectCB = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS SkinnedCB = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS SsaoCB = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS MaterialBuffer = 0;
+
+    // Clustered lighting data: a ClusterRange per cluster, the light index list it
+    // points into, and the local lights themselves.  0 when there is nothing to upload.
+    D3D12_GPU_VIRTUAL_ADDRESS LightClusterRanges = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS LightClusterIndices = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS LocalLights = 0;
+
+    // Scratch memory for CPU work done while building this frame.  Reset once
+    // the fence below has been reached, like CmdListAlloc.
+    std::unique_ptr<LinearAllocator> FrameAlloc = nullptr;
 
     // Fence value to mark commands up to this fence point.  This lets us
     // check if these frame resources are still in use by the GPU.
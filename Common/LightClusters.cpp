@@ -0,0 +1,296 @@
+//***************************************************************************************
+// LightClusters.cpp
+//***************************************************************************************
+
+#include "LightClusters.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+ClusterLight MakePointClusterLight(const XMFLOAT3& position, float range)
+{
+    ClusterLight light;
+    light.Center = position;
+    light.Radius = range;
+    return light;
+}
+
+ClusterLight MakeSpotClusterLight(const XMFLOAT3& position, const XMFLOAT3& direction,
+    float range, float cosHalfAngle)
+{
+    // Wider than a hemisphere: the range sphere is as tight as it gets.
+    if(cosHalfAngle <= 0.0f)
+        return MakePointClusterLight(position, range);
+
+    XMVECTOR apex = XMLoadFloat3(&position);
+    XMVECTOR dir = XMVector3Normalize(XMLoadFloat3(&direction));
+
+    float offset, radius;
+    if(cosHalfAngle < 0.70710678f)
+    {
+        // Wide cone: the sphere around the rim of the cap also holds the apex.
+        offset = range * cosHalfAngle;
+        radius = range * std::sqrt(1.0f - cosHalfAngle*cosHalfAngle);
+    }
+    else
+    {
+        // Narrow cone: the sphere through the apex and the rim.
+        offset = range / (2.0f * cosHalfAngle);
+        radius = offset;
+    }
+
+    ClusterLight light;
+    XMStoreFloat3(&light.Center, apex + offset*dir);
+    light.Radius = radius;
+    return light;
+}
+
+void LightClusterBuilder::SetGrid(const ClusterGridDesc& desc)
+{
+    assert(desc.TilesX > 0 && desc.TilesY > 0 && desc.SlicesZ > 0);
+    assert(desc.NearZ > 0.0f && desc.FarZ > desc.NearZ);
+
+    mGrid = desc;
+    mTanHalfFovY = std::tan(0.5f * desc.FovY);
+    mTanHalfFovX = mTanHalfFovY * desc.Aspect;
+    mSliceScale = (float)desc.SlicesZ / std::log(desc.FarZ / desc.NearZ);
+
+    uint32_t clustersPerSlice = desc.TilesX * desc.TilesY;
+    mClustersPerSlicePadded = (clustersPerSlice + 3) & ~3u;
+
+    // Padding clusters can never be hit.
+    size_t total = (size_t)mClustersPerSlicePadded * desc.SlicesZ;
+    mMinX.assign(total, 1e30f); mMinY.assign(total, 1e30f); mMinZ.assign(total, 1e30f);
+    mMaxX.assign(total, -1e30f); mMaxY.assign(total, -1e30f); mMaxZ.assign(total, -1e30f);
+
+    for(uint32_t z = 0; z < desc.SlicesZ; ++z)
+    {
+        float zn = desc.NearZ * std::pow(desc.FarZ / desc.NearZ, (float)z / desc.SlicesZ);
+        float zf = desc.NearZ * std::pow(desc.FarZ / desc.NearZ, (float)(z + 1) / desc.SlicesZ);
+
+        for(uint32_t y = 0; y < desc.TilesY; ++y)
+        {
+            // NDC y goes up, tile rows go down.
+            float top = (1.0f - 2.0f * y / desc.TilesY) * mTanHalfFovY;
+            float bottom = (1.0f - 2.0f * (y + 1) / desc.TilesY) * mTanHalfFovY;
+
+            for(uint32_t x = 0; x < desc.TilesX; ++x)
+            {
+                float left = (-1.0f + 2.0f * x / desc.TilesX) * mTanHalfFovX;
+                float right = (-1.0f + 2.0f * (x + 1) / desc.TilesX) * mTanHalfFovX;
+
+                // The froxel widens with depth, so its AABB spans both end caps.
+                size_t i = (size_t)z * mClustersPerSlicePadded + y * desc.TilesX + x;
+                mMinX[i] = std::min(left * zn, left * zf);
+                mMaxX[i] = std::max(right * zn, right * zf);
+                mMinY[i] = std::min(bottom * zn, bottom * zf);
+                mMaxY[i] = std::max(top * zn, top * zf);
+                mMinZ[i] = zn;
+                mMaxZ[i] = zf;
+            }
+        }
+    }
+
+    mSlices.resize(desc.SlicesZ);
+    for(auto& slice : mSlices)
+    {
+        slice.Counts.resize(clustersPerSlice);
+        slice.Offsets.resize(clustersPerSlice + 1);
+    }
+}
+
+uint32_t LightClusterBuilder::SliceFromDepth(float viewZ)const
+{
+    if(viewZ <= mGrid.NearZ)
+        return 0;
+
+    float slice = std::floor(std::log(viewZ / mGrid.NearZ) * mSliceScale);
+    return (uint32_t)std::min(slice, (float)(mGrid.SlicesZ - 1));
+}
+
+void LightClusterBuilder::BeginBuild(const ClusterLight* lights, uint32_t lightCount, FXMMATRIX view)
+{
+    assert(mClustersPerSlicePadded != 0 && "SetGrid() first");
+
+    mViewLights.clear();
+    mViewLights.reserve(lightCount);
+
+    mStats = LightClusterStats();
+    mStats.LightCount = lightCount;
+
+    for(uint32_t i = 0; i < lightCount; ++i)
+    {
+        XMFLOAT3 c;
+        XMStoreFloat3(&c, XMVector3TransformCoord(XMLoadFloat3(&lights[i].Center), view));
+        float r = lights[i].Radius;
+
+        float zMin = c.z - r;
+        float zMax = c.z + r;
+        if(zMax < mGrid.NearZ || zMin > mGrid.FarZ || r <= 0.0f)
+            continue;
+
+        // Only the part of the sphere in front of the near plane can touch a cluster.
+        float zNear = std::max(zMin, mGrid.NearZ);
+        float zFar = std::min(zMax, mGrid.FarZ);
+
+        // x/z over the box around the sphere is extreme at its corners, which gives a
+        // conservative range in tangent space.
+        float uMin = std::min((c.x - r) / zNear, (c.x - r) / zFar) / mTanHalfFovX;
+        float uMax = std::max((c.x + r) / zNear, (c.x + r) / zFar) / mTanHalfFovX;
+        float vMin = std::min((c.y - r) / zNear, (c.y - r) / zFar) / mTanHalfFovY;
+        float vMax = std::max((c.y + r) / zNear, (c.y + r) / zFar) / mTanHalfFovY;
+        if(uMax < -1.0f || uMin > 1.0f || vMax < -1.0f || vMin > 1.0f)
+            continue;
+
+        auto toTile = [](float t, uint32_t tiles)
+        {
+            float tile = std::floor(t * tiles);
+            return (uint16_t)std::min(std::max(tile, 0.0f), (float)(tiles - 1));
+        };
+
+        ViewLight light;
+        light.Center = c;
+        light.RadiusSq = r * r;
+        light.LightIndex = i;
+        light.SliceMin = (uint16_t)SliceFromDepth(zNear);
+        light.SliceMax = (uint16_t)SliceFromDepth(zFar);
+        light.TileMinX = toTile(0.5f * (uMin + 1.0f), mGrid.TilesX);
+        light.TileMaxX = toTile(0.5f * (uMax + 1.0f), mGrid.TilesX);
+        light.TileMinY = toTile(0.5f * (1.0f - vMax), mGrid.TilesY);
+        light.TileMaxY = toTile(0.5f * (1.0f - vMin), mGrid.TilesY);
+        mViewLights.push_back(light);
+    }
+
+    mStats.VisibleLightCount = (uint32_t)mViewLights.size();
+}
+
+void LightClusterBuilder::AssignSlices(uint32_t sliceBegin, uint32_t sliceEnd)
+{
+    assert(sliceEnd <= mGrid.SlicesZ);
+
+    for(uint32_t slice = sliceBegin; slice < sliceEnd; ++slice)
+        AssignSlice(slice);
+}
+
+void LightClusterBuilder::AssignSlice(uint32_t slice)
+{
+    SliceLists& lists = mSlices[slice];
+    lists.Pairs.clear();
+
+    size_t sliceBase = (size_t)slice * mClustersPerSlicePadded;
+    const float* minX = &mMinX[sliceBase];
+    const float* minY = &mMinY[sliceBase];
+    const float* minZ = &mMinZ[sliceBase];
+    const float* maxX = &mMaxX[sliceBase];
+    const float* maxY = &mMaxY[sliceBase];
+    const float* maxZ = &mMaxZ[sliceBase];
+
+    XMVECTOR zero = XMVectorZero();
+
+    for(const ViewLight& light : mViewLights)
+    {
+        if(slice < light.SliceMin || slice > light.SliceMax)
+            continue;
+
+        XMVECTOR cx = XMVectorReplicate(light.Center.x);
+        XMVECTOR cy = XMVectorReplicate(light.Center.y);
+        XMVECTOR cz = XMVectorReplicate(light.Center.z);
+        XMVECTOR r2 = XMVectorReplicate(light.RadiusSq);
+
+        for(uint32_t y = light.TileMinY; y <= light.TileMaxY; ++y)
+        {
+            uint32_t begin = y * mGrid.TilesX + light.TileMinX;
+            uint32_t end = y * mGrid.TilesX + light.TileMaxX + 1;
+
+            // Four clusters at a time from an aligned start.  Lanes outside [begin, end)
+            // are masked below; the slice is padded so the loads stay in bounds.
+            for(uint32_t i = begin & ~3u; i < end; i += 4)
+            {
+                XMVECTOR dx = XMVectorMax(XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(minX + i)), cx),
+                                          XMVectorSubtract(cx, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(maxX + i))));
+                XMVECTOR dy = XMVectorMax(XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(minY + i)), cy),
+                                          XMVectorSubtract(cy, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(maxY + i))));
+                XMVECTOR dz = XMVectorMax(XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(minZ + i)), cz),
+                                          XMVectorSubtract(cz, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(maxZ + i))));
+                dx = XMVectorMax(dx, zero);
+                dy = XMVectorMax(dy, zero);
+                dz = XMVectorMax(dz, zero);
+
+                // Squared distance from the sphere center to each AABB.
+                XMVECTOR distSq = XMVectorMultiply(dx, dx);
+                distSq = XMVectorMultiplyAdd(dy, dy, distSq);
+                distSq = XMVectorMultiplyAdd(dz, dz, distSq);
+
+                XMVECTOR hit = XMVectorLessOrEqual(distSq, r2);
+                if(XMVector4EqualInt(hit, XMVectorFalseInt()))
+                    continue;
+
+                uint32_t mask[4];
+                XMStoreInt4(mask, hit);
+                for(uint32_t lane = 0; lane < 4; ++lane)
+                {
+                    uint32_t cluster = i + lane;
+                    if(mask[lane] != 0 && cluster >= begin && cluster < end)
+                        lists.Pairs.push_back({ cluster, light.LightIndex });
+                }
+            }
+        }
+    }
+
+    // Group by cluster with a counting sort; lights keep their order within a cluster.
+    std::fill(lists.Counts.begin(), lists.Counts.end(), 0u);
+    for(const ClusterLightPair& pair : lists.Pairs)
+        ++lists.Counts[pair.Cluster];
+
+    lists.Offsets[0] = 0;
+    for(size_t c = 0; c < lists.Counts.size(); ++c)
+        lists.Offsets[c + 1] = lists.Offsets[c] + lists.Counts[c];
+
+    // Counts becomes the write cursor.
+    std::copy(lists.Offsets.begin(), lists.Offsets.end() - 1, lists.Counts.begin());
+    lists.Indices.resize(lists.Pairs.size());
+    for(const ClusterLightPair& pair : lists.Pairs)
+        lists.Indices[lists.Counts[pair.Cluster]++] = pair.Light;
+}
+
+void LightClusterBuilder::FinishBuild()
+{
+    uint32_t clustersPerSlice = mGrid.TilesX * mGrid.TilesY;
+
+    size_t indexCount = 0;
+    for(const SliceLists& lists : mSlices)
+        indexCount += lists.Indices.size();
+
+    mClusterRanges.resize(ClusterCount());
+    mLightIndices.resize(indexCount);
+
+    uint32_t base = 0;
+    uint32_t maxPerCluster = 0;
+    for(uint32_t slice = 0; slice < mGrid.SlicesZ; ++slice)
+    {
+        const SliceLists& lists = mSlices[slice];
+        for(uint32_t c = 0; c < clustersPerSlice; ++c)
+        {
+            ClusterRange& range = mClusterRanges[slice * clustersPerSlice + c];
+            range.Offset = base + lists.Offsets[c];
+            range.Count = lists.Offsets[c + 1] - lists.Offsets[c];
+            maxPerCluster = std::max(maxPerCluster, range.Count);
+        }
+
+        std::copy(lists.Indices.begin(), lists.Indices.end(), mLightIndices.begin() + base);
+        base += (uint32_t)lists.Indices.size();
+    }
+
+    mStats.IndexCount = (uint32_t)indexCount;
+    mStats.MaxLightsPerCluster = maxPerCluster;
+}
+
+void LightClusterBuilder::Build(const ClusterLight* lights, uint32_t lightCount, FXMMATRIX view)
+{
+    BeginBuild(lights, lightCount, view);
+    AssignSlices(0, mGrid.SlicesZ);
+    FinishBuild();
+}
@@ -0,0 +1,159 @@
+//***************************************************************************************
+// LightClusters.h
+//
+// CPU light assignment for clustered forward shading.
+//   -The camera frustum is divided into TilesX x TilesY screen tiles and SlicesZ depth
+//    slices ("froxels").  Slices are spaced exponentially, so clusters near the camera
+//    stay small.
+//   -Cluster bounds are view-space AABBs kept as structure-of-arrays, so the
+//    sphere-vs-AABB test runs on four clusters at once with DirectXMath.
+//   -Each light is first narrowed to the slice and tile range its bounding sphere can
+//    touch; only those clusters are tested.
+//   -Building is split in three steps so the middle one can run on several threads:
+//      BeginBuild()    transforms the lights to view space (single thread),
+//      AssignSlices()  assigns lights to the clusters of a range of slices; disjoint
+//                      ranges may run concurrently,
+//      FinishBuild()   packs the per-slice lists into one index list.
+//    Build() does all three on the calling thread.
+//
+// The output is one ClusterRange per cluster (offset and count into the index list)
+// and a compact list of light indices.  Nothing here touches D3D12.
+//***************************************************************************************
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+struct ClusterGridDesc
+{
+    uint32_t TilesX = 16;
+    uint32_t TilesY = 9;
+    uint32_t SlicesZ = 24;
+
+    // Camera projection.  Lights outside [NearZ, FarZ] are not assigned.
+    float FovY = 0.25f * DirectX::XM_PI;
+    float Aspect = 16.0f / 9.0f;
+    float NearZ = 1.0f;
+    float FarZ = 1000.0f;
+};
+
+// World-space bounding sphere of a point or spot light.
+struct ClusterLight
+{
+    DirectX::XMFLOAT3 Center = { 0.0f, 0.0f, 0.0f };
+    float Radius = 0.0f;
+};
+
+// Bounding sphere of the light's range.
+ClusterLight MakePointClusterLight(const DirectX::XMFLOAT3& position, float range);
+
+// Bounding sphere of a cone with its apex at position, opening along direction.
+// cosHalfAngle is the cosine of the angle where the light is cut off.
+ClusterLight MakeSpotClusterLight(const DirectX::XMFLOAT3& position,
+    const DirectX::XMFLOAT3& direction, float range, float cosHalfAngle);
+
+struct ClusterRange
+{
+    uint32_t Offset = 0;
+    uint32_t Count = 0;
+};
+
+struct LightClusterStats
+{
+    uint32_t LightCount = 0;
+
+    // Lights that overlap the clustered depth range.
+    uint32_t VisibleLightCount = 0;
+
+    uint32_t IndexCount = 0;
+    uint32_t MaxLightsPerCluster = 0;
+};
+
+class LightClusterBuilder
+{
+public:
+    LightClusterBuilder() = default;
+    LightClusterBuilder(const LightClusterBuilder& rhs) = delete;
+    LightClusterBuilder& operator=(const LightClusterBuilder& rhs) = delete;
+
+    // Rebuilds the cluster bounds.  Call when the projection changes.
+    void SetGrid(const ClusterGridDesc& desc);
+    const ClusterGridDesc& GetGrid()const { return mGrid; }
+
+    uint32_t ClusterCount()const { return mGrid.TilesX * mGrid.TilesY * mGrid.SlicesZ; }
+    uint32_t SliceCount()const { return mGrid.SlicesZ; }
+
+    // Cluster index of tile (x, y) in slice z; tile (0, 0) is the top left of the screen.
+    uint32_t ClusterIndex(uint32_t x, uint32_t y, uint32_t z)const
+    {
+        return (z * mGrid.TilesY + y) * mGrid.TilesX + x;
+    }
+
+    // Slice containing view-space depth viewZ, clamped to the grid.
+    uint32_t SliceFromDepth(float viewZ)const;
+
+    // Light indices in the output refer to positions in 'lights'.
+    void BeginBuild(const ClusterLight* lights, uint32_t lightCount, DirectX::FXMMATRIX view);
+    void AssignSlices(uint32_t sliceBegin, uint32_t sliceEnd);
+    void FinishBuild();
+
+    void Build(const ClusterLight* lights, uint32_t lightCount, DirectX::FXMMATRIX view);
+
+    // Valid after FinishBuild(), until the next BeginBuild().
+    const std::vector<ClusterRange>& GetClusterRanges()const { return mClusterRanges; }
+    const std::vector<uint32_t>& GetLightIndices()const { return mLightIndices; }
+    const LightClusterStats& GetStats()const { return mStats; }
+
+private:
+    // A light in view space with the clusters it may touch.
+    struct ViewLight
+    {
+        DirectX::XMFLOAT3 Center;
+        float RadiusSq;
+        uint32_t LightIndex;
+        uint16_t SliceMin, SliceMax;
+        uint16_t TileMinX, TileMaxX;
+        uint16_t TileMinY, TileMaxY;
+    };
+
+    struct ClusterLightPair
+    {
+        uint32_t Cluster;    // cluster within the slice
+        uint32_t Light;      // index into the caller's light array
+    };
+
+    // Lights of one slice, grouped by cluster.  Kept between frames so steady-state
+    // builds do not allocate.
+    struct SliceLists
+    {
+        std::vector<ClusterLightPair> Pairs;    // in light order
+        std::vector<uint32_t> Counts;
+        std::vector<uint32_t> Offsets;
+        std::vector<uint32_t> Indices;          // light indices grouped by cluster
+    };
+
+    void AssignSlice(uint32_t slice);
+
+private:
+    ClusterGridDesc mGrid;
+
+    // Clusters of one slice, rounded up to a multiple of four for the SIMD loop.
+    uint32_t mClustersPerSlicePadded = 0;
+
+    float mTanHalfFovX = 0.0f;
+    float mTanHalfFovY = 0.0f;
+    float mSliceScale = 0.0f;    // SlicesZ / log(FarZ / NearZ)
+
+    // View-space cluster AABBs, slice by slice, mClustersPerSlicePadded apiece.
+    std::vector<float> mMinX, mMinY, mMinZ;
+    std::vector<float> mMaxX, mMaxY, mMaxZ;
+
+    std::vector<ViewLight> mViewLights;
+    std::vector<SliceLists> mSlices;
+
+    std::vector<ClusterRange> mClusterRanges;
+    std::vector<uint32_t> mLightIndices;
+    LightClusterStats mStats;
+};
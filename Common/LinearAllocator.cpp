@@ -0,0 +1,134 @@
+//***************************************************************************************
+// LinearAllocator.cpp
+//***************************************************************************************
+
+#include "LinearAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace
+{
+    inline size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+#if defined(DEBUG) || defined(_DEBUG)
+    // Memory handed back by Reset() is filled with this so stale pointers stand out.
+    const uint8_t kFreedPattern = 0xCD;
+#endif
+}
+
+LinearAllocator::LinearAllocator(size_t capacity)
+    : mCapacity(capacity), mOffset(0)
+{
+    mBuffer = static_cast<uint8_t*>(::operator new(mCapacity, std::align_val_t(64)));
+}
+
+LinearAllocator::~LinearAllocator()
+{
+    FreeOverflow();
+    ::operator delete(mBuffer, std::align_val_t(64));
+}
+
+void* LinearAllocator::Allocate(size_t size, size_t alignment)
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    // The arena base is 64-byte aligned, so aligning the offset aligns the pointer.
+    if(alignment > 64)
+        return AllocateOverflow(size, alignment);
+
+    size_t current = mOffset.load(std::memory_order_relaxed);
+    for(;;)
+    {
+        size_t aligned = AlignUp(current, alignment);
+        size_t next = aligned + size;
+        if(next > mCapacity)
+            return AllocateOverflow(size, alignment);
+
+        if(mOffset.compare_exchange_weak(current, next, std::memory_order_relaxed))
+            return mBuffer + aligned;
+    }
+}
+
+void* LinearAllocator::AllocateOverflow(size_t size, size_t alignment)
+{
+    // Block layout: [OverflowBlock | padding | payload], all from one aligned new so
+    // the payload keeps the alignment the arena would have given it.
+    alignment = std::max<size_t>(alignment, alignof(OverflowBlock));
+    size_t headerSize = AlignUp(sizeof(OverflowBlock), alignment);
+    auto block = static_cast<OverflowBlock*>(::operator new(headerSize + size, std::align_val_t(alignment)));
+    block->Alignment = alignment;
+
+    std::lock_guard<std::mutex> lock(mOverflowMutex);
+
+#if defined(DEBUG) || defined(_DEBUG)
+    if(mOverflowCount == 0)
+    {
+        char msg[160];
+        std::snprintf(msg, sizeof(msg),
+            "LinearAllocator overflow: capacity %zu bytes exhausted, falling back to the heap.\n",
+            mCapacity);
+#ifdef _WIN32
+        OutputDebugStringA(msg);
+#else
+        std::fputs(msg, stderr);
+#endif
+    }
+#endif
+
+    block->Next = mOverflowBlocks;
+    mOverflowBlocks = block;
+    mOverflowBytes += size;
+    ++mOverflowCount;
+    ++mTotalOverflowCount;
+
+    return reinterpret_cast<uint8_t*>(block) + headerSize;
+}
+
+void LinearAllocator::FreeOverflow()
+{
+    while(mOverflowBlocks != nullptr)
+    {
+        OverflowBlock* next = mOverflowBlocks->Next;
+        ::operator delete(mOverflowBlocks, std::align_val_t(mOverflowBlocks->Alignment));
+        mOverflowBlocks = next;
+    }
+
+    mOverflowBytes = 0;
+    mOverflowCount = 0;
+}
+
+void LinearAllocator::Reset()
+{
+    size_t used = std::min<size_t>(mOffset.load(std::memory_order_relaxed), mCapacity);
+    mHighWaterMark = std::max<size_t>(mHighWaterMark, used + mOverflowBytes);
+
+#if defined(DEBUG) || defined(_DEBUG)
+    std::memset(mBuffer, kFreedPattern, used);
+#endif
+
+    FreeOverflow();
+    mOffset.store(0, std::memory_order_relaxed);
+}
+
+LinearAllocatorStats LinearAllocator::GetStats()const
+{
+    LinearAllocatorStats stats;
+    stats.Capacity = mCapacity;
+    stats.BytesUsed = std::min<size_t>(mOffset.load(std::memory_order_relaxed), mCapacity);
+    stats.HighWaterMark = std::max<size_t>(mHighWaterMark, stats.BytesUsed + mOverflowBytes);
+    stats.OverflowBytes = mOverflowBytes;
+    stats.OverflowCount = mOverflowCount;
+    stats.TotalOverflowCount = mTotalOverflowCount;
+    return stats;
+}
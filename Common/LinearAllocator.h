@@ -0,0 +1,124 @@
+//***************************************************************************************
+// LinearAllocator.h
+//
+// Bump allocator for transient per-frame CPU data.
+//   -Each FrameResource owns one.  Allocations are never freed individually; the whole
+//    arena is rewound with Reset() once the GPU fence of that FrameResource completes.
+//   -Allocate() is lock free, so tasks running on worker threads may share an arena.
+//   -If a frame needs more than the arena capacity, the extra allocations are served
+//    from the heap and released on the next Reset().  This is reported in debug builds
+//    and through the statistics so the capacity can be raised.
+//***************************************************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct LinearAllocatorStats
+{
+    size_t Capacity = 0;
+
+    // Bytes bumped since the last Reset().
+    size_t BytesUsed = 0;
+
+    // Largest BytesUsed seen at Reset() time, overflow included.
+    size_t HighWaterMark = 0;
+
+    // Heap fallbacks taken since the last Reset() and since creation.
+    size_t OverflowBytes = 0;
+    uint32_t OverflowCount = 0;
+    uint32_t TotalOverflowCount = 0;
+};
+
+class LinearAllocator
+{
+public:
+    explicit LinearAllocator(size_t capacity);
+    LinearAllocator(const LinearAllocator& rhs) = delete;
+    LinearAllocator& operator=(const LinearAllocator& rhs) = delete;
+    ~LinearAllocator();
+
+    // Returns memory aligned to 'alignment' (a power of two).  Never returns nullptr.
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Uninitialized storage for 'count' elements of T.
+    template<typename T>
+    T* AllocateArray(size_t count)
+    {
+        return static_cast<T*>(Allocate(count*sizeof(T), alignof(T)));
+    }
+
+    // Rewinds the arena.  Only call once nothing allocated since the last Reset() is in use.
+    void Reset();
+
+    LinearAllocatorStats GetStats()const;
+
+private:
+    void* AllocateOverflow(size_t size, size_t alignment);
+    void FreeOverflow();
+
+private:
+    struct OverflowBlock
+    {
+        OverflowBlock* Next;
+        size_t Alignment;   // of the allocation, needed to free it
+    };
+
+    uint8_t* mBuffer = nullptr;
+    size_t mCapacity = 0;
+    std::atomic<size_t> mOffset;
+
+    std::mutex mOverflowMutex;
+    OverflowBlock* mOverflowBlocks = nullptr;
+    size_t mOverflowBytes = 0;
+    uint32_t mOverflowCount = 0;
+    uint32_t mTotalOverflowCount = 0;
+
+    size_t mHighWaterMark = 0;
+};
+
+// std-compatible adapter so containers can live in a LinearAllocator, e.g.
+//     FrameVector<UINT> visible{ LinearStlAllocator<UINT>(*frameAlloc) };
+// deallocate() is a no-op; memory comes back on LinearAllocator::Reset().
+template<typename T>
+class LinearStlAllocator
+{
+public:
+    using value_type = T;
+
+    LinearStlAllocator(LinearAllocator& arena) noexcept : mArena(&arena) {}
+
+    template<typename U>
+    LinearStlAllocator(const LinearStlAllocator<U>& rhs) noexcept : mArena(rhs.Arena()) {}
+
+    T* allocate(size_t n)
+    {
+        return mArena->AllocateArray<T>(n);
+    }
+
+    void deallocate(T*, size_t) noexcept {}
+
+    LinearAllocator* Arena()const noexcept { return mArena; }
+
+private:
+    LinearAllocator* mArena;
+};
+
+template<typename T, typename U>
+bool operator==(const LinearStlAllocator<T>& lhs, const LinearStlAllocator<U>& rhs) noexcept
+{
+    return lhs.Arena() == rhs.Arena();
+}
+
+template<typename T, typename U>
+bool operator!=(const LinearStlAllocator<T>& lhs, const LinearStlAllocator<U>& rhs) noexcept
+{
+    return lhs.Arena() != rhs.Arena();
+}
+
+template<typename T>
+using FrameVector = std::vector<T, LinearStlAllocator<T>>;
@@ -0,0 +1,175 @@
+//***************************************************************************************
+// ShadowCaching.cpp
+//***************************************************************************************
+
+#include "ShadowCaching.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+ShadowReceiverVolume::ShadowReceiverVolume(const ShadowCascade& cascade)
+{
+    mLightView = cascade.LightView;
+    XMStoreFloat3(&mCenterLS, XMVector3TransformCoord(
+        XMLoadFloat3(&cascade.ReceiverBounds.Center), XMLoadFloat4x4(&mLightView)));
+    mRadius = cascade.ReceiverBounds.Radius;
+}
+
+bool ShadowReceiverVolume::Intersects(const BoundingBox& casterBounds, float* casterNearZ)const
+{
+    BoundingBox boundsLS;
+    casterBounds.Transform(boundsLS, XMLoadFloat4x4(&mLightView));
+
+    // Entirely behind the receivers.
+    float nearZ = boundsLS.Center.z - boundsLS.Extents.z;
+    if(nearZ > mCenterLS.z + mRadius)
+        return false;
+
+    // The sweep toward the light is a cylinder around the light's z axis; compare
+    // the receiver circle with the caster's x/y rectangle.
+    float dx = std::max(0.0f, std::fabs(boundsLS.Center.x - mCenterLS.x) - boundsLS.Extents.x);
+    float dy = std::max(0.0f, std::fabs(boundsLS.Center.y - mCenterLS.y) - boundsLS.Extents.y);
+    if(dx*dx + dy*dy > mRadius*mRadius)
+        return false;
+
+    *casterNearZ = nearZ;
+    return true;
+}
+
+ShadowCacheTracker::ShadowCacheTracker(const ShadowCacheSettings& settings)
+    : mSettings(settings)
+{
+}
+
+void ShadowCacheTracker::Invalidate()
+{
+    mHasLightDir = false;
+    mLightChanged = true;
+    mCachedCount = 0;
+    std::fill(std::begin(mCachedValid), std::end(mCachedValid), false);
+    mCasterSnapshots.clear();
+}
+
+XMFLOAT3 ShadowCacheTracker::SelectLightDirection(const XMFLOAT3& lightDir)
+{
+    XMVECTOR dir = XMVector3Normalize(XMLoadFloat3(&lightDir));
+
+    bool turned = true;
+    if(mHasLightDir)
+    {
+        float cosAngle = XMVectorGetX(XMVector3Dot(dir, XMLoadFloat3(&mLightDir)));
+        turned = cosAngle < std::cos(mSettings.LightAngleThreshold);
+    }
+
+    if(turned)
+    {
+        XMStoreFloat3(&mLightDir, dir);
+        mHasLightDir = true;
+        mLightChanged = true;
+    }
+
+    return mLightDir;
+}
+
+bool ShadowCacheTracker::SameFootprint(const ShadowCascade& cached, const ShadowCascade& fitted)const
+{
+    if(cached.ReceiverBounds.Radius != fitted.ReceiverBounds.Radius)
+        return false;
+
+    // Both centers are snapped to the texel grid, so anything beyond float noise is
+    // a move of at least one texel.
+    float epsilon = 1e-4f * cached.ReceiverBounds.Radius;
+    if(std::fabs(cached.LightCenterLS.x - fitted.LightCenterLS.x) > epsilon ||
+       std::fabs(cached.LightCenterLS.y - fitted.LightCenterLS.y) > epsilon)
+        return false;
+
+    // The cached depth range must hold everything the refit needs.
+    return cached.LightNearZ <= fitted.LightNearZ && cached.LightFarZ >= fitted.LightFarZ;
+}
+
+uint32_t ShadowCacheTracker::Update(ShadowCascade* cascades, uint32_t cascadeCount,
+    const ShadowCasterState* casters, uint32_t casterCount)
+{
+    assert(cascadeCount <= MaxShadowCascades);
+
+    uint32_t allCascades = (1u << cascadeCount) - 1;
+    uint32_t dirty = 0;
+
+    if(cascadeCount != mCachedCount || mLightChanged)
+        dirty = allCascades;
+
+    for(uint32_t i = 0; i < cascadeCount; ++i)
+    {
+        // The light view only changes with the selected light direction, which is
+        // handled above.
+        if(!mCachedValid[i] || !SameFootprint(mCached[i], cascades[i]))
+            dirty |= 1u << i;
+    }
+
+    // Casters, tested against the cascades as fitted this frame.
+    if(casterCount != mCasterSnapshots.size())
+    {
+        dirty = allCascades;
+        mCasterSnapshots.resize(casterCount);
+        for(uint32_t c = 0; c < casterCount; ++c)
+            mCasterSnapshots[c] = casters[c].Bounds;
+    }
+    else
+    {
+        ShadowReceiverVolume volumes[MaxShadowCascades];
+        for(uint32_t i = 0; i < cascadeCount; ++i)
+            volumes[i] = ShadowReceiverVolume(cascades[i]);
+
+        float moveThresholdSq = mSettings.CasterMoveThreshold * mSettings.CasterMoveThreshold;
+        for(uint32_t c = 0; c < casterCount; ++c)
+        {
+            const BoundingBox& bounds = casters[c].Bounds;
+            BoundingBox& snapshot = mCasterSnapshots[c];
+
+            XMVECTOR centerDelta = XMLoadFloat3(&bounds.Center) - XMLoadFloat3(&snapshot.Center);
+            XMVECTOR extentsDelta = XMLoadFloat3(&bounds.Extents) - XMLoadFloat3(&snapshot.Extents);
+            bool moved = XMVectorGetX(XMVector3LengthSq(centerDelta)) > moveThresholdSq ||
+                XMVectorGetX(XMVector3LengthSq(extentsDelta)) > moveThresholdSq;
+
+            if(!moved && !casters[c].Animated)
+                continue;
+
+            // A moved caster affects the cascades it left and the ones it entered.
+            for(uint32_t i = 0; i < cascadeCount && dirty != allCascades; ++i)
+            {
+                float z;
+                if(volumes[i].Intersects(bounds, &z) || (moved && volumes[i].Intersects(snapshot, &z)))
+                    dirty |= 1u << i;
+            }
+
+            // Keep the snapshot current even when everything re-renders anyway.
+            if(moved)
+                snapshot = bounds;
+        }
+    }
+
+    for(uint32_t i = 0; i < cascadeCount; ++i)
+    {
+        if(dirty & (1u << i))
+        {
+            float slack = mSettings.DepthSlack * cascades[i].ReceiverBounds.Radius;
+            SetCascadeDepthRange(cascades[i], cascades[i].LightNearZ - slack, cascades[i].LightFarZ + slack);
+
+            mCached[i] = cascades[i];
+            mCachedValid[i] = true;
+            ++mStats.CascadesRendered;
+        }
+        else
+        {
+            cascades[i] = mCached[i];
+            ++mStats.CascadesReused;
+        }
+    }
+
+    mCachedCount = cascadeCount;
+    mLightChanged = false;
+    return dirty;
+}
@@ -0,0 +1,141 @@
+//***************************************************************************************
+// ShadowCaching.h
+//
+// Work reduction for the cascaded shadow pass.
+//   -ShadowReceiverVolume culls casters against a cascade's receivers swept toward the
+//    light: a caster only matters if it overlaps the receiver sphere's footprint and
+//    is not entirely behind it.  The nearest surviving caster also gives a tighter
+//    near plane than the scene bounds.
+//   -ShadowCacheTracker decides which cascades have to be re-rendered.  A cascade
+//    keeps the shadow map contents (and the matrices they were rendered with) until
+//      the light turned further than LightAngleThreshold,
+//      its footprint moved or its depth range no longer covers what is needed,
+//      or a caster it can see moved further than CasterMoveThreshold.
+//    Animated casters make every cascade they touch re-render each frame.
+//
+// Only DirectXMath/DirectXCollision are used, so the decisions can be tested without
+// a device.
+//***************************************************************************************
+
+#pragma once
+
+#include "CascadedShadows.h"
+
+#include <cfloat>
+#include <vector>
+
+// A cascade's receivers extruded toward the light.
+class ShadowReceiverVolume
+{
+public:
+    ShadowReceiverVolume() = default;
+    explicit ShadowReceiverVolume(const ShadowCascade& cascade);
+
+    // True if the world-space box can cast onto the receivers.  *casterNearZ gets
+    // the box's smallest light-space depth.
+    bool Intersects(const DirectX::BoundingBox& casterBounds, float* casterNearZ)const;
+
+private:
+    DirectX::XMFLOAT4X4 mLightView;
+    DirectX::XMFLOAT3 mCenterLS = { 0.0f, 0.0f, 0.0f };
+    float mRadius = 0.0f;
+};
+
+// Writes the indices of the casters that can shadow the cascade's receivers to
+// visibleIndices (room for casterCount entries) and returns how many there are.
+// *casterNearZ gets the smallest light-space depth among them, or FLT_MAX if none.
+// getBounds(i) returns the world-space DirectX::BoundingBox of caster i.
+template<typename GetBounds>
+uint32_t CullShadowCastersExtruded(const ShadowCascade& cascade, uint32_t casterCount,
+    GetBounds getBounds, uint32_t* visibleIndices, float* casterNearZ)
+{
+    ShadowReceiverVolume volume(cascade);
+
+    uint32_t visibleCount = 0;
+    float nearZ = FLT_MAX;
+    for(uint32_t i = 0; i < casterCount; ++i)
+    {
+        float z;
+        if(volume.Intersects(getBounds(i), &z))
+        {
+            visibleIndices[visibleCount++] = i;
+            nearZ = z < nearZ ? z : nearZ;
+        }
+    }
+
+    *casterNearZ = nearZ;
+    return visibleCount;
+}
+
+struct ShadowCacheSettings
+{
+    // Radians the light may turn before every cascade is re-rendered.
+    float LightAngleThreshold = 0.5f * DirectX::XM_PI / 180.0f;
+
+    // World units a caster's bounds may move before the cascades it touches are
+    // re-rendered.
+    float CasterMoveThreshold = 0.01f;
+
+    // A re-rendered cascade's depth range is widened by this fraction of its radius
+    // on both ends, so small camera moves along the light do not invalidate it.
+    float DepthSlack = 0.25f;
+};
+
+struct ShadowCasterState
+{
+    DirectX::BoundingBox Bounds;
+
+    // The geometry changes every frame even if the bounds do not (skinned meshes).
+    bool Animated = false;
+};
+
+struct ShadowCacheStats
+{
+    uint64_t CascadesRendered = 0;
+    uint64_t CascadesReused = 0;
+};
+
+class ShadowCacheTracker
+{
+public:
+    explicit ShadowCacheTracker(const ShadowCacheSettings& settings = ShadowCacheSettings());
+
+    void SetSettings(const ShadowCacheSettings& settings) { mSettings = settings; }
+    const ShadowCacheSettings& GetSettings()const { return mSettings; }
+
+    // Forget everything; all cascades re-render on the next Update().
+    void Invalidate();
+
+    // The direction to fit this frame's cascades with.  It stays at the direction
+    // of the cached shadows until the light has turned past the threshold.
+    DirectX::XMFLOAT3 SelectLightDirection(const DirectX::XMFLOAT3& lightDir);
+
+    // cascades holds the cascades fitted this frame, with the direction from
+    // SelectLightDirection().  On return it holds the cascades to render and sample
+    // with: the cached ones where the shadow map is still valid, the refitted (and
+    // depth-widened) ones elsewhere.  Returns a mask with bit i set if cascade i
+    // must be re-rendered this frame.
+    uint32_t Update(ShadowCascade* cascades, uint32_t cascadeCount,
+        const ShadowCasterState* casters, uint32_t casterCount);
+
+    const ShadowCacheStats& GetStats()const { return mStats; }
+
+private:
+    bool SameFootprint(const ShadowCascade& cached, const ShadowCascade& fitted)const;
+
+private:
+    ShadowCacheSettings mSettings;
+
+    bool mHasLightDir = false;
+    bool mLightChanged = true;
+    DirectX::XMFLOAT3 mLightDir;
+
+    uint32_t mCachedCount = 0;
+    bool mCachedValid[MaxShadowCascades] = {};
+    ShadowCascade mCached[MaxShadowCascades];
+
+    // Caster bounds as of the last time each caster counted as moved.
+    std::vector<DirectX::BoundingBox> mCasterSnapshots;
+
+    ShadowCacheStats mStats;
+};
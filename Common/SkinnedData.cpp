@@ -110,6 +110,14 @@ void AnimationClip::Interpolate(float t, std::vector<XMFLOAT4X4>& boneTransforms
 	}
 }
 
+void AnimationClip::Interpolate(float t, XMFLOAT4X4* boneTransforms)const
+{
+	for(UINT i = 0; i < BoneAnimations.size(); ++i)
+	{
+		BoneAnimations[i].Interpolate(t, boneTransforms[i]);
+	}
+}
+
 float SkinnedData::GetClipStartTime(const std::string& clipName)const
 {
 	auto clip = mAnimations.find(clipName);
@@ -141,17 +149,37 @@ void SkinnedData::GetFinalTransforms(const std::string& clipName, float timePos,
 	UINT numBones = mBoneOffsets.size();
 
 	std::vector<XMFLOAT4X4> toParentTransforms(numBones);
+	std::vector<XMFLOAT4X4> toRootTransforms(numBones);
 
-	// Interpolate all the bones of this clip at the given time instance.
 	auto clip = mAnimations.find(clipName);
-	clip->second.Interpolate(timePos, toParentTransforms);
+	ComputeFinalTransforms(clip->second, timePos, toParentTransforms.data(), toRootTransforms.data(), finalTransforms);
+}
+
+void SkinnedData::GetFinalTransforms(const std::string& clipName, float timePos,
+	std::vector<XMFLOAT4X4>& finalTransforms, LinearAllocator& scratch)const
+{
+	UINT numBones = mBoneOffsets.size();
+
+	XMFLOAT4X4* toParentTransforms = scratch.AllocateArray<XMFLOAT4X4>(numBones);
+	XMFLOAT4X4* toRootTransforms = scratch.AllocateArray<XMFLOAT4X4>(numBones);
+
+	auto clip = mAnimations.find(clipName);
+	ComputeFinalTransforms(clip->second, timePos, toParentTransforms, toRootTransforms, finalTransforms);
+}
+
+void SkinnedData::ComputeFinalTransforms(const AnimationClip& clip, float timePos,
+	XMFLOAT4X4* toParentTransforms, XMFLOAT4X4* toRootTransforms,
+	std::vector<XMFLOAT4X4>& finalTransforms)const
+{
+	UINT numBones = mBoneOffsets.size();
+
+	// Interpolate all the bones of this clip at the given time instance.
+	clip.Interpolate(timePos, toParentTransforms);
 
 	//
 	// Traverse the hierarchy and transform all the bones to the root space.
 	//
 
-	std::vector<XMFLOAT4X4> toRootTransforms(numBones);
-
 	// The root bone has index 0.  The root bone has no parent, so its toRootTransform
 	// is just its local bone transform.
 	toRootTransforms[0] = toParentTransforms[0];
@@ -177,4 +205,4 @@ void SkinnedData::GetFinalTransforms(const std::string& clipName, float timePos,
         XMMATRIX finalTransform = XMMatrixMultiply(offset, toRoot);
 		XMStoreFloat4x4(&finalTransforms[i], XMMatrixTranspose(finalTransform));
 	}
-}
\ No newline at end of file
+}
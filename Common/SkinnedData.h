@@ -6,6 +6,7 @@
 #include <string>
 #include <unordered_map>
 #include "MathHelper.h"
+#include "LinearAllocator.h"
 
 ///<summary>
 /// A Keyframe defines the bone transformation at an instant in time.
@@ -49,6 +50,7 @@ struct AnimationClip
 	float GetClipEndTime()const;
 
     void Interpolate(float t, std::vector<DirectX::XMFLOAT4X4>& boneTransforms)const;
+    void Interpolate(float t, DirectX::XMFLOAT4X4* boneTransforms)const;
 
     std::vector<BoneAnimation> BoneAnimations; 	
 };
@@ -73,6 +75,16 @@ public:
     void GetFinalTransforms(const std::string& clipName, float timePos, 
 		 std::vector<DirectX::XMFLOAT4X4>& finalTransforms)const;
 
+	// Same as above, but the intermediate bone transforms are taken from 'scratch'
+	// instead of the heap.
+    void GetFinalTransforms(const std::string& clipName, float timePos, 
+		 std::vector<DirectX::XMFLOAT4X4>& finalTransforms, LinearAllocator& scratch)const;
+
+private:
+	void ComputeFinalTransforms(const AnimationClip& clip, float timePos,
+		DirectX::XMFLOAT4X4* toParentTransforms, DirectX::XMFLOAT4X4* toRootTransforms,
+		std::vector<DirectX::XMFLOAT4X4>& finalTransforms)const;
+
 private:
     // Gives parentIndex of ith bone.
 	std::vector<int> mBoneHierarchy;
@@ -0,0 +1,220 @@
+//***************************************************************************************
+// TaskGraph.cpp
+//***************************************************************************************
+
+#include "TaskGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <tracy/Tracy.hpp>
+
+TaskGraph::TaskGraph(uint32_t workerCount)
+{
+    if(workerCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    mWorkers.reserve(workerCount);
+    for(uint32_t i = 0; i < workerCount; ++i)
+        mWorkers.emplace_back(&TaskGraph::WorkerLoop, this, i);
+}
+
+TaskGraph::~TaskGraph()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQuit = true;
+    }
+    mCondition.notify_all();
+
+    for(auto& worker : mWorkers)
+        worker.join();
+}
+
+TaskGraph::TaskId TaskGraph::AddTask(const char* name, std::function<void()> func,
+    std::initializer_list<TaskId> dependencies)
+{
+    return AddTaskImpl(name, std::move(func), dependencies.begin(), dependencies.size());
+}
+
+TaskGraph::TaskId TaskGraph::AddTask(const char* name, std::function<void()> func,
+    const std::vector<TaskId>& dependencies)
+{
+    return AddTaskImpl(name, std::move(func), dependencies.data(), dependencies.size());
+}
+
+std::vector<TaskGraph::TaskId> TaskGraph::AddParallelFor(const char* name, uint32_t count,
+    uint32_t batchCount, std::function<void(uint32_t begin, uint32_t end)> func,
+    std::initializer_list<TaskId> dependencies)
+{
+    if(batchCount == 0)
+        batchCount = WorkerCount() + 1;
+    batchCount = std::max<uint32_t>(1, std::min(batchCount, count));
+
+    // The batches share one copy of func.
+    auto shared = std::make_shared<std::function<void(uint32_t, uint32_t)>>(std::move(func));
+
+    std::vector<TaskId> ids;
+    ids.reserve(batchCount);
+    for(uint32_t batch = 0; batch < batchCount; ++batch)
+    {
+        uint32_t begin = (uint32_t)((uint64_t)count * batch / batchCount);
+        uint32_t end = (uint32_t)((uint64_t)count * (batch + 1) / batchCount);
+        ids.push_back(AddTaskImpl(name, [shared, begin, end]{ (*shared)(begin, end); },
+            dependencies.begin(), dependencies.size()));
+    }
+    return ids;
+}
+
+TaskGraph::TaskId TaskGraph::AddTaskImpl(const char* name, std::function<void()> func,
+    const TaskId* dependencies, size_t dependencyCount)
+{
+    TaskId id = (TaskId)mTasks.size();
+
+    Task task;
+    task.Name = name;
+    task.Func = std::move(func);
+    task.DependencyCount = (uint32_t)dependencyCount;
+    mTasks.push_back(std::move(task));
+
+    for(size_t i = 0; i < dependencyCount; ++i)
+    {
+        // Only earlier tasks can be depended on, which also rules out cycles.
+        assert(dependencies[i] < id);
+        mTasks[dependencies[i]].Dependents.push_back(id);
+    }
+
+    // Run() hands out ids from here without allocating.
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mReady.reserve(mTasks.size());
+    }
+
+    return id;
+}
+
+void TaskGraph::Run()
+{
+    if(mTasks.empty())
+        return;
+
+    if(mSingleThreaded || mWorkers.empty())
+    {
+        for(TaskId id = 0; id < (TaskId)mTasks.size(); ++id)
+        {
+            ZoneScopedN("Task");
+            ZoneName(mTasks[id].Name, std::strlen(mTasks[id].Name));
+            mTasks[id].Func();
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        mRemaining = (uint32_t)mTasks.size();
+        mFirstError = nullptr;
+        mReady.clear();
+
+        for(TaskId id = 0; id < (TaskId)mTasks.size(); ++id)
+        {
+            mTasks[id].Pending = mTasks[id].DependencyCount;
+            if(mTasks[id].Pending == 0)
+                mReady.push_back(id);
+        }
+
+        // Pop from the back, so keep the earliest roots there.
+        std::reverse(mReady.begin(), mReady.end());
+    }
+    mCondition.notify_all();
+
+    // Help out until the whole graph is done.
+    for(;;)
+    {
+        TaskId id;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]{ return !mReady.empty() || mRemaining == 0; });
+            if(mRemaining == 0)
+                break;
+
+            id = mReady.back();
+            mReady.pop_back();
+        }
+        Execute(id);
+    }
+
+    if(mFirstError)
+        std::rethrow_exception(mFirstError);
+}
+
+void TaskGraph::WorkerLoop(uint32_t workerIndex)
+{
+    char threadName[32];
+    std::snprintf(threadName, sizeof(threadName), "TaskGraph worker %u", workerIndex);
+    tracy::SetThreadName(threadName);
+
+    for(;;)
+    {
+        TaskId id;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]{ return mQuit || !mReady.empty(); });
+            if(mQuit)
+                return;
+
+            id = mReady.back();
+            mReady.pop_back();
+        }
+        Execute(id);
+    }
+}
+
+void TaskGraph::Execute(TaskId id)
+{
+    Task& task = mTasks[id];
+
+    try
+    {
+        ZoneScopedN("Task");
+        ZoneName(task.Name, std::strlen(task.Name));
+        task.Func();
+    }
+    catch(...)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if(!mFirstError)
+            mFirstError = std::current_exception();
+    }
+
+    Finish(id);
+}
+
+void TaskGraph::Finish(TaskId id)
+{
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // Dependents still run after a failure so the graph always drains.
+        for(TaskId dependent : mTasks[id].Dependents)
+        {
+            if(--mTasks[dependent].Pending == 0)
+            {
+                mReady.push_back(dependent);
+                wake = true;
+            }
+        }
+
+        if(--mRemaining == 0)
+            wake = true;
+    }
+
+    if(wake)
+        mCondition.notify_all();
+}
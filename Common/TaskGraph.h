@@ -0,0 +1,92 @@
+//***************************************************************************************
+// TaskGraph.h
+//
+// Small dependency-graph scheduler for per-frame CPU work.
+//   -The graph is built once: AddTask() with the ids of the tasks it must wait for.
+//    A task may only depend on tasks added before it, so insertion order is always
+//    a valid execution order.
+//   -Run() executes every task once on a pool of worker threads (the calling thread
+//    helps) and returns when all of them are done.  The first exception thrown by a
+//    task is rethrown from Run().
+//   -In single-threaded mode Run() executes the tasks in insertion order on the
+//    calling thread, which gives a deterministic order for debugging.
+//   -AddParallelFor() splits an index range over several tasks, for stages whose
+//    items are independent of each other.
+//   -Each task gets a Tracy zone named after it.
+//***************************************************************************************
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskGraph
+{
+public:
+    typedef uint32_t TaskId;
+
+    // workerCount == 0 picks one less than the number of hardware threads.
+    explicit TaskGraph(uint32_t workerCount = 0);
+    TaskGraph(const TaskGraph& rhs) = delete;
+    TaskGraph& operator=(const TaskGraph& rhs) = delete;
+    ~TaskGraph();
+
+    // 'name' must outlive the graph (string literals are fine); it labels the Tracy zone.
+    TaskId AddTask(const char* name, std::function<void()> func,
+        std::initializer_list<TaskId> dependencies = {});
+    TaskId AddTask(const char* name, std::function<void()> func,
+        const std::vector<TaskId>& dependencies);
+
+    // Adds up to batchCount tasks that together call func(begin, end) over [0, count).
+    // batchCount == 0 uses one batch per thread (workers plus the caller).  Returns
+    // the ids of the batches so later tasks can wait for all of them.
+    std::vector<TaskId> AddParallelFor(const char* name, uint32_t count, uint32_t batchCount,
+        std::function<void(uint32_t begin, uint32_t end)> func,
+        std::initializer_list<TaskId> dependencies = {});
+
+    void Run();
+
+    void SetSingleThreaded(bool singleThreaded) { mSingleThreaded = singleThreaded; }
+    bool IsSingleThreaded()const { return mSingleThreaded; }
+
+    uint32_t WorkerCount()const { return (uint32_t)mWorkers.size(); }
+
+private:
+    struct Task
+    {
+        const char* Name = nullptr;
+        std::function<void()> Func;
+        std::vector<TaskId> Dependents;
+        uint32_t DependencyCount = 0;
+
+        // Dependencies not finished yet in the current Run().
+        uint32_t Pending = 0;
+    };
+
+    TaskId AddTaskImpl(const char* name, std::function<void()> func,
+        const TaskId* dependencies, size_t dependencyCount);
+
+    void WorkerLoop(uint32_t workerIndex);
+    void Execute(TaskId id);
+    void Finish(TaskId id);
+
+private:
+    std::vector<Task> mTasks;
+    bool mSingleThreaded = false;
+
+    std::vector<std::thread> mWorkers;
+
+    // Everything below is guarded by mMutex.
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::vector<TaskId> mReady;
+    uint32_t mRemaining = 0;
+    std::exception_ptr mFirstError;
+    bool mQuit = false;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "d3dUtil.h"
+#include "UploadRing.h"
 
 template<typename T>
 class UploadBuffer
@@ -61,4 +62,47 @@ private:
 
     UINT mElementByteSize = 0;
     bool mIsConstantBuffer = false;
-};
\ No newline at end of file
+};
+
+// Upload heap buffer that stays mapped for its whole lifetime, for use by an UploadRing.
+class UploadHeapRingBacking : public IUploadRingBacking
+{
+public:
+    UploadHeapRingBacking(ID3D12Device* device, UINT64 byteSize)
+        : mByteSize(byteSize)
+    {
+        ThrowIfFailed(device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&mUploadBuffer)));
+
+        ThrowIfFailed(mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMappedData)));
+    }
+
+    UploadHeapRingBacking(const UploadHeapRingBacking& rhs) = delete;
+    UploadHeapRingBacking& operator=(const UploadHeapRingBacking& rhs) = delete;
+    ~UploadHeapRingBacking()
+    {
+        if(mUploadBuffer != nullptr)
+            mUploadBuffer->Unmap(0, nullptr);
+
+        mMappedData = nullptr;
+    }
+
+    virtual uint8_t* MappedData()override { return mMappedData; }
+    virtual uint64_t GpuAddress()const override { return mUploadBuffer->GetGPUVirtualAddress(); }
+    virtual uint64_t Size()const override { return mByteSize; }
+
+    ID3D12Resource* Resource()const
+    {
+        return mUploadBuffer.Get();
+    }
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
+    uint8_t* mMappedData = nullptr;
+    UINT64 mByteSize = 0;
+};
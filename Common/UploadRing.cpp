@@ -0,0 +1,110 @@
+//***************************************************************************************
+// UploadRing.cpp
+//***************************************************************************************
+
+#include "UploadRing.h"
+
+#include <algorithm>
+#include <cassert>
+
+UploadRing::UploadRing(std::unique_ptr<IUploadRingBacking> backing)
+    : mBacking(std::move(backing))
+{
+    mMappedData = mBacking->MappedData();
+    mGpuAddress = mBacking->GpuAddress();
+    mSize = mBacking->Size();
+
+    assert(mSize % ConstantBufferAlignment == 0);
+}
+
+UploadAllocation UploadRing::Allocate(uint64_t size, uint64_t alignment)
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && mSize % alignment == 0);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    UploadAllocation alloc;
+    if(size == 0 || size > mSize)
+    {
+        ++mFailedAllocations;
+        return alloc;
+    }
+
+    // Nothing in flight: start over at offset 0 so large blocks do not need to wrap.
+    if(mHead == mTail && mFrameCount == 0)
+    {
+        mHead = 0;
+        mTail = 0;
+    }
+
+    // Align the head.  Because the ring size is a multiple of the alignment, an aligned
+    // counter is also an aligned offset.
+    uint64_t head = (mHead + alignment - 1) & ~(alignment - 1);
+
+    // A block may not wrap around the end of the ring; skip to the start instead.
+    uint64_t offset = head % mSize;
+    if(offset + size > mSize)
+    {
+        head += mSize - offset;
+        offset = 0;
+    }
+
+    if(head + size - mTail > mSize)
+    {
+        ++mFailedAllocations;
+        return alloc;
+    }
+
+    mHead = head + size;
+    mHighWaterMark = std::max(mHighWaterMark, mHead - mTail);
+
+    alloc.CpuAddress = mMappedData + offset;
+    alloc.GpuAddress = mGpuAddress + offset;
+    alloc.Offset = offset;
+    alloc.Size = size;
+    return alloc;
+}
+
+void UploadRing::FinishFrame(uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if(mFrameCount == MaxFramesInFlight)
+    {
+        // More frames in flight than we track; fold the newest into the previous marker.
+        // That only delays when its memory comes back.
+        FrameMarker& last = mFrames[(mFirstFrame + mFrameCount - 1) % MaxFramesInFlight];
+        last.FenceValue = fenceValue;
+        last.Head = mHead;
+        return;
+    }
+
+    FrameMarker& marker = mFrames[(mFirstFrame + mFrameCount) % MaxFramesInFlight];
+    marker.FenceValue = fenceValue;
+    marker.Head = mHead;
+    ++mFrameCount;
+}
+
+void UploadRing::Retire(uint64_t completedFenceValue)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    while(mFrameCount > 0 && mFrames[mFirstFrame].FenceValue <= completedFenceValue)
+    {
+        mTail = mFrames[mFirstFrame].Head;
+        mFirstFrame = (mFirstFrame + 1) % MaxFramesInFlight;
+        --mFrameCount;
+    }
+}
+
+UploadRingStats UploadRing::GetStats()const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    UploadRingStats stats;
+    stats.Capacity = mSize;
+    stats.BytesInFlight = mHead - mTail;
+    stats.HighWaterMark = mHighWaterMark;
+    stats.FailedAllocations = mFailedAllocations;
+    return stats;
+}
@@ -0,0 +1,145 @@
+//***************************************************************************************
+// UploadRing.h
+//
+// Ring suballocator for per-frame upload data (constant buffers, structured buffers).
+//   -The memory itself comes from an IUploadRingBacking: an upload heap on D3D12
+//    (see UploadHeapRingBacking in UploadBuffer.h) or plain CPU memory for tests.
+//   -Allocations are aligned (256 bytes by default, as constant buffer views require)
+//    and never straddle the end of the ring.
+//   -FinishFrame() tags everything allocated so far with a fence value; Retire() frees
+//    the frames whose fence the GPU has passed.
+//   -All methods are thread safe, so update tasks can allocate concurrently.
+//
+// This file has no D3D12 dependency so the offset management can be exercised on its own.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+// Persistently mapped memory an UploadRing suballocates from.
+class IUploadRingBacking
+{
+public:
+    virtual ~IUploadRingBacking() = default;
+
+    virtual uint8_t* MappedData() = 0;
+
+    // GPU virtual address of MappedData()[0].
+    virtual uint64_t GpuAddress()const = 0;
+
+    virtual uint64_t Size()const = 0;
+};
+
+// Host memory backing with a made-up GPU base address.
+class CpuUploadRingBacking : public IUploadRingBacking
+{
+public:
+    CpuUploadRingBacking(uint64_t size, uint64_t fakeGpuAddress = 0x100000000ull)
+        : mData(new uint8_t[size]), mSize(size), mGpuAddress(fakeGpuAddress)
+    {
+    }
+
+    virtual uint8_t* MappedData()override { return mData.get(); }
+    virtual uint64_t GpuAddress()const override { return mGpuAddress; }
+    virtual uint64_t Size()const override { return mSize; }
+
+private:
+    std::unique_ptr<uint8_t[]> mData;
+    uint64_t mSize = 0;
+    uint64_t mGpuAddress = 0;
+};
+
+struct UploadAllocation
+{
+    uint8_t* CpuAddress = nullptr;
+    uint64_t GpuAddress = 0;
+
+    // Offset from the start of the backing.
+    uint64_t Offset = 0;
+    uint64_t Size = 0;
+
+    bool IsValid()const { return CpuAddress != nullptr; }
+};
+
+struct UploadRingStats
+{
+    uint64_t Capacity = 0;
+    uint64_t BytesInFlight = 0;
+    uint64_t HighWaterMark = 0;
+    uint32_t FailedAllocations = 0;
+};
+
+class UploadRing
+{
+public:
+    static const uint64_t ConstantBufferAlignment = 256;
+
+    explicit UploadRing(std::unique_ptr<IUploadRingBacking> backing);
+    UploadRing(const UploadRing& rhs) = delete;
+    UploadRing& operator=(const UploadRing& rhs) = delete;
+
+    // Returns an invalid allocation if the ring does not have 'size' free bytes.
+    // 'alignment' must be a power of two that divides the ring size.
+    UploadAllocation Allocate(uint64_t size, uint64_t alignment = ConstantBufferAlignment);
+
+    // Room for 'count' elements of T, each padded to 'stride' bytes (0 means sizeof(T)).
+    template<typename T>
+    UploadAllocation AllocateArray(uint64_t count, uint64_t stride = 0,
+        uint64_t alignment = ConstantBufferAlignment)
+    {
+        if(stride == 0)
+            stride = sizeof(T);
+        return Allocate(count*stride, alignment);
+    }
+
+    // Everything allocated since the previous call belongs to the frame that will
+    // signal 'fenceValue'.
+    void FinishFrame(uint64_t fenceValue);
+
+    // Releases all frames whose fence value is <= completedFenceValue.
+    void Retire(uint64_t completedFenceValue);
+
+    UploadRingStats GetStats()const;
+
+    IUploadRingBacking* Backing()const { return mBacking.get(); }
+
+private:
+    // Fence values of frames still in flight, with the ring head at their end.
+    struct FrameMarker
+    {
+        uint64_t FenceValue;
+        uint64_t Head;
+    };
+
+    static const uint32_t MaxFramesInFlight = 16;
+
+    mutable std::mutex mMutex;
+
+    std::unique_ptr<IUploadRingBacking> mBacking;
+    uint8_t* mMappedData = nullptr;
+    uint64_t mGpuAddress = 0;
+    uint64_t mSize = 0;
+
+    // Monotonic byte counters; the ring offset is counter % mSize.
+    uint64_t mHead = 0;
+    uint64_t mTail = 0;
+
+    FrameMarker mFrames[MaxFramesInFlight];
+    uint32_t mFirstFrame = 0;
+    uint32_t mFrameCount = 0;
+
+    uint64_t mHighWaterMark = 0;
+    uint32_t mFailedAllocations = 0;
+};
+
+// Copies 'data' into element 'index' of an allocation laid out 'stride' bytes per element.
+template<typename T>
+inline void CopyToUpload(const UploadAllocation& alloc, uint64_t index, const T& data, uint64_t stride = sizeof(T))
+{
+    std::memcpy(alloc.CpuAddress + index*stride, &data, sizeof(T));
+}
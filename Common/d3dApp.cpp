@@ -355,6 +355,12 @@ LRESULT D3DApp::MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         }
         else if((int)wParam == VK_F2)
             Set4xMsaaState(!m4xMsaaState);
+        else if((int)wParam == VK_F3)
+        {
+            auto& monitor = myengine::audio::Audio::Instance().ResourceMonitor();
+            monitor.DumpCsv("audio_resources.csv");
+            monitor.DumpJson("audio_resources.json");
+        }
 
         return 0;
 	}
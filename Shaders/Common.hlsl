@@ -18,6 +18,9 @@
 // Include structures and functions for lighting.
 #include "LightingUtil.hlsl"
 
+// Must match MaxShadowCascades in CascadedShadows.h.
+#define MaxShadowCascades 4
+
 struct MaterialData
 {
 	float4   DiffuseAlbedo;
@@ -77,7 +80,6 @@ cbuffer cbPass : register(b2)
     float4x4 gViewProj;
     float4x4 gInvViewProj;
     float4x4 gViewProjTex;
-    float4x4 gShadowTransform;
     float3 gEyePosW;
     float cbPerObjectPad1;
     float2 gRenderTargetSize;
@@ -93,6 +95,15 @@ cbuffer cbPass : register(b2)
     // indices [NUM_DIR_LIGHTS+NUM_POINT_LIGHTS, NUM_DIR_LIGHTS+NUM_POINT_LIGHT+NUM_SPOT_LIGHTS)
     // are spot lights for a maximum of MaxLights per object.
     Light gLights[MaxLights];
+
+    // The cascades share gShadowMap as a 2x2 atlas; these already include the
+    // offset and scale into each cascade's quarter.
+    float4x4 gCascadeShadowTransforms[MaxShadowCascades];
+    float4 gCascadeSplits;
+    uint gCascadeCount;
+    uint gCascadePad0;
+    uint gCascadePad1;
+    uint gCascadePad2;
 };
 
 //---------------------------------------------------------------------------------------
@@ -153,3 +164,27 @@ float CalcShadowFactor(float4 shadowPosH)
     return percentLit / 9.0f;
 }
 
+//---------------------------------------------------------------------------------------
+// Picks the cascade by view-space depth and does PCF in it.  The cascades are fitted
+// with bounding spheres, so receivers stay clear of the atlas tile borders.
+//---------------------------------------------------------------------------------------
+float CalcCascadedShadowFactor(float3 posW)
+{
+    float viewDepth = mul(float4(posW, 1.0f), gView).z;
+
+    uint cascade = 0;
+    [unroll]
+    for(uint i = 0; i < MaxShadowCascades - 1; ++i)
+    {
+        if(i + 1 < gCascadeCount && viewDepth > gCascadeSplits[i])
+            cascade = i + 1;
+    }
+
+    // No shadows past the last cascade.
+    if(cascade >= gCascadeCount || viewDepth > gCascadeSplits[cascade])
+        return 1.0f;
+
+    float4 shadowPosH = mul(float4(posW, 1.0f), gCascadeShadowTransforms[cascade]);
+    return CalcShadowFactor(shadowPosH);
+}
+
@@ -51,6 +51,9 @@ bool SkinnedMeshApp::Initialize()
     mShadowMap = std::make_unique<ShadowMap>(md3dDevice.Get(),
         2048, 2048);
 
+    // The cascades share the shadow map as a 2x2 atlas.
+    mCascadeSettings.Resolution = mShadowMap->Width() / 2;
+
     mSsao = std::make_unique<Ssao>(
         md3dDevice.Get(),
         mCommandList.Get(),
@@ -65,7 +68,9 @@ bool SkinnedMeshApp::Initialize()
     BuildShapeGeometry();
 	BuildMaterials();
     BuildRenderItems();
+    BuildAudioEmitters();
     BuildFrameResources();
+    BuildUpdateTasks();
     BuildPSOs();
 
     mSsao->SetPSOs(mPSOs["ssao"].Get(), mPSOs["ssaoBlur"].Get());
@@ -108,6 +113,13 @@ void SkinnedMeshApp::OnResize()
 
 	mCamera.SetLens(0.25f*MathHelper::Pi, AspectRatio(), 1.0f, 1000.0f);
 
+    ClusterGridDesc clusterGrid;
+    clusterGrid.FovY = mCamera.GetFovY();
+    clusterGrid.Aspect = mCamera.GetAspect();
+    clusterGrid.NearZ = mCamera.GetNearZ();
+    clusterGrid.FarZ = mCamera.GetFarZ();
+    mLightClusters.SetGrid(clusterGrid);
+
     if(mSsao != nullptr)
     {
         mSsao->OnResize(mClientWidth, mClientHeight);
@@ -137,6 +149,12 @@ void SkinnedMeshApp::Update(const GameTimer& gt)
         CloseHandle(eventHandle);
     }
 
+    // The GPU is done with this frame resource, so its transient CPU memory is free again.
+    mCurrFrameResource->FrameAlloc->Reset();
+    mCurrFrameResource->Uploads->Retire(mFence->GetCompletedValue());
+    TracyPlot("FrameAlloc high water (bytes)", (int64_t)mCurrFrameResource->FrameAlloc->GetStats().HighWaterMark);
+    TracyPlot("Upload ring high water (bytes)", (int64_t)mCurrFrameResource->Uploads->GetStats().HighWaterMark);
+
     //
     // Animate the lights (and hence shadows).
     //
@@ -151,14 +169,12 @@ void SkinnedMeshApp::Update(const GameTimer& gt)
         XMStoreFloat3(&mRotatedLightDirections[i], lightDir);
     }
  
-	AnimateMaterials(gt);
-	UpdateObjectCBs(gt);
-    UpdateSkinnedCBs(gt);
-	UpdateMaterialBuffer(gt);
-    UpdateShadowTransform(gt);
-	UpdateMainPassCB(gt);
-    UpdateShadowPassCB(gt);
-    UpdateSsaoCB(gt);
+    mUpdateTimer = &gt;
+    mUpdateTasks->SetSingleThreaded(mSingleThreadedUpdate);
+    mUpdateTasks->Run();
+    mUpdateTimer = nullptr;
+
+    SyncAudioTransforms();
     FrameMarkEnd("test");
 }
 
@@ -185,8 +201,7 @@ void SkinnedMeshApp::Draw(const GameTimer& gt)
 
     // Bind all the materials used in this scene.  For structured buffers, we can bypass the heap and 
     // set as a root descriptor.
-    auto matBuffer = mCurrFrameResource->MaterialBuffer->Resource();
-    mCommandList->SetGraphicsRootShaderResourceView(3, matBuffer->GetGPUVirtualAddress());
+    mCommandList->SetGraphicsRootShaderResourceView(3, mCurrFrameResource->MaterialBuffer);
 	
     // Bind null SRV for shadow map pass.
     mCommandList->SetGraphicsRootDescriptorTable(4, mNullSrv);	 
@@ -221,8 +236,7 @@ void SkinnedMeshApp::Draw(const GameTimer& gt)
 
     // Bind all the materials used in this scene.  For structured buffers, we can bypass the heap and 
     // set as a root descriptor.
-    matBuffer = mCurrFrameResource->MaterialBuffer->Resource();
-    mCommandList->SetGraphicsRootShaderResourceView(3, matBuffer->GetGPUVirtualAddress());
+    mCommandList->SetGraphicsRootShaderResourceView(3, mCurrFrameResource->MaterialBuffer);
 
 
     mCommandList->RSSetViewports(1, &mScreenViewport);
@@ -244,8 +258,7 @@ void SkinnedMeshApp::Draw(const GameTimer& gt)
     // The root signature knows how many descriptors are expected in the table.
     mCommandList->SetGraphicsRootDescriptorTable(5, mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
 	
-    auto passCB = mCurrFrameResource->PassCB->Resource();
-	mCommandList->SetGraphicsRootConstantBufferView(2, passCB->GetGPUVirtualAddress());
+	mCommandList->SetGraphicsRootConstantBufferView(2, mCurrFrameResource->PassCB);
 
     // Bind the sky cube map.  For our demos, we just use one "world" cube map representing the environment
     // from far away, so all objects will use the same cube map and we only need to set it once per-frame.  
@@ -288,6 +301,7 @@ void SkinnedMeshApp::Draw(const GameTimer& gt)
 
     // Advance the fence value to mark commands up to this fence point.
     mCurrFrameResource->Fence = ++mCurrentFence;
+    mCurrFrameResource->Uploads->FinishFrame(mCurrentFence);
 
     // Add an instruction to the command queue to set a new fence point. 
     // Because we are on the GPU timeline, the new fence point won't be 
@@ -352,26 +366,22 @@ void SkinnedMeshApp::UpdateObjectCBs(const GameTimer& gt)
 {
     static constexpr tracy::SourceLocationData __tracy_source_location350{ nullptr, __FUNCTION__, "C:\\Users\\tao\\Desktop\\WwiseDemo\\SkinnedMeshApp.cpp", (uint32_t)350, 0 }; 
     tracy::ScopedZone ___tracy_scoped_zone(&__tracy_source_location350, true);
-	auto currObjectCB = mCurrFrameResource->ObjectCB.get();
+    UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
+    UploadAllocation currObjectCB = AllocateFrameUpload((UINT64)mAllRitems.size()*objCBByteSize);
+    mCurrFrameResource->ObjectCB = currObjectCB.GpuAddress;
+
+	// The constants live in fresh ring memory every frame, so every item is written.
 	for(auto& e : mAllRitems)
 	{
-		// Only update the cbuffer data if the constants have changed.  
-		// This needs to be tracked per frame resource.
-		if(e->NumFramesDirty > 0)
-		{
-            XMMATRIX world = XMLoadFloat4x4(&e->World);
-            XMMATRIX texTransform = XMLoadFloat4x4(&e->TexTransform);
-
-            ObjectConstants objConstants;
-            XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
-            XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(texTransform));
-            objConstants.MaterialIndex = e->Mat->MatCBIndex;
-
-            currObjectCB->CopyData(e->ObjCBIndex, objConstants);
-
-			// Next FrameResource need to be updated too.
-			e->NumFramesDirty--;
-		}
+        XMMATRIX world = XMLoadFloat4x4(&e->World);
+        XMMATRIX texTransform = XMLoadFloat4x4(&e->TexTransform);
+
+        ObjectConstants objConstants;
+        XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
+        XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(texTransform));
+        objConstants.MaterialIndex = e->Mat->MatCBIndex;
+
+        CopyToUpload(currObjectCB, e->ObjCBIndex, objConstants, objCBByteSize);
 	}
 }
 
@@ -417,11 +427,12 @@ XMFLOAT4 ScalarMultiply(const XMFLOAT4& vec, float scalar) {
 void SkinnedMeshApp::UpdateSkinnedCBs(const GameTimer& gt)
 {
 	// We only have one skinned model being animated.
-	mSkinnedModelInst->UpdateSkinnedAnimation(gt.DeltaTime());
+	mSkinnedModelInst->UpdateSkinnedAnimation(gt.DeltaTime(), *mCurrFrameResource->FrameAlloc);
     auto& boneTrans = mSkinnedModelInst->FinalTransforms();
     if (GPUSkin)
     {
-		auto currSkinnedCB = mCurrFrameResource->SkinnedCB.get();
+		UploadAllocation currSkinnedCB = AllocateFrameUpload(d3dUtil::CalcConstantBufferByteSize(sizeof(SkinnedConstants)));
+		mCurrFrameResource->SkinnedCB = currSkinnedCB.GpuAddress;
 			
 		SkinnedConstants skinnedConstants;
 		std::copy(
@@ -429,13 +440,12 @@ void SkinnedMeshApp::UpdateSkinnedCBs(const GameTimer& gt)
 			std::end(mSkinnedModelInst->FinalTransforms()),
 			&skinnedConstants.BoneTransforms[0]);
 
-		currSkinnedCB->CopyData(0, skinnedConstants);
+		CopyToUpload(currSkinnedCB, 0, skinnedConstants);
     }
     else
     {
         // cpu skin
         auto& geo = mGeometries[mSkinnedModelFilename];
-        auto vertices = geo->vertices;
         for (int i = 0; i < geo->vertices.size(); i++)
         {
             auto& vertex = geo->vertices[i];
@@ -471,70 +481,42 @@ void SkinnedMeshApp::UpdateSkinnedCBs(const GameTimer& gt)
  
 void SkinnedMeshApp::UpdateMaterialBuffer(const GameTimer& gt)
 {
-	auto currMaterialBuffer = mCurrFrameResource->MaterialBuffer.get();
+	UploadAllocation currMaterialBuffer = AllocateFrameUpload((UINT64)mMaterials.size()*sizeof(MaterialData));
+	mCurrFrameResource->MaterialBuffer = currMaterialBuffer.GpuAddress;
+
+	// The structured buffer is rebuilt in fresh ring memory every frame.
 	for(auto& e : mMaterials)
 	{
-		// Only update the cbuffer data if the constants have changed.  If the cbuffer
-		// data changes, it needs to be updated for each FrameResource.
 		Material* mat = e.second.get();
-		if(mat->NumFramesDirty > 0)
-		{
-			XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
-
-			MaterialData matData;
-			matData.DiffuseAlbedo = mat->DiffuseAlbedo;
-			matData.FresnelR0 = mat->FresnelR0;
-			matData.Roughness = mat->Roughness;
-			XMStoreFloat4x4(&matData.MatTransform, XMMatrixTranspose(matTransform));
-			matData.DiffuseMapIndex = mat->DiffuseSrvHeapIndex;
-			matData.NormalMapIndex = mat->NormalSrvHeapIndex;
-
-			currMaterialBuffer->CopyData(mat->MatCBIndex, matData);
-
-			// Next FrameResource need to be updated too.
-			mat->NumFramesDirty--;
-		}
+		XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
+
+		MaterialData matData;
+		matData.DiffuseAlbedo = mat->DiffuseAlbedo;
+		matData.FresnelR0 = mat->FresnelR0;
+		matData.Roughness = mat->Roughness;
+		XMStoreFloat4x4(&matData.MatTransform, XMMatrixTranspose(matTransform));
+		matData.DiffuseMapIndex = mat->DiffuseSrvHeapIndex;
+		matData.NormalMapIndex = mat->NormalSrvHeapIndex;
+
+		CopyToUpload(currMaterialBuffer, mat->MatCBIndex, matData);
 	}
 }
 
 void SkinnedMeshApp::UpdateShadowTransform(const GameTimer& gt)
 {
-    // Only the first "main" light casts a shadow.
-    XMVECTOR lightDir = XMLoadFloat3(&mRotatedLightDirections[0]);
-    XMVECTOR lightPos = -2.0f*mSceneBounds.Radius*lightDir;
-    XMVECTOR targetPos = XMLoadFloat3(&mSceneBounds.Center);
-    XMVECTOR lightUp = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-    XMMATRIX lightView = XMMatrixLookAtLH(lightPos, targetPos, lightUp);
-
-    XMStoreFloat3(&mLightPosW, lightPos);
-
-    // Transform bounding sphere to light space.
-    XMFLOAT3 sphereCenterLS;
-    XMStoreFloat3(&sphereCenterLS, XMVector3TransformCoord(targetPos, lightView));
-
-    // Ortho frustum in light space encloses scene.
-    float l = sphereCenterLS.x - mSceneBounds.Radius;
-    float b = sphereCenterLS.y - mSceneBounds.Radius;
-    float n = sphereCenterLS.z - mSceneBounds.Radius;
-    float r = sphereCenterLS.x + mSceneBounds.Radius;
-    float t = sphereCenterLS.y + mSceneBounds.Radius;
-    float f = sphereCenterLS.z + mSceneBounds.Radius;
-
-    mLightNearZ = n;
-    mLightFarZ = f;
-    XMMATRIX lightProj = XMMatrixOrthographicOffCenterLH(l, r, b, t, n, f);
-
-    // Transform NDC space [-1,+1]^2 to texture space [0,1]^2
-    XMMATRIX T(
-        0.5f, 0.0f, 0.0f, 0.0f,
-        0.0f, -0.5f, 0.0f, 0.0f,
-        0.0f, 0.0f, 1.0f, 0.0f,
-        0.5f, 0.5f, 0.0f, 1.0f);
-
-    XMMATRIX S = lightView*lightProj*T;
-    XMStoreFloat4x4(&mLightView, lightView);
-    XMStoreFloat4x4(&mLightProj, lightProj);
-    XMStoreFloat4x4(&mShadowTransform, S);
+    XMMATRIX view = mCamera.GetView();
+
+    CascadeCameraDesc camera;
+    XMStoreFloat4x4(&camera.InvView, XMMatrixInverse(&XMMatrixDeterminant(view), view));
+    camera.FovY = mCamera.GetFovY();
+    camera.Aspect = mCamera.GetAspect();
+    camera.NearZ = mCamera.GetNearZ();
+    camera.FarZ = mCamera.GetFarZ();
+
+    // Only the first "main" light casts a shadow.  The shadow direction lags the
+    // rotating light by up to the cache's angle threshold, so cached cascades stay usable.
+    XMFLOAT3 lightDir = mShadowCache.SelectLightDirection(mRotatedLightDirections[0]);
+    ComputeShadowCascades(camera, lightDir, mSceneBounds, mCascadeSettings, mCascades);
 }
 
 void SkinnedMeshApp::UpdateMainPassCB(const GameTimer& gt)
@@ -555,7 +537,6 @@ void SkinnedMeshApp::UpdateMainPassCB(const GameTimer& gt)
         0.5f, 0.5f, 0.0f, 1.0f);
 
     XMMATRIX viewProjTex = XMMatrixMultiply(viewProj, T);
-    XMMATRIX shadowTransform = XMLoadFloat4x4(&mShadowTransform);
 
 	XMStoreFloat4x4(&mMainPassCB.View, XMMatrixTranspose(view));
 	XMStoreFloat4x4(&mMainPassCB.InvView, XMMatrixTranspose(invView));
@@ -564,7 +545,6 @@ void SkinnedMeshApp::UpdateMainPassCB(const GameTimer& gt)
 	XMStoreFloat4x4(&mMainPassCB.ViewProj, XMMatrixTranspose(viewProj));
 	XMStoreFloat4x4(&mMainPassCB.InvViewProj, XMMatrixTranspose(invViewProj));
     XMStoreFloat4x4(&mMainPassCB.ViewProjTex, XMMatrixTranspose(viewProjTex));
-    XMStoreFloat4x4(&mMainPassCB.ShadowTransform, XMMatrixTranspose(shadowTransform));
 	mMainPassCB.EyePosW = mCamera.GetPosition3f();
 	mMainPassCB.RenderTargetSize = XMFLOAT2((float)mClientWidth, (float)mClientHeight);
 	mMainPassCB.InvRenderTargetSize = XMFLOAT2(1.0f / mClientWidth, 1.0f / mClientHeight);
@@ -579,38 +559,175 @@ void SkinnedMeshApp::UpdateMainPassCB(const GameTimer& gt)
 	mMainPassCB.Lights[1].Strength = { 0.4f, 0.4f, 0.4f };
 	mMainPassCB.Lights[2].Direction = mRotatedLightDirections[2];
 	mMainPassCB.Lights[2].Strength = { 0.2f, 0.2f, 0.2f };
+
+    // Cascade i lives in quarter (i%2, i/2) of the shadow map.
+    float splits[MaxShadowCascades] = { 0.0f };
+    for(UINT i = 0; i < mCascadeSettings.CascadeCount; ++i)
+    {
+        XMMATRIX toAtlas = XMMatrixScaling(0.5f, 0.5f, 1.0f) *
+            XMMatrixTranslation(0.5f*(i % 2), 0.5f*(i / 2), 0.0f);
+        XMMATRIX cascadeTransform = XMLoadFloat4x4(&mCascades[i].ShadowTransform) * toAtlas;
+        XMStoreFloat4x4(&mMainPassCB.CascadeShadowTransforms[i], XMMatrixTranspose(cascadeTransform));
+        splits[i] = mCascades[i].SplitFar;
+    }
+    mMainPassCB.CascadeSplits = XMFLOAT4(splits);
+    mMainPassCB.CascadeCount = mCascadeSettings.CascadeCount;
  
-	auto currPassCB = mCurrFrameResource->PassCB.get();
-	currPassCB->CopyData(0, mMainPassCB);
+	UploadAllocation currPassCB = AllocateFrameUpload(d3dUtil::CalcConstantBufferByteSize(sizeof(PassConstants)));
+	mCurrFrameResource->PassCB = currPassCB.GpuAddress;
+	CopyToUpload(currPassCB, 0, mMainPassCB);
 }
 
 void SkinnedMeshApp::UpdateShadowPassCB(const GameTimer& gt)
 {
-    XMMATRIX view = XMLoadFloat4x4(&mLightView);
-    XMMATRIX proj = XMLoadFloat4x4(&mLightProj);
-
-    XMMATRIX viewProj = XMMatrixMultiply(view, proj);
-    XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(view), view);
-    XMMATRIX invProj = XMMatrixInverse(&XMMatrixDeterminant(proj), proj);
-    XMMATRIX invViewProj = XMMatrixInverse(&XMMatrixDeterminant(viewProj), viewProj);
-
-    UINT w = mShadowMap->Width();
-    UINT h = mShadowMap->Height();
-
-    XMStoreFloat4x4(&mShadowPassCB.View, XMMatrixTranspose(view));
-    XMStoreFloat4x4(&mShadowPassCB.InvView, XMMatrixTranspose(invView));
-    XMStoreFloat4x4(&mShadowPassCB.Proj, XMMatrixTranspose(proj));
-    XMStoreFloat4x4(&mShadowPassCB.InvProj, XMMatrixTranspose(invProj));
-    XMStoreFloat4x4(&mShadowPassCB.ViewProj, XMMatrixTranspose(viewProj));
-    XMStoreFloat4x4(&mShadowPassCB.InvViewProj, XMMatrixTranspose(invViewProj));
-    mShadowPassCB.EyePosW = mLightPosW;
-    mShadowPassCB.RenderTargetSize = XMFLOAT2((float)w, (float)h);
-    mShadowPassCB.InvRenderTargetSize = XMFLOAT2(1.0f / w, 1.0f / h);
-    mShadowPassCB.NearZ = mLightNearZ;
-    mShadowPassCB.FarZ = mLightFarZ;
-
-    auto currPassCB = mCurrFrameResource->PassCB.get();
-    currPassCB->CopyData(1, mShadowPassCB);
+    UINT passCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(PassConstants));
+    UINT cascadeCount = mCascadeSettings.CascadeCount;
+
+    // One pass per cascade, back to back.
+    UploadAllocation currPassCB = AllocateFrameUpload((UINT64)cascadeCount*passCBByteSize);
+    mCurrFrameResource->ShadowPassCB = currPassCB.GpuAddress;
+
+    UINT w = mCascadeSettings.Resolution;
+    UINT h = mCascadeSettings.Resolution;
+
+    for(UINT i = 0; i < cascadeCount; ++i)
+    {
+        const ShadowCascade& cascade = mCascades[i];
+
+        XMMATRIX view = XMLoadFloat4x4(&cascade.LightView);
+        XMMATRIX proj = XMLoadFloat4x4(&cascade.LightProj);
+
+        XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+        XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(view), view);
+        XMMATRIX invProj = XMMatrixInverse(&XMMatrixDeterminant(proj), proj);
+        XMMATRIX invViewProj = XMMatrixInverse(&XMMatrixDeterminant(viewProj), viewProj);
+
+        XMStoreFloat4x4(&mShadowPassCB.View, XMMatrixTranspose(view));
+        XMStoreFloat4x4(&mShadowPassCB.InvView, XMMatrixTranspose(invView));
+        XMStoreFloat4x4(&mShadowPassCB.Proj, XMMatrixTranspose(proj));
+        XMStoreFloat4x4(&mShadowPassCB.InvProj, XMMatrixTranspose(invProj));
+        XMStoreFloat4x4(&mShadowPassCB.ViewProj, XMMatrixTranspose(viewProj));
+        XMStoreFloat4x4(&mShadowPassCB.InvViewProj, XMMatrixTranspose(invViewProj));
+        mShadowPassCB.EyePosW = cascade.LightPosW;
+        mShadowPassCB.RenderTargetSize = XMFLOAT2((float)w, (float)h);
+        mShadowPassCB.InvRenderTargetSize = XMFLOAT2(1.0f / w, 1.0f / h);
+        mShadowPassCB.NearZ = cascade.LightNearZ;
+        mShadowPassCB.FarZ = cascade.LightFarZ;
+
+        CopyToUpload(currPassCB, i, mShadowPassCB, passCBByteSize);
+    }
+}
+
+void SkinnedMeshApp::CullShadowCasters()
+{
+    const auto& opaque = mRitemLayer[(int)RenderLayer::Opaque];
+    const auto& skinned = mRitemLayer[(int)RenderLayer::SkinnedOpaque];
+
+    LinearAllocator& frameAlloc = *mCurrFrameResource->FrameAlloc;
+    uint32_t* visible = frameAlloc.AllocateArray<uint32_t>(std::max<size_t>(opaque.size(), skinned.size()));
+
+    for(UINT i = 0; i < mCascadeSettings.CascadeCount; ++i)
+    {
+        ShadowCascade& cascade = mCascades[i];
+        ShadowCasterList& casters = mShadowCasters[i];
+
+        // Cull against the receivers swept toward the light rather than the cascade's
+        // box, so casters behind the receivers are dropped too.
+        float opaqueNearZ, skinnedNearZ;
+        casters.OpaqueCount = CullShadowCastersExtruded(cascade, (uint32_t)opaque.size(),
+            [&opaque](uint32_t j) -> const BoundingBox& { return opaque[j]->Bounds; }, visible, &opaqueNearZ);
+        casters.Opaque = frameAlloc.AllocateArray<RenderItem*>(casters.OpaqueCount);
+        for(UINT j = 0; j < casters.OpaqueCount; ++j)
+            casters.Opaque[j] = opaque[visible[j]];
+
+        casters.SkinnedCount = CullShadowCastersExtruded(cascade, (uint32_t)skinned.size(),
+            [&skinned](uint32_t j) -> const BoundingBox& { return skinned[j]->Bounds; }, visible, &skinnedNearZ);
+        casters.Skinned = frameAlloc.AllocateArray<RenderItem*>(casters.SkinnedCount);
+        for(UINT j = 0; j < casters.SkinnedCount; ++j)
+            casters.Skinned[j] = skinned[visible[j]];
+
+        // Pull the near plane in to the nearest caster that survived, but never past
+        // the receivers themselves.
+        float casterNearZ = std::min(opaqueNearZ, skinnedNearZ);
+        float receiversNearZ = cascade.LightFarZ - 2.0f*cascade.ReceiverBounds.Radius;
+        float nearZ = std::max(cascade.LightNearZ, std::min(casterNearZ, receiversNearZ));
+        if(nearZ != cascade.LightNearZ)
+            SetCascadeDepthRange(cascade, nearZ, cascade.LightFarZ);
+    }
+
+    // Decide which cascades have to be re-rendered.  Skinned items animate every frame.
+    UINT casterCount = (UINT)(opaque.size() + skinned.size());
+    ShadowCasterState* casterStates = frameAlloc.AllocateArray<ShadowCasterState>(casterCount);
+    for(UINT j = 0; j < casterCount; ++j)
+    {
+        const RenderItem* ri = j < opaque.size() ? opaque[j] : skinned[j - opaque.size()];
+        casterStates[j].Bounds = ri->Bounds;
+        casterStates[j].Animated = ri->SkinnedModelInst != nullptr;
+    }
+
+    mDirtyCascadeMask = mShadowCache.Update(mCascades, mCascadeSettings.CascadeCount, casterStates, casterCount);
+
+    const ShadowCacheStats& stats = mShadowCache.GetStats();
+    TracyPlot("Shadow cascades rendered", (int64_t)stats.CascadesRendered);
+    TracyPlot("Shadow cascades reused", (int64_t)stats.CascadesReused);
+}
+
+void SkinnedMeshApp::BeginLightClusters()
+{
+    UINT lightCount = (UINT)mLocalLights.size();
+    ClusterLight* clusterLights = mCurrFrameResource->FrameAlloc->AllocateArray<ClusterLight>(lightCount);
+
+    for(UINT i = 0; i < lightCount; ++i)
+    {
+        const Light& light = mLocalLights[i];
+        if(i < mNumLocalPointLights)
+        {
+            clusterLights[i] = MakePointClusterLight(light.Position, light.FalloffEnd);
+        }
+        else
+        {
+            // The spot factor is pow(cos, SpotPower); treat the cone as ending where
+            // it drops below 1/256.
+            float cosCutoff = expf(logf(1.0f / 256.0f) / light.SpotPower);
+            clusterLights[i] = MakeSpotClusterLight(light.Position, light.Direction,
+                light.FalloffEnd, cosCutoff);
+        }
+    }
+
+    mLightClusters.BeginBuild(clusterLights, lightCount, mCamera.GetView());
+}
+
+void SkinnedMeshApp::UploadLightClusters()
+{
+    mLightClusters.FinishBuild();
+
+    // No shader reads the cluster data yet; skip the upload until there is something in it.
+    mCurrFrameResource->LightClusterRanges = 0;
+    mCurrFrameResource->LightClusterIndices = 0;
+    mCurrFrameResource->LocalLights = 0;
+    if(mLocalLights.empty())
+        return;
+
+    const auto& ranges = mLightClusters.GetClusterRanges();
+    const auto& indices = mLightClusters.GetLightIndices();
+
+    UploadAllocation rangesBuffer = AllocateFrameUpload((UINT64)ranges.size()*sizeof(ClusterRange));
+    CopyMemory(rangesBuffer.CpuAddress, ranges.data(), ranges.size()*sizeof(ClusterRange));
+    mCurrFrameResource->LightClusterRanges = rangesBuffer.GpuAddress;
+
+    if(!indices.empty())
+    {
+        UploadAllocation indexBuffer = AllocateFrameUpload((UINT64)indices.size()*sizeof(uint32_t));
+        CopyMemory(indexBuffer.CpuAddress, indices.data(), indices.size()*sizeof(uint32_t));
+        mCurrFrameResource->LightClusterIndices = indexBuffer.GpuAddress;
+    }
+
+    UploadAllocation lightBuffer = AllocateFrameUpload((UINT64)mLocalLights.size()*sizeof(Light));
+    CopyMemory(lightBuffer.CpuAddress, mLocalLights.data(), mLocalLights.size()*sizeof(Light));
+    mCurrFrameResource->LocalLights = lightBuffer.GpuAddress;
+
+    TracyPlot("Clustered lights visible", (int64_t)mLightClusters.GetStats().VisibleLightCount);
+    TracyPlot("Clustered light indices", (int64_t)mLightClusters.GetStats().IndexCount);
 }
 
 void SkinnedMeshApp::UpdateSsaoCB(const GameTimer& gt)
@@ -632,7 +749,9 @@ void SkinnedMeshApp::UpdateSsaoCB(const GameTimer& gt)
 
     mSsao->GetOffsetVectors(ssaoCB.OffsetVectors);
 
-    auto blurWeights = mSsao->CalcGaussWeights(2.5f);
+    // Three float4s worth of weights; the ones past the blur radius stay zero.
+    float blurWeights[12] = { 0.0f };
+    mSsao->CalcGaussWeights(2.5f, blurWeights);
     ssaoCB.BlurWeights[0] = XMFLOAT4(&blurWeights[0]);
     ssaoCB.BlurWeights[1] = XMFLOAT4(&blurWeights[4]);
     ssaoCB.BlurWeights[2] = XMFLOAT4(&blurWeights[8]);
@@ -645,8 +764,21 @@ void SkinnedMeshApp::UpdateSsaoCB(const GameTimer& gt)
     ssaoCB.OcclusionFadeEnd = 2.0f;
     ssaoCB.SurfaceEpsilon = 0.05f;
 
-    auto currSsaoCB = mCurrFrameResource->SsaoCB.get();
-    currSsaoCB->CopyData(0, ssaoCB);
+    UploadAllocation currSsaoCB = AllocateFrameUpload(d3dUtil::CalcConstantBufferByteSize(sizeof(SsaoConstants)));
+    mCurrFrameResource->SsaoCB = currSsaoCB.GpuAddress;
+    CopyToUpload(currSsaoCB, 0, ssaoCB);
+}
+
+UploadAllocation SkinnedMeshApp::AllocateFrameUpload(UINT64 byteSize)
+{
+    UploadAllocation alloc = mCurrFrameResource->Uploads->Allocate(byteSize);
+
+    // The ring holds a whole frame of constants; running out means the FrameResource
+    // upload size needs to grow.
+    if(!alloc.IsValid())
+        ThrowIfFailed(E_OUTOFMEMORY);
+
+    return alloc;
 }
 
 void SkinnedMeshApp::LoadTextures()
@@ -1045,6 +1177,18 @@ void SkinnedMeshApp::BuildShapeGeometry()
     quadSubmesh.StartIndexLocation = quadIndexOffset;
     quadSubmesh.BaseVertexLocation = quadVertexOffset;
 
+    // Local-space bounds, for culling.
+    BoundingBox::CreateFromPoints(boxSubmesh.Bounds, box.Vertices.size(),
+        &box.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+    BoundingBox::CreateFromPoints(gridSubmesh.Bounds, grid.Vertices.size(),
+        &grid.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+    BoundingBox::CreateFromPoints(sphereSubmesh.Bounds, sphere.Vertices.size(),
+        &sphere.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+    BoundingBox::CreateFromPoints(cylinderSubmesh.Bounds, cylinder.Vertices.size(),
+        &cylinder.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+    BoundingBox::CreateFromPoints(quadSubmesh.Bounds, quad.Vertices.size(),
+        &quad.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+
 	//
 	// Extract the vertex elements we are interested in and pack the
 	// vertices of all the meshes into one vertex buffer.
@@ -1184,6 +1328,13 @@ void SkinnedMeshApp::LoadSkinnedModel()
         submesh.StartIndexLocation = mSkinnedSubsets[i].FaceStart * 3;
         submesh.BaseVertexLocation = 0;
 
+        // Bind pose bounds, padded so animated limbs stay inside.
+        BoundingBox::CreateFromPoints(submesh.Bounds, mSkinnedSubsets[i].VertexCount,
+            &vertices[mSkinnedSubsets[i].VertexStart].Pos, sizeof(M3DLoader::SkinnedVertex));
+        submesh.Bounds.Extents.x *= 1.25f;
+        submesh.Bounds.Extents.y *= 1.25f;
+        submesh.Bounds.Extents.z *= 1.25f;
+
 		geo->DrawArgs[name] = submesh;
 	}
 
@@ -1401,13 +1552,37 @@ void SkinnedMeshApp::BuildFrameResources()
 {
     for(int i = 0; i < gNumFrameResources; ++i)
     {
-        mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(),
-            2, (UINT)mAllRitems.size(), 
-            1,
-            (UINT)mMaterials.size()));
+        mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get()));
     }
 }
 
+void SkinnedMeshApp::BuildUpdateTasks()
+{
+    mUpdateTasks = std::make_unique<TaskGraph>();
+    TaskGraph& tasks = *mUpdateTasks;
+
+    // The stages share no state except where a dependency is declared.  Uploads go
+    // through the frame's UploadRing and LinearAllocator, which are thread safe.
+    auto animateMaterials = tasks.AddTask("AnimateMaterials", [this]{ AnimateMaterials(*mUpdateTimer); });
+    tasks.AddTask("UpdateObjectCBs", [this]{ UpdateObjectCBs(*mUpdateTimer); });
+    tasks.AddTask("UpdateSkinnedCBs", [this]{ UpdateSkinnedCBs(*mUpdateTimer); });
+    tasks.AddTask("UpdateMaterialBuffer", [this]{ UpdateMaterialBuffer(*mUpdateTimer); }, { animateMaterials });
+
+    // Caster culling tightens the cascades and swaps in the cached ones, so both pass
+    // constant buffers read the light matrices after it; SSAO reads the main pass projection.
+    auto shadowTransform = tasks.AddTask("UpdateShadowTransform", [this]{ UpdateShadowTransform(*mUpdateTimer); });
+    auto shadowCasters = tasks.AddTask("CullShadowCasters", [this]{ CullShadowCasters(); }, { shadowTransform });
+    auto mainPass = tasks.AddTask("UpdateMainPassCB", [this]{ UpdateMainPassCB(*mUpdateTimer); }, { shadowCasters });
+    tasks.AddTask("UpdateShadowPassCB", [this]{ UpdateShadowPassCB(*mUpdateTimer); }, { shadowCasters });
+
+    // Light clustering: one pass over the lights, then the depth slices in parallel.
+    auto beginClusters = tasks.AddTask("BeginLightClusters", [this]{ BeginLightClusters(); });
+    auto assignClusters = tasks.AddParallelFor("AssignLightClusters", mLightClusters.SliceCount(), 0,
+        [this](uint32_t begin, uint32_t end){ mLightClusters.AssignSlices(begin, end); }, { beginClusters });
+    tasks.AddTask("UploadLightClusters", [this]{ UploadLightClusters(); }, assignClusters);
+    tasks.AddTask("UpdateSsaoCB", [this]{ UpdateSsaoCB(*mUpdateTimer); }, { mainPass });
+}
+
 void SkinnedMeshApp::BuildMaterials()
 {
 	auto bricks0 = std::make_unique<Material>();
@@ -1508,6 +1683,7 @@ void SkinnedMeshApp::BuildRenderItems()
 	boxRitem->IndexCount = boxRitem->Geo->DrawArgs["box"].IndexCount;
 	boxRitem->StartIndexLocation = boxRitem->Geo->DrawArgs["box"].StartIndexLocation;
 	boxRitem->BaseVertexLocation = boxRitem->Geo->DrawArgs["box"].BaseVertexLocation;
+	boxRitem->Bounds = boxRitem->Geo->DrawArgs["box"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(boxRitem.get());
 	mAllRitems.push_back(std::move(boxRitem));
@@ -1522,6 +1698,7 @@ void SkinnedMeshApp::BuildRenderItems()
     gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
     gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
     gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
+    gridRitem->Bounds = gridRitem->Geo->DrawArgs["grid"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(gridRitem.get());
 	mAllRitems.push_back(std::move(gridRitem));
@@ -1537,6 +1714,7 @@ void SkinnedMeshApp::BuildRenderItems()
     mirrorItem->IndexCount = mirrorItem->Geo->DrawArgs["quad"].IndexCount;
     mirrorItem->StartIndexLocation = mirrorItem->Geo->DrawArgs["quad"].StartIndexLocation;
     mirrorItem->BaseVertexLocation = mirrorItem->Geo->DrawArgs["quad"].BaseVertexLocation;
+    mirrorItem->Bounds = mirrorItem->Geo->DrawArgs["quad"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(mirrorItem.get());
 	mAllRitems.push_back(std::move(mirrorItem));
@@ -1566,6 +1744,7 @@ void SkinnedMeshApp::BuildRenderItems()
 		leftCylRitem->IndexCount = leftCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		leftCylRitem->StartIndexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		leftCylRitem->BaseVertexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		leftCylRitem->Bounds = leftCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&rightCylRitem->World, leftCylWorld);
 		XMStoreFloat4x4(&rightCylRitem->TexTransform, brickTexTransform);
@@ -1576,6 +1755,7 @@ void SkinnedMeshApp::BuildRenderItems()
 		rightCylRitem->IndexCount = rightCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		rightCylRitem->StartIndexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		rightCylRitem->BaseVertexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		rightCylRitem->Bounds = rightCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&leftSphereRitem->World, leftSphereWorld);
 		leftSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -1586,6 +1766,7 @@ void SkinnedMeshApp::BuildRenderItems()
 		leftSphereRitem->IndexCount = leftSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		leftSphereRitem->StartIndexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		leftSphereRitem->BaseVertexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		leftSphereRitem->Bounds = leftSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		XMStoreFloat4x4(&rightSphereRitem->World, rightSphereWorld);
 		rightSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -1596,6 +1777,7 @@ void SkinnedMeshApp::BuildRenderItems()
 		rightSphereRitem->IndexCount = rightSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		rightSphereRitem->StartIndexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		rightSphereRitem->BaseVertexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		rightSphereRitem->Bounds = rightSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		mRitemLayer[(int)RenderLayer::Opaque].push_back(leftCylRitem.get());
 		mRitemLayer[(int)RenderLayer::Opaque].push_back(rightCylRitem.get());
@@ -1628,6 +1810,7 @@ void SkinnedMeshApp::BuildRenderItems()
         ritem->IndexCount = ritem->Geo->DrawArgs[submeshName].IndexCount;
         ritem->StartIndexLocation = ritem->Geo->DrawArgs[submeshName].StartIndexLocation;
         ritem->BaseVertexLocation = ritem->Geo->DrawArgs[submeshName].BaseVertexLocation;
+        ritem->Bounds = ritem->Geo->DrawArgs[submeshName].Bounds;
 
         // All render items for this solider.m3d instance share
         // the same skinned model instance.
@@ -1637,19 +1820,76 @@ void SkinnedMeshApp::BuildRenderItems()
         mRitemLayer[(int)RenderLayer::SkinnedOpaque].push_back(ritem.get());
         mAllRitems.push_back(std::move(ritem));
     }
+
+    // Nothing moves after this, so move the bounds to world space once.
+    for(auto& ri : mAllRitems)
+        ri->Bounds.Transform(ri->Bounds, XMLoadFloat4x4(&ri->World));
+}
+
+void SkinnedMeshApp::BuildAudioEmitters()
+{
+    using namespace myengine::audio;
+    Audio& audio = Audio::Instance();
+
+    if(audio.IsInitialized())
+        mAudioSink = std::make_unique<AkAudioPositionSink>();
+    else
+        mAudioSink = std::make_unique<NullAudioPositionSink>();
+
+    mListenerEmitter = mAudioSync.AddEmitter(LISTENER_ID);
+
+    // All render items of a skinned model instance share its world matrix, so the
+    // first one stands in for the whole model.
+    for(const RenderItem* ri : mRitemLayer[(int)RenderLayer::SkinnedOpaque])
+    {
+        if(ri->SkinnedModelInst != mSkinnedModelInst.get())
+            continue;
+
+        AudioGameObject* object = audio.GetAudioObject(mSkinnedModelInst->AudioObject());
+        if(object != nullptr)
+        {
+            AkUInt32 emitter = mAudioSync.AddEmitter(object->GetID());
+            mAudioLod.SetEmitter(emitter, mAudioEmitterMaxDistance);
+            mAudioEmitters.push_back({ ri, emitter });
+        }
+        break;
+    }
+}
+
+void SkinnedMeshApp::SyncAudioTransforms()
+{
+    ZoneScoped;
+
+    mAudioSync.SetTransform(mListenerEmitter, 0,
+        mCamera.GetPosition3f(), mCamera.GetLook3f(), mCamera.GetUp3f());
+
+    for(const AudioEmitterBinding& binding : mAudioEmitters)
+    {
+        const XMFLOAT4X4& world = binding.Item->World;
+        mAudioSync.SetTransform(binding.Emitter, 0, world);
+        mAudioLod.SetPosition(binding.Emitter, XMFLOAT3(world._41, world._42, world._43));
+    }
+
+    mAudioLod.Update(mCamera.GetPosition3f());
+    mAudioSync.Submit(*mAudioSink, mAudioLod.GetDueMask(), mAudioLod.GetDueMaskSize());
 }
 
 void SkinnedMeshApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
+{
+    DrawRenderItems(cmdList, ritems.data(), ritems.size());
+}
+
+void SkinnedMeshApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, RenderItem* const* ritems, size_t count)
 {
 	ZoneScoped;
     UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
     UINT skinnedCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(SkinnedConstants));
 
-	auto objectCB = mCurrFrameResource->ObjectCB->Resource();
-    auto skinnedCB = mCurrFrameResource->SkinnedCB->Resource();
+	auto objectCB = mCurrFrameResource->ObjectCB;
+    auto skinnedCB = mCurrFrameResource->SkinnedCB;
 
     // For each render item...
-    for(size_t i = 0; i < ritems.size(); ++i)
+    for(size_t i = 0; i < count; ++i)
     {
         auto ri = ritems[i];
 
@@ -1657,13 +1897,13 @@ void SkinnedMeshApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const s
         cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
         cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
 
-        D3D12_GPU_VIRTUAL_ADDRESS objCBAddress = objectCB->GetGPUVirtualAddress() + ri->ObjCBIndex*objCBByteSize;
+        D3D12_GPU_VIRTUAL_ADDRESS objCBAddress = objectCB + ri->ObjCBIndex*objCBByteSize;
 
 		cmdList->SetGraphicsRootConstantBufferView(0, objCBAddress);
 
         if(ri->SkinnedModelInst != nullptr)
         {
-            D3D12_GPU_VIRTUAL_ADDRESS skinnedCBAddress = skinnedCB->GetGPUVirtualAddress() + ri->SkinnedCBIndex*skinnedCBByteSize;
+            D3D12_GPU_VIRTUAL_ADDRESS skinnedCBAddress = skinnedCB + ri->SkinnedCBIndex*skinnedCBByteSize;
             cmdList->SetGraphicsRootConstantBufferView(1, skinnedCBAddress);
         }
         else
@@ -1677,31 +1917,48 @@ void SkinnedMeshApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const s
 
 void SkinnedMeshApp::DrawSceneToShadowMap()
 {
-    mCommandList->RSSetViewports(1, &mShadowMap->Viewport());
-    mCommandList->RSSetScissorRects(1, &mShadowMap->ScissorRect());
+    // Every cascade is still valid from an earlier frame.
+    if(mDirtyCascadeMask == 0)
+        return;
 
     // Change to DEPTH_WRITE.
     mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mShadowMap->Resource(),
         D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_DEPTH_WRITE));
 
-    // Clear the back buffer and depth buffer.
-    mCommandList->ClearDepthStencilView(mShadowMap->Dsv(), 
-        D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
-
     // Specify the buffers we are going to render to.
     mCommandList->OMSetRenderTargets(0, nullptr, false, &mShadowMap->Dsv());
 
-    // Bind the pass constant buffer for the shadow map pass.
     UINT passCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(PassConstants));
-    auto passCB = mCurrFrameResource->PassCB->Resource();
-    D3D12_GPU_VIRTUAL_ADDRESS passCBAddress = passCB->GetGPUVirtualAddress() + 1*passCBByteSize;
-    mCommandList->SetGraphicsRootConstantBufferView(2, passCBAddress);
+    UINT tileSize = mCascadeSettings.Resolution;
 
-    mCommandList->SetPipelineState(mPSOs["shadow_opaque"].Get());
-    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
+    // Each dirty cascade clears and redraws its own quarter of the map; the others
+    // keep what an earlier frame rendered.
+    for(UINT i = 0; i < mCascadeSettings.CascadeCount; ++i)
+    {
+        if((mDirtyCascadeMask & (1u << i)) == 0)
+            continue;
 
-    mCommandList->SetPipelineState(mPSOs["skinnedShadow_opaque"].Get());
-    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::SkinnedOpaque]);
+        D3D12_VIEWPORT viewport = { (float)((i % 2)*tileSize), (float)((i / 2)*tileSize),
+            (float)tileSize, (float)tileSize, 0.0f, 1.0f };
+        D3D12_RECT scissorRect = { (LONG)((i % 2)*tileSize), (LONG)((i / 2)*tileSize),
+            (LONG)((i % 2 + 1)*tileSize), (LONG)((i / 2 + 1)*tileSize) };
+        mCommandList->RSSetViewports(1, &viewport);
+        mCommandList->RSSetScissorRects(1, &scissorRect);
+
+        mCommandList->ClearDepthStencilView(mShadowMap->Dsv(),
+            D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 1, &scissorRect);
+
+        // Bind the pass constant buffer for this cascade.
+        mCommandList->SetGraphicsRootConstantBufferView(2, mCurrFrameResource->ShadowPassCB + i*passCBByteSize);
+
+        const ShadowCasterList& casters = mShadowCasters[i];
+
+        mCommandList->SetPipelineState(mPSOs["shadow_opaque"].Get());
+        DrawRenderItems(mCommandList.Get(), casters.Opaque, casters.OpaqueCount);
+
+        mCommandList->SetPipelineState(mPSOs["skinnedShadow_opaque"].Get());
+        DrawRenderItems(mCommandList.Get(), casters.Skinned, casters.SkinnedCount);
+    }
 
     // Change back to GENERIC_READ so we can read the texture in a shader.
     mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mShadowMap->Resource(),
@@ -1729,8 +1986,7 @@ void SkinnedMeshApp::DrawNormalsAndDepth()
     mCommandList->OMSetRenderTargets(1, &normalMapRtv, true, &DepthStencilView());
 
     // Bind the constant buffer for this pass.
-    auto passCB = mCurrFrameResource->PassCB->Resource();
-    mCommandList->SetGraphicsRootConstantBufferView(2, passCB->GetGPUVirtualAddress());
+    mCommandList->SetGraphicsRootConstantBufferView(2, mCurrFrameResource->PassCB);
 
     mCommandList->SetPipelineState(mPSOs["drawNormals"].Get());
     DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
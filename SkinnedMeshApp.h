@@ -4,6 +4,8 @@
 
 #include "audio.h"
 #include "gameobject.h"
+#include "audiotransformsync.h"
+#include "audiolod.h"
 #include "Common/d3dApp.h"
 #include "Common/MathHelper.h"
 #include "Common/UploadBuffer.h"
@@ -14,6 +16,9 @@
 #include "Ssao.h"
 #include "Common/SkinnedData.h"
 #include "Common/LoadM3d.h"
+#include "Common/TaskGraph.h"
+#include "Common/LightClusters.h"
+#include "Common/ShadowCaching.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -26,9 +31,19 @@ public:
     SkinnedModelInstance(SkinnedData* SkinnedInfo, std::string clipName, std::string game_object_name):
         SkinnedInfo(SkinnedInfo), m_finalTransforms(SkinnedInfo->BoneCount()), ClipName(clipName), TimePos(0.0f)
     {
-        gameobject = myengine::audio::Audio::Instance().RegisterAudioObject(game_object_name);
+        audioObject = myengine::audio::Audio::Instance().RegisterAudioObject(game_object_name);
     }
 
+    ~SkinnedModelInstance()
+    {
+        myengine::audio::Audio::Instance().UnregisterAudioObject(audioObject);
+    }
+
+    SkinnedModelInstance(const SkinnedModelInstance& rhs) = delete;
+    SkinnedModelInstance& operator=(const SkinnedModelInstance& rhs) = delete;
+
+    myengine::audio::AudioObjectHandle AudioObject()const { return audioObject; }
+
     std::vector<DirectX::XMFLOAT4X4>& FinalTransforms()
     {
         return m_finalTransforms;
@@ -38,14 +53,14 @@ private:
     std::vector<DirectX::XMFLOAT4X4> m_finalTransforms;
     std::string ClipName;
     float TimePos = 0.0f;
-    myengine::audio::AudioGameObject* gameobject = nullptr;
+    myengine::audio::AudioObjectHandle audioObject;
 public:
 
     // Called every frame and increments the time position, interpolates the 
     // animations for each bone based on the current animation clip, and 
     // generates the final transforms which are ultimately set to the effect
     // for processing in the vertex shader.
-    void UpdateSkinnedAnimation(float dt)
+    void UpdateSkinnedAnimation(float dt, LinearAllocator& scratch)
     {
         TimePos += dt;
 
@@ -53,11 +68,11 @@ public:
         if (TimePos > SkinnedInfo->GetClipEndTime(ClipName))
         {
             TimePos = 0.0f;
-            //gameobject->PostEvent("Play_Reflect_Emitter");
+            //myengine::audio::Audio::Instance().GetAudioObject(audioObject)->PostEvent("Play_Reflect_Emitter");
         }
 
         // Compute the final transforms for this time position.
-        SkinnedInfo->GetFinalTransforms(ClipName, TimePos, FinalTransforms());
+        SkinnedInfo->GetFinalTransforms(ClipName, TimePos, FinalTransforms(), scratch);
     }
 };
 
@@ -75,13 +90,8 @@ struct RenderItem
 
 	XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
 
-	// Dirty flag indicating the object data has changed and we need to update the constant buffer.
-	// Because we have an object cbuffer for each FrameResource, we have to apply the
-	// update to each FrameResource.  Thus, when we modify obect data we should set 
-	// NumFramesDirty = gNumFrameResources so that each frame resource gets the update.
-	int NumFramesDirty = gNumFrameResources;
-
-	// Index into GPU constant buffer corresponding to the ObjectCB for this render item.
+	// Index into this frame's ObjectCB block for this render item.  The block is
+	// rewritten every frame, so there is no dirty tracking.
 	UINT ObjCBIndex = -1;
  
 	Material* Mat = nullptr;
@@ -100,6 +110,20 @@ struct RenderItem
 	
     // nullptr if this render-item is not animated by skinned mesh.
     SkinnedModelInstance* SkinnedModelInst = nullptr;
+
+    // World-space bounds, used to cull shadow casters.  The scene is static, so
+    // BuildRenderItems computes them once.
+    DirectX::BoundingBox Bounds;
+};
+
+// Render items that can cast into one shadow cascade this frame.  The arrays live
+// in the frame's FrameAlloc.
+struct ShadowCasterList
+{
+    RenderItem** Opaque = nullptr;
+    UINT OpaqueCount = 0;
+    RenderItem** Skinned = nullptr;
+    UINT SkinnedCount = 0;
 };
 
 enum class RenderLayer : int
@@ -140,7 +164,13 @@ private:
     void UpdateShadowTransform(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
     void UpdateShadowPassCB(const GameTimer& gt);
+    void CullShadowCasters();
+    void BeginLightClusters();
+    void UploadLightClusters();
     void UpdateSsaoCB(const GameTimer& gt);
+    void SyncAudioTransforms();
+
+    UploadAllocation AllocateFrameUpload(UINT64 byteSize);
 
 	void LoadTextures();
     void BuildRootSignature();
@@ -151,9 +181,12 @@ private:
 	void LoadSkinnedModel();
     void BuildPSOs();
     void BuildFrameResources();
+    void BuildUpdateTasks();
     void BuildMaterials();
     void BuildRenderItems();
+    void BuildAudioEmitters();
     void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
+    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, RenderItem* const* ritems, size_t count);
     void DrawSceneToShadowMap();
 	void DrawNormalsAndDepth();
 
@@ -167,6 +200,25 @@ private:
 private:
 
     bool GPUSkin = true;
+
+    // Run the update tasks one after another on the main thread, in the order
+    // they were added.  Handy when stepping through Update in a debugger.
+    bool mSingleThreadedUpdate = false;
+
+    // Audio emitters follow render items and the listener follows the camera; their
+    // transforms are sent at the end of Update, distant emitters less often.
+    struct AudioEmitterBinding
+    {
+        const RenderItem* Item;
+        AkUInt32 Emitter;
+    };
+    myengine::audio::AudioTransformSync mAudioSync;
+    std::unique_ptr<myengine::audio::IAudioPositionSink> mAudioSink;
+    std::vector<AudioEmitterBinding> mAudioEmitters;
+    AkUInt32 mListenerEmitter = myengine::audio::AudioTransformSync::INVALID_EMITTER;
+    myengine::audio::AudioLodManager mAudioLod;
+    float mAudioEmitterMaxDistance = 50.0f;
+
     std::vector<std::unique_ptr<FrameResource>> mFrameResources;
     FrameResource* mCurrFrameResource = nullptr;
     int mCurrFrameResourceIndex = 0;
@@ -202,8 +254,8 @@ private:
 
     CD3DX12_GPU_DESCRIPTOR_HANDLE mNullSrv;
 
-    PassConstants mMainPassCB;  // index 0 of pass cbuffer.
-    PassConstants mShadowPassCB;// index 1 of pass cbuffer.
+    PassConstants mMainPassCB;
+    PassConstants mShadowPassCB;
 
     UINT mSkinnedSrvHeapStart = 0;
     std::string mSkinnedModelFilename = "Models\\soldier.m3d";
@@ -221,12 +273,15 @@ private:
 
     DirectX::BoundingSphere mSceneBounds;
 
-    float mLightNearZ = 0.0f;
-    float mLightFarZ = 0.0f;
-    XMFLOAT3 mLightPosW;
-    XMFLOAT4X4 mLightView = MathHelper::Identity4x4();
-    XMFLOAT4X4 mLightProj = MathHelper::Identity4x4();
-    XMFLOAT4X4 mShadowTransform = MathHelper::Identity4x4();
+    // Each cascade renders into one quarter of mShadowMap.
+    CascadeSettings mCascadeSettings;
+    ShadowCascade mCascades[MaxShadowCascades];
+    ShadowCasterList mShadowCasters[MaxShadowCascades];
+
+    // Cascades whose tile in mShadowMap is still valid are not re-rendered; bit i of
+    // mDirtyCascadeMask is set if cascade i is drawn this frame.
+    ShadowCacheTracker mShadowCache;
+    UINT mDirtyCascadeMask = 0;
 
     float mLightRotationAngle = 0.0f;
     XMFLOAT3 mBaseLightDirections[3] = {
@@ -236,6 +291,17 @@ private:
     };
     XMFLOAT3 mRotatedLightDirections[3];
 
+    // Point and spot lights for clustered shading: the first mNumLocalPointLights
+    // entries are point lights, the rest are spot lights.  The demo scene has none.
+    std::vector<Light> mLocalLights;
+    UINT mNumLocalPointLights = 0;
+    LightClusterBuilder mLightClusters;
+
+    // Per-frame Update stages and their dependencies.  The tasks read the timer
+    // through mUpdateTimer, which is only valid while Update is running them.
+    std::unique_ptr<TaskGraph> mUpdateTasks;
+    const GameTimer* mUpdateTimer = nullptr;
+
     POINT mLastMousePos;
 };
 
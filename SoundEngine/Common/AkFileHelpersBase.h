@@ -29,6 +29,9 @@ written agreement between you and Audiokinetic Inc.
 #include <AK/SoundEngine/Common/AkTypes.h>
 #include <AK/Tools/Common/AkPlatformFuncs.h>
 
+/// Called by CAkFileHelpers::ListDirectory() for each entry of a directory, "." and ".." excluded.
+typedef void (*AkDirectoryEntryFunc)( void * in_pCookie, const AkOSChar * in_pszName, bool in_bIsDirectory );
+
 /// Provides platform-agnostic helper functions
 class CAkFileHelpersBase
 {
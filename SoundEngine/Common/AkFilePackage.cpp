@@ -20,7 +20,8 @@ written agreement between you and Audiokinetic Inc.
 // It holds a system file handle and a look-up table (CAkFilePackageLUT).
 //
 // CAkFilePackage objects can be chained together using the ListFilePackages
-// typedef defined below.
+// typedef defined below. CAkFilePackageIndex maps the files of such a list
+// to the package that serves them.
 //
 //////////////////////////////////////////////////////////////////////
 
@@ -49,3 +50,232 @@ void CAkFilePackage::ClearMemory(
 		AkFree(AkMemID_FilePackage, in_pMemToRelease);
 	}
 }
+
+CAkFilePackageIndex::CAkFilePackageIndex()
+	: m_pSlots( NULL )
+	, m_uMask( 0 )
+	, m_uNumEntries( 0 )
+	, m_bValid( true )
+	, m_pVisited( NULL )
+	, m_pRemaining( NULL )
+	, m_eVisitedClass( CAkFilePackageLUT::LookupClass_None )
+	, m_uCount( 0 )
+	, m_bOverride( false )
+{
+}
+
+CAkFilePackageIndex::~CAkFilePackageIndex()
+{
+	Term();
+}
+
+void CAkFilePackageIndex::Term()
+{
+	if ( m_pSlots )
+	{
+		AkFree( AkMemID_FilePackage, m_pSlots );
+		m_pSlots = NULL;
+	}
+	m_uMask = 0;
+	m_uNumEntries = 0;
+	m_bValid = true;
+}
+
+void CAkFilePackageIndex::AddPackage( 
+	CAkFilePackage *	in_pPackage,		// New package.
+	ListFilePackages &	in_packages			// All packages, in_pPackage included.
+	)
+{
+	if ( !m_bValid )
+	{
+		Rebuild( in_packages );
+	}
+	else if ( !IndexPackage( in_pPackage, true ) )
+	{
+		Term();
+		m_bValid = false;
+	}
+}
+
+void CAkFilePackageIndex::RemovePackage( 
+	CAkFilePackage *	in_pPackage,		// Removed package.
+	ListFilePackages &	in_packages			// Remaining packages.
+	)
+{
+	if ( !m_bValid )
+	{
+		Rebuild( in_packages );
+		return;
+	}
+	if ( !m_pSlots )
+		return;
+
+	// Replacing or erasing entries never needs more room.
+	m_pVisited = in_pPackage;
+	m_pRemaining = &in_packages;
+	for ( AkUInt32 i = 0; i < CAkFilePackageLUT::LookupClass_Num; ++i )
+	{
+		m_eVisitedClass = (CAkFilePackageLUT::LookupClass)i;
+		in_pPackage->lut.ForEachFile( m_eVisitedClass, RemoveFile, this );
+	}
+	m_pVisited = NULL;
+	m_pRemaining = NULL;
+}
+
+void CAkFilePackageIndex::Rebuild( 
+	ListFilePackages &	in_packages			// All packages.
+	)
+{
+	Term();
+
+	// Most recent first: packages only add the files that are not indexed yet.
+	for ( ListFilePackages::Iterator it = in_packages.Begin(); it != in_packages.End(); ++it )
+	{
+		if ( !IndexPackage( *it, false ) )
+		{
+			Term();
+			m_bValid = false;
+			return;
+		}
+	}
+}
+
+CAkFilePackage * CAkFilePackageIndex::Find( 
+	CAkFilePackageLUT::LookupClass	in_eClass,				// Look-up class of the request.
+	AkUInt64						in_uID,					// File ID.
+	bool							in_bIsLanguageSpecific	// Flag of the request.
+	) const
+{
+	AKASSERT( m_bValid );
+	if ( !m_pSlots || in_eClass >= CAkFilePackageLUT::LookupClass_Num )
+		return NULL;
+	return m_pSlots[ FindSlot( MakeKey( in_eClass, in_bIsLanguageSpecific ), in_uID ) ].pPackage;
+}
+
+AkUInt32 CAkFilePackageIndex::FindSlot( AkUInt32 in_uKey, AkUInt64 in_uID ) const
+{
+	AkUInt32 uSlot = Hash( in_uKey, in_uID ) & m_uMask;
+	while ( m_pSlots[uSlot].pPackage 
+		&& ( m_pSlots[uSlot].uID != in_uID || m_pSlots[uSlot].uKey != in_uKey ) )
+	{
+		uSlot = ( uSlot + 1 ) & m_uMask;
+	}
+	return uSlot;
+}
+
+bool CAkFilePackageIndex::Reserve( AkUInt32 in_uNumEntries )
+{
+	// At most half full.
+	AkUInt32 uNumSlots = m_pSlots ? m_uMask + 1 : 0;
+	if ( 2 * (AkUInt64)in_uNumEntries <= uNumSlots )
+		return true;
+
+	AkUInt32 uNewNumSlots = 16;
+	while ( uNewNumSlots < 2 * (AkUInt64)in_uNumEntries )
+		uNewNumSlots *= 2;
+
+	Slot * pOldSlots = m_pSlots;
+	m_pSlots = (Slot*)AkAlloc( AkMemID_FilePackage, uNewNumSlots * sizeof( Slot ) );
+	if ( !m_pSlots )
+	{
+		m_pSlots = pOldSlots;
+		return false;
+	}
+	AKPLATFORM::AkMemSet( m_pSlots, 0, uNewNumSlots * sizeof( Slot ) );
+	m_uMask = uNewNumSlots - 1;
+
+	for ( AkUInt32 i = 0; i < uNumSlots; ++i )
+	{
+		if ( pOldSlots[i].pPackage )
+			m_pSlots[ FindSlot( pOldSlots[i].uKey, pOldSlots[i].uID ) ] = pOldSlots[i];
+	}
+	if ( pOldSlots )
+		AkFree( AkMemID_FilePackage, pOldSlots );
+	return true;
+}
+
+// Backward shift deletion: entries that probed past the slot move back, so 
+// that probing can stop at the first free slot.
+void CAkFilePackageIndex::Erase( AkUInt32 in_uSlot )
+{
+	AkUInt32 uFree = in_uSlot;
+	for ( AkUInt32 uSlot = ( in_uSlot + 1 ) & m_uMask; m_pSlots[uSlot].pPackage; uSlot = ( uSlot + 1 ) & m_uMask )
+	{
+		AkUInt32 uHome = Hash( m_pSlots[uSlot].uKey, m_pSlots[uSlot].uID ) & m_uMask;
+		bool bStays = ( uFree <= uSlot ) 
+			? ( uFree < uHome && uHome <= uSlot ) 
+			: ( uFree < uHome || uHome <= uSlot );
+		if ( !bStays )
+		{
+			m_pSlots[uFree] = m_pSlots[uSlot];
+			uFree = uSlot;
+		}
+	}
+	m_pSlots[uFree].pPackage = NULL;
+	--m_uNumEntries;
+}
+
+bool CAkFilePackageIndex::IndexPackage( CAkFilePackage * in_pPackage, bool in_bOverride )
+{
+	m_pVisited = in_pPackage;
+	m_bOverride = in_bOverride;
+
+	m_uCount = 0;
+	for ( AkUInt32 i = 0; i < CAkFilePackageLUT::LookupClass_Num; ++i )
+		in_pPackage->lut.ForEachFile( (CAkFilePackageLUT::LookupClass)i, CountFile, this );
+
+	bool bSuccess = Reserve( m_uNumEntries + m_uCount );
+	if ( bSuccess )
+	{
+		for ( AkUInt32 i = 0; i < CAkFilePackageLUT::LookupClass_Num; ++i )
+		{
+			m_eVisitedClass = (CAkFilePackageLUT::LookupClass)i;
+			in_pPackage->lut.ForEachFile( m_eVisitedClass, AddFile, this );
+		}
+	}
+
+	m_pVisited = NULL;
+	return bSuccess;
+}
+
+void CAkFilePackageIndex::CountFile( void * in_pCookie, AkUInt64 /*in_uID*/, bool /*in_bIsLanguageSpecific*/ )
+{
+	++((CAkFilePackageIndex*)in_pCookie)->m_uCount;
+}
+
+void CAkFilePackageIndex::AddFile( void * in_pCookie, AkUInt64 in_uID, bool in_bIsLanguageSpecific )
+{
+	CAkFilePackageIndex * pThis = (CAkFilePackageIndex*)in_pCookie;
+	AkUInt32 uKey = MakeKey( pThis->m_eVisitedClass, in_bIsLanguageSpecific );
+	Slot & slot = pThis->m_pSlots[ pThis->FindSlot( uKey, in_uID ) ];
+	if ( !slot.pPackage )
+	{
+		slot.uID = in_uID;
+		slot.uKey = uKey;
+		slot.pPackage = pThis->m_pVisited;
+		++pThis->m_uNumEntries;
+	}
+	else if ( pThis->m_bOverride )
+	{
+		slot.pPackage = pThis->m_pVisited;
+	}
+}
+
+void CAkFilePackageIndex::RemoveFile( void * in_pCookie, AkUInt64 in_uID, bool in_bIsLanguageSpecific )
+{
+	CAkFilePackageIndex * pThis = (CAkFilePackageIndex*)in_pCookie;
+	AkUInt32 uSlot = pThis->FindSlot( MakeKey( pThis->m_eVisitedClass, in_bIsLanguageSpecific ), in_uID );
+	Slot & slot = pThis->m_pSlots[uSlot];
+	if ( slot.pPackage != pThis->m_pVisited )
+		return;	// Served by a more recent package.
+
+	for ( ListFilePackages::Iterator it = pThis->m_pRemaining->Begin(); it != pThis->m_pRemaining->End(); ++it )
+	{
+		if ( (*it)->lut.HasFile( pThis->m_eVisitedClass, in_uID, in_bIsLanguageSpecific ) )
+		{
+			slot.pPackage = *it;
+			return;
+		}
+	}
+	pThis->Erase( uSlot );
+}
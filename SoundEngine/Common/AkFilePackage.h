@@ -20,7 +20,8 @@ written agreement between you and Audiokinetic Inc.
 // It holds a system file handle and a look-up table (CAkFilePackageLUT).
 //
 // CAkFilePackage objects can be chained together using the ListFilePackages
-// typedef defined below.
+// typedef defined below. CAkFilePackageIndex maps the files of such a list
+// to the package that serves them.
 //
 //////////////////////////////////////////////////////////////////////
 
@@ -100,6 +101,36 @@ public:
 		return pFilePackage;
 	}	
 
+	// Package factory for packages whose header stays where it is (in a file
+	// mapping): only allocates memory for the object.
+	template<class T_PACKAGE>
+	static T_PACKAGE * CreateInPlace( 
+		const AkOSChar*		in_pszPackageName,	// Name of the file package (for memory monitoring and ID generation).
+		AkUInt32 			in_uHeaderSize		// File package header size, including the size of the header chunk AKPK_HEADER_CHUNK_DEF_SIZE.
+		)
+	{
+		void * pToRelease = AkMalign(AkMemID_FilePackage, sizeof( T_PACKAGE ), AK_SIMD_ALIGNMENT);
+		if ( !pToRelease )
+			return NULL;
+
+		AkUInt32 uPackageID = AK::SoundEngine::GetIDFromString( in_pszPackageName );
+		return AkPlacementNew( pToRelease ) T_PACKAGE( uPackageID, in_uHeaderSize, pToRelease );
+	}
+
+	// Mapped packages: the whole package file, readable in place. NULL for
+	// packages read through the low-level I/O.
+	virtual const AkUInt8 * MappedData() const { return NULL; }
+	virtual AkUInt64 MappedSize() const { return 0; }
+
+	// Called after a read was served from the mapping, with the heuristics
+	// of the transfer, so the package can prefetch or drop pages.
+	virtual void AdviseRead(
+		AkUInt64			/*in_uOffset*/,		// Offset of the read in the package.
+		AkUInt32			/*in_uSize*/,		// Size of the read.
+		AkReal32			/*in_fDeadline*/,	// Deadline heuristic, in ms.
+		AkPriority			/*in_priority*/		// Priority heuristic.
+		) {}
+
 	// Getters.
 	inline AkUInt32 ID() { return m_uPackageID; }
 	inline AkUInt32 HeaderSize() { return m_uHeaderSize; }
@@ -155,4 +186,98 @@ protected:
 //-----------------------------------------------------------------------------
 typedef AkListBare<CAkFilePackage,CAkListAware,AkCountPolicyWithCount> ListFilePackages;
 
+//-----------------------------------------------------------------------------
+// Name: CAkFilePackageIndex
+// Desc: Maps every file of a list of packages to the package it is opened 
+// from: the first package of the list that has it, that is, the last one 
+// loaded. Kept up to date as packages are added and removed, so that a 
+// look-up costs the same with any number of packages. Keys are those of 
+// CAkFilePackageLUT::LookupFile(): look-up class, file ID and language flag.
+// Not thread safe.
+//-----------------------------------------------------------------------------
+class CAkFilePackageIndex
+{
+public:
+	CAkFilePackageIndex();
+	~CAkFilePackageIndex();
+
+	// Empties the index.
+	void Term();
+
+	// False after running out of memory: Find() cannot be used until the 
+	// next call to AddPackage(), RemovePackage() or Rebuild() succeeds.
+	inline bool IsValid() const { return m_bValid; }
+
+	// in_pPackage was just added at the front of in_packages.
+	void AddPackage( 
+		CAkFilePackage *	in_pPackage,		// New package.
+		ListFilePackages &	in_packages			// All packages, in_pPackage included.
+		);
+
+	// in_pPackage was just removed from in_packages; it must still be alive.
+	// Its files go to the next package that has them.
+	void RemovePackage( 
+		CAkFilePackage *	in_pPackage,		// Removed package.
+		ListFilePackages &	in_packages			// Remaining packages.
+		);
+
+	// Indexes all packages again, e.g. after a language change.
+	void Rebuild( 
+		ListFilePackages &	in_packages			// All packages.
+		);
+
+	// Returns the package to open the file from, NULL if none has it.
+	CAkFilePackage * Find( 
+		CAkFilePackageLUT::LookupClass	in_eClass,				// Look-up class of the request.
+		AkUInt64						in_uID,					// File ID.
+		bool							in_bIsLanguageSpecific	// Flag of the request.
+		) const;
+
+private:
+	struct Slot
+	{
+		AkUInt64			uID;
+		CAkFilePackage *	pPackage;	// NULL if the slot is free.
+		AkUInt32			uKey;		// Look-up class and language flag.
+	};
+
+	static inline AkUInt32 MakeKey( CAkFilePackageLUT::LookupClass in_eClass, bool in_bIsLanguageSpecific )
+	{
+		return ( (AkUInt32)in_eClass << 1 ) | ( in_bIsLanguageSpecific ? 1 : 0 );
+	}
+
+	static inline AkUInt32 Hash( AkUInt32 in_uKey, AkUInt64 in_uID )
+	{
+		return (AkUInt32)( ( ( in_uID + in_uKey ) * 0x9E3779B97F4A7C15ULL ) >> 32 );
+	}
+
+	// Slot of the key, or the free slot where it goes.
+	AkUInt32 FindSlot( AkUInt32 in_uKey, AkUInt64 in_uID ) const;
+
+	// Room for in_uNumEntries entries. Returns false if out of memory.
+	bool Reserve( AkUInt32 in_uNumEntries );
+	void Erase( AkUInt32 in_uSlot );
+
+	// Adds the files of a package; with in_bOverride, they replace those of 
+	// the packages already indexed.
+	bool IndexPackage( CAkFilePackage * in_pPackage, bool in_bOverride );
+
+	// CAkFilePackageLUT::ForEachFile() callbacks; the cookie is this.
+	static void CountFile( void * in_pCookie, AkUInt64 in_uID, bool in_bIsLanguageSpecific );
+	static void AddFile( void * in_pCookie, AkUInt64 in_uID, bool in_bIsLanguageSpecific );
+	static void RemoveFile( void * in_pCookie, AkUInt64 in_uID, bool in_bIsLanguageSpecific );
+
+	Slot *							m_pSlots;
+	AkUInt32						m_uMask;
+	AkUInt32						m_uNumEntries;
+	bool							m_bValid;
+
+	// State of the ForEachFile() callbacks.
+	CAkFilePackage *				m_pVisited;
+	ListFilePackages *				m_pRemaining;
+	CAkFilePackageLUT::LookupClass	m_eVisitedClass;
+	AkUInt32						m_uCount;
+	bool							m_bOverride;
+};
+
 #endif //_AK_FILE_PACKAGE_H_
@@ -0,0 +1,330 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkFilePackageDecompressor.cpp
+//
+// See AkFilePackageDecompressor.h.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "AkFilePackageDecompressor.h"
+#include "AkLz4.h"
+#include <AK/SoundEngine/Common/AkMemoryMgr.h>
+#include <AK/Tools/Common/AkAutoLock.h>
+
+CAkFilePackageDecompressor::CAkFilePackageDecompressor()
+	: m_pFirst( NULL )
+	, m_pLast( NULL )
+	, m_pThreads( NULL )
+	, m_uNumThreads( 0 )
+{
+	AKPLATFORM::AkClearSemaphore( m_semJobs );
+}
+
+CAkFilePackageDecompressor::~CAkFilePackageDecompressor()
+{
+	Term();
+}
+
+AKRESULT CAkFilePackageDecompressor::Init( AkUInt32 in_uNumThreads )
+{
+	if ( m_uNumThreads > 0 )
+		return AK_Success;
+	AKASSERT( in_uNumThreads > 0 );
+
+	m_pThreads = (AkThread*)AkAlloc( AkMemID_Streaming, in_uNumThreads * sizeof( AkThread ) );
+	if ( !m_pThreads )
+		return AK_InsufficientMemory;
+
+	if ( AKPLATFORM::AkCreateSemaphore( m_semJobs, 0 ) != AK_Success )
+	{
+		Term();
+		return AK_Fail;
+	}
+
+	// Transfers wait for decompression like they wait for the disk.
+	AkThreadProperties threadProps;
+	AKPLATFORM::AkGetDefaultHighPriorityThreadProperties( threadProps );
+	for ( AkUInt32 i = 0; i < in_uNumThreads; ++i )
+	{
+		AKPLATFORM::AkClearThread( &m_pThreads[i] );
+		AKPLATFORM::AkCreateThread( WorkerThreadFunc, this, threadProps, &m_pThreads[i], "AK::PackageDecompressor" );
+		if ( !AKPLATFORM::AkIsValidThread( &m_pThreads[i] ) )
+		{
+			Term();
+			return AK_Fail;
+		}
+		++m_uNumThreads;
+	}
+	return AK_Success;
+}
+
+void CAkFilePackageDecompressor::Term()
+{
+	if ( !m_pThreads )
+		return;
+
+	// One stop per running thread, behind the jobs.
+	if ( m_uNumThreads > 0 )
+		AKPLATFORM::AkReleaseSemaphore( m_semJobs, m_uNumThreads );
+	for ( AkUInt32 i = 0; i < m_uNumThreads; ++i )
+	{
+		AKPLATFORM::AkWaitForSingleThread( &m_pThreads[i] );
+		AKPLATFORM::AkCloseThread( &m_pThreads[i] );
+	}
+	m_uNumThreads = 0;
+	AKASSERT( !m_pFirst );
+
+	AkFree( AkMemID_Streaming, m_pThreads );
+	m_pThreads = NULL;
+	AKPLATFORM::AkDestroySemaphore( m_semJobs );
+	AKPLATFORM::AkClearSemaphore( m_semJobs );
+}
+
+AkAsyncIOTransferInfo * CAkFilePackageDecompressor::ReadChunks(
+	const CAkFilePackageLUT &					in_lut,
+	const CAkFilePackageLUT::AkCompressedFile &	in_file,
+	AkAsyncIOTransferInfo *						in_pTransfer,
+	AkUInt32									in_uBlockSize
+	)
+{
+	AKASSERT( IsInitialized() );
+	Job * pJob = CreateJob( in_lut, in_file, in_pTransfer, AkMax( in_uBlockSize, (AkUInt32)1 ) );
+	if ( !pJob )
+		return NULL;
+	pJob->pDecompressor = this;
+	return &pJob->chunksRead;
+}
+
+void CAkFilePackageDecompressor::DecompressMapped(
+	const CAkFilePackageLUT &					in_lut,
+	const CAkFilePackageLUT::AkCompressedFile &	in_file,
+	AkAsyncIOTransferInfo *						in_pTransfer,
+	const AkUInt8 *								in_pPackage,
+	AkUInt64									in_uPackageSize
+	)
+{
+	AKASSERT( IsInitialized() );
+	Job * pJob = CreateJob( in_lut, in_file, in_pTransfer, 0 );
+	if ( !pJob )
+		return;
+	pJob->pDecompressor = this;
+
+	AkUInt64 uChunksEnd = in_file.uDataOffset + pJob->pChunkOffsets[pJob->uLastChunk + 1];
+	if ( uChunksEnd > in_uPackageSize )
+	{
+		Complete( pJob, AK_Fail );
+		return;
+	}
+	pJob->pChunks = in_pPackage + in_file.uDataOffset + pJob->pChunkOffsets[pJob->uFirstChunk];
+	Queue( pJob );
+}
+
+CAkFilePackageDecompressor::Job * CAkFilePackageDecompressor::CreateJob(
+	const CAkFilePackageLUT &					in_lut,
+	const CAkFilePackageLUT::AkCompressedFile &	in_file,
+	AkAsyncIOTransferInfo *						in_pTransfer,
+	AkUInt32									in_uBlockSize
+	)
+{
+	// Part of the file that is transferred. The Stream Manager rounds its
+	// last transfer up to the block size, past the end of the file.
+	if ( in_pTransfer->uFilePosition < in_file.uDataOffset
+		|| in_pTransfer->uFilePosition - in_file.uDataOffset >= in_file.uFileSize
+		|| in_pTransfer->uRequestedSize == 0 )
+	{
+		AKASSERT( !"Transfer out of the compressed file" );
+		in_pTransfer->pCallback( in_pTransfer, AK_Fail );
+		return NULL;
+	}
+	AkUInt64 uPosition = in_pTransfer->uFilePosition - in_file.uDataOffset;
+	AkUInt32 uSize = (AkUInt32)AkMin( (AkUInt64)in_pTransfer->uRequestedSize, in_file.uFileSize - uPosition );
+	AkUInt32 uFirstChunk = (AkUInt32)( uPosition / in_file.uChunkSize );
+	AkUInt32 uLastChunk = (AkUInt32)( ( uPosition + uSize - 1 ) / in_file.uChunkSize );
+	const AkUInt32 * pChunkOffsets = in_lut.GetChunkOffsets( in_file );
+
+	// Chunks are read in whole blocks of the package file, in memory aligned
+	// the same way.
+	AkUInt64 uChunksStart = in_file.uDataOffset + pChunkOffsets[uFirstChunk];
+	AkUInt64 uChunksEnd = in_file.uDataOffset + pChunkOffsets[uLastChunk + 1];
+	AkUInt64 uReadStart = uChunksStart;
+	AkUInt32 uReadSize = 0;
+	AkUInt32 uAlign = AK_SIMD_ALIGNMENT;
+	if ( in_uBlockSize > 0 )
+	{
+		uReadStart = uChunksStart - uChunksStart % in_uBlockSize;
+		uReadSize = (AkUInt32)( ( ( uChunksEnd - uReadStart + in_uBlockSize - 1 ) / in_uBlockSize ) * in_uBlockSize );
+		uAlign = AkMax( uAlign, in_uBlockSize );
+	}
+
+	size_t uJobSize = ( ( sizeof( Job ) + uAlign - 1 ) / uAlign ) * uAlign;
+	Job * pJob = (Job*)AkMalign( AkMemID_Streaming, uJobSize + uReadSize, uAlign );
+	if ( !pJob )
+	{
+		in_pTransfer->pCallback( in_pTransfer, AK_InsufficientMemory );
+		return NULL;
+	}
+
+	pJob->pTransfer = in_pTransfer;
+	pJob->pFile = &in_file;
+	pJob->pChunkOffsets = pChunkOffsets;
+	pJob->pChunks = NULL;
+	pJob->uPosition = uPosition;
+	pJob->uSize = uSize;
+	pJob->uFirstChunk = uFirstChunk;
+	pJob->uLastChunk = uLastChunk;
+	pJob->pDecompressor = NULL;
+	pJob->pNextItem = NULL;
+
+	AkAsyncIOTransferInfo & read = pJob->chunksRead;
+	AKPLATFORM::AkMemSet( &read, 0, sizeof( read ) );
+	if ( in_uBlockSize > 0 )
+	{
+		AkUInt8 * pBuffer = (AkUInt8*)pJob + uJobSize;
+		pJob->pChunks = pBuffer + ( uChunksStart - uReadStart );
+		read.pBuffer = pBuffer;
+		read.uFilePosition = uReadStart;
+		read.uBufferSize = uReadSize;
+		read.uRequestedSize = (AkUInt32)( uChunksEnd - uReadStart );
+		read.pCallback = OnChunksRead;
+		read.pCookie = pJob;
+	}
+	return pJob;
+}
+
+void CAkFilePackageDecompressor::Queue( Job * in_pJob )
+{
+	{
+		AkAutoLock<CAkLock> lock( m_lock );
+		if ( m_pLast )
+			m_pLast->pNextItem = in_pJob;
+		else
+			m_pFirst = in_pJob;
+		m_pLast = in_pJob;
+	}
+	AKPLATFORM::AkReleaseSemaphore( m_semJobs, 1 );
+}
+
+void CAkFilePackageDecompressor::Complete( Job * in_pJob, AKRESULT in_eResult )
+{
+	AkAsyncIOTransferInfo * pTransfer = in_pJob->pTransfer;
+	AkFalign( AkMemID_Streaming, in_pJob );
+	pTransfer->pCallback( pTransfer, in_eResult );
+}
+
+// Completion of a read of chunks, on a thread of the base hook.
+void CAkFilePackageDecompressor::OnChunksRead( AkAsyncIOTransferInfo * in_pTransferInfo, AKRESULT in_eResult )
+{
+	Job * pJob = (Job*)in_pTransferInfo->pCookie;
+	if ( in_eResult != AK_Success )
+	{
+		Complete( pJob, in_eResult );
+		return;
+	}
+	pJob->pDecompressor->Queue( pJob );
+}
+
+AKRESULT CAkFilePackageDecompressor::Decompress(
+	const Job &			in_job,
+	AkUInt8 *&			io_pScratch,
+	AkUInt32 &			io_uScratchSize
+	)
+{
+	const CAkFilePackageLUT::AkCompressedFile & file = *in_job.pFile;
+	AkUInt8 * pDest = (AkUInt8*)in_job.pTransfer->pBuffer;
+	AkUInt64 uEnd = in_job.uPosition + in_job.uSize;
+
+	for ( AkUInt32 uChunk = in_job.uFirstChunk; uChunk <= in_job.uLastChunk; ++uChunk )
+	{
+		// The LUT checked the chunk table: stored sizes are never larger
+		// than uncompressed ones.
+		AkUInt64 uChunkStart = (AkUInt64)uChunk * file.uChunkSize;
+		AkUInt32 uChunkSize = (AkUInt32)AkMin( (AkUInt64)file.uChunkSize, file.uFileSize - uChunkStart );
+		const AkUInt8 * pStored = in_job.pChunks + ( in_job.pChunkOffsets[uChunk] - in_job.pChunkOffsets[in_job.uFirstChunk] );
+		AkUInt32 uStoredSize = in_job.pChunkOffsets[uChunk + 1] - in_job.pChunkOffsets[uChunk];
+
+		// Part of the chunk that is transferred.
+		AkUInt64 uFrom = AkMax( uChunkStart, in_job.uPosition );
+		AkUInt64 uTo = AkMin( uChunkStart + uChunkSize, uEnd );
+		AkUInt8 * pTo = pDest + ( uFrom - in_job.uPosition );
+
+		if ( uStoredSize == uChunkSize )
+		{
+			// Stored as is.
+			AKPLATFORM::AkMemCpy( pTo, pStored + ( uFrom - uChunkStart ), (AkUInt32)( uTo - uFrom ) );
+			continue;
+		}
+
+		if ( uFrom == uChunkStart && uTo == uChunkStart + uChunkSize )
+		{
+			// Whole chunk: straight into the transfer's buffer.
+			if ( CAkLz4::Decompress( pStored, uStoredSize, pTo, uChunkSize ) != (AkInt32)uChunkSize )
+				return AK_Fail;
+			continue;
+		}
+
+		if ( io_uScratchSize < uChunkSize )
+		{
+			if ( io_pScratch )
+				AkFree( AkMemID_Streaming, io_pScratch );
+			io_uScratchSize = 0;
+			io_pScratch = (AkUInt8*)AkAlloc( AkMemID_Streaming, file.uChunkSize );
+			if ( !io_pScratch )
+				return AK_InsufficientMemory;
+			io_uScratchSize = file.uChunkSize;
+		}
+		if ( CAkLz4::Decompress( pStored, uStoredSize, io_pScratch, uChunkSize ) != (AkInt32)uChunkSize )
+			return AK_Fail;
+		AKPLATFORM::AkMemCpy( pTo, io_pScratch + ( uFrom - uChunkStart ), (AkUInt32)( uTo - uFrom ) );
+	}
+	return AK_Success;
+}
+
+AK_DECLARE_THREAD_ROUTINE( CAkFilePackageDecompressor::WorkerThreadFunc )
+{
+	CAkFilePackageDecompressor * pThis = AK_GET_THREAD_ROUTINE_PARAMETER_PTR( CAkFilePackageDecompressor );
+	AK_INSTRUMENT_THREAD_START( "CAkFilePackageDecompressor::WorkerThreadFunc" );
+
+	// Partly transferred chunks; kept for the next jobs.
+	AkUInt8 * pScratch = NULL;
+	AkUInt32 uScratchSize = 0;
+
+	for ( ;; )
+	{
+		AKPLATFORM::AkWaitForSemaphore( pThis->m_semJobs );
+		Job * pJob;
+		{
+			AkAutoLock<CAkLock> lock( pThis->m_lock );
+			pJob = pThis->m_pFirst;
+			if ( pJob )
+			{
+				pThis->m_pFirst = pJob->pNextItem;
+				if ( !pThis->m_pFirst )
+					pThis->m_pLast = NULL;
+			}
+		}
+
+		if ( !pJob )
+			break;
+
+		Complete( pJob, Decompress( *pJob, pScratch, uScratchSize ) );
+	}
+
+	if ( pScratch )
+		AkFree( AkMemID_Streaming, pScratch );
+
+	AkExitThread( AK_RETURN_THREAD_OK );
+}
@@ -0,0 +1,143 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkFilePackageDecompressor.h
+//
+// Transfers of files that are compressed in a file package (see the
+// compression map in AkFilePackageLUT.h).
+//
+// The Stream Manager reads compressed files like any other: positions and
+// sizes are those of the uncompressed file. For each transfer,
+// CAkFilePackageLowLevelIO gets from ReadChunks() a read of the compressed
+// chunks it covers, into a staging buffer, and submits it to its base hook
+// instead of the transfer. When that read completes, the chunks are
+// decompressed on a worker thread, straight into the Stream Manager's
+// buffer, and the transfer is completed. Chunks the transfer only needs
+// part of (normally its first and last) go through a scratch buffer.
+// Files of mapped packages are decompressed from the mapping, without a
+// read (DecompressMapped()).
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_FILE_PACKAGE_DECOMPRESSOR_H_
+#define _AK_FILE_PACKAGE_DECOMPRESSOR_H_
+
+#include <AK/SoundEngine/Common/AkStreamMgrModule.h>
+#include <AK/Tools/Common/AkPlatformFuncs.h>
+#include <AK/Tools/Common/AkLock.h>
+#include "AkFilePackageLUT.h"
+
+// Default number of decompression threads.
+#define AK_FILE_PACKAGE_DECOMPRESSOR_THREADS	(2)
+
+//-----------------------------------------------------------------------------
+// Name: class CAkFilePackageDecompressor
+// Desc: Decompresses transfers of compressed packaged files on worker threads.
+//-----------------------------------------------------------------------------
+class CAkFilePackageDecompressor
+{
+public:
+	CAkFilePackageDecompressor();
+	~CAkFilePackageDecompressor();
+
+	// Starts the worker threads; does nothing if they are running.
+	AKRESULT Init(
+		AkUInt32			in_uNumThreads = AK_FILE_PACKAGE_DECOMPRESSOR_THREADS
+		);
+
+	// Stops the worker threads, after the transfers they have. No reads
+	// returned by ReadChunks() may still be in flight.
+	void Term();
+
+	inline bool IsInitialized() const { return m_uNumThreads > 0; }
+
+	// Prepares the read of the chunks of in_file covered by in_pTransfer.
+	// Its position is relative to the package, like for files stored as is.
+	// Submit the returned transfer to the package file; its completion
+	// queues the decompression, which completes in_pTransfer. Returns NULL
+	// if in_pTransfer could not be started; it was then completed with an
+	// error.
+	AkAsyncIOTransferInfo * ReadChunks(
+		const CAkFilePackageLUT &					in_lut,			// LUT of the package.
+		const CAkFilePackageLUT::AkCompressedFile &	in_file,		// File read.
+		AkAsyncIOTransferInfo *						in_pTransfer,	// Transfer of the Stream Manager.
+		AkUInt32									in_uBlockSize	// Block size of the package file.
+		);
+
+	// Queues the decompression of in_pTransfer from a package mapped in
+	// memory. in_pTransfer is completed on a worker thread, or right away
+	// with an error.
+	void DecompressMapped(
+		const CAkFilePackageLUT &					in_lut,			// LUT of the package.
+		const CAkFilePackageLUT::AkCompressedFile &	in_file,		// File read.
+		AkAsyncIOTransferInfo *						in_pTransfer,	// Transfer of the Stream Manager.
+		const AkUInt8 *								in_pPackage,	// Mapped package.
+		AkUInt64									in_uPackageSize	// Size of the mapping.
+		);
+
+private:
+	// A transfer being decompressed. Read chunks follow it in memory.
+	struct Job
+	{
+		AkAsyncIOTransferInfo						chunksRead;		// Read of the chunks (disk packages).
+		AkAsyncIOTransferInfo *						pTransfer;		// Transfer of the Stream Manager.
+		const CAkFilePackageLUT::AkCompressedFile *	pFile;
+		const AkUInt32 *							pChunkOffsets;	// Of pFile.
+		const AkUInt8 *								pChunks;		// Stored data of uFirstChunk.
+		AkUInt64									uPosition;		// Position of the transfer in the file.
+		AkUInt32									uSize;			// Size of the transfer, up to the end of the file.
+		AkUInt32									uFirstChunk;
+		AkUInt32									uLastChunk;
+		CAkFilePackageDecompressor *				pDecompressor;
+		Job *										pNextItem;
+	};
+
+	// Allocates a job for in_pTransfer. With in_uBlockSize > 0, it also
+	// holds the read of its chunks, in blocks of that size. Completes the
+	// transfer with an error and returns NULL on failure.
+	static Job * CreateJob(
+		const CAkFilePackageLUT &					in_lut,
+		const CAkFilePackageLUT::AkCompressedFile &	in_file,
+		AkAsyncIOTransferInfo *						in_pTransfer,
+		AkUInt32									in_uBlockSize
+		);
+
+	void Queue( Job * in_pJob );
+
+	// Decompresses the chunks of a job into its transfer.
+	static AKRESULT Decompress(
+		const Job &			in_job,
+		AkUInt8 *&			io_pScratch,	// Grown as needed.
+		AkUInt32 &			io_uScratchSize
+		);
+
+	// Completes the transfer of a job and frees it.
+	static void Complete( Job * in_pJob, AKRESULT in_eResult );
+
+	static void OnChunksRead( AkAsyncIOTransferInfo * in_pTransferInfo, AKRESULT in_eResult );
+
+	static AK_DECLARE_THREAD_ROUTINE( WorkerThreadFunc );
+
+	// FIFO of jobs to decompress. A thread that finds it empty stops.
+	Job *					m_pFirst;
+	Job *					m_pLast;
+	CAkLock					m_lock;
+	AkSemaphore				m_semJobs;		// Jobs, plus one per thread to stop.
+
+	AkThread *				m_pThreads;
+	AkUInt32				m_uNumThreads;
+};
+
+#endif //_AK_FILE_PACKAGE_DECOMPRESSOR_H_
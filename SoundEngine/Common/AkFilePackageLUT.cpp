@@ -29,6 +29,10 @@ written agreement between you and Audiokinetic Inc.
 // matches the name of the directory that is created by the Wwise Bank Manager,
 // except for the trailing slash.
 //
+// Look-ups go through hash indexes of the LUTs; see AkFilePackageLUT.h.
+// The compression map is validated once by Setup(), so that readers can 
+// trust its chunk tables.
+//
 //////////////////////////////////////////////////////////////////////
 
 
@@ -55,9 +59,13 @@ CAkFilePackageLUT::CAkFilePackageLUT()
 ,m_pSoundBanks( NULL )
 ,m_pStmFiles( NULL )
 ,m_pExternals( NULL )
+,m_pCompressedFiles( NULL )
+,m_uNumCompressedFiles( 0 )
+,m_pChunkOffsets( NULL )
 {
 	AK_STATIC_ASSERT(sizeof(AkFileEntry<AkFileID>) == 20);
 	AK_STATIC_ASSERT(sizeof(AkFileEntry<AkUInt64>) == 24);
+	AK_STATIC_ASSERT(sizeof(AkCompressedFile) == 24);
 }
 
 CAkFilePackageLUT::~CAkFilePackageLUT()
@@ -81,6 +89,7 @@ AKRESULT CAkFilePackageLUT::Setup(
 		AkUInt32			uExternalsLUTSize;
 	};
 	FileHeaderFormat * pHeader = (FileHeaderFormat*)in_pData;
+	const AkUInt8 * pHeaderEnd = in_pData + in_uHeaderSize;
 
 	// Check header size,
 	if ( in_uHeaderSize < sizeof(FileHeaderFormat)
@@ -109,10 +118,104 @@ AKRESULT CAkFilePackageLUT::Setup(
 	in_pData += pHeader->uStmFilesLUTSize;
 
 	m_pExternals	= (FileLUT<AkUInt64>*)in_pData;
+	in_pData += pHeader->uExternalsLUTSize;
+
+	if ( pHeader->uVersion >= AKPK_COMPRESSED_VERSION )
+	{
+		AKRESULT eResult = SetupCompressionMap( in_pData, pHeaderEnd );
+		if ( eResult != AK_Success )
+			return eResult;
+	}
+
+	BuildIndexes();
+
+	return AK_Success;
+}
+
+// (Re)builds the hash indexes for m_curLangID. Tables that cannot be
+// indexed are binary searched.
+void CAkFilePackageLUT::BuildIndexes()
+{
+	m_soundBanksIndex.Build( m_pSoundBanks, m_curLangID );
+	m_stmFilesIndex.Build( m_pStmFiles, m_curLangID );
+	m_externalsIndex.Build( m_pExternals, m_curLangID );
+}
+
+// Parses the compression map at in_pData, which ends at in_pEnd.
+AKRESULT CAkFilePackageLUT::SetupCompressionMap(
+	AkUInt8 *			in_pData,			// Compression map.
+	const AkUInt8 *		in_pEnd				// End of the header.
+	)
+{
+	struct CompressionMapFormat
+	{
+		AkUInt32			uNumFiles;
+		AkUInt32			uNumChunkOffsets;
+	};
+
+	if ( in_pEnd < in_pData + sizeof(CompressionMapFormat) )
+		return AK_Fail;
+	const CompressionMapFormat * pMap = (CompressionMapFormat*)in_pData;
+	AkUInt64 uMapSize = sizeof(CompressionMapFormat)
+		+ (AkUInt64)pMap->uNumFiles * sizeof(AkCompressedFile)
+		+ (AkUInt64)pMap->uNumChunkOffsets * sizeof(AkUInt32);
+	if ( uMapSize > (AkUInt64)( in_pEnd - in_pData ) )
+		return AK_Fail;
+
+	const AkCompressedFile * pFiles = (AkCompressedFile*)( in_pData + sizeof(CompressionMapFormat) );
+	const AkUInt32 * pChunkOffsets = (AkUInt32*)( pFiles + pMap->uNumFiles );
+
+	// Readers rely on the chunks of a file being in its table, in order, 
+	// and never bigger than they are uncompressed.
+	for ( AkUInt32 i = 0; i < pMap->uNumFiles; ++i )
+	{
+		const AkCompressedFile & file = pFiles[i];
+		if ( file.uCodec != AKPK_CODEC_LZ4
+			|| file.uChunkSize == 0
+			|| ( i > 0 && file.uDataOffset <= pFiles[i - 1].uDataOffset ) )
+		{
+			return AK_Fail;
+		}
+
+		AkUInt32 uNumChunks = GetNumChunks( file );
+		if ( (AkUInt64)file.uFirstChunk + uNumChunks + 1 > pMap->uNumChunkOffsets )
+			return AK_Fail;
+
+		const AkUInt32 * pOffsets = pChunkOffsets + file.uFirstChunk;
+		for ( AkUInt32 uChunk = 0; uChunk < uNumChunks; ++uChunk )
+		{
+			AkUInt32 uSize = AkMin( file.uChunkSize, file.uFileSize - uChunk * file.uChunkSize );
+			if ( pOffsets[uChunk + 1] < pOffsets[uChunk] 
+				|| pOffsets[uChunk + 1] - pOffsets[uChunk] > uSize )
+				return AK_Fail;
+		}
+	}
 
+	m_pCompressedFiles = pFiles;
+	m_uNumCompressedFiles = pMap->uNumFiles;
+	m_pChunkOffsets = pChunkOffsets;
 	return AK_Success;
 }
 
+// Compression map entry of the file whose data starts at in_uDataOffset.
+const CAkFilePackageLUT::AkCompressedFile * CAkFilePackageLUT::LookupCompressedFile(
+	AkUInt64			in_uDataOffset		// Offset of the file's data in the package.
+	) const
+{
+	AkInt32 iTop = 0, iBottom = (AkInt32)m_uNumCompressedFiles - 1;
+	while ( iTop <= iBottom )
+	{
+		AkInt32 iThis = ( iBottom - iTop ) / 2 + iTop;
+		if ( m_pCompressedFiles[iThis].uDataOffset > in_uDataOffset )
+			iBottom = iThis - 1;
+		else if ( m_pCompressedFiles[iThis].uDataOffset < in_uDataOffset )
+			iTop = iThis + 1;
+		else
+			return m_pCompressedFiles + iThis;
+	}
+	return NULL;
+}
+
 // Find a file entry by ID.
 const CAkFilePackageLUT::AkFileEntry<AkFileID> * CAkFilePackageLUT::LookupFile(
 	AkFileID			in_uID,			// File ID.
@@ -125,12 +228,12 @@ const CAkFilePackageLUT::AkFileEntry<AkFileID> * CAkFilePackageLUT::LookupFile(
 		&& m_pSoundBanks
 		&& m_pSoundBanks->HasFiles() )
 	{
-		return LookupFile<AkFileID>( in_uID, m_pSoundBanks, in_pFlags->bIsLanguageSpecific );
+		return FindFile<AkFileID>( in_uID, m_pSoundBanks, m_soundBanksIndex, in_pFlags->bIsLanguageSpecific );
 	}
 	else if ( m_pStmFiles && m_pStmFiles->HasFiles() )
 	{
 		// We assume that the file is a streamed audio file.
-		return LookupFile<AkFileID>( in_uID, m_pStmFiles, in_pFlags->bIsLanguageSpecific );
+		return FindFile<AkFileID>( in_uID, m_pStmFiles, m_stmFilesIndex, in_pFlags->bIsLanguageSpecific );
 	}
 	// No table loaded.
 	return NULL;
@@ -148,13 +251,83 @@ const CAkFilePackageLUT::AkFileEntry<AkUInt64> * CAkFilePackageLUT::LookupFile(
 		&& m_pExternals 
 		&& m_pExternals->HasFiles() )
 	{
-		return LookupFile<AkUInt64>( in_uID, m_pExternals, in_pFlags->bIsLanguageSpecific );
+		return FindFile<AkUInt64>( in_uID, m_pExternals, m_externalsIndex, in_pFlags->bIsLanguageSpecific );
 	}
 
 	// No table loaded.
 	return NULL;
 }
 
+// Which LUT LookupFile() searches for a request.
+CAkFilePackageLUT::LookupClass CAkFilePackageLUT::GetLookupClass(
+	const AkFileSystemFlags * in_pFlags		// Special flags. Do not pass NULL.
+	)
+{
+	AKASSERT( in_pFlags );
+	if ( in_pFlags->uCompanyID == AKCOMPANYID_AUDIOKINETIC )
+		return AK::IsBankCodecID( in_pFlags->uCodecID ) ? LookupClass_SoundBank : LookupClass_StmFile;
+	if ( in_pFlags->uCompanyID == AKCOMPANYID_AUDIOKINETIC_EXTERNAL )
+		return LookupClass_External;
+	return LookupClass_None;
+}
+
+// True if LookupFile() would find the file.
+bool CAkFilePackageLUT::HasFile(
+	LookupClass			in_eClass,				// Look-up class of the request.
+	AkUInt64			in_uID,					// File ID.
+	bool				in_bIsLanguageSpecific	// Flag of the request.
+	)
+{
+	switch ( in_eClass )
+	{
+	case LookupClass_SoundBank:
+	case LookupClass_StmFile:
+		if ( in_uID > 0xFFFFFFFF )
+			return false;
+		if ( in_eClass == LookupClass_SoundBank && m_pSoundBanks && m_pSoundBanks->HasFiles() )
+			return FindFile<AkFileID>( (AkFileID)in_uID, m_pSoundBanks, m_soundBanksIndex, in_bIsLanguageSpecific ) != NULL;
+		if ( m_pStmFiles && m_pStmFiles->HasFiles() )
+			return FindFile<AkFileID>( (AkFileID)in_uID, m_pStmFiles, m_stmFilesIndex, in_bIsLanguageSpecific ) != NULL;
+		return false;
+	case LookupClass_External:
+		if ( m_pExternals && m_pExternals->HasFiles() )
+			return FindFile<AkUInt64>( in_uID, m_pExternals, m_externalsIndex, in_bIsLanguageSpecific ) != NULL;
+		return false;
+	default:
+		return false;
+	}
+}
+
+// Calls in_pfnFile for every file LookupFile() can find for a look-up
+// class, in the current language.
+void CAkFilePackageLUT::ForEachFile(
+	LookupClass			in_eClass,				// Look-up class.
+	AkFileFunc			in_pfnFile,				// Called for each file.
+	void *				in_pCookie				// Passed to in_pfnFile.
+	) const
+{
+	switch ( in_eClass )
+	{
+	case LookupClass_SoundBank:
+		if ( m_pSoundBanks && m_pSoundBanks->HasFiles() )
+		{
+			ForEachFile<AkFileID>( m_pSoundBanks, in_pfnFile, in_pCookie );
+			break;
+		}
+		// No sound banks: LookupFile() searches the streamed files.
+	case LookupClass_StmFile:
+		if ( m_pStmFiles && m_pStmFiles->HasFiles() )
+			ForEachFile<AkFileID>( m_pStmFiles, in_pfnFile, in_pCookie );
+		break;
+	case LookupClass_External:
+		if ( m_pExternals && m_pExternals->HasFiles() )
+			ForEachFile<AkUInt64>( m_pExternals, in_pfnFile, in_pCookie );
+		break;
+	default:
+		break;
+	}
+}
+
 // Set current language. 
 // Returns AK_InvalidLanguage if a package is loaded but the language string cannot be found.
 // Returns AK_Success otherwise.
@@ -162,6 +335,9 @@ AKRESULT CAkFilePackageLUT::SetCurLanguage(
 	const AkOSChar*			in_pszLanguage	// Language string.
 	)
 {
+	AkUInt16 prevLangID = m_curLangID;
+	AKRESULT eResult = AK_Success;
+
 	m_curLangID = AK_INVALID_LANGUAGE_ID;
 	if ( m_pLangMap && in_pszLanguage )
 	{
@@ -169,12 +345,19 @@ AKRESULT CAkFilePackageLUT::SetCurLanguage(
 		if ( uLangID == AK_INVALID_UNIQUE_ID 
 			&& m_pLangMap->GetNumStrings() > 1 )	// Do not return AK_InvalidLanguage if package contains only SFX data.
 		{
-			return AK_InvalidLanguage;
+			eResult = AK_InvalidLanguage;
+		}
+		else
+		{
+			m_curLangID = uLangID;
 		}
-		m_curLangID = uLangID;
 	}
 
-	return AK_Success;
+	// The indexes only hold the entries of the current language.
+	if ( m_curLangID != prevLangID )
+		BuildIndexes();
+
+	return eResult;
 }
 
 void CAkFilePackageLUT::RemoveFileExtension( AkOSChar* in_pstring )
@@ -29,22 +29,41 @@ written agreement between you and Audiokinetic Inc.
 // matches the name of the directory that is created by the Wwise Bank Manager,
 // except for the trailing slash.
 //
+// The LUTs are sorted, but look-ups go through a hash index built by Setup()
+// and rebuilt by SetCurLanguage(): it only holds the language-neutral entries
+// and those of the current language, so a look-up is one or two probes. If
+// it cannot be allocated, look-ups binary search the LUTs.
+//
+// Packages of version AKPK_COMPRESSED_VERSION and above end their header 
+// with a compression map. Files listed there are stored in chunks that are 
+// compressed independently (see AkFilePackageCompressor), so that any part 
+// of the file can be read by decompressing only the chunks it covers: the 
+// map gives the offset of each chunk, from the start of the file's data. 
+// A chunk whose stored size is its uncompressed size is stored as is. The 
+// LUT entries of these files keep their uncompressed size.
+//
 //////////////////////////////////////////////////////////////////////
 
 #ifndef _AK_FILE_PACKAGE_LUT_H_
 #define _AK_FILE_PACKAGE_LUT_H_
 
 #include <AK/SoundEngine/Common/IAkStreamMgr.h>
+#include <AK/SoundEngine/Common/AkMemoryMgr.h>
+#include <AK/Tools/Common/AkPlatformFuncs.h>
 #include <AK/Tools/Common/AkAssert.h>
 
 // AK file packager definitions.
 #define AKPK_CURRENT_VERSION		(1)
+#define AKPK_COMPRESSED_VERSION		(2)	// Adds the compression map.
 
 #define AKPK_HEADER_CHUNK_DEF_SIZE	(8)	// The header chunk definition is 8 bytes wide.
 
 #define AKPK_FILE_FORMAT_TAG	\
 		AkmmioFOURCC('A','K','P','K')
 
+// Codecs of compressed files.
+#define AKPK_CODEC_LZ4				(1)	// LZ4 blocks (see AkLz4.h).
+
 //-----------------------------------------------------------------------------
 // Name: class CAkFilePackageLUT.
 // Desc: Keeps pointers to various parts of the header. Offers look-up services
@@ -67,6 +86,16 @@ public:
         AkUInt32	uStartBlock;// Start block, expressed in terms of uBlockSize. 
         AkUInt32	uLanguageID;// Language ID. AK_INVALID_LANGUAGE_ID if not language-specific. 
     };
+
+	// Entry of the compression map. Sorted by uDataOffset.
+	struct AkCompressedFile
+	{
+		AkUInt64	uDataOffset;	// Offset of the file's data in the package (uStartBlock * uBlockSize of its entries).
+		AkUInt32	uFileSize;		// Uncompressed size in bytes.
+		AkUInt32	uCodec;			// AKPK_CODEC_xxx.
+		AkUInt32	uChunkSize;		// Uncompressed size of every chunk but the last.
+		AkUInt32	uFirstChunk;	// Index of its first chunk offset in the chunk table.
+	};
 #pragma pack(pop)
 
     CAkFilePackageLUT();
@@ -91,6 +120,56 @@ public:
 		AkFileSystemFlags * in_pFlags			// Special flags. Do not pass NULL.
 		);
 
+	// Which LUT LookupFile() searches for a request.
+	enum LookupClass
+	{
+		LookupClass_SoundBank,	// Sound bank codecs: sound banks, or streamed files if there are no sound banks.
+		LookupClass_StmFile,	// Other Audiokinetic files: streamed files.
+		LookupClass_External,	// External sources.
+		LookupClass_Num,
+		LookupClass_None = LookupClass_Num	// Never in a package.
+	};
+	static LookupClass GetLookupClass(
+		const AkFileSystemFlags * in_pFlags		// Special flags. Do not pass NULL.
+		);
+
+	// True if LookupFile() would find the file.
+	bool HasFile(
+		LookupClass			in_eClass,				// Look-up class of the request.
+		AkUInt64			in_uID,					// File ID.
+		bool				in_bIsLanguageSpecific	// Flag of the request.
+		);
+
+	// Calls in_pfnFile for every file LookupFile() can find for a look-up
+	// class, in the current language.
+	typedef void (*AkFileFunc)( void * in_pCookie, AkUInt64 in_uID, bool in_bIsLanguageSpecific );
+	void ForEachFile(
+		LookupClass			in_eClass,				// Look-up class.
+		AkFileFunc			in_pfnFile,				// Called for each file.
+		void *				in_pCookie				// Passed to in_pfnFile.
+		) const;
+
+	// True if the package has a compression map with files in it.
+	inline bool HasCompressedFiles() const { return m_uNumCompressedFiles > 0; }
+
+	// Compression map entry of the file whose data starts at in_uDataOffset 
+	// in the package; NULL if the file is stored as is.
+	const AkCompressedFile * LookupCompressedFile(
+		AkUInt64			in_uDataOffset		// Offset of the file's data in the package.
+		) const;
+
+	// Chunk offsets of a compressed file, from the start of its data: one 
+	// per chunk, plus the end of the last chunk.
+	inline const AkUInt32 * GetChunkOffsets( const AkCompressedFile & in_file ) const
+	{
+		return m_pChunkOffsets + in_file.uFirstChunk;
+	}
+
+	static inline AkUInt32 GetNumChunks( const AkCompressedFile & in_file )
+	{
+		return (AkUInt32)( ( (AkUInt64)in_file.uFileSize + in_file.uChunkSize - 1 ) / in_file.uChunkSize );
+	}
+
 	// Set current language.
 	// Returns AK_InvalidLanguage if a package is loaded but the language string cannot be found.
 	// Returns AK_Success otherwise.
@@ -99,12 +178,12 @@ public:
 		);
 
 	// Find a soundbank ID by its name (by hashing its name)
-	AkFileID GetSoundBankID( 
+	static AkFileID GetSoundBankID( 
 		const AkOSChar*			in_pszBankName		// Soundbank name.
 		);
 
     // Return the id of an external file (by hashing its name in 64 bits)
-	AkUInt64 GetExternalID( 
+	static AkUInt64 GetExternalID( 
 		const AkOSChar*			in_pszExternalName		// External Source name.
 		);	
 
@@ -139,6 +218,101 @@ protected:
 		bool						in_bIsLanguageSpecific	// True: match language ID.
 		);
 
+	//
+	// Hash index of a file LUT (open addressing, linear probing). Each file ID
+	// has one slot, with its language-neutral entry and its entry in the
+	// language the index was built for.
+	//
+	template <class T_FILEID>
+	class FileIndex
+	{
+	public:
+		FileIndex() : m_pSlots( NULL ), m_pEntries( NULL ), m_uMask( 0 ) {}
+		~FileIndex() { Term(); }
+
+		// Returns AK_InsufficientMemory if the index could not be allocated;
+		// the index is then empty.
+		AKRESULT Build(
+			const FileLUT<T_FILEID> *	in_pLut,		// LUT to index.
+			AkUInt16					in_langID		// Language of the language-specific entries.
+			);
+		void Term();
+
+		inline bool IsBuilt() const { return m_pSlots != NULL; }
+
+		inline const AkFileEntry<T_FILEID> * Lookup(
+			T_FILEID	in_uID,					// File ID.
+			bool		in_bIsLanguageSpecific	// True: entry of the index's language.
+			) const
+		{
+			AkUInt32 uSlot = Hash( in_uID ) & m_uMask;
+			for ( ;; uSlot = ( uSlot + 1 ) & m_uMask )
+			{
+				const Slot & slot = m_pSlots[uSlot];
+				if ( slot.uNeutralEntry == 0 && slot.uLanguageEntry == 0 )
+					return NULL;
+				if ( slot.fileID == in_uID )
+				{
+					AkUInt32 uEntry = in_bIsLanguageSpecific ? slot.uLanguageEntry : slot.uNeutralEntry;
+					return uEntry ? m_pEntries + uEntry - 1 : NULL;
+				}
+			}
+		}
+
+	private:
+		FileIndex( const FileIndex & );
+		FileIndex & operator=( const FileIndex & );
+
+		// File IDs are hashes already: only spread them over the slots.
+		static inline AkUInt32 Hash( T_FILEID in_uID )
+		{
+			return (AkUInt32)( ( (AkUInt64)in_uID * 0x9E3779B97F4A7C15ULL ) >> 32 );
+		}
+
+		struct Slot
+		{
+			T_FILEID	fileID;
+			AkUInt32	uNeutralEntry;	// Index in the LUT + 1; 0 if none.
+			AkUInt32	uLanguageEntry;	// Index in the LUT + 1; 0 if none.
+		};
+
+		Slot *							m_pSlots;
+		const AkFileEntry<T_FILEID> *	m_pEntries;
+		AkUInt32						m_uMask;
+	};
+
+	// Looks up a LUT through its index, or by binary search if it has none.
+	template <class T_FILEID>
+	const AkFileEntry<T_FILEID> * FindFile(
+		T_FILEID					in_uID,					// File ID.
+		const FileLUT<T_FILEID> *	in_pLut,				// LUT to search. Must have files.
+		const FileIndex<T_FILEID> &	in_index,				// Its index.
+		bool						in_bIsLanguageSpecific	// True: match language ID.
+		)
+	{
+		if ( in_index.IsBuilt() )
+			return in_index.Lookup( in_uID, in_bIsLanguageSpecific );
+		return LookupFile<T_FILEID>( in_uID, in_pLut, in_bIsLanguageSpecific );
+	}
+
+	// Calls in_pfnFile for each entry of in_pLut that is language-neutral
+	// or in the current language.
+	template <class T_FILEID>
+	void ForEachFile(
+		const FileLUT<T_FILEID> *	in_pLut,				// LUT. Must have files.
+		AkFileFunc					in_pfnFile,				// Called for each file.
+		void *						in_pCookie				// Passed to in_pfnFile.
+		) const;
+
+	// (Re)builds the hash indexes for m_curLangID.
+	void BuildIndexes();
+
+	// Parses the compression map at in_pData, which ends at in_pEnd.
+	AKRESULT SetupCompressionMap(
+		AkUInt8 *			in_pData,			// Compression map.
+		const AkUInt8 *		in_pEnd				// End of the header.
+		);
+
 private:
 
 	AkUInt16			m_curLangID;	// Current language.
@@ -175,6 +349,16 @@ private:
 
 	// External Sources LUT.
     FileLUT<AkUInt64> *			m_pExternals;
+
+	// Hash indexes of the LUTs above.
+	FileIndex<AkFileID>			m_soundBanksIndex;
+	FileIndex<AkFileID>			m_stmFilesIndex;
+	FileIndex<AkUInt64>			m_externalsIndex;
+
+	// Compression map.
+	const AkCompressedFile *	m_pCompressedFiles;
+	AkUInt32					m_uNumCompressedFiles;
+	const AkUInt32 *			m_pChunkOffsets;
 };
 
 // Helper: Find a file entry by ID.
@@ -215,4 +399,96 @@ const CAkFilePackageLUT::AkFileEntry<T_FILEID> * CAkFilePackageLUT::LookupFile(
 	return NULL;
 }
 
+template <class T_FILEID>
+void CAkFilePackageLUT::ForEachFile(
+	const FileLUT<T_FILEID> *	in_pLut,		// LUT. Must have files.
+	AkFileFunc					in_pfnFile,		// Called for each file.
+	void *						in_pCookie		// Passed to in_pfnFile.
+	) const
+{
+	const AkFileEntry<T_FILEID> * pTable = in_pLut->FileEntries();
+	for ( AkUInt32 i = 0; i < in_pLut->NumFiles(); ++i )
+	{
+		// Without a current language, language-specific requests find the
+		// language-neutral entries.
+		if ( pTable[i].uLanguageID == AK_INVALID_LANGUAGE_ID )
+		{
+			in_pfnFile( in_pCookie, pTable[i].fileID, false );
+			if ( m_curLangID == AK_INVALID_LANGUAGE_ID )
+				in_pfnFile( in_pCookie, pTable[i].fileID, true );
+		}
+		else if ( pTable[i].uLanguageID == m_curLangID )
+		{
+			in_pfnFile( in_pCookie, pTable[i].fileID, true );
+		}
+	}
+}
+
+template <class T_FILEID>
+AKRESULT CAkFilePackageLUT::FileIndex<T_FILEID>::Build(
+	const FileLUT<T_FILEID> *	in_pLut,		// LUT to index.
+	AkUInt16					in_langID		// Language of the language-specific entries.
+	)
+{
+	Term();
+	if ( !in_pLut || !in_pLut->HasFiles() )
+		return AK_Success;
+
+	const AkFileEntry<T_FILEID> * pTable = in_pLut->FileEntries();
+	AkUInt32 uNumFiles = in_pLut->NumFiles();
+
+	// At most half full.
+	AkUInt32 uNumIndexed = 0;
+	for ( AkUInt32 i = 0; i < uNumFiles; ++i )
+	{
+		if ( pTable[i].uLanguageID == AK_INVALID_LANGUAGE_ID || pTable[i].uLanguageID == in_langID )
+			++uNumIndexed;
+	}
+	AkUInt32 uNumSlots = 8;
+	while ( uNumSlots < 2 * uNumIndexed )
+		uNumSlots *= 2;
+
+	m_pSlots = (Slot*)AkAlloc( AkMemID_FilePackage, uNumSlots * sizeof( Slot ) );
+	if ( !m_pSlots )
+		return AK_InsufficientMemory;
+	AKPLATFORM::AkMemSet( m_pSlots, 0, uNumSlots * sizeof( Slot ) );
+	m_pEntries = pTable;
+	m_uMask = uNumSlots - 1;
+
+	for ( AkUInt32 i = 0; i < uNumFiles; ++i )
+	{
+		const AkFileEntry<T_FILEID> & entry = pTable[i];
+		bool bNeutral = ( entry.uLanguageID == AK_INVALID_LANGUAGE_ID );
+		bool bLanguage = ( entry.uLanguageID == in_langID );
+		if ( !bNeutral && !bLanguage )
+			continue;
+
+		AkUInt32 uSlot = Hash( entry.fileID ) & m_uMask;
+		while ( ( m_pSlots[uSlot].uNeutralEntry || m_pSlots[uSlot].uLanguageEntry ) && m_pSlots[uSlot].fileID != entry.fileID )
+			uSlot = ( uSlot + 1 ) & m_uMask;
+
+		// Without a current language, language-specific look-ups find the
+		// language-neutral entry, like the binary search does.
+		Slot & slot = m_pSlots[uSlot];
+		slot.fileID = entry.fileID;
+		if ( bNeutral )
+			slot.uNeutralEntry = i + 1;
+		if ( bLanguage )
+			slot.uLanguageEntry = i + 1;
+	}
+	return AK_Success;
+}
+
+template <class T_FILEID>
+void CAkFilePackageLUT::FileIndex<T_FILEID>::Term()
+{
+	if ( m_pSlots )
+	{
+		AkFree( AkMemID_FilePackage, m_pSlots );
+		m_pSlots = NULL;
+	}
+	m_pEntries = NULL;
+	m_uMask = 0;
+}
+
 #endif //_AK_FILE_PACKAGE_LUT_H_
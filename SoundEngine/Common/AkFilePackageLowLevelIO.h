@@ -34,7 +34,9 @@ written agreement between you and Audiokinetic Inc.
 //
 // LoadFilePackage() returns a package ID that can be used to unload it. Any number
 // of packages can be loaded simultaneously. When Open() is called, the last package 
-// loaded is searched first, then the previous one, and so on.
+// loaded is searched first, then the previous one, and so on. A global index of 
+// the files of all packages (CAkFilePackageIndex), updated as packages are loaded 
+// and unloaded, finds that package directly.
 //
 // The language ID was created dynamically when the package was created. The header 
 // also contains a map of language names (strings) to their ID, so that the proper 
@@ -45,6 +47,17 @@ written agreement between you and Audiokinetic Inc.
 // The type of package is also a template argument. By default, it is a disk package
 // (see AkDiskPackage.h).
 //
+// Packages whose type supports it (see CAkMappedPackage on POSIX) can instead be
+// loaded with LoadFilePackageMapped(): the package file is mapped in memory once,
+// the look-up tables are used in place, and reads of the files it contains are
+// served by copying from the mapping, without going through the base hook.
+//
+// Files that are compressed in the package (see AkFilePackageLUT.h) are
+// read through CAkFilePackageDecompressor: the chunks a transfer covers are
+// read from the package (or found in its mapping), and decompressed into the
+// Stream Manager's buffer on worker threads, started when the first package
+// with compressed files is loaded. GetMappedData() returns NULL for them.
+//
 //////////////////////////////////////////////////////////////////////
 
 #ifndef _AK_FILE_PACKAGE_LOW_LEVEL_IO_H_
@@ -52,6 +65,7 @@ written agreement between you and Audiokinetic Inc.
 
 #include <AK/SoundEngine/Common/AkStreamMgrModule.h>
 #include "AkFilePackage.h"
+#include "AkFilePackageDecompressor.h"
 #include <AK/Tools/Common/AkAutoLock.h>
 #include <AK/Tools/Common/AkLock.h>
 
@@ -249,10 +263,12 @@ public:
 			: T_LLIOHOOK::AkFileDescType(in_copy)		
 			, pPackage(in_copy.pPackage)
 			, uBlockSize(in_copy.uBlockSize)
+			, pCompressed(in_copy.pCompressed)
 		{}
 
 		CAkFilePackage* pPackage = nullptr;			///< If this file is in a File Package, this will point to our package.
 		AkUInt32 uBlockSize = 1;					///< Block size for files within a package.
+		const CAkFilePackageLUT::AkCompressedFile* pCompressed = nullptr;	///< Compression map entry of a compressed packaged file.
 	};
 
 	typedef AkPackageFileDesc AkFileDescType;
@@ -274,6 +290,21 @@ public:
         const AkOSChar* in_pszFilePackageName,	// File package name. Location is resolved using base class' Open().
 		AkUInt32 &		out_uPackageID			// Returned package ID.
         );
+
+	// Same as LoadFilePackage(), but maps the package in memory (requires 
+	// T_PACKAGE::CreateMapped()). Falls back on LoadFilePackage() if the
+	// package cannot be mapped.
+	AKRESULT LoadFilePackageMapped(
+		const AkOSChar* in_pszFilePackageName,	// File package name. Location is resolved using base class' Open().
+		AkUInt32 &		out_uPackageID			// Returned package ID.
+		);
+
+	// Address of the data of a file opened from a mapped package, valid until
+	// the file is closed. NULL if the file is not in a mapped package. Lets
+	// callers use the data in place (e.g. AK::SoundEngine::LoadBankMemoryView()).
+	const void * GetMappedData(
+		AkFileDesc*		in_pFileDesc			// File descriptor.
+		) const;
 	
 	// Unload a file package.
 	// Returns AK_Success if in_uPackageID exists, AK_Fail otherwise.
@@ -317,6 +348,10 @@ public:
 	// Override BatchOpen: Files contained in package must be opened differently
 	virtual void BatchOpen(AkUInt32 in_uNumFiles, AkAsyncFileOpenData** in_ppItems) override;
 
+	// Override BatchRead: Files in mapped packages are copied from the mapping,
+	// compressed files are decompressed
+	virtual void BatchRead(AkUInt32 in_uNumTransfers, BatchIoTransferItem* in_pTransferItems) override;
+
 	// Override Close: Do not close handle if file descriptor is part of the current packaged file.
 	virtual AKRESULT Close(
 		AkFileDesc* in_pFileDesc			// File descriptor.
@@ -375,6 +410,20 @@ protected:
 		T_PACKAGE *&			out_pPackage			// Returned package
         );
 
+	// Maps a file package, with a given file package reader.
+	AKRESULT _LoadMappedFilePackage(
+		const AkOSChar*			in_pszFilePackageName,	// File package name.
+		AkFilePackageReader &	in_reader,				// File package reader.
+		T_PACKAGE *&			out_pPackage			// Returned package
+		);
+
+	// Parses the LUT of a newly created package and sets its language.
+	AKRESULT _SetupFilePackage(
+		T_PACKAGE *				in_pPackage,			// Package.
+		AkUInt8 *				in_pHeader,				// Package header, including the header chunk.
+		AkUInt32				in_uHeaderSize			// Size of the header, including the header chunk.
+		);
+
     // Searches the LUT to find the file data associated with the FileID.
     // Returns AK_Success if the file is found.
 	template <class T_FILEID>
@@ -385,6 +434,15 @@ protected:
 		AkPackageFileDesc*&		out_pFileDesc	// Returned file descriptor.
 		);	
 
+	// Same, with the file ID type of the look-up class.
+    AKRESULT FindPackagedFile( 
+		T_PACKAGE *						in_pPackage,	// Package to search into.
+		CAkFilePackageLUT::LookupClass	in_eClass,		// Look-up class of in_pFlags.
+		AkUInt64						in_fileID,		// File ID.
+		AkFileSystemFlags *				in_pFlags,		// Special flags.
+		AkPackageFileDesc*&				out_pFileDesc	// Returned file descriptor.
+		);	
+
 	inline AkPackageFileDesc* CastFileDesc(AkFileDesc* in_pFileDesc) const { return static_cast<AkPackageFileDesc*>(in_pFileDesc); }
 
 protected:
@@ -393,6 +451,8 @@ protected:
 
 	// List of loaded packages.
 	ListFilePackages	m_packages;
+	CAkFilePackageIndex	m_index;		// Package serving each file of m_packages.
+	CAkFilePackageDecompressor	m_decompressor;	// Reads of compressed files.
 	CAkLock				m_lock;
 	bool				m_bRegisteredToLangChg;	// True after registering to language change notifications.
 	bool				m_bFallback;
@@ -34,7 +34,9 @@ written agreement between you and Audiokinetic Inc.
 //
 // LoadFilePackage() returns a package ID that can be used to unload it. Any number
 // of packages can be loaded simultaneously. When Open() is called, the last package 
-// loaded is searched first, then the previous one, and so on.
+// loaded is searched first, then the previous one, and so on. A global index of 
+// the files of all packages (CAkFilePackageIndex), updated as packages are loaded 
+// and unloaded, finds that package directly.
 //
 // The language ID was created dynamically when the package was created. The header 
 // also contains a map of language names (strings) to their ID, so that the proper 
@@ -73,6 +75,7 @@ void CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::Term()
 	if ( m_bRegisteredToLangChg )
 		AK::StreamMgr::RemoveLanguageChangeObserver( this );
 	T_LLIOHOOK::Term();
+	m_decompressor.Term();
 }
 
 // Override Open: Search file in each LUT first. If it cannot be found, use base class services.
@@ -134,6 +137,74 @@ inline void CAkFilePackageLowLevelIO<T_LLIOHOOK, T_PACKAGE>::BatchOpen(AkUInt32
 	}
 }
 
+template<class T_LLIOHOOK, class T_PACKAGE>
+inline void CAkFilePackageLowLevelIO<T_LLIOHOOK, T_PACKAGE>::BatchRead(AkUInt32 in_uNumTransfers, BatchIoTransferItem* in_pTransferItems)
+{
+	AkUInt32 uNumItemsNotMapped = 0;
+	BatchIoTransferItem* arItemsNotMapped = (BatchIoTransferItem*)AkAlloca(sizeof(BatchIoTransferItem) * in_uNumTransfers);
+
+	// Files of mapped packages are copied right away; the packages cannot go away
+	// while their files are open, so no lock is needed.
+	for (int i = 0; i < (int)in_uNumTransfers; i++)
+	{
+		BatchIoTransferItem& item = in_pTransferItems[i];
+		AkPackageFileDesc* pDesc = CastFileDesc(item.pFileDesc);
+		CAkFilePackage* pPackage = pDesc->pPackage;
+		const AkUInt8* pData = pPackage ? pPackage->MappedData() : NULL;
+
+		// Compressed files: their chunks are decompressed on the decompressor's 
+		// threads, from the mapping or after reading them from the package file.
+		if (pDesc->pCompressed)
+		{
+			if (pData)
+			{
+				m_decompressor.DecompressMapped(pPackage->lut, *pDesc->pCompressed, item.pTransferInfo, pData, pPackage->MappedSize());
+				continue;
+			}
+
+			AkFileDesc* pPackageDesc = ((T_PACKAGE*)pPackage)->GetFileDesc();
+			AkAsyncIOTransferInfo* pChunksRead = m_decompressor.ReadChunks(pPackage->lut, *pDesc->pCompressed, item.pTransferInfo, T_LLIOHOOK::GetBlockSize(*pPackageDesc));
+			if (pChunksRead)
+			{
+				arItemsNotMapped[uNumItemsNotMapped] = item;
+				arItemsNotMapped[uNumItemsNotMapped].pFileDesc = pPackageDesc;
+				arItemsNotMapped[uNumItemsNotMapped].pTransferInfo = pChunksRead;
+				uNumItemsNotMapped++;
+			}
+			continue;
+		}
+
+		if (!pData)
+		{
+			arItemsNotMapped[uNumItemsNotMapped] = item;
+			uNumItemsNotMapped++;
+			continue;
+		}
+
+		// uFilePosition is relative to the package file, like for the base hook.
+		// Transfers are rounded up to the block size, so the last one of the last 
+		// file may end past the mapping: it only needs the bytes up to the file's end.
+		AkAsyncIOTransferInfo* pTransferInfo = item.pTransferInfo;
+		AkUInt64 uPosition = pTransferInfo->uFilePosition;
+		AkUInt64 uFileEnd = (AkUInt64)pDesc->uSector * pDesc->uBlockSize + pDesc->iFileSize;
+		AkUInt64 uEnd = uPosition + pTransferInfo->uRequestedSize;
+		AKRESULT eResult = AK_Fail;
+		if (uPosition < uFileEnd && AkMin(uEnd, uFileEnd) <= pPackage->MappedSize())
+		{
+			AkUInt32 uSize = (AkUInt32)(AkMin(uEnd, pPackage->MappedSize()) - uPosition);
+			AKPLATFORM::AkMemCpy(pTransferInfo->pBuffer, pData + uPosition, uSize);
+			pPackage->AdviseRead(uPosition, uSize, item.ioHeuristics.fDeadline, item.ioHeuristics.priority);
+			eResult = AK_Success;
+		}
+		pTransferInfo->pCallback(pTransferInfo, eResult);
+	}
+
+	if (uNumItemsNotMapped > 0)
+	{
+		T_LLIOHOOK::BatchRead(uNumItemsNotMapped, arItemsNotMapped);
+	}
+}
+
 template<class T_LLIOHOOK, class T_PACKAGE>
 inline AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK, T_PACKAGE>::OutputSearchedPaths(
 	AKRESULT in_result,
@@ -222,6 +293,9 @@ void CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::OnLanguageChange(
 		(*it)->lut.SetCurLanguage( in_pLanguageName );
 		++it;
 	}
+
+	// Language-specific files changed in every package.
+	m_index.Rebuild( m_packages );
 }
 
 // Searches the LUT to find the file data associated with the FileID.
@@ -250,6 +324,8 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::FindPackagedFile(
 		out_pFileDesc->uSector	= pEntry->uStartBlock;
 		out_pFileDesc->uBlockSize = pEntry->uBlockSize;
 		out_pFileDesc->pPackage = in_pPackage;
+		out_pFileDesc->pCompressed = in_pPackage->lut.HasCompressedFiles() 
+			? in_pPackage->lut.LookupCompressedFile( (AkUInt64)pEntry->uStartBlock * pEntry->uBlockSize ) : NULL;
 		in_pPackage->AddRef();
 		
 		return AK_Success;
@@ -257,6 +333,20 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::FindPackagedFile(
 	return AK_FileNotFound;
 }
 
+template <class T_LLIOHOOK, class T_PACKAGE>
+AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::FindPackagedFile( 
+	T_PACKAGE *						in_pPackage,	// Package to search into.
+	CAkFilePackageLUT::LookupClass	in_eClass,		// Look-up class of in_pFlags.
+	AkUInt64						in_fileID,		// File ID.
+	AkFileSystemFlags *				in_pFlags,		// Special flags.
+	AkPackageFileDesc*&				out_pFileDesc	// Returned file descriptor.
+	)
+{
+	if ( in_eClass == CAkFilePackageLUT::LookupClass_External )
+		return FindPackagedFile( in_pPackage, in_fileID, in_pFlags, out_pFileDesc );
+	return FindPackagedFile( in_pPackage, (AkFileID)in_fileID, in_pFlags, out_pFileDesc );
+}
+
 // File package loading:
 // Opens a package file, parses its header, fills LUT.
 // Overrides of Open() will search files in loaded LUTs first, then use default Low-Level I/O 
@@ -288,12 +378,60 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::LoadFilePackage(
 		// Add to packages list.
 		AkAutoLock<CAkLock> lock(m_lock);
 		m_packages.AddFirst( pPackage );
+		m_index.AddPackage( pPackage, m_packages );
+		
+		out_uPackageID = pPackage->ID();
+	}
+	return eRes;
+}
+
+// Mapped file package loading: same as LoadFilePackage(), but the package is mapped in memory.
+template <class T_LLIOHOOK, class T_PACKAGE>
+AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::LoadFilePackageMapped(
+    const AkOSChar *    in_pszFilePackageName,	// File package name. 
+	AkUInt32 &			out_uPackageID			// Returned package ID.
+    )
+{
+	// Open package file.
+	AkFilePackageReader filePackageReader;
+	AKRESULT eRes = filePackageReader.Open( in_pszFilePackageName, true );	// Open from SFX-only directory.
+	if ( eRes != AK_Success )
+        return eRes;
+
+	filePackageReader.SetName( in_pszFilePackageName );
+
+	T_PACKAGE * pPackage;
+	eRes = _LoadMappedFilePackage( in_pszFilePackageName, filePackageReader, pPackage );
+	if ( eRes == AK_NotImplemented )
+	{
+		// Could not map it; read it the regular way.
+		eRes = _LoadFilePackage( in_pszFilePackageName, filePackageReader, AK_DEFAULT_PRIORITY, pPackage );
+	}
+
+	if ( eRes == AK_Success
+		|| eRes == AK_InvalidLanguage )
+	{
+		AKASSERT( pPackage );
+		// Add to packages list.
+		AkAutoLock<CAkLock> lock(m_lock);
+		m_packages.AddFirst( pPackage );
+		m_index.AddPackage( pPackage, m_packages );
 		
 		out_uPackageID = pPackage->ID();
 	}
 	return eRes;
 }
 
+template <class T_LLIOHOOK, class T_PACKAGE>
+const void * CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::GetMappedData(
+	AkFileDesc*		in_pFileDesc			// File descriptor.
+	) const
+{
+	AkPackageFileDesc * pDesc = CastFileDesc( in_pFileDesc );
+	if ( !pDesc->pPackage || !pDesc->pPackage->MappedData() || pDesc->pCompressed )
+		return NULL;
+	return pDesc->pPackage->MappedData() + (AkUInt64)pDesc->uSector * pDesc->uBlockSize;
+}
 
 template <class T_LLIOHOOK, class T_PACKAGE>
 AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK, T_PACKAGE>::FindInPackages(
@@ -317,23 +455,31 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK, T_PACKAGE>::FindInPackages(
 		pFileName = szFileName;
 	}
 
+	// File IDs are the same in all packages.
+	CAkFilePackageLUT::LookupClass eClass = CAkFilePackageLUT::GetLookupClass(in_FileOpen.pFlags);
+	AkUInt64 fileID = in_FileOpen.fileID;
+	if (eClass == CAkFilePackageLUT::LookupClass_None)
+		return AK_FileNotFound;
+	else if (eClass == CAkFilePackageLUT::LookupClass_External)
+		fileID = CAkFilePackageLUT::GetExternalID(pFileName);
+	else if (eClass == CAkFilePackageLUT::LookupClass_SoundBank && in_FileOpen.pszFileName)
+		fileID = CAkFilePackageLUT::GetSoundBankID(in_FileOpen.pszFileName);
+
+	// The index knows which package has it.
+	if (m_index.IsValid())
+	{
+		T_PACKAGE* pPackage = (T_PACKAGE*)m_index.Find(eClass, fileID, in_FileOpen.pFlags->bIsLanguageSpecific);
+		if (!pPackage)
+			return AK_FileNotFound;
+		return FindPackagedFile(pPackage, eClass, fileID, in_FileOpen.pFlags, out_pFileDesc);
+	}
+
+	// No index (out of memory): search the packages, most recent first.
 	ListFilePackages::Iterator it = m_packages.Begin();
 	AKRESULT eResult;
 	while (it != m_packages.End())
 	{
-		if (in_FileOpen.pFlags->uCompanyID == AKCOMPANYID_AUDIOKINETIC)
-		{
-			AkFileID fileID = in_FileOpen.fileID;
-			if (AK::IsBankCodecID(in_FileOpen.pFlags->uCodecID) && in_FileOpen.pszFileName)
-				fileID = (*it)->lut.GetSoundBankID(in_FileOpen.pszFileName);
-
-			eResult = FindPackagedFile((T_PACKAGE*)(*it), fileID, in_FileOpen.pFlags, out_pFileDesc);
-		}
-		else
-		{
-			AkUInt64 fileID = (*it)->lut.GetExternalID(pFileName);
-			 eResult = FindPackagedFile((T_PACKAGE*)(*it), fileID, in_FileOpen.pFlags, out_pFileDesc);
-		}
+		eResult = FindPackagedFile((T_PACKAGE*)(*it), eClass, fileID, in_FileOpen.pFlags, out_pFileDesc);
 
 		if (eResult == AK_Success) // Found the ID in the lut.
 		{
@@ -458,20 +604,73 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::_LoadFilePackage(
 		}
 	}
 
+	return _SetupFilePackage( out_pPackage, pFilePackageHeader, uFileHeader.uHeaderSize + AKPK_HEADER_CHUNK_DEF_SIZE );
+}
+
+// Maps a file package, with a given file package reader. The header is parsed in place.
+template <class T_LLIOHOOK, class T_PACKAGE>
+AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::_LoadMappedFilePackage(
+	const AkOSChar*			in_pszFilePackageName,	// File package name. 
+	AkFilePackageReader &	in_reader,				// File package reader.
+	T_PACKAGE *&			out_pPackage			// Returned package
+	)
+{
+	// AK_NotImplemented leaves the reader open, for the regular path.
+	out_pPackage = T_PACKAGE::CreateMapped( in_reader, in_pszFilePackageName );
+	if ( !out_pPackage )
+		return AK_NotImplemented;
+
+	struct AkFilePackageHeader
+	{
+		AkUInt32 uFileFormatTag;
+		AkUInt32 uHeaderSize;
+	};
+
+	AkUInt8 * pData = (AkUInt8*)out_pPackage->MappedData();
+	const AkFilePackageHeader & fileHeader = *(const AkFilePackageHeader*)pData;
+	if ( out_pPackage->MappedSize() < sizeof(AkFilePackageHeader)
+		|| fileHeader.uFileFormatTag != AKPK_FILE_FORMAT_TAG 
+		|| 0 == fileHeader.uHeaderSize 
+		|| (AkUInt64)fileHeader.uHeaderSize + AKPK_HEADER_CHUNK_DEF_SIZE > out_pPackage->MappedSize() )
+	{
+		AKASSERT( !"Invalid file package header" );
+		out_pPackage->Release();	// Also closes the reader.
+		return AK_Fail;
+	}
+
+	return _SetupFilePackage( out_pPackage, pData, fileHeader.uHeaderSize + AKPK_HEADER_CHUNK_DEF_SIZE );
+}
+
+// Parses the LUT of a newly created package and sets its language.
+template <class T_LLIOHOOK, class T_PACKAGE>
+AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::_SetupFilePackage(
+	T_PACKAGE *				in_pPackage,			// Package.
+	AkUInt8 *				in_pHeader,				// Package header, including the header chunk.
+	AkUInt32				in_uHeaderSize			// Size of the header, including the header chunk.
+	)
+{
 	// Parse LUT.
-	eRes = out_pPackage->lut.Setup( pFilePackageHeader, uFileHeader.uHeaderSize + AKPK_HEADER_CHUNK_DEF_SIZE );
+	AKRESULT eRes = in_pPackage->lut.Setup( in_pHeader, in_uHeaderSize );
 	if ( eRes != AK_Success )
 	{
-		out_pPackage->Release();
+		in_pPackage->Release();
 		return eRes;
 	}
 
+	// Start the decompression threads with the first package that needs them.
+	if ( in_pPackage->lut.HasCompressedFiles() && m_decompressor.Init() != AK_Success )
+	{
+		AK::Monitor::PostString("Could not start file package decompression", AK::Monitor::ErrorLevel_Error);
+		in_pPackage->Release();
+		return AK_Fail;
+	}
+
 	// Register to language change notifications if it wasn't already done
 	if ( !m_bRegisteredToLangChg )
 	{
 		if ( AK::StreamMgr::AddLanguageChangeObserver( LanguageChangeHandler, this ) != AK_Success )
 		{
-			out_pPackage->Release();
+			in_pPackage->Release();
 			return AK_Fail;
 		}
 		m_bRegisteredToLangChg = true;
@@ -479,7 +678,7 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::_LoadFilePackage(
 
 	// Use the current language path (if defined) to set the language ID, 
     // for language specific file mapping.
-	return out_pPackage->lut.SetCurLanguage( AK::StreamMgr::GetCurrentLanguage() );
+	return in_pPackage->lut.SetCurLanguage( AK::StreamMgr::GetCurrentLanguage() );
 }
 
 // Unload a file package.
@@ -496,6 +695,7 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::UnloadFilePackage(
 		{
 			CAkFilePackage * pPackage = (*it);
 			it = m_packages.Erase( it );
+			m_index.RemovePackage( pPackage, m_packages );
 
 			// Destroy package.
 			pPackage->Release();
@@ -515,6 +715,7 @@ template <class T_LLIOHOOK, class T_PACKAGE>
 AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK,T_PACKAGE>::UnloadAllFilePackages()
 {
 	AkAutoLock<CAkLock> lock(m_lock);
+	m_index.Term();
 	ListFilePackages::IteratorEx it = m_packages.BeginEx();
 	while ( it != m_packages.End() )
 	{
@@ -0,0 +1,261 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkLz4.cpp
+//
+// See AkLz4.h. No stdafx.h: this file is also built into tools.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "AkLz4.h"
+#include <string.h>
+
+// Format constants.
+#define AK_LZ4_MIN_MATCH		(4)			// Shortest match.
+#define AK_LZ4_LAST_LITERALS	(5)			// The last 5 bytes are always literals.
+#define AK_LZ4_MATCH_LIMIT		(12)		// The last match starts at least 12 bytes before the end.
+#define AK_LZ4_MAX_OFFSET		(65535)
+
+// Compressor hash table: one position per hash of a 4-byte sequence.
+#define AK_LZ4_HASH_BITS		(12)
+
+namespace
+{
+	inline AkUInt32 Read32( const AkUInt8 * in_p )
+	{
+		AkUInt32 u;
+		memcpy( &u, in_p, sizeof( u ) );
+		return u;
+	}
+
+	inline AkUInt32 Hash( AkUInt32 in_uSequence )
+	{
+		return ( in_uSequence * 2654435761U ) >> ( 32 - AK_LZ4_HASH_BITS );
+	}
+
+	// Writes the rest of a length whose 4-bit field is 15.
+	inline AkUInt8 * WriteLength( AkUInt8 * io_p, AkUInt32 in_uLength )
+	{
+		while ( in_uLength >= 255 )
+		{
+			*io_p++ = 255;
+			in_uLength -= 255;
+		}
+		*io_p++ = (AkUInt8)in_uLength;
+		return io_p;
+	}
+
+	// Size of a sequence in the compressed block.
+	inline AkUInt32 SequenceSize( AkUInt32 in_uLiterals, AkUInt32 in_uMatchLength )
+	{
+		AkUInt32 uSize = 1 + in_uLiterals;
+		if ( in_uLiterals >= 15 )
+			uSize += ( in_uLiterals - 15 ) / 255 + 1;
+		if ( in_uMatchLength > 0 )
+		{
+			uSize += 2;
+			if ( in_uMatchLength - AK_LZ4_MIN_MATCH >= 15 )
+				uSize += ( in_uMatchLength - AK_LZ4_MIN_MATCH - 15 ) / 255 + 1;
+		}
+		return uSize;
+	}
+
+	// Writes literals and, if in_uMatchLength > 0, a match.
+	AkUInt8 * WriteSequence(
+		AkUInt8 *			io_p,
+		const AkUInt8 *		in_pLiterals,
+		AkUInt32			in_uLiterals,
+		AkUInt32			in_uOffset,
+		AkUInt32			in_uMatchLength
+		)
+	{
+		AkUInt8 * pToken = io_p++;
+		AkUInt8 uToken = (AkUInt8)( ( in_uLiterals < 15 ? in_uLiterals : 15 ) << 4 );
+		if ( in_uLiterals >= 15 )
+			io_p = WriteLength( io_p, in_uLiterals - 15 );
+		if ( in_uLiterals > 0 )
+			memcpy( io_p, in_pLiterals, in_uLiterals );
+		io_p += in_uLiterals;
+
+		if ( in_uMatchLength > 0 )
+		{
+			*io_p++ = (AkUInt8)( in_uOffset & 0xFF );
+			*io_p++ = (AkUInt8)( in_uOffset >> 8 );
+			AkUInt32 uLength = in_uMatchLength - AK_LZ4_MIN_MATCH;
+			uToken |= (AkUInt8)( uLength < 15 ? uLength : 15 );
+			if ( uLength >= 15 )
+				io_p = WriteLength( io_p, uLength - 15 );
+		}
+		*pToken = uToken;
+		return io_p;
+	}
+
+	// Reads the rest of a length whose 4-bit field is 15. Returns false if
+	// the block ends or the length exceeds in_uMax.
+	inline bool ReadLength( const AkUInt8 *& io_p, const AkUInt8 * in_pEnd, AkUInt32 in_uMax, AkUInt32 & io_uLength )
+	{
+		AkUInt8 uByte;
+		do
+		{
+			if ( io_p >= in_pEnd )
+				return false;
+			uByte = *io_p++;
+			io_uLength += uByte;
+			if ( io_uLength > in_uMax )
+				return false;
+		}
+		while ( uByte == 255 );
+		return true;
+	}
+}
+
+AkUInt32 CAkLz4::Compress(
+	const void *	in_pSrc,
+	AkUInt32		in_uSrcSize,
+	void *			out_pDest,
+	AkUInt32		in_uDestCapacity
+	)
+{
+	const AkUInt8 * pSrc = (const AkUInt8*)in_pSrc;
+	AkUInt8 * pDest = (AkUInt8*)out_pDest;
+	AkUInt8 * pDestEnd = pDest + in_uDestCapacity;
+
+	AkUInt32 uAnchor = 0;	// First byte not written yet.
+	if ( in_uSrcSize > AK_LZ4_MATCH_LIMIT )
+	{
+		// Position + 1 of the last occurrence of each hash; 0 if none.
+		AkUInt32 table[1 << AK_LZ4_HASH_BITS];
+		memset( table, 0, sizeof( table ) );
+
+		AkUInt32 uMatchStartLimit = in_uSrcSize - AK_LZ4_MATCH_LIMIT;
+		AkUInt32 uMatchEndLimit = in_uSrcSize - AK_LZ4_LAST_LITERALS;
+		AkUInt32 uPos = 0;
+		AkUInt32 uMisses = 0;
+		while ( uPos <= uMatchStartLimit )
+		{
+			AkUInt32 uSequence = Read32( pSrc + uPos );
+			AkUInt32 uHash = Hash( uSequence );
+			AkUInt32 uRef = table[uHash];
+			table[uHash] = uPos + 1;
+
+			if ( uRef == 0
+				|| uPos - ( uRef - 1 ) > AK_LZ4_MAX_OFFSET
+				|| Read32( pSrc + uRef - 1 ) != uSequence )
+			{
+				// Incompressible data is skipped faster and faster.
+				uPos += 1 + ( uMisses++ >> 6 );
+				continue;
+			}
+			uMisses = 0;
+			uRef -= 1;
+
+			// Extend the match backwards over pending literals, then forwards.
+			while ( uPos > uAnchor && uRef > 0 && pSrc[uPos - 1] == pSrc[uRef - 1] )
+			{
+				--uPos;
+				--uRef;
+			}
+			AkUInt32 uLength = AK_LZ4_MIN_MATCH;
+			while ( uPos + uLength < uMatchEndLimit && pSrc[uPos + uLength] == pSrc[uRef + uLength] )
+				++uLength;
+
+			AkUInt32 uLiterals = uPos - uAnchor;
+			if ( SequenceSize( uLiterals, uLength ) > (AkUInt32)( pDestEnd - pDest ) )
+				return 0;
+			pDest = WriteSequence( pDest, pSrc + uAnchor, uLiterals, uPos - uRef, uLength );
+
+			uPos += uLength;
+			uAnchor = uPos;
+
+			// Most matches are followed by another one nearby.
+			if ( uPos - 2 <= uMatchStartLimit )
+				table[Hash( Read32( pSrc + uPos - 2 ) )] = uPos - 2 + 1;
+		}
+	}
+
+	// Last literals.
+	AkUInt32 uLiterals = in_uSrcSize - uAnchor;
+	if ( SequenceSize( uLiterals, 0 ) > (AkUInt32)( pDestEnd - pDest ) )
+		return 0;
+	pDest = WriteSequence( pDest, pSrc + uAnchor, uLiterals, 0, 0 );
+
+	return (AkUInt32)( pDest - (AkUInt8*)out_pDest );
+}
+
+AkInt32 CAkLz4::Decompress(
+	const void *	in_pSrc,
+	AkUInt32		in_uSrcSize,
+	void *			out_pDest,
+	AkUInt32		in_uDestCapacity
+	)
+{
+	const AkUInt8 * pSrc = (const AkUInt8*)in_pSrc;
+	const AkUInt8 * pSrcEnd = pSrc + in_uSrcSize;
+	AkUInt8 * pDestStart = (AkUInt8*)out_pDest;
+	AkUInt8 * pDest = pDestStart;
+	AkUInt8 * pDestEnd = pDestStart + in_uDestCapacity;
+
+	for ( ;; )
+	{
+		if ( pSrc >= pSrcEnd )
+			return -1;
+		AkUInt8 uToken = *pSrc++;
+
+		// Literals.
+		AkUInt32 uLiterals = uToken >> 4;
+		if ( uLiterals == 15 && !ReadLength( pSrc, pSrcEnd, in_uDestCapacity, uLiterals ) )
+			return -1;
+		if ( uLiterals > (AkUInt32)( pSrcEnd - pSrc ) || uLiterals > (AkUInt32)( pDestEnd - pDest ) )
+			return -1;
+		memcpy( pDest, pSrc, uLiterals );
+		pSrc += uLiterals;
+		pDest += uLiterals;
+
+		// The last sequence has no match.
+		if ( pSrc == pSrcEnd )
+			break;
+
+		// Match.
+		if ( pSrcEnd - pSrc < 2 )
+			return -1;
+		AkUInt32 uOffset = pSrc[0] | ( (AkUInt32)pSrc[1] << 8 );
+		pSrc += 2;
+		if ( uOffset == 0 || uOffset > (AkUInt32)( pDest - pDestStart ) )
+			return -1;
+
+		AkUInt32 uLength = uToken & 15;
+		if ( uLength == 15 && !ReadLength( pSrc, pSrcEnd, in_uDestCapacity, uLength ) )
+			return -1;
+		uLength += AK_LZ4_MIN_MATCH;
+		if ( uLength > (AkUInt32)( pDestEnd - pDest ) )
+			return -1;
+
+		const AkUInt8 * pRef = pDest - uOffset;
+		if ( uOffset >= uLength )
+		{
+			memcpy( pDest, pRef, uLength );
+			pDest += uLength;
+		}
+		else
+		{
+			// Overlapping: the match repeats its last uOffset bytes.
+			AkUInt8 * pEnd = pDest + uLength;
+			while ( pDest < pEnd )
+				*pDest++ = *pRef++;
+		}
+	}
+
+	return (AkInt32)( pDest - pDestStart );
+}
@@ -0,0 +1,72 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkLz4.h
+//
+// Compression of independent blocks in the LZ4 block format: a sequence
+// of literals followed by a match (2-byte offset in a 64 KB window, length
+// of at least 4), the last sequence having literals only. Blocks written
+// by Compress() can be read by any LZ4 block decoder, and Decompress()
+// reads blocks of any LZ4 block encoder.
+//
+// Decompression is a few hundred MB/s to GB/s per core, faster than any
+// disk; it checks every length and offset, so corrupt data fails instead
+// of reading or writing out of bounds. Compression is greedy, with a
+// single hash table entry per 4-byte sequence; it is meant for offline
+// tools (see AkFilePackageCompressor).
+//
+// Only depends on AkTypes.h, so that tools can use it without the
+// sound engine.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_LZ4_H_
+#define _AK_LZ4_H_
+
+#include <AK/SoundEngine/Common/AkTypes.h>
+
+//-----------------------------------------------------------------------------
+// Name: class CAkLz4
+// Desc: LZ4 block compression and decompression.
+//-----------------------------------------------------------------------------
+class CAkLz4
+{
+public:
+	// Largest compressed size of in_uSize bytes.
+	static inline AkUInt32 CompressBound( AkUInt32 in_uSize )
+	{
+		return in_uSize + in_uSize / 255 + 16;
+	}
+
+	// Compresses a block. Returns the compressed size, or 0 if it does not
+	// fit in in_uDestCapacity bytes (never with CompressBound()).
+	static AkUInt32 Compress(
+		const void *	in_pSrc,			// Data.
+		AkUInt32		in_uSrcSize,		// Size of the data.
+		void *			out_pDest,			// Compressed block.
+		AkUInt32		in_uDestCapacity	// Size of out_pDest.
+		);
+
+	// Decompresses a block. Returns the decompressed size, or -1 if the
+	// block is invalid or does not fit in in_uDestCapacity bytes.
+	static AkInt32 Decompress(
+		const void *	in_pSrc,			// Compressed block.
+		AkUInt32		in_uSrcSize,		// Size of the compressed block.
+		void *			out_pDest,			// Data.
+		AkUInt32		in_uDestCapacity	// Size of out_pDest.
+		);
+};
+
+#endif //_AK_LZ4_H_
@@ -33,6 +33,8 @@ written agreement between you and Audiokinetic Inc.
 #include <stdio.h>
 #include <AK/Tools/Common/AkAssert.h>
 #include <AK/Tools/Common/AkObject.h>
+#include <AK/Tools/Common/AkAutoLock.h>
+#include <stdlib.h>
 
 #include "AkFileHelpers.h"
 #include "AkMultipleFileLocation.h"
@@ -42,8 +44,109 @@ written agreement between you and Audiokinetic Inc.
 #define MAX_EXTENSION_SIZE          (4)     // .xxx
 #define MAX_FILETITLE_SIZE          (MAX_NUMBER_STRING_SIZE+MAX_EXTENSION_SIZE+1)   // null-terminated
 
+#define MAX_INDEX_DEPTH             (4)     // Kind/Language/Subfolder/File
+#define MAX_INDEX_SIZE              (256*1024)  // Files; a base path with more is not indexed
+#define MAX_RESOLVED_FILES          (4096)
+
+#if defined(AK_WIN) || defined(AK_MAC_OS_X) || defined(AK_IOS)
+#define AK_CASE_INSENSITIVE_PATHS
+#endif
+
+namespace
+{
+	const AkUInt64 kHashSeed = 14695981039346656037ULL;	// FNV-1a
+	const AkUInt64 kHashPrime = 1099511628211ULL;
+
+	// Both separators are the same, and case does not matter where the file system ignores it.
+	inline AkOSChar FoldChar(AkOSChar in_c)
+	{
+		if (in_c == '\\')
+			return '/';
+#ifdef AK_CASE_INSENSITIVE_PATHS
+		if (in_c >= 'A' && in_c <= 'Z')
+			return in_c - 'A' + 'a';
+#endif
+		return in_c;
+	}
+
+	inline AkUInt64 HashChar(AkUInt64 in_uHash, AkOSChar in_c)
+	{
+		return (in_uHash ^ (AkUInt64)FoldChar(in_c)) * kHashPrime;
+	}
+
+	inline AkUInt64 HashPath(AkUInt64 in_uHash, const AkOSChar* in_pszPath)
+	{
+		for (; *in_pszPath; ++in_pszPath)
+			in_uHash = HashChar(in_uHash, *in_pszPath);
+		return in_uHash;
+	}
+
+	inline AkUInt64 HashValue(AkUInt64 in_uHash, AkUInt32 in_uValue)
+	{
+		for (AkUInt32 i = 0; i < 4; ++i, in_uValue >>= 8)
+			in_uHash = (in_uHash ^ (in_uValue & 0xFF)) * kHashPrime;
+		return in_uHash;
+	}
+
+	int CompareHashes(const void* in_pA, const void* in_pB)
+	{
+		AkUInt64 a = *(const AkUInt64*)in_pA;
+		AkUInt64 b = *(const AkUInt64*)in_pB;
+		return a < b ? -1 : (a > b ? 1 : 0);
+	}
+
+	// First element not below in_uValue, in an array of structures starting with an AkUInt64.
+	template <class T>
+	AkUInt32 LowerBound(const T* in_pArray, AkUInt32 in_uSize, AkUInt64 in_uValue)
+	{
+		AkUInt32 uLo = 0, uHi = in_uSize;
+		while (uLo < uHi)
+		{
+			AkUInt32 uMid = (uLo + uHi) / 2;
+			if (*(const AkUInt64*)&in_pArray[uMid] < in_uValue)
+				uLo = uMid + 1;
+			else
+				uHi = uMid;
+		}
+		return uLo;
+	}
+
+	// Grows a heap array to hold at least in_uSize elements.
+	template <class T>
+	bool Reserve(T*& io_pArray, AkUInt32& io_uCapacity, AkUInt32 in_uSize)
+	{
+		if (in_uSize <= io_uCapacity)
+			return true;
+		AkUInt32 uCapacity = AkMax(in_uSize, io_uCapacity * 2);
+		uCapacity = AkMax(uCapacity, (AkUInt32)64);
+		T* pArray = (T*)AkRealloc(AkMemID_Streaming, io_pArray, uCapacity * sizeof(T));
+		if (!pArray)
+			return false;
+		io_pArray = pArray;
+		io_uCapacity = uCapacity;
+		return true;
+	}
+
+	// State of the recursive listing of a base path.
+	struct IndexBuilder
+	{
+		CAkMultipleFileLocation* pLocation;
+		AkUInt64* pIndex;
+		AkUInt32 uIndexSize;
+		AkUInt32 uIndexCapacity;
+		AkUInt32 uDepth;
+		size_t uBaseLength;
+		bool bFailed;
+		AkOSChar szPath[AK_MAX_PATH];
+	};
+}
+
 CAkMultipleFileLocation::CAkMultipleFileLocation()
 	: m_bUseSubfoldering(false)
+	, m_bUseDirectoryIndex(true)
+	, m_pResolved(NULL)
+	, m_uNumResolved(0)
+	, m_uResolvedCapacity(0)
 {
 }
 
@@ -60,11 +163,20 @@ void CAkMultipleFileLocation::ClearLocations()
 		while (p)
 		{
 			FilePath* next = p->pNextLightItem;
+			ClearIndex(p);
 			AkDelete(AkMemID_Streaming, p);
 			p = next;
 		}
 	}
 	m_Locations.Term();
+
+	ClearResolved();
+	if (m_pResolved)
+	{
+		AkFree(AkMemID_Streaming, m_pResolved);
+		m_pResolved = NULL;
+		m_uResolvedCapacity = 0;
+	}
 }
 
 AKRESULT CAkMultipleFileLocation::Open(
@@ -98,17 +210,49 @@ AKRESULT CAkMultipleFileLocation::Open(
 	}
 	else
 	{
+		// Only reads are resolved through the indexes: writes may create the file.
+		bool bRead = in_FileOpen.eOpenMode == AK_OpenModeRead;
+		AkUInt64 uKey = 0;
+		if (bRead)
+		{
+			uKey = GetResolvedKey(in_FileOpen);
+			FilePath* pLocation = FindResolved(uKey);
+			if (pLocation && GetFullFilePath(in_FileOpen, szFullFilePath, pLocation->szPath) == AK_Success)
+			{
+				res = PlatformOpenFile(szFullFilePath, in_FileOpen.eOpenMode, in_bOverlapped, out_fileDesc);
+				if (res == AK_Success)
+				{
+					AKASSERT(out_fileDesc.iFileSize != 0);
+					return AK_Success;
+				}
+
+				// Gone since it was found: search again.
+				RemoveResolved(uKey);
+				res = AK_Fail;
+			}
+		}
+
 		for (AkListBareLight<FilePath>::Iterator it = m_Locations.Begin(); it != m_Locations.End(); ++it)
 		{
 			// Get the full file path, using path concatenation logic.
 
 			if (GetFullFilePath(in_FileOpen, szFullFilePath, (*it)->szPath) == AK_Success)
 			{
+				if (bRead && !IsInIndex(*it, szFullFilePath))
+				{
+					res = AkMax(res, AK_FileNotFound);
+					continue;
+				}
+
 				AKRESULT eLocationRes = PlatformOpenFile(szFullFilePath, in_FileOpen.eOpenMode, in_bOverlapped, out_fileDesc);
 				if (eLocationRes == AK_Success)
 				{
 					// iFileSize must be set by the OpenPolicy.
 					AKASSERT((in_FileOpen.eOpenMode == AK_OpenModeRead && out_fileDesc.iFileSize != 0) || in_FileOpen.eOpenMode != AK_OpenModeRead);
+					if (bRead)
+						AddResolved(uKey, *it);
+					else
+						AddToIndex(*it, szFullFilePath);
 					return AK_Success;
 				}
 				// File I/O error codes are more specific as the numerical value goes up, so always prefer the higher ones as the overall result to help debug I/O errors.
@@ -274,8 +418,16 @@ AKRESULT CAkMultipleFileLocation::AddBasePath(const AkOSChar* in_pszBasePath)
 		}
 	}
 	pPath->pNextLightItem = NULL;
+	pPath->pIndex = NULL;
+	pPath->uIndexSize = 0;
+	pPath->uIndexCapacity = 0;
+	pPath->bIndexed = false;
+	BuildIndex(pPath);
 	m_Locations.AddFirst(pPath);
 
+	// Files found before may now resolve to the new path.
+	ClearResolved();
+
 	AKRESULT eDirectoryResult = PlatformCheckDirectoryExists(in_pszBasePath);
 	if (eDirectoryResult != AK_NotImplemented) // AK_NotImplemented could be returned and should be ignored.
 		return eDirectoryResult;
@@ -302,3 +454,222 @@ AKRESULT CAkMultipleFileLocation::PlatformCheckDirectoryExists(const AkOSChar* i
 {
 	return CAkFileHelpers::CheckDirectoryExists(io_pszBasePath);
 }
+
+AKRESULT CAkMultipleFileLocation::PlatformListDirectory(const AkOSChar* in_pszDirectory, AkDirectoryEntryFunc in_pfnEntry, void* in_pCookie)
+{
+	return CAkFileHelpers::ListDirectory(in_pszDirectory, in_pfnEntry, in_pCookie);
+}
+
+void CAkMultipleFileLocation::RefreshDirectoryIndex()
+{
+	for (AkListBareLight<FilePath>::Iterator it = m_Locations.Begin(); it != m_Locations.End(); ++it)
+	{
+		ClearIndex(*it);
+		BuildIndex(*it);
+	}
+	ClearResolved();
+}
+
+void CAkMultipleFileLocation::BuildIndex(FilePath* io_pLocation)
+{
+	if (!m_bUseDirectoryIndex)
+		return;
+
+	IndexBuilder* pBuilder = (IndexBuilder*)AkAlloc(AkMemID_Streaming, sizeof(IndexBuilder));
+	if (!pBuilder)
+		return;
+
+	pBuilder->pLocation = this;
+	pBuilder->pIndex = NULL;
+	pBuilder->uIndexSize = 0;
+	pBuilder->uIndexCapacity = 0;
+	pBuilder->uDepth = 0;
+	pBuilder->bFailed = false;
+	AKPLATFORM::SafeStrCpy(pBuilder->szPath, io_pLocation->szPath, AK_MAX_PATH);
+	pBuilder->uBaseLength = AKPLATFORM::OsStrLen(pBuilder->szPath);
+
+	struct Lister
+	{
+		static void OnEntry(void* in_pCookie, const AkOSChar* in_pszName, bool in_bIsDirectory)
+		{
+			IndexBuilder* pBuilder = (IndexBuilder*)in_pCookie;
+			if (pBuilder->bFailed)
+				return;
+
+			// Append the entry to the current directory.
+			size_t uLength = AKPLATFORM::OsStrLen(pBuilder->szPath);
+			size_t uNameLength = AKPLATFORM::OsStrLen(in_pszName);
+			if (uLength + uNameLength + 2 > AK_MAX_PATH)
+				return;
+			AKPLATFORM::SafeStrCpy(pBuilder->szPath + uLength, in_pszName, AK_MAX_PATH - uLength);
+
+			if (!in_bIsDirectory)
+			{
+				if (pBuilder->uIndexSize == MAX_INDEX_SIZE
+					|| !Reserve(pBuilder->pIndex, pBuilder->uIndexCapacity, pBuilder->uIndexSize + 1))
+				{
+					pBuilder->bFailed = true;
+				}
+				else
+				{
+					pBuilder->pIndex[pBuilder->uIndexSize++] = HashPath(kHashSeed, pBuilder->szPath + pBuilder->uBaseLength);
+				}
+			}
+			else if (pBuilder->uDepth + 1 < MAX_INDEX_DEPTH)
+			{
+				pBuilder->szPath[uLength + uNameLength] = AK_PATH_SEPARATOR[0];
+				pBuilder->szPath[uLength + uNameLength + 1] = 0;
+				++pBuilder->uDepth;
+				pBuilder->pLocation->PlatformListDirectory(pBuilder->szPath, OnEntry, pBuilder);
+				--pBuilder->uDepth;
+			}
+
+			pBuilder->szPath[uLength] = 0;
+		}
+	};
+
+	// A base path that cannot be listed (it may not exist yet) is probed on every open.
+	AKRESULT eResult = PlatformListDirectory(pBuilder->szPath, Lister::OnEntry, pBuilder);
+	if (eResult == AK_Success && !pBuilder->bFailed)
+	{
+		if (pBuilder->uIndexSize > 0)
+			qsort(pBuilder->pIndex, pBuilder->uIndexSize, sizeof(AkUInt64), CompareHashes);
+
+		AkAutoLock<CAkLock> lock(m_lock);
+		io_pLocation->pIndex = pBuilder->pIndex;
+		io_pLocation->uIndexSize = pBuilder->uIndexSize;
+		io_pLocation->uIndexCapacity = pBuilder->uIndexCapacity;
+		io_pLocation->bIndexed = true;
+	}
+	else if (pBuilder->pIndex)
+	{
+		AkFree(AkMemID_Streaming, pBuilder->pIndex);
+	}
+
+	AkFree(AkMemID_Streaming, pBuilder);
+}
+
+void CAkMultipleFileLocation::ClearIndex(FilePath* io_pLocation)
+{
+	AkAutoLock<CAkLock> lock(m_lock);
+	if (io_pLocation->pIndex)
+		AkFree(AkMemID_Streaming, io_pLocation->pIndex);
+	io_pLocation->pIndex = NULL;
+	io_pLocation->uIndexSize = 0;
+	io_pLocation->uIndexCapacity = 0;
+	io_pLocation->bIndexed = false;
+}
+
+bool CAkMultipleFileLocation::IsInIndex(const FilePath* in_pLocation, const AkOSChar* in_pszFullFilePath)
+{
+	if (!in_pLocation->bIndexed)
+		return true;
+
+	// Absolute file names do not depend on the base path.
+	const AkOSChar* pszBase = in_pLocation->szPath;
+	const AkOSChar* pszRelative = in_pszFullFilePath;
+	for (; *pszBase; ++pszBase, ++pszRelative)
+	{
+		if (FoldChar(*pszBase) != FoldChar(*pszRelative))
+			return true;
+	}
+
+	AkUInt64 uHash = HashPath(kHashSeed, pszRelative);
+	AkAutoLock<CAkLock> lock(m_lock);
+	AkUInt32 uPos = LowerBound(in_pLocation->pIndex, in_pLocation->uIndexSize, uHash);
+	return uPos < in_pLocation->uIndexSize && in_pLocation->pIndex[uPos] == uHash;
+}
+
+void CAkMultipleFileLocation::AddToIndex(FilePath* io_pLocation, const AkOSChar* in_pszFullFilePath)
+{
+	if (!io_pLocation->bIndexed)
+		return;
+
+	size_t uBaseLength = AKPLATFORM::OsStrLen(io_pLocation->szPath);
+	if (AKPLATFORM::OsStrLen(in_pszFullFilePath) <= uBaseLength)
+		return;
+	AkUInt64 uHash = HashPath(kHashSeed, in_pszFullFilePath + uBaseLength);
+
+	AkAutoLock<CAkLock> lock(m_lock);
+	AkUInt32 uPos = LowerBound(io_pLocation->pIndex, io_pLocation->uIndexSize, uHash);
+	if (uPos < io_pLocation->uIndexSize && io_pLocation->pIndex[uPos] == uHash)
+		return;
+
+	if (!Reserve(io_pLocation->pIndex, io_pLocation->uIndexCapacity, io_pLocation->uIndexSize + 1))
+	{
+		// Cannot record it: stop trusting the index.
+		io_pLocation->bIndexed = false;
+		return;
+	}
+	memmove(io_pLocation->pIndex + uPos + 1, io_pLocation->pIndex + uPos, (io_pLocation->uIndexSize - uPos) * sizeof(AkUInt64));
+	io_pLocation->pIndex[uPos] = uHash;
+	++io_pLocation->uIndexSize;
+}
+
+AkUInt64 CAkMultipleFileLocation::GetResolvedKey(const AkFileOpenData& in_FileOpen) const
+{
+	// Everything GetFullFilePath() uses, except the base path.
+	AkUInt64 uKey = kHashSeed;
+	if (in_FileOpen.pszFileName)
+		uKey = HashPath(uKey, in_FileOpen.pszFileName);
+	else
+		uKey = HashValue(uKey, in_FileOpen.fileID);
+
+	uKey = HashValue(uKey, m_bUseSubfoldering ? 1 : 0);
+	if (in_FileOpen.pFlags)
+	{
+		uKey = HashValue(uKey, in_FileOpen.pFlags->uCompanyID);
+		uKey = HashValue(uKey, in_FileOpen.pFlags->uCodecID);
+		uKey = HashValue(uKey, in_FileOpen.pFlags->uDirectoryHash);
+		if (in_FileOpen.pFlags->bIsLanguageSpecific)
+			uKey = HashPath(uKey, AK::StreamMgr::GetCurrentLanguage());
+	}
+	return uKey;
+}
+
+CAkMultipleFileLocation::FilePath* CAkMultipleFileLocation::FindResolved(AkUInt64 in_uKey)
+{
+	AkAutoLock<CAkLock> lock(m_lock);
+	AkUInt32 uPos = LowerBound(m_pResolved, m_uNumResolved, in_uKey);
+	if (uPos < m_uNumResolved && m_pResolved[uPos].uKey == in_uKey)
+		return m_pResolved[uPos].pLocation;
+	return NULL;
+}
+
+void CAkMultipleFileLocation::AddResolved(AkUInt64 in_uKey, FilePath* in_pLocation)
+{
+	AkAutoLock<CAkLock> lock(m_lock);
+	if (m_uNumResolved == MAX_RESOLVED_FILES)
+		m_uNumResolved = 0;	// Start over rather than pick entries to drop.
+
+	AkUInt32 uPos = LowerBound(m_pResolved, m_uNumResolved, in_uKey);
+	if (uPos < m_uNumResolved && m_pResolved[uPos].uKey == in_uKey)
+	{
+		m_pResolved[uPos].pLocation = in_pLocation;
+		return;
+	}
+
+	if (!Reserve(m_pResolved, m_uResolvedCapacity, m_uNumResolved + 1))
+		return;
+	memmove(m_pResolved + uPos + 1, m_pResolved + uPos, (m_uNumResolved - uPos) * sizeof(ResolvedFile));
+	m_pResolved[uPos].uKey = in_uKey;
+	m_pResolved[uPos].pLocation = in_pLocation;
+	++m_uNumResolved;
+}
+
+void CAkMultipleFileLocation::RemoveResolved(AkUInt64 in_uKey)
+{
+	AkAutoLock<CAkLock> lock(m_lock);
+	AkUInt32 uPos = LowerBound(m_pResolved, m_uNumResolved, in_uKey);
+	if (uPos < m_uNumResolved && m_pResolved[uPos].uKey == in_uKey)
+	{
+		memmove(m_pResolved + uPos, m_pResolved + uPos + 1, (m_uNumResolved - uPos - 1) * sizeof(ResolvedFile));
+		--m_uNumResolved;
+	}
+}
+
+void CAkMultipleFileLocation::ClearResolved()
+{
+	AkAutoLock<CAkLock> lock(m_lock);
+	m_uNumResolved = 0;
+}
@@ -20,6 +20,14 @@ written agreement between you and Audiokinetic Inc.
 // "Going Further > Overriding Managers > Streaming / Stream Manager > Low-Level I/O"
 // of the SDK documentation. 
 //
+// To avoid probing every base path on each open, the files under a base
+// path are indexed when it is added, and the location a file was found in
+// is remembered. Opens for reading then skip the base paths that do not
+// have the file, and usually go straight to the right one. Files that
+// appear under a base path after it was added are not seen until
+// RefreshDirectoryIndex() is called, except the ones opened for writing
+// through this class.
+//
 //////////////////////////////////////////////////////////////////////
 
 #ifndef _AK_MULTI_FILE_LOCATION_H_
@@ -30,6 +38,8 @@ struct AkFileSystemFlags;
 #include <AK/SoundEngine/Common/IAkStreamMgr.h>
 #include <AK/SoundEngine/Common/AkStreamMgrModule.h>
 #include <AK/Tools/Common/AkListBareLight.h>
+#include <AK/Tools/Common/AkLock.h>
+#include "AkFileHelpersBase.h"
 
 
 // This file location class supports multiple base paths for Wwise file access.
@@ -42,8 +52,19 @@ protected:
 	struct FilePath
 	{
 		FilePath *pNextLightItem;
+		AkUInt64 *pIndex;			// Sorted hashes of the paths of the files under szPath, relative to it.
+		AkUInt32 uIndexSize;
+		AkUInt32 uIndexCapacity;
+		bool bIndexed;				// False if the directory could not be listed: always probed.
 		AkOSChar szPath[1];	//Variable length
 	};
+
+	// A file resolved to the location it was found in.
+	struct ResolvedFile
+	{
+		AkUInt64 uKey;
+		FilePath *pLocation;
+	};
 public:
 	CAkMultipleFileLocation();
 	void Term();
@@ -56,6 +77,7 @@ public:
 	// Audio source path is appended to base path whenever uCompanyID is AK and uCodecID specifies an audio source.
 	// Bank path is appended to base path whenever uCompanyID is AK and uCodecID specifies a sound bank.
 	// Language specific dir name is appended to path whenever "bIsLanguageSpecific" is true.
+	// Adding a base path forgets where files were found, since the new path takes precedence.
 	AKRESULT SetBasePath(const AkOSChar*   in_pszBasePath)
 	{
 		return AddBasePath(in_pszBasePath);
@@ -65,6 +87,13 @@ public:
 
 	void SetUseSubfoldering(bool bUseSubfoldering) { m_bUseSubfoldering = bUseSubfoldering; }
 
+	// Directory indexing of the base paths added after the call. On by default.
+	void SetUseDirectoryIndex(bool bUseDirectoryIndex) { m_bUseDirectoryIndex = bUseDirectoryIndex; }
+
+	// Lists the base paths again and forgets where files were found. Call when files
+	// were added or removed under the base paths (downloaded content, for example).
+	void RefreshDirectoryIndex();
+
 	AKRESULT Open(
 		const AkFileOpenData& in_OpenData,		///< File open information (name, flags, etc)
 		bool			in_bOverlapped,			// Overlapped IO open
@@ -116,8 +145,31 @@ protected:
 	// By default, invokes CAkFileHelpers::CheckDirectoryExists
 	virtual AKRESULT PlatformCheckDirectoryExists(const AkOSChar* io_pszBasePath);
 
+	// Overridable per-platform directory listing, used to index the base paths.
+	// Returns AK_NotImplemented if the platform cannot list directories; the base paths are then always probed.
+	// By default, invokes CAkFileHelpers::ListDirectory
+	virtual AKRESULT PlatformListDirectory(const AkOSChar* in_pszDirectory, AkDirectoryEntryFunc in_pfnEntry, void* in_pCookie);
+
 	AkListBareLight<FilePath> m_Locations;
 	bool m_bUseSubfoldering; // If true, the file resolver will assume auto-generated banks and loose/streamed WEM files are organized in sub-folders
+	bool m_bUseDirectoryIndex;
+
+private:
+	void BuildIndex(FilePath* io_pLocation);
+	void ClearIndex(FilePath* io_pLocation);
+	bool IsInIndex(const FilePath* in_pLocation, const AkOSChar* in_pszFullFilePath);
+	void AddToIndex(FilePath* io_pLocation, const AkOSChar* in_pszFullFilePath);
+
+	AkUInt64 GetResolvedKey(const AkFileOpenData& in_FileOpen) const;
+	FilePath* FindResolved(AkUInt64 in_uKey);
+	void AddResolved(AkUInt64 in_uKey, FilePath* in_pLocation);
+	void RemoveResolved(AkUInt64 in_uKey);
+	void ClearResolved();
+
+	CAkLock m_lock;					// Indexes and resolved files; opens may come from several threads.
+	ResolvedFile* m_pResolved;		// Sorted by key.
+	AkUInt32 m_uNumResolved;
+	AkUInt32 m_uResolvedCapacity;
 };
 
 #endif //_AK_MULTI_FILE_LOCATION_H_
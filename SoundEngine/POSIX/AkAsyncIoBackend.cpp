@@ -0,0 +1,748 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided 
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkAsyncIoBackend.cpp
+//
+// See AkAsyncIoBackend.h.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "AkAsyncIoBackend.h"
+#include <AK/SoundEngine/Common/AkMemoryMgr.h>
+#include <AK/Tools/Common/AkAutoLock.h>
+#include <AK/Tools/Common/AkObject.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(AK_SUPPORT_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace
+{
+	// Skips in_uBytes transferred bytes of a scatter/gather list.
+	void AdvanceIovecs( struct iovec *& io_pIov, AkUInt32 & io_uNumIov, size_t in_uBytes )
+	{
+		while ( io_uNumIov > 0 && in_uBytes >= io_pIov->iov_len )
+		{
+			in_uBytes -= io_pIov->iov_len;
+			++io_pIov;
+			--io_uNumIov;
+		}
+		if ( io_uNumIov > 0 )
+		{
+			io_pIov->iov_base = (char*)io_pIov->iov_base + in_uBytes;
+			io_pIov->iov_len -= in_uBytes;
+		}
+	}
+
+	// Bytes described by the first in_uNumIov entries of a list.
+	inline size_t IovecsSize( const struct iovec * in_pIov, AkUInt32 in_uNumIov )
+	{
+		size_t uSize = 0;
+		for ( AkUInt32 i = 0; i < in_uNumIov; ++i )
+			uSize += in_pIov[i].iov_len;
+		return uSize;
+	}
+
+	// Bytes that must be transferred for the request to succeed.
+	inline AkUInt32 GetMinSize( const AkAsyncIoRequest & in_request )
+	{
+		return ( in_request.bWrite || in_request.uMinSize == 0 ) ? in_request.uSize : in_request.uMinSize;
+	}
+
+	// Transfers the whole request with preadv()/pwritev(), IOV_MAX entries at
+	// a time, continuing after short transfers and interruptions. A read
+	// shorter than what was submitted, past uMinSize, is the end of the file
+	// (direct I/O could not continue from there anyway).
+	AKRESULT TransferBlocking( const AkAsyncIoRequest & in_request )
+	{
+		struct iovec single;
+		struct iovec * pIov = in_request.pIovecs;
+		AkUInt32 uNumIov = in_request.uNumIovecs;
+		if ( uNumIov == 0 )
+		{
+			single.iov_base = in_request.pBuffer;
+			single.iov_len = in_request.uSize;
+			pIov = &single;
+			uNumIov = 1;
+		}
+
+		AkUInt32 uDone = 0;
+		while ( uDone < in_request.uSize )
+		{
+			off_t offset = (off_t)( in_request.uOffset + uDone );
+			int iNumIov = (int)AkMin( uNumIov, (AkUInt32)IOV_MAX );
+			size_t uSubmitted = IovecsSize( pIov, (AkUInt32)iNumIov );
+			ssize_t iResult = in_request.bWrite
+				? pwritev( in_request.fd, pIov, iNumIov, offset )
+				: preadv( in_request.fd, pIov, iNumIov, offset );
+			if ( iResult < 0 && errno == EINTR )
+				continue;
+			if ( iResult < 0 )
+				return AK_Fail;
+
+			bool bShort = (size_t)iResult < uSubmitted;
+			uDone += (AkUInt32)iResult;
+			AdvanceIovecs( pIov, uNumIov, (size_t)iResult );
+			if ( bShort && uDone >= GetMinSize( in_request ) )
+				return AK_Success;
+			if ( iResult == 0 )
+				return AK_Fail;
+		}
+		return AK_Success;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// CAkAsyncIoBackend
+//-----------------------------------------------------------------------------
+CAkAsyncIoBackend * CAkAsyncIoBackend::Create(
+	const AkAsyncIoSettings &	in_settings
+	)
+{
+#if defined(AK_SUPPORT_IO_URING)
+	if ( in_settings.eType != AkAsyncIoBackend_ThreadPool )
+	{
+		CAkAsyncIoBackend * pUring = AkNew( AkMemID_Streaming, CAkIoUringBackend() );
+		if ( pUring && pUring->Init( in_settings ) == AK_Success )
+			return pUring;
+		Destroy( pUring );
+		if ( in_settings.eType == AkAsyncIoBackend_IoUring )
+			return NULL;
+	}
+#else
+	if ( in_settings.eType == AkAsyncIoBackend_IoUring )
+		return NULL;
+#endif
+
+	CAkAsyncIoBackend * pPool = AkNew( AkMemID_Streaming, CAkThreadPoolIoBackend() );
+	if ( pPool && pPool->Init( in_settings ) == AK_Success )
+		return pPool;
+	Destroy( pPool );
+	return NULL;
+}
+
+void CAkAsyncIoBackend::Destroy( CAkAsyncIoBackend * in_pBackend )
+{
+	if ( in_pBackend )
+		AkDelete( AkMemID_Streaming, in_pBackend );
+}
+
+//-----------------------------------------------------------------------------
+// CAkThreadPoolIoBackend
+//-----------------------------------------------------------------------------
+CAkThreadPoolIoBackend::CAkThreadPoolIoBackend()
+	: m_pQueue( NULL )
+	, m_uQueueSize( 0 )
+	, m_uHead( 0 )
+	, m_uCount( 0 )
+	, m_bSemaphores( false )
+	, m_pThreads( NULL )
+	, m_uNumThreads( 0 )
+{
+	AKPLATFORM::AkClearSemaphore( m_semItems );
+	AKPLATFORM::AkClearSemaphore( m_semSpace );
+}
+
+CAkThreadPoolIoBackend::~CAkThreadPoolIoBackend()
+{
+	Term();
+}
+
+AKRESULT CAkThreadPoolIoBackend::Init( const AkAsyncIoSettings & in_settings )
+{
+	AKASSERT( in_settings.uQueueDepth > 0 && in_settings.uNumThreads > 0 );
+
+	// Room for a stop request per thread on top of the queue depth.
+	m_uQueueSize = in_settings.uQueueDepth + in_settings.uNumThreads;
+	m_pQueue = (AkAsyncIoRequest*)AkAlloc( AkMemID_Streaming, m_uQueueSize * sizeof( AkAsyncIoRequest ) );
+	m_pThreads = (AkThread*)AkAlloc( AkMemID_Streaming, in_settings.uNumThreads * sizeof( AkThread ) );
+	if ( !m_pQueue || !m_pThreads )
+		return AK_InsufficientMemory;
+
+	if ( AKPLATFORM::AkCreateSemaphore( m_semItems, 0 ) != AK_Success )
+		return AK_Fail;
+	if ( AKPLATFORM::AkCreateSemaphore( m_semSpace, m_uQueueSize ) != AK_Success )
+	{
+		AKPLATFORM::AkDestroySemaphore( m_semItems );
+		AKPLATFORM::AkClearSemaphore( m_semItems );
+		return AK_Fail;
+	}
+	m_bSemaphores = true;
+
+	AkThreadProperties threadProps;
+	AKPLATFORM::AkGetDefaultHighPriorityThreadProperties( threadProps );
+	for ( AkUInt32 i = 0; i < in_settings.uNumThreads; ++i )
+	{
+		AKPLATFORM::AkClearThread( &m_pThreads[i] );
+		AKPLATFORM::AkCreateThread( WorkerThreadFunc, this, threadProps, &m_pThreads[i], "AK::IoThreadPool" );
+		if ( !AKPLATFORM::AkIsValidThread( &m_pThreads[i] ) )
+			return AK_Fail;
+		++m_uNumThreads;
+	}
+	return AK_Success;
+}
+
+void CAkThreadPoolIoBackend::Term()
+{
+	// One stop request per running thread, queued behind the real ones.
+	AkAsyncIoRequest stop = {};
+	stop.fd = -1;
+	for ( AkUInt32 i = 0; i < m_uNumThreads; ++i )
+		Submit( &stop, 1 );
+	for ( AkUInt32 i = 0; i < m_uNumThreads; ++i )
+	{
+		AKPLATFORM::AkWaitForSingleThread( &m_pThreads[i] );
+		AKPLATFORM::AkCloseThread( &m_pThreads[i] );
+	}
+	m_uNumThreads = 0;
+
+	if ( m_pThreads )
+	{
+		AkFree( AkMemID_Streaming, m_pThreads );
+		m_pThreads = NULL;
+	}
+	if ( m_pQueue )
+	{
+		AkFree( AkMemID_Streaming, m_pQueue );
+		m_pQueue = NULL;
+	}
+	// The destructor calls Term() again.
+	if ( m_bSemaphores )
+	{
+		AKPLATFORM::AkDestroySemaphore( m_semItems );
+		AKPLATFORM::AkDestroySemaphore( m_semSpace );
+		AKPLATFORM::AkClearSemaphore( m_semItems );
+		AKPLATFORM::AkClearSemaphore( m_semSpace );
+		m_bSemaphores = false;
+	}
+}
+
+void CAkThreadPoolIoBackend::Submit( const AkAsyncIoRequest * in_pRequests, AkUInt32 in_uNumRequests )
+{
+	for ( AkUInt32 i = 0; i < in_uNumRequests; ++i )
+	{
+		AKPLATFORM::AkWaitForSemaphore( m_semSpace );
+		{
+			AkAutoLock<CAkLock> lock( m_lock );
+			m_pQueue[( m_uHead + m_uCount ) % m_uQueueSize] = in_pRequests[i];
+			++m_uCount;
+		}
+		AKPLATFORM::AkReleaseSemaphore( m_semItems, 1 );
+	}
+}
+
+AK_DECLARE_THREAD_ROUTINE( CAkThreadPoolIoBackend::WorkerThreadFunc )
+{
+	CAkThreadPoolIoBackend * pThis = AK_GET_THREAD_ROUTINE_PARAMETER_PTR( CAkThreadPoolIoBackend );
+	AK_INSTRUMENT_THREAD_START( "CAkThreadPoolIoBackend::WorkerThreadFunc" );
+
+	for ( ;; )
+	{
+		AKPLATFORM::AkWaitForSemaphore( pThis->m_semItems );
+		AkAsyncIoRequest request;
+		{
+			AkAutoLock<CAkLock> lock( pThis->m_lock );
+			request = pThis->m_pQueue[pThis->m_uHead];
+			pThis->m_uHead = ( pThis->m_uHead + 1 ) % pThis->m_uQueueSize;
+			--pThis->m_uCount;
+		}
+		AKPLATFORM::AkReleaseSemaphore( pThis->m_semSpace, 1 );
+
+		if ( request.fd < 0 )
+			break;
+
+		request.pfnCompletion( request.pCookie, TransferBlocking( request ) );
+	}
+
+	AkExitThread( AK_RETURN_THREAD_OK );
+}
+
+#if defined(AK_SUPPORT_IO_URING)
+
+//-----------------------------------------------------------------------------
+// CAkIoUringBackend
+//-----------------------------------------------------------------------------
+
+// Reserved user_data values; anything else is a slot index.
+#define AK_IOURING_STOP_TOKEN		(~(AkUInt64)0)
+
+// Size of the registered file table. Files opened beyond that are used
+// unregistered.
+#define AK_IOURING_MAX_FIXED_FILES	(256)
+#define AK_IOURING_MAX_FD			(4096)
+
+namespace
+{
+	int IoUringSetup( unsigned in_uEntries, io_uring_params * io_pParams )
+	{
+		return (int)syscall( __NR_io_uring_setup, in_uEntries, io_pParams );
+	}
+
+	int IoUringEnter( int in_ringFd, unsigned in_uToSubmit, unsigned in_uMinComplete, unsigned in_uFlags )
+	{
+		return (int)syscall( __NR_io_uring_enter, in_ringFd, in_uToSubmit, in_uMinComplete, in_uFlags, NULL, 0 );
+	}
+
+	int IoUringRegister( int in_ringFd, unsigned in_uOpcode, const void * in_pArg, unsigned in_uNumArgs )
+	{
+		return (int)syscall( __NR_io_uring_register, in_ringFd, in_uOpcode, in_pArg, in_uNumArgs );
+	}
+}
+
+CAkIoUringBackend::CAkIoUringBackend()
+	: m_ringFd( -1 )
+	, m_pSqRing( MAP_FAILED )
+	, m_uSqRingSize( 0 )
+	, m_pSqHead( NULL )
+	, m_pSqTail( NULL )
+	, m_uSqMask( 0 )
+	, m_pSqArray( NULL )
+	, m_pSqes( (io_uring_sqe*)MAP_FAILED )
+	, m_uSqesSize( 0 )
+	, m_pCqRing( MAP_FAILED )
+	, m_uCqRingSize( 0 )
+	, m_pCqHead( NULL )
+	, m_pCqTail( NULL )
+	, m_uCqMask( 0 )
+	, m_pCqes( NULL )
+	, m_pSlots( NULL )
+	, m_pFreeSlots( NULL )
+	, m_uNumSlots( 0 )
+	, m_uNumFree( 0 )
+	, m_pFixedBuffer( NULL )
+	, m_uFixedBufferSize( 0 )
+	, m_pFixedFileOfFd( NULL )
+	, m_uMaxFd( 0 )
+	, m_pFreeFixedFiles( NULL )
+	, m_uNumFreeFixedFiles( 0 )
+	, m_bFilesRegistered( false )
+{
+	AKPLATFORM::AkClearEvent( m_eventSlotFreed );
+	AKPLATFORM::AkClearThread( &m_reaper );
+}
+
+CAkIoUringBackend::~CAkIoUringBackend()
+{
+	Term();
+}
+
+AKRESULT CAkIoUringBackend::Init( const AkAsyncIoSettings & in_settings )
+{
+	AKASSERT( in_settings.uQueueDepth > 0 );
+
+	// Every slot has at most one entry in the submission queue, plus one for
+	// the stop request.
+	io_uring_params params;
+	memset( &params, 0, sizeof( params ) );
+	m_ringFd = IoUringSetup( in_settings.uQueueDepth + 1, &params );
+	if ( m_ringFd < 0 )
+		return AK_Fail;
+
+	m_uSqRingSize = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+	m_uCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+	if ( params.features & IORING_FEAT_SINGLE_MMAP )
+	{
+		if ( m_uCqRingSize > m_uSqRingSize )
+			m_uSqRingSize = m_uCqRingSize;
+		m_uCqRingSize = m_uSqRingSize;
+	}
+
+	m_pSqRing = mmap( NULL, m_uSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING );
+	if ( m_pSqRing == MAP_FAILED )
+		return AK_Fail;
+
+	if ( params.features & IORING_FEAT_SINGLE_MMAP )
+	{
+		m_pCqRing = m_pSqRing;
+	}
+	else
+	{
+		m_pCqRing = mmap( NULL, m_uCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_CQ_RING );
+		if ( m_pCqRing == MAP_FAILED )
+			return AK_Fail;
+	}
+
+	m_uSqesSize = params.sq_entries * sizeof( io_uring_sqe );
+	m_pSqes = (io_uring_sqe*)mmap( NULL, m_uSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES );
+	if ( m_pSqes == MAP_FAILED )
+		return AK_Fail;
+
+	char * pSq = (char*)m_pSqRing;
+	m_pSqHead = (unsigned*)( pSq + params.sq_off.head );
+	m_pSqTail = (unsigned*)( pSq + params.sq_off.tail );
+	m_uSqMask = *(unsigned*)( pSq + params.sq_off.ring_mask );
+	m_pSqArray = (unsigned*)( pSq + params.sq_off.array );
+
+	char * pCq = (char*)m_pCqRing;
+	m_pCqHead = (unsigned*)( pCq + params.cq_off.head );
+	m_pCqTail = (unsigned*)( pCq + params.cq_off.tail );
+	m_uCqMask = *(unsigned*)( pCq + params.cq_off.ring_mask );
+	m_pCqes = (io_uring_cqe*)( pCq + params.cq_off.cqes );
+
+	m_uNumSlots = in_settings.uQueueDepth;
+	m_pSlots = (Slot*)AkAlloc( AkMemID_Streaming, m_uNumSlots * sizeof( Slot ) );
+	m_pFreeSlots = (AkUInt32*)AkAlloc( AkMemID_Streaming, m_uNumSlots * sizeof( AkUInt32 ) );
+	if ( !m_pSlots || !m_pFreeSlots )
+		return AK_InsufficientMemory;
+	for ( AkUInt32 i = 0; i < m_uNumSlots; ++i )
+		m_pFreeSlots[i] = m_uNumSlots - 1 - i;
+	m_uNumFree = m_uNumSlots;
+
+	if ( AKPLATFORM::AkCreateEvent( m_eventSlotFreed ) != AK_Success )
+		return AK_Fail;
+
+	// Sparse file table; entries are filled by RegisterFile(). Without it
+	// (older kernels) files are simply used unregistered.
+	m_uMaxFd = AK_IOURING_MAX_FD;
+	m_pFixedFileOfFd = (AkInt32*)AkAlloc( AkMemID_Streaming, m_uMaxFd * sizeof( AkInt32 ) );
+	m_pFreeFixedFiles = (AkInt32*)AkAlloc( AkMemID_Streaming, AK_IOURING_MAX_FIXED_FILES * sizeof( AkInt32 ) );
+	if ( !m_pFixedFileOfFd || !m_pFreeFixedFiles )
+		return AK_InsufficientMemory;
+	for ( AkUInt32 i = 0; i < m_uMaxFd; ++i )
+		m_pFixedFileOfFd[i] = -1;
+
+	AkInt32 sparseFiles[AK_IOURING_MAX_FIXED_FILES];
+	for ( AkUInt32 i = 0; i < AK_IOURING_MAX_FIXED_FILES; ++i )
+	{
+		sparseFiles[i] = -1;
+		m_pFreeFixedFiles[i] = AK_IOURING_MAX_FIXED_FILES - 1 - i;
+	}
+	m_bFilesRegistered = IoUringRegister( m_ringFd, IORING_REGISTER_FILES, sparseFiles, AK_IOURING_MAX_FIXED_FILES ) == 0;
+	m_uNumFreeFixedFiles = m_bFilesRegistered ? AK_IOURING_MAX_FIXED_FILES : 0;
+
+	AkThreadProperties threadProps;
+	AKPLATFORM::AkGetDefaultHighPriorityThreadProperties( threadProps );
+	AKPLATFORM::AkCreateThread( ReaperThreadFunc, this, threadProps, &m_reaper, "AK::IoUringReaper" );
+	if ( !AKPLATFORM::AkIsValidThread( &m_reaper ) )
+		return AK_Fail;
+
+	return AK_Success;
+}
+
+void CAkIoUringBackend::Term()
+{
+	if ( AKPLATFORM::AkIsValidThread( &m_reaper ) )
+	{
+		// The stop request completes after everything submitted before it,
+		// since the reaper only exits once all slots are back.
+		{
+			AkAutoLock<CAkLock> lock( m_lock );
+			unsigned uTail = *m_pSqTail;
+			io_uring_sqe * pSqe = &m_pSqes[uTail & m_uSqMask];
+			memset( pSqe, 0, sizeof( *pSqe ) );
+			pSqe->opcode = IORING_OP_NOP;
+			pSqe->user_data = AK_IOURING_STOP_TOKEN;
+			m_pSqArray[uTail & m_uSqMask] = uTail & m_uSqMask;
+			__atomic_store_n( m_pSqTail, uTail + 1, __ATOMIC_RELEASE );
+		}
+		Enter( 1, 0 );
+
+		AKPLATFORM::AkWaitForSingleThread( &m_reaper );
+		AKPLATFORM::AkCloseThread( &m_reaper );
+		AKPLATFORM::AkClearThread( &m_reaper );
+	}
+
+	UnmapRings();
+
+	if ( m_pSlots )
+	{
+		AkFree( AkMemID_Streaming, m_pSlots );
+		m_pSlots = NULL;
+	}
+	if ( m_pFreeSlots )
+	{
+		AkFree( AkMemID_Streaming, m_pFreeSlots );
+		m_pFreeSlots = NULL;
+	}
+	if ( m_pFixedFileOfFd )
+	{
+		AkFree( AkMemID_Streaming, m_pFixedFileOfFd );
+		m_pFixedFileOfFd = NULL;
+	}
+	if ( m_pFreeFixedFiles )
+	{
+		AkFree( AkMemID_Streaming, m_pFreeFixedFiles );
+		m_pFreeFixedFiles = NULL;
+	}
+	AKPLATFORM::AkDestroyEvent( m_eventSlotFreed );
+}
+
+void CAkIoUringBackend::UnmapRings()
+{
+	if ( m_pSqes != MAP_FAILED )
+		munmap( m_pSqes, m_uSqesSize );
+	if ( m_pCqRing != MAP_FAILED && m_pCqRing != m_pSqRing )
+		munmap( m_pCqRing, m_uCqRingSize );
+	if ( m_pSqRing != MAP_FAILED )
+		munmap( m_pSqRing, m_uSqRingSize );
+	m_pSqes = (io_uring_sqe*)MAP_FAILED;
+	m_pCqRing = MAP_FAILED;
+	m_pSqRing = MAP_FAILED;
+
+	if ( m_ringFd >= 0 )
+	{
+		close( m_ringFd );
+		m_ringFd = -1;
+	}
+}
+
+void CAkIoUringBackend::RegisterBuffer( void * in_pMemory, AkUInt64 in_uSize )
+{
+	struct iovec iov;
+	iov.iov_base = in_pMemory;
+	iov.iov_len = (size_t)in_uSize;
+	if ( IoUringRegister( m_ringFd, IORING_REGISTER_BUFFERS, &iov, 1 ) == 0 )
+	{
+		m_pFixedBuffer = (char*)in_pMemory;
+		m_uFixedBufferSize = in_uSize;
+	}
+}
+
+void CAkIoUringBackend::RegisterFile( int in_fd )
+{
+	AkAutoLock<CAkLock> lock( m_lock );
+	if ( !m_bFilesRegistered || in_fd < 0 || (AkUInt32)in_fd >= m_uMaxFd || m_uNumFreeFixedFiles == 0 )
+		return;
+
+	AkInt32 iIndex = m_pFreeFixedFiles[m_uNumFreeFixedFiles - 1];
+	io_uring_files_update update;
+	memset( &update, 0, sizeof( update ) );
+	update.offset = (unsigned)iIndex;
+	update.fds = (AkUInt64)(uintptr_t)&in_fd;
+	if ( IoUringRegister( m_ringFd, IORING_REGISTER_FILES_UPDATE, &update, 1 ) == 1 )
+	{
+		--m_uNumFreeFixedFiles;
+		m_pFixedFileOfFd[in_fd] = iIndex;
+	}
+}
+
+void CAkIoUringBackend::UnregisterFile( int in_fd )
+{
+	AkAutoLock<CAkLock> lock( m_lock );
+	if ( in_fd < 0 || (AkUInt32)in_fd >= m_uMaxFd || m_pFixedFileOfFd[in_fd] < 0 )
+		return;
+
+	AkInt32 iIndex = m_pFixedFileOfFd[in_fd];
+	AkInt32 iNone = -1;
+	io_uring_files_update update;
+	memset( &update, 0, sizeof( update ) );
+	update.offset = (unsigned)iIndex;
+	update.fds = (AkUInt64)(uintptr_t)&iNone;
+	IoUringRegister( m_ringFd, IORING_REGISTER_FILES_UPDATE, &update, 1 );
+
+	m_pFixedFileOfFd[in_fd] = -1;
+	m_pFreeFixedFiles[m_uNumFreeFixedFiles++] = iIndex;
+}
+
+void CAkIoUringBackend::QueueSlot( AkUInt32 in_uSlot )
+{
+	Slot & slot = m_pSlots[in_uSlot];
+	const AkAsyncIoRequest & request = slot.request;
+
+	unsigned uTail = *m_pSqTail;
+	io_uring_sqe * pSqe = &m_pSqes[uTail & m_uSqMask];
+	memset( pSqe, 0, sizeof( *pSqe ) );
+
+	if ( slot.iFixedFile >= 0 )
+	{
+		pSqe->fd = slot.iFixedFile;
+		pSqe->flags = IOSQE_FIXED_FILE;
+	}
+	else
+	{
+		pSqe->fd = request.fd;
+	}
+	pSqe->off = request.uOffset + slot.uDone;
+	pSqe->user_data = in_uSlot;
+
+	char * pBuffer = (char*)slot.pIov->iov_base;
+	size_t uSize = slot.pIov->iov_len;
+	if ( slot.uNumIov == 1 && m_pFixedBuffer && pBuffer >= m_pFixedBuffer && pBuffer + uSize <= m_pFixedBuffer + m_uFixedBufferSize )
+	{
+		pSqe->opcode = request.bWrite ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+		pSqe->addr = (AkUInt64)(uintptr_t)pBuffer;
+		pSqe->len = (AkUInt32)uSize;
+		pSqe->buf_index = 0;
+		slot.uSubmitted = (AkUInt32)uSize;
+	}
+	else
+	{
+		// Longer lists go IOV_MAX entries at a time; OnCompletion() queues the rest.
+		pSqe->opcode = request.bWrite ? IORING_OP_WRITEV : IORING_OP_READV;
+		pSqe->addr = (AkUInt64)(uintptr_t)slot.pIov;
+		pSqe->len = AkMin( slot.uNumIov, (AkUInt32)IOV_MAX );
+		slot.uSubmitted = (AkUInt32)IovecsSize( slot.pIov, pSqe->len );
+	}
+
+	m_pSqArray[uTail & m_uSqMask] = uTail & m_uSqMask;
+	__atomic_store_n( m_pSqTail, uTail + 1, __ATOMIC_RELEASE );
+}
+
+void CAkIoUringBackend::Enter( AkUInt32 in_uToSubmit, AkUInt32 in_uMinComplete )
+{
+	// The kernel submits whatever is queued, which may include entries of
+	// another thread, or none if another thread got there first.
+	unsigned uFlags = in_uMinComplete ? IORING_ENTER_GETEVENTS : 0;
+	for ( ;; )
+	{
+		if ( IoUringEnter( m_ringFd, in_uToSubmit, in_uMinComplete, uFlags ) >= 0 )
+			return;
+		if ( errno != EINTR && errno != EAGAIN && errno != EBUSY )
+		{
+			AKASSERT( !"io_uring_enter failed" );
+			return;
+		}
+	}
+}
+
+void CAkIoUringBackend::Submit( const AkAsyncIoRequest * in_pRequests, AkUInt32 in_uNumRequests )
+{
+	AkUInt32 uPending = 0;
+	for ( AkUInt32 i = 0; i < in_uNumRequests; ++i )
+	{
+		m_lock.Lock();
+		while ( m_uNumFree == 0 )
+		{
+			// Queue full: hand what is queued to the kernel, then wait for the
+			// reaper to free a slot.
+			m_lock.Unlock();
+			Enter( uPending, 0 );
+			uPending = 0;
+			AKPLATFORM::AkWaitForEvent( m_eventSlotFreed );
+			m_lock.Lock();
+		}
+
+		AkUInt32 uSlot = m_pFreeSlots[--m_uNumFree];
+		Slot & slot = m_pSlots[uSlot];
+		slot.request = in_pRequests[i];
+		slot.uDone = 0;
+		if ( slot.request.uNumIovecs > 0 )
+		{
+			slot.pIov = slot.request.pIovecs;
+			slot.uNumIov = slot.request.uNumIovecs;
+		}
+		else
+		{
+			slot.iov.iov_base = slot.request.pBuffer;
+			slot.iov.iov_len = slot.request.uSize;
+			slot.pIov = &slot.iov;
+			slot.uNumIov = 1;
+		}
+		int fd = slot.request.fd;
+		slot.iFixedFile = ( fd >= 0 && (AkUInt32)fd < m_uMaxFd ) ? m_pFixedFileOfFd[fd] : -1;
+		QueueSlot( uSlot );
+		++uPending;
+		m_lock.Unlock();
+	}
+
+	// One system call for the whole batch.
+	Enter( uPending, 0 );
+}
+
+void CAkIoUringBackend::ReleaseSlot( AkUInt32 in_uSlot )
+{
+	{
+		AkAutoLock<CAkLock> lock( m_lock );
+		m_pFreeSlots[m_uNumFree++] = in_uSlot;
+	}
+	AKPLATFORM::AkSignalEvent( m_eventSlotFreed );
+}
+
+void CAkIoUringBackend::OnCompletion( AkUInt64 in_uUserData, AkInt32 in_iResult )
+{
+	AkUInt32 uSlot = (AkUInt32)in_uUserData;
+	Slot & slot = m_pSlots[uSlot];
+
+	bool bShort = false;
+	if ( in_iResult == -EINTR || in_iResult == -EAGAIN || in_iResult > 0 )
+	{
+		if ( in_iResult > 0 )
+		{
+			bShort = (AkUInt32)in_iResult < slot.uSubmitted;
+			slot.uDone += (AkUInt32)in_iResult;
+			AdvanceIovecs( slot.pIov, slot.uNumIov, (size_t)in_iResult );
+		}
+
+		// A read shorter than what was submitted, past uMinSize, is the end
+		// of the file. Otherwise, queue the rest.
+		if ( slot.uDone < slot.request.uSize && !( bShort && slot.uDone >= GetMinSize( slot.request ) ) )
+		{
+			{
+				AkAutoLock<CAkLock> lock( m_lock );
+				QueueSlot( uSlot );
+			}
+			Enter( 1, 0 );
+			return;
+		}
+	}
+
+	AKRESULT eResult = ( in_iResult >= 0 && slot.uDone >= GetMinSize( slot.request ) ) ? AK_Success : AK_Fail;
+	AkAsyncIoCompletionFunc pfnCompletion = slot.request.pfnCompletion;
+	void * pCookie = slot.request.pCookie;
+
+	// Free the slot first: the callback may submit more transfers.
+	ReleaseSlot( uSlot );
+	pfnCompletion( pCookie, eResult );
+}
+
+AK_DECLARE_THREAD_ROUTINE( CAkIoUringBackend::ReaperThreadFunc )
+{
+	CAkIoUringBackend * pThis = AK_GET_THREAD_ROUTINE_PARAMETER_PTR( CAkIoUringBackend );
+	AK_INSTRUMENT_THREAD_START( "CAkIoUringBackend::ReaperThreadFunc" );
+
+	bool bStopping = false;
+	for ( ;; )
+	{
+		unsigned uHead = *pThis->m_pCqHead;
+		unsigned uTail = __atomic_load_n( pThis->m_pCqTail, __ATOMIC_ACQUIRE );
+		if ( uHead == uTail )
+		{
+			if ( bStopping )
+			{
+				AkAutoLock<CAkLock> lock( pThis->m_lock );
+				if ( pThis->m_uNumFree == pThis->m_uNumSlots )
+					break;
+			}
+			pThis->Enter( 0, 1 );
+			continue;
+		}
+
+		for ( ; uHead != uTail; ++uHead )
+		{
+			const io_uring_cqe & cqe = pThis->m_pCqes[uHead & pThis->m_uCqMask];
+			AkUInt64 uUserData = cqe.user_data;
+			AkInt32 iResult = cqe.res;
+
+			// Hand the entry back before the callback, which may take a while.
+			__atomic_store_n( pThis->m_pCqHead, uHead + 1, __ATOMIC_RELEASE );
+
+			if ( uUserData == AK_IOURING_STOP_TOKEN )
+				bStopping = true;
+			else
+				pThis->OnCompletion( uUserData, iResult );
+		}
+	}
+
+	AkExitThread( AK_RETURN_THREAD_OK );
+}
+
+#endif // AK_SUPPORT_IO_URING
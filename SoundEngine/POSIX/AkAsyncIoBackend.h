@@ -0,0 +1,250 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided 
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkAsyncIoBackend.h
+//
+// Asynchronous file transfers for the POSIX deferred low-level IO hook.
+//
+// Submit() queues a batch of reads and writes and returns; each one is
+// completed later, on another thread, through its completion function.
+// A transfer succeeds only if all of its bytes were transferred (short
+// transfers are continued, end of file is a failure). A transfer is either
+// one buffer or a list of buffers filled in order (preadv()/pwritev()).
+//
+// Two implementations:
+// - CAkIoUringBackend (Linux): one io_uring, driven with raw system calls.
+//   A batch is queued and submitted with a single io_uring_enter(), and a
+//   reaper thread waits for completions. Files and one buffer (normally the
+//   Stream Manager's I/O memory) can be registered with the ring, so the
+//   kernel does not look them up again for every transfer.
+// - CAkThreadPoolIoBackend: worker threads doing pread()/pwrite(). Used
+//   where io_uring is unavailable: other platforms, old kernels, or
+//   sandboxes that block it.
+//
+// CAkAsyncIoBackend::Create() picks io_uring when it can be set up, and the
+// thread pool otherwise.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_ASYNC_IO_BACKEND_H_
+#define _AK_ASYNC_IO_BACKEND_H_
+
+#include <AK/SoundEngine/Common/AkTypes.h>
+#include <AK/Tools/Common/AkPlatformFuncs.h>
+#include <AK/Tools/Common/AkLock.h>
+#include <sys/uio.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define AK_SUPPORT_IO_URING
+#endif
+#endif
+
+typedef void (*AkAsyncIoCompletionFunc)( void * in_pCookie, AKRESULT in_eResult );
+
+struct AkAsyncIoRequest
+{
+	int						fd;
+	void *					pBuffer;		// Ignored if uNumIovecs > 0.
+	AkUInt64				uOffset;
+	AkUInt32				uSize;			// Total size, also with iovecs.
+	AkUInt32				uMinSize;		// Reads: enough if the file ends after this many bytes. 0 for uSize.
+	bool					bWrite;
+	struct iovec *			pIovecs;		// Scatter/gather list; the backend may modify it until completion.
+	AkUInt32				uNumIovecs;		// 0 to use pBuffer.
+	AkAsyncIoCompletionFunc	pfnCompletion;
+	void *					pCookie;		// Passed back to the completion function.
+};
+
+enum AkAsyncIoBackendType
+{
+	AkAsyncIoBackend_Auto,			// io_uring if available, else thread pool
+	AkAsyncIoBackend_IoUring,
+	AkAsyncIoBackend_ThreadPool
+};
+
+struct AkAsyncIoSettings
+{
+	AkUInt32				uQueueDepth = 64;	// Transfers in flight; Submit() blocks beyond that.
+	AkUInt32				uNumThreads = 4;	// Thread pool only.
+	AkAsyncIoBackendType	eType = AkAsyncIoBackend_Auto;
+};
+
+//-----------------------------------------------------------------------------
+// Name: class CAkAsyncIoBackend
+// Desc: Interface of the asynchronous transfer backends.
+//-----------------------------------------------------------------------------
+class CAkAsyncIoBackend
+{
+public:
+	virtual ~CAkAsyncIoBackend() {}
+
+	// Creates and initializes a backend of the requested type; with
+	// AkAsyncIoBackend_Auto, falls back to the thread pool if io_uring fails.
+	// Returns NULL on failure. Destroy with Destroy().
+	static CAkAsyncIoBackend * Create(
+		const AkAsyncIoSettings &	in_settings
+		);
+	static void Destroy( CAkAsyncIoBackend * in_pBackend );
+
+	// Waits for the transfers in flight and stops the threads.
+	virtual void Term() = 0;
+
+	// Queues the transfers. Blocks while uQueueDepth transfers are in flight.
+	// The completion function may be called before Submit() returns.
+	virtual void Submit(
+		const AkAsyncIoRequest *	in_pRequests,
+		AkUInt32					in_uNumRequests
+		) = 0;
+
+	// Optional registrations; no-ops for backends that do not use them.
+	// Transfers from registered files and into the registered buffer work
+	// either way. Unregister a file before closing it.
+	virtual void RegisterBuffer( void * /*in_pMemory*/, AkUInt64 /*in_uSize*/ ) {}
+	virtual void RegisterFile( int /*in_fd*/ ) {}
+	virtual void UnregisterFile( int /*in_fd*/ ) {}
+
+	virtual const char * GetName() const = 0;
+
+protected:
+	virtual AKRESULT Init(
+		const AkAsyncIoSettings &	in_settings
+		) = 0;
+};
+
+//-----------------------------------------------------------------------------
+// Name: class CAkThreadPoolIoBackend
+// Desc: pread()/pwrite() on worker threads.
+//-----------------------------------------------------------------------------
+class CAkThreadPoolIoBackend : public CAkAsyncIoBackend
+{
+public:
+	CAkThreadPoolIoBackend();
+	virtual ~CAkThreadPoolIoBackend();
+
+	virtual void Term() override;
+	virtual void Submit( const AkAsyncIoRequest * in_pRequests, AkUInt32 in_uNumRequests ) override;
+	virtual const char * GetName() const override { return "thread pool"; }
+
+protected:
+	virtual AKRESULT Init( const AkAsyncIoSettings & in_settings ) override;
+
+private:
+	static AK_DECLARE_THREAD_ROUTINE( WorkerThreadFunc );
+
+	// Bounded FIFO of pending requests. A request with fd == -1 stops a worker.
+	AkAsyncIoRequest *		m_pQueue;
+	AkUInt32				m_uQueueSize;
+	AkUInt32				m_uHead;
+	AkUInt32				m_uCount;
+	CAkLock					m_lock;
+	AkSemaphore				m_semItems;
+	AkSemaphore				m_semSpace;
+	bool					m_bSemaphores;	// Both created; cleared by Term().
+
+	AkThread *				m_pThreads;
+	AkUInt32				m_uNumThreads;
+};
+
+#if defined(AK_SUPPORT_IO_URING)
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+//-----------------------------------------------------------------------------
+// Name: class CAkIoUringBackend
+// Desc: One io_uring with a reaper thread.
+//-----------------------------------------------------------------------------
+class CAkIoUringBackend : public CAkAsyncIoBackend
+{
+public:
+	CAkIoUringBackend();
+	virtual ~CAkIoUringBackend();
+
+	virtual void Term() override;
+	virtual void Submit( const AkAsyncIoRequest * in_pRequests, AkUInt32 in_uNumRequests ) override;
+	virtual void RegisterBuffer( void * in_pMemory, AkUInt64 in_uSize ) override;
+	virtual void RegisterFile( int in_fd ) override;
+	virtual void UnregisterFile( int in_fd ) override;
+	virtual const char * GetName() const override { return "io_uring"; }
+
+protected:
+	virtual AKRESULT Init( const AkAsyncIoSettings & in_settings ) override;
+
+private:
+	// One transfer in flight. Stays allocated until the transfer is complete,
+	// so a short transfer can be continued.
+	struct Slot
+	{
+		AkAsyncIoRequest	request;
+		AkUInt32			uDone;			// Bytes transferred so far.
+		AkUInt32			uSubmitted;		// Bytes asked of the kernel by the last queued entry.
+		AkInt32				iFixedFile;		// Index in the registered file table, or -1.
+		struct iovec *		pIov;			// The rest of the transfer.
+		AkUInt32			uNumIov;
+		struct iovec		iov;			// Single buffer requests.
+	};
+
+	static AK_DECLARE_THREAD_ROUTINE( ReaperThreadFunc );
+
+	void QueueSlot( AkUInt32 in_uSlot );		// Call with m_lock held.
+	void Enter( AkUInt32 in_uToSubmit, AkUInt32 in_uMinComplete );
+	void OnCompletion( AkUInt64 in_uUserData, AkInt32 in_iResult );
+	void ReleaseSlot( AkUInt32 in_uSlot );
+	void UnmapRings();
+
+	int						m_ringFd;
+
+	// Submission queue.
+	void *					m_pSqRing;
+	size_t					m_uSqRingSize;
+	unsigned *				m_pSqHead;
+	unsigned *				m_pSqTail;
+	unsigned				m_uSqMask;
+	unsigned *				m_pSqArray;
+	io_uring_sqe *			m_pSqes;
+	size_t					m_uSqesSize;
+
+	// Completion queue.
+	void *					m_pCqRing;
+	size_t					m_uCqRingSize;
+	unsigned *				m_pCqHead;
+	unsigned *				m_pCqTail;
+	unsigned				m_uCqMask;
+	io_uring_cqe *			m_pCqes;
+
+	// Transfer slots and the free list; m_lock also guards the submission queue.
+	Slot *					m_pSlots;
+	AkUInt32 *				m_pFreeSlots;
+	AkUInt32				m_uNumSlots;
+	AkUInt32				m_uNumFree;
+	CAkLock					m_lock;
+	AkEvent					m_eventSlotFreed;
+
+	// Registered buffer (one) and files (sparse table indexed by slot).
+	char *					m_pFixedBuffer;
+	AkUInt64				m_uFixedBufferSize;
+	AkInt32 *				m_pFixedFileOfFd;	// fd -> table index, -1 if not registered
+	AkUInt32				m_uMaxFd;
+	AkInt32 *				m_pFreeFixedFiles;
+	AkUInt32				m_uNumFreeFixedFiles;
+	bool					m_bFilesRegistered;
+
+	AkThread				m_reaper;
+};
+
+#endif // AK_SUPPORT_IO_URING
+
+#endif //_AK_ASYNC_IO_BACKEND_H_
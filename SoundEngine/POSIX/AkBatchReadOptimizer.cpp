@@ -0,0 +1,308 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided 
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkBatchReadOptimizer.cpp
+//
+// See AkBatchReadOptimizer.h.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "AkBatchReadOptimizer.h"
+#include <AK/SoundEngine/Common/AkMemoryMgr.h>
+#include <AK/Tools/Common/AkObject.h>
+#include <limits.h>
+
+// Alignment of the gap buffer, so merged transfers of direct I/O files stay
+// aligned as long as the reads are.
+#define AK_BATCH_READ_GAP_ALIGNMENT	(4096)
+
+namespace
+{
+	// File range and the memory that holds it.
+	struct AkReadRange
+	{
+		AkUInt64	uOffset;
+		AkUInt64	uSize;
+		char *		pBuffer;
+	};
+
+	struct AkReadCompletion
+	{
+		AkAsyncIoCompletionFunc	pfnCompletion;
+		void *					pCookie;
+	};
+
+	inline bool IsBefore( const AkBatchRead & in_a, const AkBatchRead & in_b )
+	{
+		return in_a.fd < in_b.fd || ( in_a.fd == in_b.fd && in_a.uOffset < in_b.uOffset );
+	}
+}
+
+// One merged transfer, allocated in one block with its arrays.
+struct CAkBatchReadOptimizer::Group
+{
+	AkUInt32			uNumReads;
+	AkUInt32			uNumIovecs;
+	AkUInt32			uNumRanges;
+	AkUInt32			uNumCopies;
+	struct iovec *		pIovecs;
+	AkReadRange *		pRanges;	// Parts of the transfer read into the reads' buffers, in file order.
+	AkReadRange *		pCopies;	// Parts of reads to copy from pRanges once the transfer is done.
+	AkReadCompletion *	pReads;
+};
+
+CAkBatchReadOptimizer::CAkBatchReadOptimizer()
+	: m_pGapBuffer( NULL )
+	, m_uNumReads( 0 )
+	, m_uNumTransfers( 0 )
+	, m_uNumMergedReads( 0 )
+{
+}
+
+CAkBatchReadOptimizer::~CAkBatchReadOptimizer()
+{
+	Term();
+}
+
+AKRESULT CAkBatchReadOptimizer::Init( const AkBatchReadSettings & in_settings )
+{
+	m_settings = in_settings;
+	if ( m_settings.uMaxReadsPerTransfer == 0 )
+		m_settings.uMaxMergedSize = 0;
+
+	if ( m_settings.uMaxMergedSize > 0 && m_settings.uMaxGap > 0 )
+	{
+		m_pGapBuffer = AkMalign( AkMemID_Streaming, m_settings.uMaxGap, AK_BATCH_READ_GAP_ALIGNMENT );
+		if ( !m_pGapBuffer )
+			return AK_InsufficientMemory;
+	}
+	return AK_Success;
+}
+
+void CAkBatchReadOptimizer::Term()
+{
+	if ( m_pGapBuffer )
+	{
+		AkFalign( AkMemID_Streaming, m_pGapBuffer );
+		m_pGapBuffer = NULL;
+	}
+}
+
+void CAkBatchReadOptimizer::GetStats( AkBatchReadStats & out_stats ) const
+{
+	out_stats.uReads = (AkUInt32)AkAtomicLoad32( &m_uNumReads );
+	out_stats.uTransfers = (AkUInt32)AkAtomicLoad32( &m_uNumTransfers );
+	out_stats.uMergedReads = (AkUInt32)AkAtomicLoad32( &m_uNumMergedReads );
+}
+
+void CAkBatchReadOptimizer::Submit(
+	CAkAsyncIoBackend *		in_pBackend,
+	AkBatchRead *			io_pReads,
+	AkUInt32				in_uNumReads
+	)
+{
+	// Batches are at most uMaxConcurrentIO reads: insertion sort is enough.
+	for ( AkUInt32 i = 1; i < in_uNumReads; ++i )
+	{
+		AkBatchRead read = io_pReads[i];
+		AkUInt32 j = i;
+		for ( ; j > 0 && IsBefore( read, io_pReads[j - 1] ); --j )
+			io_pReads[j] = io_pReads[j - 1];
+		io_pReads[j] = read;
+	}
+
+	AkUInt32 uNumTransfers = 0;
+	AkUInt32 uNumMerged = 0;
+	for ( AkUInt32 uFirst = 0; uFirst < in_uNumReads; ++uNumTransfers )
+	{
+		AkUInt32 uCount = CountMergeable( io_pReads, uFirst, in_uNumReads );
+		if ( uCount == 1 )
+		{
+			const AkBatchRead & read = io_pReads[uFirst];
+			AkAsyncIoRequest request = {};
+			request.fd = read.fd;
+			request.pBuffer = read.pBuffer;
+			request.uOffset = read.uOffset;
+			request.uSize = read.uSize;
+			request.uMinSize = read.uMinSize;
+			request.pfnCompletion = read.pfnCompletion;
+			request.pCookie = read.pCookie;
+			in_pBackend->Submit( &request, 1 );
+		}
+		else
+		{
+			SubmitMerged( in_pBackend, io_pReads + uFirst, uCount );
+			uNumMerged += uCount;
+		}
+		uFirst += uCount;
+	}
+
+	AkAtomicAdd32( &m_uNumReads, (AkInt32)in_uNumReads );
+	AkAtomicAdd32( &m_uNumTransfers, (AkInt32)uNumTransfers );
+	AkAtomicAdd32( &m_uNumMergedReads, (AkInt32)uNumMerged );
+}
+
+AkUInt32 CAkBatchReadOptimizer::CountMergeable( const AkBatchRead * in_pReads, AkUInt32 in_uFirst, AkUInt32 in_uNumReads ) const
+{
+	if ( m_settings.uMaxMergedSize == 0 )
+		return 1;
+
+	const AkBatchRead & first = in_pReads[in_uFirst];
+	AkUInt64 uEnd = first.uOffset + first.uSize;
+	AkUInt32 uNumIovecs = 1;
+	AkUInt32 uCount = 1;
+	for ( AkUInt32 i = in_uFirst + 1; i < in_uNumReads && uCount < m_settings.uMaxReadsPerTransfer; ++i, ++uCount )
+	{
+		const AkBatchRead & read = in_pReads[i];
+		AkUInt64 uReadEnd = read.uOffset + read.uSize;
+		if ( read.fd != first.fd || read.uOffset > uEnd + m_settings.uMaxGap )
+			break;
+
+		AkUInt64 uNewEnd = AkMax( uEnd, uReadEnd );
+		if ( uNewEnd - first.uOffset > m_settings.uMaxMergedSize )
+			break;
+
+		// A gap and the part not read yet each take an iovec.
+		uNumIovecs += ( read.uOffset > uEnd ? 1 : 0 ) + ( uReadEnd > uEnd ? 1 : 0 );
+		if ( uNumIovecs > IOV_MAX )
+			break;
+
+		uEnd = uNewEnd;
+	}
+	return uCount;
+}
+
+void CAkBatchReadOptimizer::SubmitMerged(
+	CAkAsyncIoBackend *		in_pBackend,
+	const AkBatchRead *		in_pReads,
+	AkUInt32				in_uNumReads
+	)
+{
+	size_t uMemSize = sizeof( Group )
+		+ 2 * in_uNumReads * sizeof( struct iovec )
+		+ 2 * in_uNumReads * sizeof( AkReadRange )
+		+ in_uNumReads * sizeof( AkReadCompletion );
+	Group * pGroup = (Group*)AkAlloc( AkMemID_Streaming, uMemSize );
+	if ( !pGroup )
+	{
+		// Out of memory: submit them one by one.
+		for ( AkUInt32 i = 0; i < in_uNumReads; ++i )
+		{
+			AkAsyncIoRequest request = {};
+			request.fd = in_pReads[i].fd;
+			request.pBuffer = in_pReads[i].pBuffer;
+			request.uOffset = in_pReads[i].uOffset;
+			request.uSize = in_pReads[i].uSize;
+			request.uMinSize = in_pReads[i].uMinSize;
+			request.pfnCompletion = in_pReads[i].pfnCompletion;
+			request.pCookie = in_pReads[i].pCookie;
+			in_pBackend->Submit( &request, 1 );
+		}
+		return;
+	}
+
+	pGroup->uNumReads = in_uNumReads;
+	pGroup->uNumIovecs = 0;
+	pGroup->uNumRanges = 0;
+	pGroup->uNumCopies = 0;
+	pGroup->pIovecs = (struct iovec*)( pGroup + 1 );
+	pGroup->pRanges = (AkReadRange*)( pGroup->pIovecs + 2 * in_uNumReads );
+	pGroup->pCopies = pGroup->pRanges + in_uNumReads;
+	pGroup->pReads = (AkReadCompletion*)( pGroup->pCopies + in_uNumReads );
+
+	AkUInt64 uStart = in_pReads[0].uOffset;
+	AkUInt64 uEnd = uStart;
+	AkUInt64 uMinEnd = uStart;
+	for ( AkUInt32 i = 0; i < in_uNumReads; ++i )
+	{
+		const AkBatchRead & read = in_pReads[i];
+		AkUInt64 uReadEnd = read.uOffset + read.uSize;
+		uMinEnd = AkMax( uMinEnd, read.uOffset + ( read.uMinSize ? read.uMinSize : read.uSize ) );
+
+		if ( read.uOffset > uEnd )
+		{
+			struct iovec & gap = pGroup->pIovecs[pGroup->uNumIovecs++];
+			gap.iov_base = m_pGapBuffer;
+			gap.iov_len = (size_t)( read.uOffset - uEnd );
+			uEnd = read.uOffset;
+		}
+
+		if ( read.uOffset < uEnd )
+		{
+			AkReadRange & copy = pGroup->pCopies[pGroup->uNumCopies++];
+			copy.uOffset = read.uOffset;
+			copy.uSize = AkMin( uReadEnd, uEnd ) - read.uOffset;
+			copy.pBuffer = (char*)read.pBuffer;
+		}
+
+		if ( uReadEnd > uEnd )
+		{
+			char * pBuffer = (char*)read.pBuffer + ( uEnd - read.uOffset );
+
+			struct iovec & iov = pGroup->pIovecs[pGroup->uNumIovecs++];
+			iov.iov_base = pBuffer;
+			iov.iov_len = (size_t)( uReadEnd - uEnd );
+
+			AkReadRange & range = pGroup->pRanges[pGroup->uNumRanges++];
+			range.uOffset = uEnd;
+			range.uSize = uReadEnd - uEnd;
+			range.pBuffer = pBuffer;
+
+			uEnd = uReadEnd;
+		}
+
+		pGroup->pReads[i].pfnCompletion = read.pfnCompletion;
+		pGroup->pReads[i].pCookie = read.pCookie;
+	}
+
+	AkAsyncIoRequest request = {};
+	request.fd = in_pReads[0].fd;
+	request.uOffset = uStart;
+	request.uSize = (AkUInt32)( uEnd - uStart );
+	request.uMinSize = (AkUInt32)( uMinEnd - uStart );
+	request.pIovecs = pGroup->pIovecs;
+	request.uNumIovecs = pGroup->uNumIovecs;
+	request.pfnCompletion = OnMergedComplete;
+	request.pCookie = pGroup;
+	in_pBackend->Submit( &request, 1 );
+}
+
+void CAkBatchReadOptimizer::OnMergedComplete( void * in_pCookie, AKRESULT in_eResult )
+{
+	Group * pGroup = (Group*)in_pCookie;
+
+	if ( in_eResult == AK_Success )
+	{
+		// Overlapping parts were read once, into another read's buffer.
+		for ( AkUInt32 c = 0; c < pGroup->uNumCopies; ++c )
+		{
+			const AkReadRange & copy = pGroup->pCopies[c];
+			for ( AkUInt32 r = 0; r < pGroup->uNumRanges; ++r )
+			{
+				const AkReadRange & range = pGroup->pRanges[r];
+				AkUInt64 uLo = AkMax( copy.uOffset, range.uOffset );
+				AkUInt64 uHi = AkMin( copy.uOffset + copy.uSize, range.uOffset + range.uSize );
+				if ( uLo < uHi )
+					AKPLATFORM::AkMemCpy( copy.pBuffer + ( uLo - copy.uOffset ), range.pBuffer + ( uLo - range.uOffset ), (AkUInt32)( uHi - uLo ) );
+			}
+		}
+	}
+
+	for ( AkUInt32 i = 0; i < pGroup->uNumReads; ++i )
+		pGroup->pReads[i].pfnCompletion( pGroup->pReads[i].pCookie, in_eResult );
+
+	AkFree( AkMemID_Streaming, pGroup );
+}
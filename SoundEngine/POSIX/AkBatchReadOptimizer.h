@@ -0,0 +1,114 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided 
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkBatchReadOptimizer.h
+//
+// Turns a batch of reads into fewer, larger transfers before they are
+// submitted to a CAkAsyncIoBackend.
+//
+// The reads are sorted by file and offset. Neighbouring reads of the same
+// file are merged into one scatter read (preadv()) that fills each read's
+// buffer directly:
+// - reads that touch or are separated by at most uMaxGap bytes are merged
+//   (gap bytes are read into a scratch buffer and dropped);
+// - a read that overlaps the previous ones only gets its bytes that are not
+//   read yet; the overlapping part is copied from the other reads' buffers
+//   once the merged transfer is complete.
+// When a merged transfer completes, the completion function of each read is
+// called with its result. Reads that cannot be merged are submitted as they
+// are, without any allocation.
+//
+// Many small reads of neighbouring file package entries are typical of
+// bank loading; merging them saves most of the system calls.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_BATCH_READ_OPTIMIZER_H_
+#define _AK_BATCH_READ_OPTIMIZER_H_
+
+#include "AkAsyncIoBackend.h"
+#include <AK/Tools/Common/AkAtomic.h>
+
+struct AkBatchRead
+{
+	int						fd;
+	void *					pBuffer;
+	AkUInt64				uOffset;
+	AkUInt32				uSize;
+	AkUInt32				uMinSize;		// See AkAsyncIoRequest. 0 for uSize.
+	AkAsyncIoCompletionFunc	pfnCompletion;
+	void *					pCookie;
+};
+
+struct AkBatchReadSettings
+{
+	AkUInt32	uMaxGap = 4096;					// Largest hole between two merged reads, in bytes.
+	AkUInt32	uMaxMergedSize = 1024 * 1024;	// Largest merged transfer, in bytes. 0 disables merging.
+	AkUInt32	uMaxReadsPerTransfer = 64;
+};
+
+struct AkBatchReadStats
+{
+	AkUInt32	uReads;			// Reads given to Submit().
+	AkUInt32	uTransfers;		// Transfers submitted to the backend for them.
+	AkUInt32	uMergedReads;	// Reads that went into a merged transfer.
+};
+
+//-----------------------------------------------------------------------------
+// Name: class CAkBatchReadOptimizer
+// Desc: Sorts and merges batches of reads. Submit() may be called from
+//		 several threads.
+//-----------------------------------------------------------------------------
+class CAkBatchReadOptimizer
+{
+public:
+	CAkBatchReadOptimizer();
+	~CAkBatchReadOptimizer();
+
+	AKRESULT Init( const AkBatchReadSettings & in_settings );
+	void Term();
+
+	// Sorts io_pReads in place, merges them and submits the transfers.
+	void Submit(
+		CAkAsyncIoBackend *		in_pBackend,
+		AkBatchRead *			io_pReads,
+		AkUInt32				in_uNumReads
+		);
+
+	void GetStats( AkBatchReadStats & out_stats ) const;
+
+private:
+	struct Group;
+
+	// Number of reads from io_pReads[in_uFirst] that go into one transfer.
+	AkUInt32 CountMergeable( const AkBatchRead * in_pReads, AkUInt32 in_uFirst, AkUInt32 in_uNumReads ) const;
+
+	void SubmitMerged(
+		CAkAsyncIoBackend *		in_pBackend,
+		const AkBatchRead *		in_pReads,
+		AkUInt32				in_uNumReads
+		);
+
+	static void OnMergedComplete( void * in_pCookie, AKRESULT in_eResult );
+
+	AkBatchReadSettings		m_settings;
+	void *					m_pGapBuffer;		// Receives the bytes between merged reads; never read. Aligned for direct I/O.
+
+	AkAtomic32				m_uNumReads;
+	AkAtomic32				m_uNumTransfers;
+	AkAtomic32				m_uNumMergedReads;
+};
+
+#endif //_AK_BATCH_READ_OPTIMIZER_H_
@@ -0,0 +1,610 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided 
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkBlockCache.cpp
+//
+// See AkBlockCache.h.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "AkBlockCache.h"
+#include <AK/SoundEngine/Common/AkMemoryMgr.h>
+#include <AK/Tools/Common/AkObject.h>
+#include <AK/Tools/Common/AkAutoLock.h>
+
+// Block memory is aligned for direct I/O.
+#define AK_BLOCK_CACHE_ALIGNMENT	(4096)
+#define AK_INVALID_BLOCK			((AkUInt32)-1)
+
+namespace
+{
+	enum AkBlockState
+	{
+		AkBlockState_Free,
+		AkBlockState_Loading,		// Read-ahead in flight.
+		AkBlockState_Valid
+	};
+
+	inline AkUInt32 HashBlock( int in_fd, AkUInt64 in_uBlock )
+	{
+		return (AkUInt32)( ( in_uBlock * 0x9E3779B97F4A7C15ULL ) >> 32 ) ^ ( (AkUInt32)in_fd * 0x85EBCA6BU );
+	}
+}
+
+struct CAkBlockCache::Block
+{
+	AkUInt64	uBlock;			// Block number in the file.
+	int			fd;				// -1 once removed from the hash table.
+	AkUInt32	uNext;			// Next block in the hash chain.
+	AkUInt32	uValidSize;		// Less than the block size for the last block of a file.
+	AkUInt32	uPins;			// Waiters that will copy from the block.
+	AkUInt8		eState;
+	bool		bRef;			// Used since the clock hand last passed.
+	Load *		pLoad;			// While loading.
+};
+
+// A read-ahead: consecutive blocks read with one scatter transfer.
+struct CAkBlockCache::Load
+{
+	CAkBlockCache *	pCache;
+	Waiter *		pWaiters;
+	AkUInt32		uNumBlocks;
+	AkUInt32 *		pBlocks;
+	struct iovec *	pIovecs;
+};
+
+// A read that goes to storage; its blocks are added to the cache when done.
+struct CAkBlockCache::Miss
+{
+	CAkBlockCache *	pCache;
+	AkBatchRead		read;
+	AkUInt64		uFileEnd;
+	AkInt64			iStart;
+};
+
+// A read served once a read-ahead is done. Its blocks stay pinned until then.
+struct CAkBlockCache::Waiter
+{
+	AkBatchRead		read;
+	AkInt64			iStart;
+	Waiter *		pNext;
+	AkUInt32		uNumBlocks;
+	AkUInt32 *		pBlocks;
+};
+
+CAkBlockCache::CAkBlockCache()
+	: m_pMemory( NULL )
+	, m_pBlocks( NULL )
+	, m_pBuckets( NULL )
+	, m_uNumBlocks( 0 )
+	, m_uBucketMask( 0 )
+	, m_uBlockShift( 0 )
+	, m_uClockHand( 0 )
+	, m_uNumLoads( 0 )
+	, m_uNextStream( 0 )
+	, m_stats()
+{
+}
+
+CAkBlockCache::~CAkBlockCache()
+{
+	Term();
+}
+
+AKRESULT CAkBlockCache::Init( const AkBlockCacheSettings & in_settings )
+{
+	m_settings = in_settings;
+	if ( m_settings.uMemorySize == 0 || m_settings.uBlockSize == 0 )
+		return AK_Success;
+
+	AKASSERT( ( m_settings.uBlockSize & ( m_settings.uBlockSize - 1 ) ) == 0 || !"Block size must be a power of two" );
+	m_uBlockShift = 0;
+	while ( ( 1U << m_uBlockShift ) < m_settings.uBlockSize )
+		++m_uBlockShift;
+	m_settings.uBlockSize = 1U << m_uBlockShift;
+
+	m_uNumBlocks = m_settings.uMemorySize >> m_uBlockShift;
+	if ( m_uNumBlocks == 0 )
+		return AK_Success;
+
+	AkUInt32 uNumBuckets = 1;
+	while ( uNumBuckets < 2 * m_uNumBlocks )
+		uNumBuckets <<= 1;
+	m_uBucketMask = uNumBuckets - 1;
+
+	m_pMemory = (char*)AkMalign( AkMemID_Streaming, (size_t)m_uNumBlocks << m_uBlockShift, AK_BLOCK_CACHE_ALIGNMENT );
+	m_pBlocks = (Block*)AkAlloc( AkMemID_Streaming, m_uNumBlocks * sizeof( Block ) );
+	m_pBuckets = (AkUInt32*)AkAlloc( AkMemID_Streaming, uNumBuckets * sizeof( AkUInt32 ) );
+	if ( !m_pMemory || !m_pBlocks || !m_pBuckets )
+	{
+		Term();
+		return AK_InsufficientMemory;
+	}
+
+	for ( AkUInt32 i = 0; i < m_uNumBlocks; ++i )
+	{
+		Block & block = m_pBlocks[i];
+		block.uBlock = 0;
+		block.fd = -1;
+		block.uNext = AK_INVALID_BLOCK;
+		block.uValidSize = 0;
+		block.uPins = 0;
+		block.eState = AkBlockState_Free;
+		block.bRef = false;
+		block.pLoad = NULL;
+	}
+	for ( AkUInt32 i = 0; i < uNumBuckets; ++i )
+		m_pBuckets[i] = AK_INVALID_BLOCK;
+	for ( AkUInt32 i = 0; i < AK_BLOCK_CACHE_NUM_STREAMS; ++i )
+		m_streams[i].fd = -1;
+
+	m_uClockHand = 0;
+	m_uNumLoads = 0;
+	m_uNextStream = 0;
+	m_stats = AkBlockCacheStats();
+	return AK_Success;
+}
+
+void CAkBlockCache::Term()
+{
+	AKASSERT( m_uNumLoads == 0 );
+
+	if ( m_pMemory )
+	{
+		AkFalign( AkMemID_Streaming, m_pMemory );
+		m_pMemory = NULL;
+	}
+	if ( m_pBlocks )
+	{
+		AkFree( AkMemID_Streaming, m_pBlocks );
+		m_pBlocks = NULL;
+	}
+	if ( m_pBuckets )
+	{
+		AkFree( AkMemID_Streaming, m_pBuckets );
+		m_pBuckets = NULL;
+	}
+	m_uNumBlocks = 0;
+}
+
+void CAkBlockCache::GetStats( AkBlockCacheStats & out_stats )
+{
+	AkAutoLock<CAkLock> lock( m_lock );
+	out_stats = m_stats;
+}
+
+bool CAkBlockCache::Read(
+	CAkAsyncIoBackend *		in_pBackend,
+	AkBatchRead &			io_read,
+	AkUInt64				in_uFileEnd
+	)
+{
+	if ( !m_pMemory || io_read.uSize == 0 || io_read.uOffset >= in_uFileEnd )
+		return false;
+
+	// Direct I/O reads are rounded up past the end of the file; only what the
+	// file has is looked up and copied.
+	AkBatchRead read = io_read;
+	read.uSize = (AkUInt32)AkMin( (AkUInt64)read.uSize, in_uFileEnd - read.uOffset );
+
+	AkUInt64 uEnd = read.uOffset + read.uSize;
+	AkUInt64 uFirst = read.uOffset >> m_uBlockShift;
+	AkUInt32 uNumBlocks = (AkUInt32)( ( ( uEnd - 1 ) >> m_uBlockShift ) - uFirst + 1 );
+	AkUInt32 * pBlocks = (AkUInt32*)AkAlloca( uNumBlocks * sizeof( AkUInt32 ) );
+
+	AkInt64 iStart;
+	AKPLATFORM::PerformanceCounter( &iStart );
+
+	bool bSequential;
+	bool bTaken = false;
+	bool bServed = false;
+	{
+		AkAutoLock<CAkLock> lock( m_lock );
+		bSequential = IsSequential( io_read.fd, io_read.uOffset, uEnd );
+
+		// All blocks must be cached, or coming with a single read-ahead.
+		bool bHit = true;
+		Load * pLoad = NULL;
+		for ( AkUInt32 i = 0; i < uNumBlocks && bHit; ++i )
+		{
+			AkUInt32 uIndex = Find( io_read.fd, uFirst + i );
+			if ( uIndex == AK_INVALID_BLOCK )
+			{
+				bHit = false;
+				break;
+			}
+
+			Block & block = m_pBlocks[uIndex];
+			AkUInt64 uBlockStart = ( uFirst + i ) << m_uBlockShift;
+			AkUInt64 uNeeded = AkMin( uEnd, uBlockStart + m_settings.uBlockSize ) - uBlockStart;
+			if ( block.uValidSize < uNeeded )
+				bHit = false;
+			else if ( block.eState == AkBlockState_Loading )
+			{
+				if ( pLoad && pLoad != block.pLoad )
+					bHit = false;
+				pLoad = block.pLoad;
+			}
+			pBlocks[i] = uIndex;
+		}
+
+		if ( bHit && !pLoad )
+		{
+			CopyOut( read, pBlocks );
+			++m_stats.uHits;
+			bTaken = bServed = true;
+		}
+		else if ( bHit )
+		{
+			Waiter * pWaiter = (Waiter*)AkAlloc( AkMemID_Streaming, sizeof( Waiter ) + uNumBlocks * sizeof( AkUInt32 ) );
+			if ( pWaiter )
+			{
+				pWaiter->read = read;
+				pWaiter->iStart = iStart;
+				pWaiter->uNumBlocks = uNumBlocks;
+				pWaiter->pBlocks = (AkUInt32*)( pWaiter + 1 );
+				for ( AkUInt32 i = 0; i < uNumBlocks; ++i )
+				{
+					pWaiter->pBlocks[i] = pBlocks[i];
+					++m_pBlocks[pBlocks[i]].uPins;
+				}
+				pWaiter->pNext = pLoad->pWaiters;
+				pLoad->pWaiters = pWaiter;
+				++m_stats.uHits;
+				++m_stats.uWaits;
+				bTaken = true;
+			}
+		}
+
+		if ( !bTaken )
+		{
+			++m_stats.uMisses;
+			Miss * pMiss = (Miss*)AkAlloc( AkMemID_Streaming, sizeof( Miss ) );
+			if ( pMiss )
+			{
+				pMiss->pCache = this;
+				pMiss->read = io_read;
+				pMiss->uFileEnd = in_uFileEnd;
+				pMiss->iStart = iStart;
+				io_read.pfnCompletion = OnMissComplete;
+				io_read.pCookie = pMiss;
+			}
+		}
+	}
+
+	if ( bServed )
+		io_read.pfnCompletion( io_read.pCookie, AK_Success );
+
+	if ( bSequential )
+		ReadAhead( in_pBackend, io_read.fd, uEnd, in_uFileEnd );
+
+	return bTaken;
+}
+
+void CAkBlockCache::Invalidate( int in_fd )
+{
+	if ( !m_pMemory )
+		return;
+
+	AkAutoLock<CAkLock> lock( m_lock );
+	for ( AkUInt32 i = 0; i < m_uNumBlocks; ++i )
+	{
+		Block & block = m_pBlocks[i];
+		if ( block.eState == AkBlockState_Free || block.fd != in_fd )
+			continue;
+
+		// Blocks that are loading or pinned are freed once nothing uses them.
+		Remove( i );
+		if ( block.eState == AkBlockState_Valid && block.uPins == 0 )
+			block.eState = AkBlockState_Free;
+	}
+
+	for ( AkUInt32 i = 0; i < AK_BLOCK_CACHE_NUM_STREAMS; ++i )
+	{
+		if ( m_streams[i].fd == in_fd )
+			m_streams[i].fd = -1;
+	}
+}
+
+AkUInt32 CAkBlockCache::Find( int in_fd, AkUInt64 in_uBlock ) const
+{
+	AkUInt32 uIndex = m_pBuckets[HashBlock( in_fd, in_uBlock ) & m_uBucketMask];
+	while ( uIndex != AK_INVALID_BLOCK )
+	{
+		const Block & block = m_pBlocks[uIndex];
+		if ( block.fd == in_fd && block.uBlock == in_uBlock )
+			break;
+		uIndex = block.uNext;
+	}
+	return uIndex;
+}
+
+void CAkBlockCache::Insert( AkUInt32 in_uIndex, int in_fd, AkUInt64 in_uBlock )
+{
+	Block & block = m_pBlocks[in_uIndex];
+	AkUInt32 & uHead = m_pBuckets[HashBlock( in_fd, in_uBlock ) & m_uBucketMask];
+	block.fd = in_fd;
+	block.uBlock = in_uBlock;
+	block.uNext = uHead;
+	uHead = in_uIndex;
+}
+
+void CAkBlockCache::Remove( AkUInt32 in_uIndex )
+{
+	Block & block = m_pBlocks[in_uIndex];
+	AkUInt32 * pIndex = &m_pBuckets[HashBlock( block.fd, block.uBlock ) & m_uBucketMask];
+	while ( *pIndex != in_uIndex )
+		pIndex = &m_pBlocks[*pIndex].uNext;
+	*pIndex = block.uNext;
+	block.uNext = AK_INVALID_BLOCK;
+	block.fd = -1;
+}
+
+AkUInt32 CAkBlockCache::AllocBlock()
+{
+	// Two turns of the clock: the first may only clear reference bits.
+	for ( AkUInt32 uStep = 0; uStep < 2 * m_uNumBlocks; ++uStep )
+	{
+		AkUInt32 uIndex = m_uClockHand;
+		if ( ++m_uClockHand == m_uNumBlocks )
+			m_uClockHand = 0;
+
+		Block & block = m_pBlocks[uIndex];
+		if ( block.eState == AkBlockState_Free )
+			return uIndex;
+		if ( block.eState != AkBlockState_Valid || block.uPins > 0 )
+			continue;
+		if ( block.bRef )
+		{
+			block.bRef = false;
+			continue;
+		}
+
+		Remove( uIndex );
+		block.eState = AkBlockState_Free;
+		++m_stats.uEvictions;
+		return uIndex;
+	}
+	return AK_INVALID_BLOCK;
+}
+
+void CAkBlockCache::ReleaseBlock( AkUInt32 in_uIndex )
+{
+	Block & block = m_pBlocks[in_uIndex];
+	AKASSERT( block.uPins > 0 );
+	if ( --block.uPins == 0 && block.fd == -1 )
+		block.eState = AkBlockState_Free;
+}
+
+bool CAkBlockCache::IsSequential( int in_fd, AkUInt64 in_uOffset, AkUInt64 in_uEnd )
+{
+	for ( AkUInt32 i = 0; i < AK_BLOCK_CACHE_NUM_STREAMS; ++i )
+	{
+		Stream & stream = m_streams[i];
+		if ( stream.fd == in_fd && stream.uNextOffset == in_uOffset )
+		{
+			stream.uNextOffset = in_uEnd;
+			return true;
+		}
+	}
+
+	// A new stream, or a seek: replace the oldest entry.
+	Stream & stream = m_streams[m_uNextStream];
+	m_uNextStream = ( m_uNextStream + 1 ) % AK_BLOCK_CACHE_NUM_STREAMS;
+	stream.fd = in_fd;
+	stream.uNextOffset = in_uEnd;
+	return false;
+}
+
+void CAkBlockCache::CopyOut( const AkBatchRead & in_read, const AkUInt32 * in_pBlocks )
+{
+	char * pDest = (char*)in_read.pBuffer;
+	AkUInt64 uPos = in_read.uOffset;
+	AkUInt64 uEnd = in_read.uOffset + in_read.uSize;
+	for ( AkUInt32 i = 0; uPos < uEnd; ++i )
+	{
+		Block & block = m_pBlocks[in_pBlocks[i]];
+		AkUInt64 uBlockStart = block.uBlock << m_uBlockShift;
+		AkUInt32 uSize = (AkUInt32)( AkMin( uEnd, uBlockStart + m_settings.uBlockSize ) - uPos );
+		const char * pSrc = m_pMemory + ( (size_t)in_pBlocks[i] << m_uBlockShift ) + ( uPos - uBlockStart );
+		AKPLATFORM::AkMemCpy( pDest, pSrc, uSize );
+		block.bRef = true;
+		pDest += uSize;
+		uPos += uSize;
+	}
+}
+
+void CAkBlockCache::AddBlocks( const AkBatchRead & in_read, AkUInt64 in_uFileEnd )
+{
+	AkUInt64 uEnd = in_read.uOffset + in_read.uSize;
+	for ( AkUInt64 uBlock = in_read.uOffset >> m_uBlockShift; ( uBlock << m_uBlockShift ) < uEnd; ++uBlock )
+	{
+		// Only blocks the read covers entirely; the last block of the file
+		// ends at in_uFileEnd.
+		AkUInt64 uBlockStart = uBlock << m_uBlockShift;
+		AkUInt64 uBlockEnd = AkMin( uBlockStart + m_settings.uBlockSize, in_uFileEnd );
+		if ( uBlockStart < in_read.uOffset || uBlockEnd > uEnd || uBlockEnd <= uBlockStart )
+			continue;
+		if ( Find( in_read.fd, uBlock ) != AK_INVALID_BLOCK )
+			continue;
+
+		AkUInt32 uIndex = AllocBlock();
+		if ( uIndex == AK_INVALID_BLOCK )
+			break;
+
+		Block & block = m_pBlocks[uIndex];
+		block.uValidSize = (AkUInt32)( uBlockEnd - uBlockStart );
+		block.eState = AkBlockState_Valid;
+		block.bRef = false;
+		block.pLoad = NULL;
+		Insert( uIndex, in_read.fd, uBlock );
+		AKPLATFORM::AkMemCpy( m_pMemory + ( (size_t)uIndex << m_uBlockShift ), (char*)in_read.pBuffer + ( uBlockStart - in_read.uOffset ), block.uValidSize );
+	}
+}
+
+void CAkBlockCache::ReadAhead( CAkAsyncIoBackend * in_pBackend, int in_fd, AkUInt64 in_uOffset, AkUInt64 in_uFileEnd )
+{
+	const AkUInt32 uMaxBlocks = m_settings.uReadAheadBlocks;
+	if ( uMaxBlocks == 0 )
+		return;
+
+	Load * pLoad = NULL;
+	AkAsyncIoRequest request = {};
+	{
+		AkAutoLock<CAkLock> lock( m_lock );
+		if ( m_uNumLoads >= m_settings.uMaxReadAheads )
+			return;
+
+		// Skip what is cached or coming already, then take the missing blocks
+		// up to the next cached one: they are read with one transfer.
+		AkUInt64 uBlock = in_uOffset >> m_uBlockShift;
+		AkUInt64 uLastBlock = uBlock + uMaxBlocks;
+		while ( uBlock < uLastBlock && ( uBlock << m_uBlockShift ) < in_uFileEnd && Find( in_fd, uBlock ) != AK_INVALID_BLOCK )
+			++uBlock;
+
+		for ( ; uBlock < uLastBlock && ( uBlock << m_uBlockShift ) < in_uFileEnd && Find( in_fd, uBlock ) == AK_INVALID_BLOCK; ++uBlock )
+		{
+			if ( !pLoad )
+			{
+				pLoad = (Load*)AkAlloc( AkMemID_Streaming, sizeof( Load ) + uMaxBlocks * ( sizeof( struct iovec ) + sizeof( AkUInt32 ) ) );
+				if ( !pLoad )
+					return;
+				pLoad->pCache = this;
+				pLoad->pWaiters = NULL;
+				pLoad->uNumBlocks = 0;
+				pLoad->pIovecs = (struct iovec*)( pLoad + 1 );
+				pLoad->pBlocks = (AkUInt32*)( pLoad->pIovecs + uMaxBlocks );
+				request.uOffset = uBlock << m_uBlockShift;
+			}
+
+			AkUInt32 uIndex = AllocBlock();
+			if ( uIndex == AK_INVALID_BLOCK )
+				break;
+
+			AkUInt64 uBlockStart = uBlock << m_uBlockShift;
+			Block & block = m_pBlocks[uIndex];
+			block.uValidSize = (AkUInt32)AkMin( (AkUInt64)m_settings.uBlockSize, in_uFileEnd - uBlockStart );
+			block.eState = AkBlockState_Loading;
+			block.bRef = false;
+			block.pLoad = pLoad;
+			Insert( uIndex, in_fd, uBlock );
+
+			struct iovec & iov = pLoad->pIovecs[pLoad->uNumBlocks];
+			iov.iov_base = m_pMemory + ( (size_t)uIndex << m_uBlockShift );
+			// Whole blocks, so direct I/O files can be read ahead too; the last
+			// one stops at the end of the file.
+			iov.iov_len = m_settings.uBlockSize;
+			pLoad->pBlocks[pLoad->uNumBlocks++] = uIndex;
+			request.uSize += m_settings.uBlockSize;
+			request.uMinSize += block.uValidSize;
+		}
+
+		if ( !pLoad )
+			return;
+		if ( pLoad->uNumBlocks == 0 )
+		{
+			AkFree( AkMemID_Streaming, pLoad );
+			return;
+		}
+
+		++m_uNumLoads;
+		m_stats.uReadAheadBlocks += pLoad->uNumBlocks;
+	}
+
+	request.fd = in_fd;
+	request.pIovecs = pLoad->pIovecs;
+	request.uNumIovecs = pLoad->uNumBlocks;
+	request.pfnCompletion = OnLoadComplete;
+	request.pCookie = pLoad;
+	in_pBackend->Submit( &request, 1 );
+}
+
+void CAkBlockCache::OnMissComplete( void * in_pCookie, AKRESULT in_eResult )
+{
+	Miss * pMiss = (Miss*)in_pCookie;
+	CAkBlockCache * pThis = pMiss->pCache;
+
+	AkInt64 iNow;
+	AKPLATFORM::PerformanceCounter( &iNow );
+	AkReal32 fLatencyMs = AKPLATFORM::Elapsed( iNow, pMiss->iStart );
+	{
+		AkAutoLock<CAkLock> lock( pThis->m_lock );
+		if ( in_eResult == AK_Success )
+			pThis->AddBlocks( pMiss->read, pMiss->uFileEnd );
+		pThis->m_stats.fMissLatencyTotalMs += fLatencyMs;
+		pThis->m_stats.fMissLatencyMaxMs = AkMax( pThis->m_stats.fMissLatencyMaxMs, fLatencyMs );
+	}
+
+	pMiss->read.pfnCompletion( pMiss->read.pCookie, in_eResult );
+	AkFree( AkMemID_Streaming, pMiss );
+}
+
+void CAkBlockCache::OnLoadComplete( void * in_pCookie, AKRESULT in_eResult )
+{
+	Load * pLoad = (Load*)in_pCookie;
+	CAkBlockCache * pThis = pLoad->pCache;
+
+	AkInt64 iNow;
+	AKPLATFORM::PerformanceCounter( &iNow );
+
+	Waiter * pWaiters;
+	{
+		AkAutoLock<CAkLock> lock( pThis->m_lock );
+
+		// Failed blocks leave the table. Blocks that were invalidated while
+		// loading (fd == -1) are freed once their waiters are done.
+		for ( AkUInt32 i = 0; i < pLoad->uNumBlocks; ++i )
+		{
+			Block & block = pThis->m_pBlocks[pLoad->pBlocks[i]];
+			if ( in_eResult != AK_Success && block.fd != -1 )
+				pThis->Remove( pLoad->pBlocks[i] );
+			block.eState = AkBlockState_Valid;
+			block.bRef = true;
+			block.pLoad = NULL;
+		}
+
+		pWaiters = pLoad->pWaiters;
+		for ( Waiter * pWaiter = pWaiters; pWaiter; pWaiter = pWaiter->pNext )
+		{
+			if ( in_eResult == AK_Success )
+				pThis->CopyOut( pWaiter->read, pWaiter->pBlocks );
+			for ( AkUInt32 i = 0; i < pWaiter->uNumBlocks; ++i )
+				pThis->ReleaseBlock( pWaiter->pBlocks[i] );
+
+			AkReal32 fLatencyMs = AKPLATFORM::Elapsed( iNow, pWaiter->iStart );
+			pThis->m_stats.fWaitLatencyTotalMs += fLatencyMs;
+			pThis->m_stats.fWaitLatencyMaxMs = AkMax( pThis->m_stats.fWaitLatencyMaxMs, fLatencyMs );
+		}
+
+		for ( AkUInt32 i = 0; i < pLoad->uNumBlocks; ++i )
+		{
+			Block & block = pThis->m_pBlocks[pLoad->pBlocks[i]];
+			if ( block.fd == -1 && block.uPins == 0 )
+				block.eState = AkBlockState_Free;
+		}
+
+		--pThis->m_uNumLoads;
+	}
+
+	while ( pWaiters )
+	{
+		Waiter * pNext = pWaiters->pNext;
+		pWaiters->read.pfnCompletion( pWaiters->read.pCookie, in_eResult );
+		AkFree( AkMemID_Streaming, pWaiters );
+		pWaiters = pNext;
+	}
+	AkFree( AkMemID_Streaming, pLoad );
+}
@@ -0,0 +1,154 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided 
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkBlockCache.h
+//
+// Cache of file blocks between the deferred I/O hook and storage.
+//
+// Files are cut in blocks of uBlockSize bytes, keyed by file descriptor
+// and block number. A read whose blocks are all in the cache is copied
+// from them and completes right away; other reads go to storage, and the
+// whole blocks they cover are added to the cache when they complete.
+// Blocks are replaced with the CLOCK policy: a block that was used since
+// the hand last passed gets a second chance.
+//
+// The cache also follows the reads of each file. When a read starts where
+// an earlier read of the same file ended, the next uReadAheadBlocks blocks
+// are read asynchronously into the cache. A read that needs blocks of a
+// read-ahead still in flight waits for it rather than going to storage
+// again.
+//
+// Looping music and ambience re-read the same blocks over and over, which
+// is what the cache is for. The Stream Manager's own stream cache
+// (bUseStreamCache) only keeps what it happens to have in its buffers.
+//
+// Blocks of a file are dropped when it is written to or closed, since its
+// descriptor can be reused for another file.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_BLOCK_CACHE_H_
+#define _AK_BLOCK_CACHE_H_
+
+#include "AkBatchReadOptimizer.h"
+
+// Files whose reads are followed for sequential access.
+#define AK_BLOCK_CACHE_NUM_STREAMS	(16)
+
+struct AkBlockCacheSettings
+{
+	AkUInt32	uMemorySize = 4 * 1024 * 1024;	// Memory for the blocks, in bytes. 0 disables the cache.
+	AkUInt32	uBlockSize = 32 * 1024;			// Power of two.
+	AkUInt32	uReadAheadBlocks = 4;			// Blocks read ahead of a sequential read. 0 disables read-ahead.
+	AkUInt32	uMaxReadAheads = 4;				// Read-aheads in flight.
+};
+
+struct AkBlockCacheStats
+{
+	AkUInt32	uHits;					// Reads served from the cache, waits included.
+	AkUInt32	uMisses;				// Reads that went to storage.
+	AkUInt32	uWaits;					// Hits that waited for a read-ahead.
+	AkUInt32	uReadAheadBlocks;		// Blocks requested by read-ahead.
+	AkUInt32	uEvictions;
+	AkReal64	fMissLatencyTotalMs;	// Submission to completion, misses.
+	AkReal32	fMissLatencyMaxMs;
+	AkReal64	fWaitLatencyTotalMs;	// Submission to completion, waits.
+	AkReal32	fWaitLatencyMaxMs;
+
+	AkReal32 GetHitRate() const { return ( uHits + uMisses ) ? (AkReal32)uHits / (AkReal32)( uHits + uMisses ) : 0.f; }
+};
+
+//-----------------------------------------------------------------------------
+// Name: class CAkBlockCache
+// Desc: Block cache with read-ahead. All members may be called from
+//		 several threads; completions run on the backend's threads.
+//-----------------------------------------------------------------------------
+class CAkBlockCache
+{
+public:
+	CAkBlockCache();
+	~CAkBlockCache();
+
+	AKRESULT Init( const AkBlockCacheSettings & in_settings );
+
+	// Nothing may be in flight: terminate the backend first.
+	void Term();
+
+	// Returns true if the cache took the read: its completion was called
+	// with the cached data, or will be once a read-ahead is done. Otherwise
+	// io_read may have been redirected so that its data is added to the
+	// cache when it completes, and the caller submits it.
+	// in_uFileEnd is the size of the file behind in_read.fd; no block is
+	// read past it, and the part of io_read past it is not filled from the
+	// cache.
+	bool Read(
+		CAkAsyncIoBackend *		in_pBackend,
+		AkBatchRead &			io_read,
+		AkUInt64				in_uFileEnd
+		);
+
+	// Drops the blocks of a file.
+	void Invalidate( int in_fd );
+
+	void GetStats( AkBlockCacheStats & out_stats );
+
+	bool IsEnabled() const { return m_pMemory != NULL; }
+
+private:
+	struct Block;
+	struct Load;
+	struct Miss;
+	struct Waiter;
+
+	struct Stream
+	{
+		int			fd;
+		AkUInt64	uNextOffset;
+	};
+
+	// With m_lock held.
+	AkUInt32 Find( int in_fd, AkUInt64 in_uBlock ) const;
+	void Insert( AkUInt32 in_uIndex, int in_fd, AkUInt64 in_uBlock );
+	void Remove( AkUInt32 in_uIndex );
+	AkUInt32 AllocBlock();
+	void ReleaseBlock( AkUInt32 in_uIndex );
+	bool IsSequential( int in_fd, AkUInt64 in_uOffset, AkUInt64 in_uEnd );
+	void CopyOut( const AkBatchRead & in_read, const AkUInt32 * in_pBlocks );
+	void AddBlocks( const AkBatchRead & in_read, AkUInt64 in_uFileEnd );
+
+	void ReadAhead( CAkAsyncIoBackend * in_pBackend, int in_fd, AkUInt64 in_uOffset, AkUInt64 in_uFileEnd );
+
+	static void OnMissComplete( void * in_pCookie, AKRESULT in_eResult );
+	static void OnLoadComplete( void * in_pCookie, AKRESULT in_eResult );
+
+	AkBlockCacheSettings	m_settings;
+	CAkLock					m_lock;
+
+	char *					m_pMemory;
+	Block *					m_pBlocks;
+	AkUInt32 *				m_pBuckets;			// Heads of the hash chains.
+	AkUInt32				m_uNumBlocks;
+	AkUInt32				m_uBucketMask;
+	AkUInt32				m_uBlockShift;
+	AkUInt32				m_uClockHand;
+	AkUInt32				m_uNumLoads;		// Read-aheads in flight.
+
+	Stream					m_streams[AK_BLOCK_CACHE_NUM_STREAMS];
+	AkUInt32				m_uNextStream;
+
+	AkBlockCacheStats		m_stats;
+};
+
+#endif //_AK_BLOCK_CACHE_H_
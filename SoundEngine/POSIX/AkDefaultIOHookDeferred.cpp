@@ -27,8 +27,12 @@ written agreement between you and Audiokinetic Inc.
 // at class CAkDefaultLowLevelIODispatcher).
 //
 // AK::StreamMgr::IAkLowLevelIOHook: 
-// Uses standard C IO functions, into seperate thread for async IO.
-// AioFuncRead and AioFuncWrite handle the IO operation asynchronously.
+// Opens files as raw file descriptors and transfers with positional reads
+// and writes, through a CAkAsyncIoBackend (io_uring where available, a
+// pread()/pwrite() thread pool otherwise). Batched reads go through the 
+// block cache (AkBlockCache.h), then are sorted and merged into scatter 
+// reads (AkBatchReadOptimizer.h). Direct I/O and its bounce buffers are 
+// handled here too. See AkDefaultIOHookDeferred.h.
 //
 // Init() creates a streaming device (by calling AK::StreamMgr::CreateDevice()).
 // If there was no AK::StreamMgr::IAkFileLocationResolver previously registered 
@@ -41,13 +45,157 @@ written agreement between you and Audiokinetic Inc.
 #include <AK/SoundEngine/Common/AkMemoryMgr.h>
 #include "AkFileHelpers.h"
 #include <AK/Tools/Common/AkObject.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/fs.h>
+#include <linux/magic.h>
+#include <sys/ioctl.h>
+#include <sys/sysmacros.h>
+#include <sys/vfs.h>
+#endif
 
 
 // Device info.
 #define POSIX_DEFERRED_DEVICE_NAME		("POSIX Deferred")	// Default deferred device name.
 
+// Direct I/O alignment when the device does not tell, and the smallest
+// alignment of the I/O memory allocated by Init() in direct I/O mode.
+#define AK_DIRECT_IO_DEFAULT_ALIGNMENT	(4096)
+#define AK_DIRECT_IO_MAX_ALIGNMENT		(64 * 1024)
+
+namespace
+{
+	// A misaligned direct I/O read, redirected to an aligned buffer that
+	// follows this header.
+	struct AkDirectIoBounce
+	{
+		AkAsyncIoCompletionFunc	pfnCompletion;
+		void *					pCookie;
+		void *					pBuffer;	// Where the read wanted its data.
+		char *					pData;
+		AkUInt32				uSkip;		// Offset of the read in pData.
+		AkUInt32				uSize;
+	};
+
+#if defined(O_DIRECT)
+	// Reads a number from a sysfs attribute; 0 if there is none.
+	AkUInt32 ReadSysfsUInt( const char * in_pszPath )
+	{
+		int fd = open( in_pszPath, O_RDONLY | O_CLOEXEC );
+		if ( fd < 0 )
+			return 0;
+
+		char szValue[32];
+		ssize_t iRead = read( fd, szValue, sizeof( szValue ) - 1 );
+		close( fd );
+		if ( iRead <= 0 )
+			return 0;
+		szValue[iRead] = 0;
+		return (AkUInt32)strtoul( szValue, NULL, 10 );
+	}
+
+	// Offset and memory alignment of direct I/O on in_fd. Returns false if
+	// the file system does not support it.
+	bool GetDirectIoAlignment( int in_fd, AkUInt32 & out_uBlockSize, AkUInt32 & out_uMemAlign )
+	{
+		out_uBlockSize = out_uMemAlign = 0;
+
+#if defined(STATX_DIOALIGN)
+		// Linux 6.1+ tells exactly, for any file system.
+		struct statx stx;
+		if ( statx( in_fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx ) == 0 && ( stx.stx_mask & STATX_DIOALIGN ) )
+		{
+			out_uBlockSize = stx.stx_dio_offset_align;
+			out_uMemAlign = stx.stx_dio_mem_align;
+		}
+		else
+#endif
+		{
+			// Otherwise the logical block size of the device, for both.
+			struct stat fileStat;
+			if ( fstat( in_fd, &fileStat ) != 0 )
+				return false;
+
+			if ( S_ISBLK( fileStat.st_mode ) )
+			{
+				int iSectorSize = 0;
+				if ( ioctl( in_fd, BLKSSZGET, &iSectorSize ) == 0 && iSectorSize > 0 )
+					out_uBlockSize = (AkUInt32)iSectorSize;
+			}
+			else
+			{
+				// Partitions have no queue of their own: use their disk's.
+				char szPath[96];
+				snprintf( szPath, sizeof( szPath ), "/sys/dev/block/%u:%u/queue/logical_block_size", major( fileStat.st_dev ), minor( fileStat.st_dev ) );
+				out_uBlockSize = ReadSysfsUInt( szPath );
+				if ( out_uBlockSize == 0 )
+				{
+					snprintf( szPath, sizeof( szPath ), "/sys/dev/block/%u:%u/../queue/logical_block_size", major( fileStat.st_dev ), minor( fileStat.st_dev ) );
+					out_uBlockSize = ReadSysfsUInt( szPath );
+				}
+			}
+
+			if ( out_uBlockSize == 0 )
+				out_uBlockSize = AK_DIRECT_IO_DEFAULT_ALIGNMENT;
+			out_uMemAlign = out_uBlockSize;
+		}
+
+		// Powers of two the Stream Manager can work with.
+		return out_uBlockSize > 0 && out_uBlockSize <= AK_DIRECT_IO_MAX_ALIGNMENT && ( out_uBlockSize & ( out_uBlockSize - 1 ) ) == 0
+			&& out_uMemAlign > 0 && out_uMemAlign <= AK_DIRECT_IO_MAX_ALIGNMENT && ( out_uMemAlign & ( out_uMemAlign - 1 ) ) == 0;
+	}
+#endif
+
+#if defined(__linux__)
+	// Recent kernels accept O_DIRECT on tmpfs, but its files are the page
+	// cache: there is nothing to bypass, and no alignment is reported.
+	bool IsMemoryFileSystem( int in_fd )
+	{
+		struct statfs fsStat;
+		return fstatfs( in_fd, &fsStat ) == 0 && ( fsStat.f_type == TMPFS_MAGIC || fsStat.f_type == RAMFS_MAGIC );
+	}
+#endif
+
+	// Turns direct I/O on for a file opened for reading, if its file system
+	// supports it. io_fileDesc keeps an alignment of 1 otherwise.
+	void EnableDirectIo( AkPosixFileDesc & io_fileDesc )
+	{
+#if defined(O_DIRECT)
+#if defined(__linux__)
+		if ( IsMemoryFileSystem( io_fileDesc.fd ) )
+			return;
+#endif
+		int iFlags = fcntl( io_fileDesc.fd, F_GETFL );
+		if ( iFlags < 0 || fcntl( io_fileDesc.fd, F_SETFL, iFlags | O_DIRECT ) != 0 )
+			return;
+
+		AkUInt32 uBlockSize, uMemAlign;
+		if ( !GetDirectIoAlignment( io_fileDesc.fd, uBlockSize, uMemAlign ) )
+		{
+			fcntl( io_fileDesc.fd, F_SETFL, iFlags );
+			return;
+		}
+
+		io_fileDesc.uDirectIoBlockSize = uBlockSize;
+		io_fileDesc.uDirectIoMemAlign = uMemAlign;
+#elif defined(F_NOCACHE)
+		// No alignment requirement: aligned parts of reads skip the cache.
+		fcntl( io_fileDesc.fd, F_NOCACHE, 1 );
+#endif
+	}
+}
+
 CAkDefaultIOHookDeferred::CAkDefaultIOHookDeferred()
 : m_deviceID( AK_INVALID_DEVICE_ID )
+, m_pIoBackend( NULL )
+, m_eIoBackendType( AkAsyncIoBackend_Auto )
+, m_uIoThreadCount( AkAsyncIoSettings().uNumThreads )
+, m_bDirectIO( false )
+, m_pIOMemory( NULL )
 {
 }
 
@@ -68,8 +216,46 @@ AKRESULT CAkDefaultIOHookDeferred::Init(
 	if ( !AK::StreamMgr::GetFileLocationResolver() )
 		AK::StreamMgr::SetFileLocationResolver( this );
 
+	// Provide the I/O memory ourselves so that it can be registered with the
+	// backend: every transfer of the device lands in it.
+	AkDeviceSettings deviceSettings = in_deviceSettings;
+	if ( !deviceSettings.pIOMemory && deviceSettings.uIOMemorySize > 0 )
+	{
+		// Aligned for direct I/O on any device, so that transfers need no
+		// bounce buffer.
+		if ( m_bDirectIO )
+			deviceSettings.uIOMemoryAlignment = AkMax( deviceSettings.uIOMemoryAlignment, (AkUInt32)AK_DIRECT_IO_DEFAULT_ALIGNMENT );
+		m_pIOMemory = AkMalign( AkMemID_Streaming, deviceSettings.uIOMemorySize, deviceSettings.uIOMemoryAlignment );
+		if ( !m_pIOMemory )
+			return AK_InsufficientMemory;
+		deviceSettings.pIOMemory = m_pIOMemory;
+	}
+
+	AKRESULT eResult = m_blockCache.Init( m_blockCacheSettings );
+	if ( eResult != AK_Success )
+		return eResult;
+
+	// The Stream Manager never has more than uMaxConcurrentIO transfers
+	// pending on the device; the block cache adds its read-aheads.
+	AkAsyncIoSettings ioSettings;
+	ioSettings.uQueueDepth = AkMax( deviceSettings.uMaxConcurrentIO, (AkUInt32)1 );
+	if ( m_blockCache.IsEnabled() )
+		ioSettings.uQueueDepth += m_blockCacheSettings.uMaxReadAheads;
+	ioSettings.uNumThreads = AkMax( m_uIoThreadCount, (AkUInt32)1 );
+	ioSettings.eType = m_eIoBackendType;
+	m_pIoBackend = CAkAsyncIoBackend::Create( ioSettings );
+	if ( !m_pIoBackend )
+		return AK_Fail;
+
+	eResult = m_batchReadOptimizer.Init( m_batchReadSettings );
+	if ( eResult != AK_Success )
+		return eResult;
+
+	if ( deviceSettings.pIOMemory )
+		m_pIoBackend->RegisterBuffer( deviceSettings.pIOMemory, deviceSettings.uIOMemorySize );
+
 	// Create a device in the Stream Manager, specifying this as the hook.
-	return AK::StreamMgr::CreateDevice( in_deviceSettings, this, m_deviceID);
+	return AK::StreamMgr::CreateDevice( deviceSettings, this, m_deviceID);
 }
 
 void CAkDefaultIOHookDeferred::Term()
@@ -80,6 +266,18 @@ void CAkDefaultIOHookDeferred::Term()
 		AK::StreamMgr::SetFileLocationResolver( NULL );
 	
 	AK::StreamMgr::DestroyDevice( m_deviceID );
+
+	// The device is gone, so nothing is in flight anymore.
+	CAkAsyncIoBackend::Destroy( m_pIoBackend );
+	m_pIoBackend = NULL;
+	m_batchReadOptimizer.Term();
+	m_blockCache.Term();
+
+	if ( m_pIOMemory )
+	{
+		AkFalign( AkMemID_Streaming, m_pIOMemory );
+		m_pIOMemory = NULL;
+	}
 }
 
 AkFileDesc* CAkDefaultIOHookDeferred::CreateDescriptor(const AkFileDesc* in_pCopy)
@@ -100,6 +298,7 @@ AKRESULT CAkDefaultIOHookDeferred::Open(const AkFileOpenData& in_FileOpen, AkFil
 	if (eResult == AK_Success)
 	{
 		out_pFileDesc->deviceID = m_deviceID;
+		m_pIoBackend->RegisterFile( ((AkPosixFileDesc*)out_pFileDesc)->fd );
 	}
 	else
 	{
@@ -110,6 +309,67 @@ AKRESULT CAkDefaultIOHookDeferred::Open(const AkFileOpenData& in_FileOpen, AkFil
 	return eResult;	
 }
 
+AKRESULT CAkDefaultIOHookDeferred::PlatformOpenFile(
+	const AkOSChar* in_pszFullFilePath,
+	AkOpenMode      in_eOpenMode,
+	bool			/*in_bOverlapped*/,
+	AkFileDesc &    out_fileDesc
+	)
+{
+	if ( !in_pszFullFilePath )
+	{
+		AKASSERT( !"NULL file name" );
+		return AK_InvalidParameter;
+	}
+
+	// Same modes as CAkFileHelpers::OpenFile(), except that "append" is
+	// plain read/write: O_APPEND would make pwrite() ignore its offset.
+	int iFlags;
+	switch ( in_eOpenMode )
+	{
+		case AK_OpenModeRead:
+			iFlags = O_RDONLY;
+			break;
+		case AK_OpenModeWrite:
+			iFlags = O_WRONLY | O_CREAT | O_TRUNC;
+			break;
+		case AK_OpenModeWriteOvrwr:
+			iFlags = O_RDWR | O_CREAT | O_TRUNC;
+			break;
+		case AK_OpenModeReadWrite:
+			iFlags = O_RDWR | O_CREAT;
+			break;
+		default:
+			AKASSERT( !"Invalid open mode" );
+			return AK_InvalidParameter;
+	}
+
+	int fd = open( in_pszFullFilePath, iFlags | O_CLOEXEC, 0666 );
+	if ( fd < 0 )
+		return errno == EACCES ? AK_FilePermissionError : AK_FileNotFound;
+
+	out_fileDesc.iFileSize = 0;
+	if ( in_eOpenMode == AK_OpenModeRead || in_eOpenMode == AK_OpenModeReadWrite )
+	{
+		struct stat fileStat;
+		if ( fstat( fd, &fileStat ) != 0 )
+		{
+			close( fd );
+			return AK_UnknownFileError;
+		}
+		out_fileDesc.iFileSize = (AkInt64)fileStat.st_size;
+	}
+
+	out_fileDesc.hFile = NULL;
+	AkPosixFileDesc & fileDesc = static_cast<AkPosixFileDesc&>( out_fileDesc );
+	fileDesc.fd = fd;
+	fileDesc.uDirectIoBlockSize = 1;
+	fileDesc.uDirectIoMemAlign = 1;
+	if ( m_bDirectIO && in_eOpenMode == AK_OpenModeRead )
+		EnableDirectIo( fileDesc );
+	return AK_Success;
+}
+
 AKRESULT CAkDefaultIOHookDeferred::OutputSearchedPaths(
 	AKRESULT in_result,
 	const AkFileOpenData& in_FileOpen,
@@ -123,74 +383,137 @@ AKRESULT CAkDefaultIOHookDeferred::OutputSearchedPaths(
 //
 // IAkLowLevelIOHook implementation.
 //-----------------------------------------------------------------------------
-// Async Read
-void AioFuncRead(AkAsyncIOTransferInfo& transferInfo)
+// Completion of a transfer, on a backend thread.
+void CAkDefaultIOHookDeferred::OnTransferComplete( void * in_pCookie, AKRESULT in_eResult )
 {
-	
-	AkFileHandle fileHandle = ((AkFileDesc*)transferInfo.pUserData)->hFile;
-
-	// Seek in the file
-	if( lseek( fileno(fileHandle), transferInfo.uFilePosition, SEEK_SET ) == transferInfo.uFilePosition )
-	{
-		// Read the data
-		AkUInt32 byteTransferred = (AkUInt32) read( fileno(fileHandle), transferInfo.pBuffer, transferInfo.uRequestedSize );
-		
-		if( byteTransferred == transferInfo.uRequestedSize )
-		{
-			transferInfo.pCallback( &transferInfo, AK_Success );
-			return;
-		}
-	}
-	
-	transferInfo.pCallback( &transferInfo, AK_Fail );
+	AkAsyncIOTransferInfo * pTransferInfo = (AkAsyncIOTransferInfo*)in_pCookie;
+	pTransferInfo->pCallback( pTransferInfo, in_eResult );
 }
 
-// Async Write
-void AioFuncWrite(AkAsyncIOTransferInfo& transferInfo)
+bool CAkDefaultIOHookDeferred::BounceRead( AkBatchRead & io_read, const AkPosixFileDesc & in_fileDesc )
 {
-	AkFileHandle fileHandle = ((AkFileDesc*)transferInfo.pUserData)->hFile;
-	
-	// Seek in the file
-	if( lseek( fileno(fileHandle), transferInfo.uFilePosition, SEEK_SET ) == transferInfo.uFilePosition )
-	{
-		// Read the data
-		AkUInt32 byteTransferred = (AkUInt32) write( fileno(fileHandle), transferInfo.pBuffer, transferInfo.uRequestedSize );
-		
-		if( byteTransferred == transferInfo.uRequestedSize )
-		{
-			transferInfo.pCallback( &transferInfo, AK_Success );
-			fflush(fileHandle);
-			return;
-		}
-	}
-	
-	transferInfo.pCallback( &transferInfo, AK_Fail );
+	AkUInt64 uBlockSize = in_fileDesc.uDirectIoBlockSize;
+	AkUInt32 uMemAlign = AkMax( in_fileDesc.uDirectIoMemAlign, (AkUInt32)sizeof( void* ) );
+	AkUInt64 uStart = io_read.uOffset - io_read.uOffset % uBlockSize;
+	AkUInt64 uEnd = ( ( io_read.uOffset + io_read.uSize + uBlockSize - 1 ) / uBlockSize ) * uBlockSize;
+	size_t uHeaderSize = ( ( sizeof( AkDirectIoBounce ) + uMemAlign - 1 ) / uMemAlign ) * uMemAlign;
+
+	AkDirectIoBounce * pBounce = (AkDirectIoBounce*)AkMalign( AkMemID_Streaming, uHeaderSize + (size_t)( uEnd - uStart ), uMemAlign );
+	if ( !pBounce )
+		return false;
+
+	pBounce->pfnCompletion = io_read.pfnCompletion;
+	pBounce->pCookie = io_read.pCookie;
+	pBounce->pBuffer = io_read.pBuffer;
+	pBounce->pData = (char*)pBounce + uHeaderSize;
+	pBounce->uSkip = (AkUInt32)( io_read.uOffset - uStart );
+	pBounce->uSize = io_read.uSize;
+
+	AkUInt32 uMinSize = io_read.uMinSize ? io_read.uMinSize : io_read.uSize;
+	io_read.pBuffer = pBounce->pData;
+	io_read.uOffset = uStart;
+	io_read.uSize = (AkUInt32)( uEnd - uStart );
+	io_read.uMinSize = pBounce->uSkip + uMinSize;
+	io_read.pfnCompletion = OnBounceComplete;
+	io_read.pCookie = pBounce;
+	return true;
 }
 
-// Reads data from a file (asynchronous overload).
-void CAkDefaultIOHookDeferred::Read(
-	AkFileDesc &			in_fileDesc,        // File descriptor.
-	const AkIoHeuristics & /*in_heuristics*/,	// Heuristics for this data transfer (not used in this implementation).
-	AkAsyncIOTransferInfo & io_transferInfo		// Asynchronous data transfer info.
-	)
+void CAkDefaultIOHookDeferred::OnBounceComplete( void * in_pCookie, AKRESULT in_eResult )
 {
-	io_transferInfo.pUserData = (void*)&in_fileDesc;
-	
-	//Call the low level read which takes care of error handling with the callback 
-	AioFuncRead(io_transferInfo);
+	AkDirectIoBounce * pBounce = (AkDirectIoBounce*)in_pCookie;
+	if ( in_eResult == AK_Success )
+		AKPLATFORM::AkMemCpy( pBounce->pBuffer, pBounce->pData + pBounce->uSkip, pBounce->uSize );
+	pBounce->pfnCompletion( pBounce->pCookie, in_eResult );
+	AkFalign( AkMemID_Streaming, pBounce );
 }
 
-// Writes data to a file (asynchronous overload).
-void CAkDefaultIOHookDeferred::Write(
-	AkFileDesc &			in_fileDesc,        // File descriptor.
-	const AkIoHeuristics & /*in_heuristics*/,	// Heuristics for this data transfer (not used in this implementation).
-	AkAsyncIOTransferInfo & io_transferInfo		// Platform-specific asynchronous IO operation info.
+void CAkDefaultIOHookDeferred::SubmitTransfers(
+	AkUInt32				in_uNumTransfers,
+	BatchIoTransferItem *	in_pTransferItems,
+	bool					in_bWrite
 	)
 {
-	io_transferInfo.pUserData = (void*)&in_fileDesc;
-	
-	//Call the low level read which takes care of error handling with the callback 
-	AioFuncWrite(io_transferInfo);
+	if ( in_bWrite )
+	{
+		for ( AkUInt32 i = 0; i < in_uNumTransfers; ++i )
+			m_blockCache.Invalidate( ((AkPosixFileDesc*)in_pTransferItems[i].pFileDesc)->fd );
+
+		AkAsyncIoRequest * pRequests = (AkAsyncIoRequest*)AkAlloca( in_uNumTransfers * sizeof( AkAsyncIoRequest ) );
+		for ( AkUInt32 i = 0; i < in_uNumTransfers; ++i )
+		{
+			BatchIoTransferItem & item = in_pTransferItems[i];
+			AkAsyncIOTransferInfo & transferInfo = *item.pTransferInfo;
+			transferInfo.pUserData = (void*)item.pFileDesc;
+
+			AkAsyncIoRequest & request = pRequests[i];
+			request.fd = ((AkPosixFileDesc*)item.pFileDesc)->fd;
+			request.pBuffer = transferInfo.pBuffer;
+			request.uOffset = transferInfo.uFilePosition;
+			request.uSize = transferInfo.uRequestedSize;
+			request.uMinSize = 0;
+			request.bWrite = true;
+			request.pIovecs = NULL;
+			request.uNumIovecs = 0;
+			request.pfnCompletion = OnTransferComplete;
+			request.pCookie = &transferInfo;
+		}
+		m_pIoBackend->Submit( pRequests, in_uNumTransfers );
+		return;
+	}
+
+	// Reads go through the block cache, then what it did not serve is
+	// sorted and merged.
+	AkBatchRead * pReads = (AkBatchRead*)AkAlloca( in_uNumTransfers * sizeof( AkBatchRead ) );
+	AkUInt32 uNumReads = 0;
+	for ( AkUInt32 i = 0; i < in_uNumTransfers; ++i )
+	{
+		BatchIoTransferItem & item = in_pTransferItems[i];
+		AkAsyncIOTransferInfo & transferInfo = *item.pTransferInfo;
+		transferInfo.pUserData = (void*)item.pFileDesc;
+
+		const AkPosixFileDesc & fileDesc = *(AkPosixFileDesc*)item.pFileDesc;
+		AkBatchRead & read = pReads[uNumReads];
+		read.fd = fileDesc.fd;
+		read.pBuffer = transferInfo.pBuffer;
+		read.uOffset = transferInfo.uFilePosition;
+		read.uSize = transferInfo.uRequestedSize;
+		read.uMinSize = 0;
+		read.pfnCompletion = OnTransferComplete;
+		read.pCookie = &transferInfo;
+
+		// uFilePosition is relative to the descriptor, which may be a whole
+		// file package. Requests are rounded up to the block size, so the
+		// last one of a file may end past it.
+		AkUInt64 uFileEnd = (AkUInt64)item.pFileDesc->uSector * GetBlockSize( *item.pFileDesc ) + item.pFileDesc->iFileSize;
+		if ( read.uOffset < uFileEnd && read.uOffset + read.uSize > uFileEnd )
+			read.uMinSize = (AkUInt32)( uFileEnd - read.uOffset );
+
+		// Direct I/O reads whole blocks into aligned memory. The Stream
+		// Manager's buffers normally are; others are bounced.
+		if ( fileDesc.uDirectIoBlockSize > 1 )
+		{
+			AkUInt64 uBlockSize = fileDesc.uDirectIoBlockSize;
+			AkUInt64 uEnd = ( ( read.uOffset + read.uSize + uBlockSize - 1 ) / uBlockSize ) * uBlockSize;
+			if ( read.uOffset % uBlockSize == 0
+				&& (AkUIntPtr)read.pBuffer % fileDesc.uDirectIoMemAlign == 0
+				&& uEnd - read.uOffset <= transferInfo.uBufferSize )
+			{
+				if ( read.uMinSize == 0 )
+					read.uMinSize = read.uSize;
+				read.uSize = (AkUInt32)( uEnd - read.uOffset );
+			}
+			else if ( !BounceRead( read, fileDesc ) )
+			{
+				OnTransferComplete( &transferInfo, AK_InsufficientMemory );
+				continue;
+			}
+		}
+
+		if ( !m_blockCache.Read( m_pIoBackend, read, uFileEnd ) )
+			++uNumReads;
+	}
+	m_batchReadOptimizer.Submit( m_pIoBackend, pReads, uNumReads );
 }
 
 // Close a file.
@@ -200,7 +523,13 @@ AKRESULT CAkDefaultIOHookDeferred::Close(
 {
 	if (in_pFileDesc)
 	{
-		CAkFileHelpers::CloseFile(*in_pFileDesc);
+		int fd = ((AkPosixFileDesc*)in_pFileDesc)->fd;
+		if (fd >= 0)
+		{
+			m_blockCache.Invalidate(fd);
+			m_pIoBackend->UnregisterFile(fd);
+			close(fd);
+		}
 		AkDelete(AkMemID_Streaming, in_pFileDesc);
 	}
 	return AK_Success;
@@ -208,12 +537,12 @@ AKRESULT CAkDefaultIOHookDeferred::Close(
 
 // Returns the block size for the file or its storage device. 
 AkUInt32 CAkDefaultIOHookDeferred::GetBlockSize(
-    AkFileDesc &  /*in_fileDesc*/     // File descriptor.
+    AkFileDesc &  in_fileDesc     // File descriptor.
     )
 {
-	// There is no limitation nor performance degradation with unaligned
-	// seeking on any mount point with asynchronous cell fs API.
-    return 1;
+	// Positional reads have no alignment requirement, except with direct
+	// I/O, where it is the one found when the file was opened.
+    return static_cast<AkPosixFileDesc&>( in_fileDesc ).uDirectIoBlockSize;
 }
 
 // Returns a description for the streaming device above this low-level hook.
@@ -253,18 +582,10 @@ void CAkDefaultIOHookDeferred::BatchOpen(AkUInt32 in_uNumFiles, AkAsyncFileOpenD
 
 void CAkDefaultIOHookDeferred::BatchRead(AkUInt32 in_uNumTransfers, BatchIoTransferItem* in_pTransferItems)
 {
-	for (int i = 0; i < (int)in_uNumTransfers; ++i)
-	{
-		BatchIoTransferItem ioTransferItem = in_pTransferItems[i];
-		Read(*(ioTransferItem.pFileDesc), ioTransferItem.ioHeuristics, *(ioTransferItem.pTransferInfo));
-	}
+	SubmitTransfers(in_uNumTransfers, in_pTransferItems, false);
 }
 
 void CAkDefaultIOHookDeferred::BatchWrite(AkUInt32 in_uNumTransfers, BatchIoTransferItem* in_pTransferItems)
 {
-	for (int i = 0; i < (int)in_uNumTransfers; ++i)
-	{
-		BatchIoTransferItem ioTransferItem = in_pTransferItems[i];
-		Write(*(ioTransferItem.pFileDesc), ioTransferItem.ioHeuristics, *(ioTransferItem.pTransferInfo));
-	}
+	SubmitTransfers(in_uNumTransfers, in_pTransferItems, true);
 }
@@ -27,8 +27,29 @@ written agreement between you and Audiokinetic Inc.
 // at class CAkDefaultLowLevelIODispatcher).
 //
 // AK::StreamMgr::IAkLowLevelIOHook: 
-// Uses standard C IO functions, into seperate thread for async IO.
-// AioFuncRead and AioFuncWrite handle the IO operation asynchronously.
+// Files are opened as raw file descriptors (AkPosixFileDesc::fd), without
+// stdio, and only accessed with positional reads and writes, so any number
+// of transfers may run concurrently on one descriptor, like all the files
+// of a file package do. Transfers are handed to a
+// CAkAsyncIoBackend (see AkAsyncIoBackend.h): io_uring where available,
+// worker threads doing pread()/pwrite() otherwise. A BatchRead() or 
+// BatchWrite() is submitted as one batch and returns immediately; transfers
+// complete on the backend's threads, through transferInfo.pCallback.
+// The reads of a batch are sorted, and neighbouring reads of a file are
+// merged into single scatter reads (see AkBatchReadOptimizer.h). Before
+// that, reads are looked up in a block cache with read-ahead (see
+// AkBlockCache.h).
+// The device's I/O memory and open files are registered with the backend.
+//
+// With SetDirectIO( true ), files opened for reading bypass the page cache
+// (O_DIRECT; F_NOCACHE on Apple platforms). The file system's real direct
+// I/O alignment is queried when the file is opened (statx(), or the logical
+// block size of the device) and returned by GetBlockSize(), so the Stream
+// Manager aligns its transfers to it; uGranularity must be a multiple of it
+// (4096 covers all common devices). Reads that are still misaligned (file
+// package entries with a smaller block size) go through a bounce buffer.
+// Files whose file system refuses direct I/O, or keeps files in memory
+// (tmpfs), are read through the page cache, with a block size of 1.
 //
 // Init() creates a streaming device (by calling AK::StreamMgr::CreateDevice()).
 // If there was no AK::StreamMgr::IAkFileLocationResolver previously registered 
@@ -86,6 +107,9 @@ written agreement between you and Audiokinetic Inc.
 
 #include <AK/SoundEngine/Common/AkStreamMgrModule.h>
 #include "../Common/AkMultipleFileLocation.h"
+#include "AkAsyncIoBackend.h"
+#include "AkBatchReadOptimizer.h"
+#include "AkBlockCache.h"
 
 #include <AK/Tools/Common/AkLock.h>
 #include <AK/Tools/Common/AkAutoLock.h>
@@ -94,6 +118,21 @@ written agreement between you and Audiokinetic Inc.
 
 #define AK_MAX_MOUNT_POINT_STRLENGTH	(12)
 
+//-----------------------------------------------------------------------------
+// Name: struct AkPosixFileDesc
+// Desc: File descriptor of the POSIX deferred hook. hFile is not used (NULL);
+//		 the file is accessed through fd. Copies share the descriptor (files
+//		 of a file package); only the hook's Close() closes it.
+//-----------------------------------------------------------------------------
+struct AkPosixFileDesc : public AkFileDesc
+{
+	AkPosixFileDesc() : fd( -1 ), uDirectIoBlockSize( 1 ), uDirectIoMemAlign( 1 ) {}
+
+	int			fd;
+	AkUInt32	uDirectIoBlockSize;		// Offset and size alignment of reads; 1 without direct I/O.
+	AkUInt32	uDirectIoMemAlign;		// Buffer alignment of reads; 1 without direct I/O.
+};
+
 //-----------------------------------------------------------------------------
 // Name: class CAkDefaultIOHookDeferred.
 // Desc: Implements IAkLowLevelIOHook low-level I/O hook, and 
@@ -107,7 +146,7 @@ class CAkDefaultIOHookDeferred : public AK::StreamMgr::IAkFileLocationResolver
 {
 public:
 
-	typedef AkFileDesc AkFileDescType;
+	typedef AkPosixFileDesc AkFileDescType;
 
 	CAkDefaultIOHookDeferred();
 	virtual ~CAkDefaultIOHookDeferred();
@@ -121,6 +160,27 @@ public:
 		);
 	void Term();
 
+	// Selects the transfer backend. Call before Init(). Defaults to
+	// AkAsyncIoBackend_Auto.
+	void SetIoBackendType( AkAsyncIoBackendType in_eType ) { m_eIoBackendType = in_eType; }
+
+	// Number of worker threads of the thread pool backend. Call before Init().
+	void SetIoThreadCount( AkUInt32 in_uNumThreads ) { m_uIoThreadCount = in_uNumThreads; }
+
+	// Merging of neighbouring reads. Call before Init().
+	void SetBatchReadSettings( const AkBatchReadSettings & in_settings ) { m_batchReadSettings = in_settings; }
+	void GetBatchReadStats( AkBatchReadStats & out_stats ) const { m_batchReadOptimizer.GetStats( out_stats ); }
+
+	// Block cache and read-ahead. Call before Init().
+	void SetBlockCacheSettings( const AkBlockCacheSettings & in_settings ) { m_blockCacheSettings = in_settings; }
+	void GetBlockCacheStats( AkBlockCacheStats & out_stats ) { m_blockCache.GetStats( out_stats ); }
+
+	// Reads files without the page cache. Call before Init().
+	void SetDirectIO( bool in_bDirectIO ) { m_bDirectIO = in_bDirectIO; }
+
+	// Name of the backend in use, or NULL before Init().
+	const char * GetIoBackendName() const { return m_pIoBackend ? m_pIoBackend->GetName() : NULL; }
+
 	// Allow creation of specialized AkFileDesc class for derivatives of this class.
 	// On Android, we use the CAkFileHelpers class which has its own derivative.
 	// Should be freed in Close();
@@ -175,23 +235,43 @@ protected:
 		AkFileDesc*& out_pFileDesc              ///< File descriptor produced
 	);
 
+	// Opens in_pszFullFilePath with open(2) into the AkPosixFileDesc.
+	virtual AKRESULT PlatformOpenFile(
+		const AkOSChar* in_pszFullFilePath,
+		AkOpenMode      in_eOpenMode,
+		bool			in_bOverlapped,
+		AkFileDesc &    out_fileDesc
+		) override;
+
 	AkDeviceID			m_deviceID;
 
 private:
 
-    // Reads data from a file (asynchronous).
-    void Read(
-		AkFileDesc &			in_fileDesc,        // File descriptor.
-		const AkIoHeuristics &	in_heuristics,		// Heuristics for this data transfer.
-		AkAsyncIOTransferInfo & io_transferInfo		// Asynchronous data transfer info.
+	// Submits the transfers to the backend as one batch, reads through the
+	// block cache and the batch read optimizer.
+	void SubmitTransfers(
+		AkUInt32				in_uNumTransfers,
+		BatchIoTransferItem *	in_pTransferItems,
+		bool					in_bWrite
 		);
 
-    // Writes data to a file (asynchronous).
-    void Write(
-		AkFileDesc &			in_fileDesc,        // File descriptor.
-		const AkIoHeuristics &	in_heuristics,		// Heuristics for this data transfer.
-		AkAsyncIOTransferInfo & io_transferInfo		// Platform-specific asynchronous IO operation info.
-		);
+	// Backend completion: the cookie is the AkAsyncIOTransferInfo.
+	static void OnTransferComplete( void * in_pCookie, AKRESULT in_eResult );
+
+	// Redirects a misaligned direct I/O read to an aligned bounce buffer.
+	// Returns false if it could not be allocated.
+	static bool BounceRead( AkBatchRead & io_read, const AkPosixFileDesc & in_fileDesc );
+	static void OnBounceComplete( void * in_pCookie, AKRESULT in_eResult );
+
+	CAkAsyncIoBackend *		m_pIoBackend;
+	AkAsyncIoBackendType	m_eIoBackendType;
+	AkUInt32				m_uIoThreadCount;
+	bool					m_bDirectIO;
+	AkBatchReadSettings		m_batchReadSettings;
+	CAkBatchReadOptimizer	m_batchReadOptimizer;
+	AkBlockCacheSettings	m_blockCacheSettings;
+	CAkBlockCache			m_blockCache;
+	void *					m_pIOMemory;		// Allocated by Init() when the settings have none.
 };
 
 #endif //_AK_DEFAULT_IO_HOOK_DEFERRED_H_
@@ -205,6 +205,35 @@ public:
 		return AK_Success;
 	}
 
+	/// Calls in_pfnEntry for each entry of in_pszDirectory, which ends with a path separator.
+	/// Returns AK_PathNotFound if the directory cannot be opened.
+	static AKRESULT ListDirectory( const AkOSChar* in_pszDirectory, AkDirectoryEntryFunc in_pfnEntry, void * in_pCookie )
+	{
+		DIR * h = opendir(in_pszDirectory);
+		if (h == NULL) return AK_PathNotFound;
+
+		struct dirent * pEntry;
+		while ((pEntry = readdir(h)) != NULL)
+		{
+			const char * pszName = pEntry->d_name;
+			if (pszName[0] == '.' && (pszName[1] == 0 || (pszName[1] == '.' && pszName[2] == 0)))
+				continue;
+
+			bool bIsDirectory = pEntry->d_type == DT_DIR;
+			if (pEntry->d_type == DT_UNKNOWN || pEntry->d_type == DT_LNK)
+			{
+				// No stat(): a directory is what opendir() accepts.
+				AkOSChar szPath[AK_MAX_PATH];
+				AKPLATFORM::SafeStrCpy(szPath, in_pszDirectory, AK_MAX_PATH);
+				AKPLATFORM::SafeStrCat(szPath, pszName, AK_MAX_PATH);
+				bIsDirectory = CheckDirectoryExists(szPath) == AK_Success;
+			}
+			in_pfnEntry(in_pCookie, pszName, bIsDirectory);
+		}
+		closedir(h);
+		return AK_Success;
+	}
+
 	static AKRESULT WriteBlocking(
 		AkFileHandle &	in_hFile,			// Returned file identifier/handle.
 		void *			in_pData,			// Buffer. Must be aligned on CAkFileHelpers::s_uRequiredBlockSize boundary.		
@@ -0,0 +1,115 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided 
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkMappedFilePackage.cpp
+//
+// See AkMappedFilePackage.h.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "AkMappedFilePackage.h"
+#include <sys/mman.h>
+#include <unistd.h>
+
+CAkMappedPackage * CAkMappedPackage::Create( 
+	AkFilePackageReader & in_reader,
+	const AkOSChar*		in_pszPackageName,
+	AkUInt32 			in_uHeaderSize,
+	AkUInt32 &			out_uReservedHeaderSize,
+	AkUInt8 *&			out_pHeaderBuffer
+	)
+{
+	CAkMappedPackage * pPackage = CAkFilePackage::Create<CAkMappedPackage>( 
+		in_pszPackageName,
+		in_uHeaderSize,
+		in_reader.GetBlockSize(),
+		out_uReservedHeaderSize,
+		out_pHeaderBuffer );
+	if ( pPackage )
+	{
+		pPackage->m_reader = in_reader;
+		pPackage->m_hFile = in_reader.GetFileDesc()->hFile;
+	}
+	return pPackage;
+}
+
+CAkMappedPackage * CAkMappedPackage::CreateMapped( 
+	AkFilePackageReader & in_reader,
+	const AkOSChar*		in_pszPackageName
+	)
+{
+	// The package file was opened by the POSIX deferred hook.
+	int fd = static_cast<AkPosixFileDesc*>( in_reader.GetFileDesc() )->fd;
+	AkUInt64 uSize = in_reader.GetSize();
+	if ( fd < 0 || uSize < AKPK_HEADER_CHUNK_DEF_SIZE )
+		return NULL;
+
+	void * pMapped = mmap( NULL, (size_t)uSize, PROT_READ, MAP_SHARED, fd, 0 );
+	if ( pMapped == MAP_FAILED )
+		return NULL;
+
+	// Second word of the header chunk: header size, excluding the chunk. It
+	// is validated by the caller.
+	AkUInt32 uHeaderSize = ((const AkUInt32*)pMapped)[1] + AKPK_HEADER_CHUNK_DEF_SIZE;
+
+	CAkMappedPackage * pPackage = CAkFilePackage::CreateInPlace<CAkMappedPackage>( in_pszPackageName, uHeaderSize );
+	if ( !pPackage )
+	{
+		munmap( pMapped, (size_t)uSize );
+		return NULL;
+	}
+
+	pPackage->m_reader = in_reader;
+	pPackage->m_hFile = in_reader.GetFileDesc()->hFile;
+	pPackage->m_pMapped = (AkUInt8*)pMapped;
+	pPackage->m_uMappedSize = uSize;
+
+	// The look-up tables are needed right away.
+	if ( uHeaderSize < uSize )
+		madvise( pMapped, uHeaderSize, MADV_WILLNEED );
+
+	return pPackage;
+}
+
+void CAkMappedPackage::AdviseRead(
+	AkUInt64			in_uOffset,
+	AkUInt32			in_uSize,
+	AkReal32			in_fDeadline,
+	AkPriority			in_priority
+	)
+{
+	// Streams read their file sequentially, so the next read most likely
+	// follows this one. Each hint is a system call: only urgent streams get
+	// one, the others rely on the kernel's read-around.
+	if ( in_fDeadline > AK_MAPPED_PACKAGE_URGENT_DEADLINE && in_priority <= AK_DEFAULT_PRIORITY )
+		return;
+
+	static const AkUInt64 uPageSize = (AkUInt64)sysconf( _SC_PAGESIZE );
+	AkUInt64 uStart = ( ( in_uOffset + in_uSize ) / uPageSize ) * uPageSize;
+	if ( uStart >= m_uMappedSize )
+		return;
+	AkUInt64 uLength = AkMin( (AkUInt64)in_uSize, m_uMappedSize - uStart );
+	madvise( m_pMapped + uStart, (size_t)uLength, MADV_WILLNEED );
+}
+
+void CAkMappedPackage::Destroy()
+{
+	if ( m_pMapped )
+		munmap( m_pMapped, (size_t)m_uMappedSize );
+	m_pMapped = NULL;
+
+	CAkDiskPackage::Destroy();
+}
@@ -0,0 +1,92 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided 
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkMappedFilePackage.h
+//
+// File package that is mapped in memory (mmap) as a whole when loaded
+// with CAkFilePackageLowLevelIO::LoadFilePackageMapped(). The look-up
+// tables are parsed in place in the mapping, and reads of packaged files
+// are served by copying from it: for packages in the page cache, a read
+// costs no system call at all.
+//
+// The package file is opened through the regular path (the POSIX deferred
+// hook), whose file descriptor is mapped. Use it as the package type of
+// CAkFilePackageLowLevelIO, e.g. CAkFilePackageLowLevelIODeferredMapped.
+// Packages loaded with LoadFilePackage() are not mapped and behave like
+// CAkDiskPackage.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_MAPPED_FILE_PACKAGE_H_
+#define _AK_MAPPED_FILE_PACKAGE_H_
+
+#include "../Common/AkFilePackageLowLevelIO.h"
+#include "AkDefaultIOHookDeferred.h"
+
+// Reads with a deadline below this (ms), or above the default priority, 
+// prefetch the range that follows them (madvise(MADV_WILLNEED)).
+#define AK_MAPPED_PACKAGE_URGENT_DEADLINE	(50.f)
+
+//-----------------------------------------------------------------------------
+// Name: CAkMappedPackage 
+// Desc: Disk package whose file can be mapped in memory.
+//-----------------------------------------------------------------------------
+class CAkMappedPackage : public CAkDiskPackage
+{
+public:
+	// Regular factory (LoadFilePackage()): the header is read into memory and
+	// the package is not mapped.
+	static CAkMappedPackage * Create( 
+		AkFilePackageReader & in_reader,		// File package reader.
+		const AkOSChar*		in_pszPackageName,	// Name of the file package (for memory monitoring).
+		AkUInt32 			in_uHeaderSize,		// File package header size, including the size of the header chunk AKPK_HEADER_CHUNK_DEF_SIZE.
+		AkUInt32 &			out_uReservedHeaderSize, // Size reserved for header, taking mem align into account.
+		AkUInt8 *&			out_pHeaderBuffer	// Returned address of memory for header.
+		);
+
+	// Mapped factory (LoadFilePackageMapped()): maps the whole package file.
+	// Returns NULL if it cannot be mapped; the reader is left open.
+	static CAkMappedPackage * CreateMapped( 
+		AkFilePackageReader & in_reader,		// File package reader.
+		const AkOSChar*		in_pszPackageName	// Name of the file package (for ID generation).
+		);
+
+	CAkMappedPackage(AkUInt32 in_uPackageID, AkUInt32 in_uHeaderSize, void * in_pToRelease)
+		: CAkDiskPackage(in_uPackageID, in_uHeaderSize, in_pToRelease)
+		, m_pMapped( NULL )
+		, m_uMappedSize( 0 )
+	{ }
+
+	virtual const AkUInt8 * MappedData() const override { return m_pMapped; }
+	virtual AkUInt64 MappedSize() const override { return m_uMappedSize; }
+
+	virtual void AdviseRead(
+		AkUInt64			in_uOffset,
+		AkUInt32			in_uSize,
+		AkReal32			in_fDeadline,
+		AkPriority			in_priority
+		) override;
+
+	// Override Destroy(): Unmap
+	virtual void Destroy() override;
+
+protected:
+	AkUInt8 *			m_pMapped;		// Whole package file, read only. NULL if not mapped.
+	AkUInt64			m_uMappedSize;
+};
+
+typedef CAkFilePackageLowLevelIO<CAkDefaultIOHookDeferred, CAkMappedPackage> CAkFilePackageLowLevelIODeferredMapped;
+
+#endif //_AK_MAPPED_FILE_PACKAGE_H_
@@ -0,0 +1,299 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkFilePackageCompression.cpp
+//
+// See AkFilePackageCompression.h.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "AkFilePackageCompression.h"
+#include "../Common/AkFilePackageLUT.h"
+#include "../Common/AkLz4.h"
+
+#include <string.h>
+#include <map>
+
+namespace
+{
+	struct FileHeaderFormat
+	{
+		AkUInt32	uFileFormatTag;
+		AkUInt32	uHeaderSize;	// Excludes the 8 bytes of the chunk definition.
+		AkUInt32	uVersion;
+		AkUInt32	uLanguageMapSize;
+		AkUInt32	uSoundBanksLUTSize;
+		AkUInt32	uStmFilesLUTSize;
+		AkUInt32	uExternalsLUTSize;
+	};
+
+	struct CompressionMapFormat
+	{
+		AkUInt32	uNumFiles;
+		AkUInt32	uNumChunkOffsets;
+	};
+
+	// The data of one or more LUT entries.
+	struct Region
+	{
+		AkUInt64				uOffset;		// In the input package.
+		AkUInt32				uSize;
+		AkUInt32				uBlockSize;		// Largest block size of its entries.
+		bool					bSizeMismatch;	// Entries disagree on the size: stored as is.
+		std::vector<AkUInt8>	stored;			// Compressed chunks; empty if stored as is.
+		std::vector<AkUInt32>	chunkOffsets;	// Number of chunks + 1.
+		AkUInt64				uNewOffset;		// In the output package.
+	};
+
+	typedef std::map<AkUInt64, Region> Regions;
+
+	// Adds the entries of a LUT to the regions. Returns false if it is invalid.
+	template <class T_FILEID>
+	bool CollectRegions( const AkUInt8 * in_pLUT, AkUInt32 in_uLUTSize, AkUInt64 in_uPackageSize, Regions & io_regions )
+	{
+		typedef CAkFilePackageLUT::AkFileEntry<T_FILEID> Entry;
+		if ( in_uLUTSize == 0 )
+			return true;
+		AkUInt32 uNumFiles;
+		memcpy( &uNumFiles, in_pLUT, sizeof( AkUInt32 ) );
+		if ( in_uLUTSize < sizeof( AkUInt32 ) + (AkUInt64)uNumFiles * sizeof( Entry ) )
+			return false;
+
+		const Entry * pEntries = (const Entry*)( in_pLUT + sizeof( AkUInt32 ) );
+		for ( AkUInt32 i = 0; i < uNumFiles; ++i )
+		{
+			const Entry & entry = pEntries[i];
+			AkUInt64 uOffset = (AkUInt64)entry.uStartBlock * entry.uBlockSize;
+			if ( entry.uBlockSize == 0 || uOffset + entry.uFileSize > in_uPackageSize )
+				return false;
+
+			Regions::iterator it = io_regions.find( uOffset );
+			if ( it == io_regions.end() )
+			{
+				Region & region = io_regions[uOffset];
+				region.uOffset = uOffset;
+				region.uSize = entry.uFileSize;
+				region.uBlockSize = entry.uBlockSize;
+				region.bSizeMismatch = false;
+				region.uNewOffset = 0;
+			}
+			else
+			{
+				Region & region = it->second;
+				if ( region.uSize != entry.uFileSize )
+				{
+					region.bSizeMismatch = true;
+					if ( entry.uFileSize > region.uSize )
+						region.uSize = entry.uFileSize;
+				}
+				if ( entry.uBlockSize > region.uBlockSize )
+					region.uBlockSize = entry.uBlockSize;
+			}
+		}
+		return true;
+	}
+
+	// Moves the entries of a LUT to the new offsets of their regions.
+	template <class T_FILEID>
+	bool RelocateEntries( AkUInt8 * io_pLUT, AkUInt32 in_uLUTSize, const Regions & in_regions )
+	{
+		typedef CAkFilePackageLUT::AkFileEntry<T_FILEID> Entry;
+		if ( in_uLUTSize == 0 )
+			return true;
+		AkUInt32 uNumFiles;
+		memcpy( &uNumFiles, io_pLUT, sizeof( AkUInt32 ) );
+
+		Entry * pEntries = (Entry*)( io_pLUT + sizeof( AkUInt32 ) );
+		for ( AkUInt32 i = 0; i < uNumFiles; ++i )
+		{
+			Entry & entry = pEntries[i];
+			const Region & region = in_regions.find( (AkUInt64)entry.uStartBlock * entry.uBlockSize )->second;
+			AkUInt64 uStartBlock = region.uNewOffset / entry.uBlockSize;
+			if ( region.uNewOffset % entry.uBlockSize != 0 || uStartBlock > 0xFFFFFFFF )
+				return false;
+			entry.uStartBlock = (AkUInt32)uStartBlock;
+		}
+		return true;
+	}
+
+	// Compresses a region in chunks. Leaves it empty if it is not worth it.
+	void CompressRegion( Region & io_region, const AkUInt8 * in_pData, AkUInt32 in_uChunkSize, AkUInt32 in_uMinGain )
+	{
+		if ( io_region.bSizeMismatch || io_region.uSize == 0 )
+			return;
+
+		std::vector<AkUInt8> compressed( CAkLz4::CompressBound( in_uChunkSize ) );
+		for ( AkUInt32 uPos = 0; uPos < io_region.uSize; uPos += in_uChunkSize )
+		{
+			io_region.chunkOffsets.push_back( (AkUInt32)io_region.stored.size() );
+
+			AkUInt32 uSize = io_region.uSize - uPos;
+			if ( uSize > in_uChunkSize )
+				uSize = in_uChunkSize;
+			const AkUInt8 * pChunk = in_pData + uPos;
+
+			// Readers store a chunk as is when it keeps its size.
+			AkUInt32 uCompressedSize = CAkLz4::Compress( pChunk, uSize, &compressed[0], (AkUInt32)compressed.size() );
+			if ( uCompressedSize > 0 && uCompressedSize < uSize )
+				io_region.stored.insert( io_region.stored.end(), &compressed[0], &compressed[0] + uCompressedSize );
+			else
+				io_region.stored.insert( io_region.stored.end(), pChunk, pChunk + uSize );
+		}
+		io_region.chunkOffsets.push_back( (AkUInt32)io_region.stored.size() );
+
+		if ( (AkUInt64)io_region.stored.size() * 100 > (AkUInt64)io_region.uSize * ( 100 - in_uMinGain ) )
+		{
+			io_region.stored.clear();
+			io_region.chunkOffsets.clear();
+		}
+	}
+}
+
+CAkFilePackageCompression::Result CAkFilePackageCompression::Compress(
+	const std::vector<AkUInt8> &	in_package,		// Uncompressed package.
+	AkUInt32						in_uChunkSize,	// Size of the chunks; not 0.
+	AkUInt32						in_uMinGain,	// Percentage; at most 100.
+	std::vector<AkUInt8> &			out_package,	// Compressed package.
+	Stats &							out_stats
+	)
+{
+	// Parse the header.
+	FileHeaderFormat header;
+	if ( in_package.size() < sizeof( header ) )
+		return Result_NotAPackage;
+	memcpy( &header, &in_package[0], sizeof( header ) );
+	AkUInt64 uTablesSize = (AkUInt64)header.uLanguageMapSize + header.uSoundBanksLUTSize + header.uStmFilesLUTSize + header.uExternalsLUTSize;
+	if ( header.uFileFormatTag != AKPK_FILE_FORMAT_TAG
+		|| header.uVersion < AKPK_CURRENT_VERSION
+		|| (AkUInt64)header.uHeaderSize + AKPK_HEADER_CHUNK_DEF_SIZE > in_package.size()
+		|| sizeof( header ) + uTablesSize > (AkUInt64)header.uHeaderSize + AKPK_HEADER_CHUNK_DEF_SIZE )
+	{
+		return Result_NotAPackage;
+	}
+	const AkUInt8 * pTables = &in_package[0] + sizeof( header );
+	if ( header.uVersion >= AKPK_COMPRESSED_VERSION )
+	{
+		CompressionMapFormat map = { 0, 0 };
+		if ( sizeof( header ) + uTablesSize + sizeof( map ) <= (AkUInt64)header.uHeaderSize + AKPK_HEADER_CHUNK_DEF_SIZE )
+			memcpy( &map, pTables + uTablesSize, sizeof( map ) );
+		if ( map.uNumFiles > 0 )
+			return Result_AlreadyCompressed;
+	}
+
+	const AkUInt8 * pSoundBanks = pTables + header.uLanguageMapSize;
+	const AkUInt8 * pStmFiles = pSoundBanks + header.uSoundBanksLUTSize;
+	const AkUInt8 * pExternals = pStmFiles + header.uStmFilesLUTSize;
+
+	Regions regions;
+	if ( !CollectRegions<AkFileID>( pSoundBanks, header.uSoundBanksLUTSize, in_package.size(), regions )
+		|| !CollectRegions<AkFileID>( pStmFiles, header.uStmFilesLUTSize, in_package.size(), regions )
+		|| !CollectRegions<AkUInt64>( pExternals, header.uExternalsLUTSize, in_package.size(), regions ) )
+	{
+		return Result_InvalidLUT;
+	}
+
+	// Files are moved, so their data must not overlap.
+	AkUInt64 uPrevEnd = 0;
+	for ( Regions::iterator it = regions.begin(); it != regions.end(); ++it )
+	{
+		if ( it->second.uOffset < uPrevEnd )
+			return Result_OverlappingFiles;
+		uPrevEnd = it->second.uOffset + it->second.uSize;
+	}
+
+	AkUInt32 uNumCompressed = 0;
+	AkUInt32 uNumChunkOffsets = 0;
+	for ( Regions::iterator it = regions.begin(); it != regions.end(); ++it )
+	{
+		Region & region = it->second;
+		CompressRegion( region, &in_package[0] + region.uOffset, in_uChunkSize, in_uMinGain );
+		if ( !region.chunkOffsets.empty() )
+		{
+			++uNumCompressed;
+			uNumChunkOffsets += (AkUInt32)region.chunkOffsets.size();
+		}
+	}
+
+	// Lay out the new package: header with the compression map, then the
+	// files, each aligned on its block size.
+	AkUInt64 uMapSize = sizeof( CompressionMapFormat )
+		+ (AkUInt64)uNumCompressed * sizeof( CAkFilePackageLUT::AkCompressedFile )
+		+ (AkUInt64)uNumChunkOffsets * sizeof( AkUInt32 );
+	AkUInt64 uHeaderEnd = sizeof( header ) + uTablesSize + uMapSize;
+	AkUInt64 uPos = uHeaderEnd;
+	for ( Regions::iterator it = regions.begin(); it != regions.end(); ++it )
+	{
+		Region & region = it->second;
+		uPos = ( uPos + region.uBlockSize - 1 ) / region.uBlockSize * region.uBlockSize;
+		region.uNewOffset = uPos;
+		uPos += region.chunkOffsets.empty() ? region.uSize : region.stored.size();
+	}
+
+	out_package.assign( (size_t)uPos, 0 );
+	header.uVersion = AKPK_COMPRESSED_VERSION;
+	header.uHeaderSize = (AkUInt32)( uHeaderEnd - AKPK_HEADER_CHUNK_DEF_SIZE );
+	memcpy( &out_package[0], &header, sizeof( header ) );
+	memcpy( &out_package[0] + sizeof( header ), pTables, (size_t)uTablesSize );
+
+	AkUInt8 * pNewSoundBanks = &out_package[0] + sizeof( header ) + header.uLanguageMapSize;
+	AkUInt8 * pNewStmFiles = pNewSoundBanks + header.uSoundBanksLUTSize;
+	AkUInt8 * pNewExternals = pNewStmFiles + header.uStmFilesLUTSize;
+	if ( !RelocateEntries<AkFileID>( pNewSoundBanks, header.uSoundBanksLUTSize, regions )
+		|| !RelocateEntries<AkFileID>( pNewStmFiles, header.uStmFilesLUTSize, regions )
+		|| !RelocateEntries<AkUInt64>( pNewExternals, header.uExternalsLUTSize, regions ) )
+	{
+		return Result_CannotRelocate;
+	}
+
+	// Compression map, sorted by data offset like the regions.
+	AkUInt8 * pMap = pNewExternals + header.uExternalsLUTSize;
+	CompressionMapFormat map = { uNumCompressed, uNumChunkOffsets };
+	memcpy( pMap, &map, sizeof( map ) );
+	CAkFilePackageLUT::AkCompressedFile * pFiles = (CAkFilePackageLUT::AkCompressedFile*)( pMap + sizeof( map ) );
+	AkUInt32 * pChunkOffsets = (AkUInt32*)( pFiles + uNumCompressed );
+	AkUInt32 uFirstChunk = 0;
+
+	AkUInt64 uSizeIn = 0, uSizeOut = 0;
+	for ( Regions::iterator it = regions.begin(); it != regions.end(); ++it )
+	{
+		const Region & region = it->second;
+		uSizeIn += region.uSize;
+		if ( region.chunkOffsets.empty() )
+		{
+			memcpy( &out_package[0] + region.uNewOffset, &in_package[0] + region.uOffset, region.uSize );
+			uSizeOut += region.uSize;
+			continue;
+		}
+
+		memcpy( &out_package[0] + region.uNewOffset, &region.stored[0], region.stored.size() );
+		uSizeOut += region.stored.size();
+
+		CAkFilePackageLUT::AkCompressedFile file;
+		file.uDataOffset = region.uNewOffset;
+		file.uFileSize = region.uSize;
+		file.uCodec = AKPK_CODEC_LZ4;
+		file.uChunkSize = in_uChunkSize;
+		file.uFirstChunk = uFirstChunk;
+		memcpy( pFiles++, &file, sizeof( file ) );
+		memcpy( pChunkOffsets + uFirstChunk, &region.chunkOffsets[0], region.chunkOffsets.size() * sizeof( AkUInt32 ) );
+		uFirstChunk += (AkUInt32)region.chunkOffsets.size();
+	}
+
+	out_stats.uNumFiles = (AkUInt32)regions.size();
+	out_stats.uNumCompressed = uNumCompressed;
+	out_stats.uDataSizeIn = uSizeIn;
+	out_stats.uDataSizeOut = uSizeOut;
+	return Result_Success;
+}
@@ -0,0 +1,75 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkFilePackageCompression.h
+//
+// Rewrites a file package created by the AkFilePackager utility app as a
+// compressed package (version AKPK_COMPRESSED_VERSION, see
+// AkFilePackageLUT.h), in memory. Used by the AkFilePackageCompressor
+// command line tool.
+//
+// The data of each file is split in chunks of in_uChunkSize bytes,
+// compressed independently with CAkLz4. Chunks that do not get smaller
+// are stored as is, and files that do not get at least in_uMinGain
+// percent smaller, like Vorbis or Opus media, are not compressed at all.
+// The language map and LUTs are kept; only the start block of the entries
+// changes, since files keep their alignment but move.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_FILE_PACKAGE_COMPRESSION_H_
+#define _AK_FILE_PACKAGE_COMPRESSION_H_
+
+#include <AK/SoundEngine/Common/AkTypes.h>
+#include <vector>
+
+#define AK_COMPRESSOR_DEFAULT_CHUNK_SIZE	(64 * 1024)
+#define AK_COMPRESSOR_DEFAULT_MIN_GAIN		(10)
+
+//-----------------------------------------------------------------------------
+// Name: class CAkFilePackageCompression
+// Desc: Compression of file packages.
+//-----------------------------------------------------------------------------
+class CAkFilePackageCompression
+{
+public:
+	enum Result
+	{
+		Result_Success,
+		Result_NotAPackage,			// Bad tag, version or header size.
+		Result_AlreadyCompressed,
+		Result_InvalidLUT,			// An entry is out of the package.
+		Result_OverlappingFiles,	// Files that are moved must not overlap.
+		Result_CannotRelocate		// A start block does not fit the new offset.
+	};
+
+	struct Stats
+	{
+		AkUInt32	uNumFiles;			// Distinct file data in the package.
+		AkUInt32	uNumCompressed;
+		AkUInt64	uDataSizeIn;		// Size of the file data, before and after.
+		AkUInt64	uDataSizeOut;
+	};
+
+	static Result Compress(
+		const std::vector<AkUInt8> &	in_package,		// Uncompressed package.
+		AkUInt32						in_uChunkSize,	// Size of the chunks; not 0.
+		AkUInt32						in_uMinGain,	// Percentage; at most 100.
+		std::vector<AkUInt8> &			out_package,	// Compressed package.
+		Stats &							out_stats
+		);
+};
+
+#endif //_AK_FILE_PACKAGE_COMPRESSION_H_
@@ -0,0 +1,135 @@
+/*******************************************************************************
+The content of this file includes portions of the AUDIOKINETIC Wwise Technology
+released in source code form as part of the SDK installer package.
+
+Commercial License Usage
+
+Licensees holding valid commercial licenses to the AUDIOKINETIC Wwise Technology
+may use this file in accordance with the end user license agreement provided
+with the software or, alternatively, in accordance with the terms contained in a
+written agreement between you and Audiokinetic Inc.
+
+  Copyright (c) 2024 Audiokinetic Inc.
+*******************************************************************************/
+//////////////////////////////////////////////////////////////////////
+//
+// AkFilePackageCompressor.cpp
+//
+// Command line tool that rewrites a file package created by the
+// AkFilePackager utility app as a compressed package (version
+// AKPK_COMPRESSED_VERSION, see AkFilePackageLUT.h):
+//
+//   AkFilePackageCompressor <in.pck> <out.pck> [-chunksize <bytes>] [-mingain <percent>]
+//
+// The data of each file is split in chunks of -chunksize bytes (64 KB by
+// default), and files that do not get at least -mingain percent smaller
+// (10 by default) are not compressed (see AkFilePackageCompression.h).
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "AkFilePackageCompression.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+	bool ReadFile( const char * in_pszName, std::vector<AkUInt8> & out_data )
+	{
+		FILE * pFile = fopen( in_pszName, "rb" );
+		if ( !pFile )
+			return false;
+		bool bOk = fseek( pFile, 0, SEEK_END ) == 0;
+		long lSize = bOk ? ftell( pFile ) : -1;
+		bOk = lSize >= 0 && fseek( pFile, 0, SEEK_SET ) == 0;
+		if ( bOk )
+		{
+			out_data.resize( (size_t)lSize );
+			bOk = lSize == 0 || fread( &out_data[0], 1, (size_t)lSize, pFile ) == (size_t)lSize;
+		}
+		fclose( pFile );
+		return bOk;
+	}
+
+	void Usage()
+	{
+		fprintf( stderr, "Usage: AkFilePackageCompressor <in.pck> <out.pck> [-chunksize <bytes>] [-mingain <percent>]\n" );
+	}
+}
+
+int main( int argc, char * argv[] )
+{
+	if ( argc < 3 )
+	{
+		Usage();
+		return 1;
+	}
+
+	AkUInt32 uChunkSize = AK_COMPRESSOR_DEFAULT_CHUNK_SIZE;
+	AkUInt32 uMinGain = AK_COMPRESSOR_DEFAULT_MIN_GAIN;
+	for ( int i = 3; i < argc; ++i )
+	{
+		if ( strcmp( argv[i], "-chunksize" ) == 0 && i + 1 < argc )
+			uChunkSize = (AkUInt32)strtoul( argv[++i], NULL, 0 );
+		else if ( strcmp( argv[i], "-mingain" ) == 0 && i + 1 < argc )
+			uMinGain = (AkUInt32)strtoul( argv[++i], NULL, 0 );
+		else
+		{
+			Usage();
+			return 1;
+		}
+	}
+	if ( uChunkSize == 0 || uMinGain > 100 )
+	{
+		Usage();
+		return 1;
+	}
+
+	std::vector<AkUInt8> package;
+	if ( !ReadFile( argv[1], package ) )
+	{
+		fprintf( stderr, "Could not read %s\n", argv[1] );
+		return 1;
+	}
+
+	std::vector<AkUInt8> output;
+	CAkFilePackageCompression::Stats stats;
+	switch ( CAkFilePackageCompression::Compress( package, uChunkSize, uMinGain, output, stats ) )
+	{
+	case CAkFilePackageCompression::Result_Success:
+		break;
+	case CAkFilePackageCompression::Result_NotAPackage:
+		fprintf( stderr, "%s is not a file package\n", argv[1] );
+		return 1;
+	case CAkFilePackageCompression::Result_AlreadyCompressed:
+		fprintf( stderr, "%s is already compressed\n", argv[1] );
+		return 1;
+	case CAkFilePackageCompression::Result_InvalidLUT:
+		fprintf( stderr, "%s has an invalid look-up table\n", argv[1] );
+		return 1;
+	case CAkFilePackageCompression::Result_OverlappingFiles:
+		fprintf( stderr, "%s has overlapping files\n", argv[1] );
+		return 1;
+	case CAkFilePackageCompression::Result_CannotRelocate:
+		fprintf( stderr, "Files of %s cannot be relocated\n", argv[1] );
+		return 1;
+	}
+
+	FILE * pOut = fopen( argv[2], "wb" );
+	if ( !pOut || fwrite( &output[0], 1, output.size(), pOut ) != output.size() )
+	{
+		fprintf( stderr, "Could not write %s\n", argv[2] );
+		if ( pOut )
+			fclose( pOut );
+		return 1;
+	}
+	fclose( pOut );
+
+	printf( "%u of %u files compressed, data %llu -> %llu bytes, package %llu -> %llu bytes\n",
+		stats.uNumCompressed, stats.uNumFiles,
+		(unsigned long long)stats.uDataSizeIn, (unsigned long long)stats.uDataSizeOut,
+		(unsigned long long)package.size(), (unsigned long long)output.size() );
+	return 0;
+}
@@ -212,6 +212,32 @@ public:
 		return AK_PathNotFound;    // this is not a directory!
 	}
 
+	/// Calls in_pfnEntry for each entry of in_pszDirectory, which ends with a path separator.
+	/// Returns AK_PathNotFound if the directory cannot be opened.
+	static AKRESULT ListDirectory( const AkOSChar* in_pszDirectory, AkDirectoryEntryFunc in_pfnEntry, void * in_pCookie )
+	{
+		AkOSChar szPattern[AK_MAX_PATH];
+		AKPLATFORM::SafeStrCpy( szPattern, in_pszDirectory, AK_MAX_PATH );
+		AKPLATFORM::SafeStrCat( szPattern, AKTEXT("*"), AK_MAX_PATH );
+
+		WIN32_FIND_DATAW findData;
+		HANDLE hFind = ::FindFirstFileExW( szPattern, FindExInfoBasic, &findData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH );
+		if ( hFind == INVALID_HANDLE_VALUE )
+			return AK_PathNotFound;
+
+		do
+		{
+			const AkOSChar * pszName = findData.cFileName;
+			if ( pszName[0] == '.' && ( pszName[1] == 0 || ( pszName[1] == '.' && pszName[2] == 0 ) ) )
+				continue;
+			in_pfnEntry( in_pCookie, pszName, ( findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) != 0 );
+		}
+		while ( ::FindNextFileW( hFind, &findData ) );
+
+		::FindClose( hFind );
+		return AK_Success;
+	}
+
 	static AKRESULT WriteBlocking(
 		AkFileHandle &	in_hFile,			// Returned file identifier/handle.
 		void *			in_pData,			// Buffer. Must be aligned on CAkFileHelpers::s_uRequiredBlockSize boundary.		
@@ -39,6 +39,14 @@ void Ssao::GetOffsetVectors(DirectX::XMFLOAT4 offsets[14])
 }
 
 std::vector<float> Ssao::CalcGaussWeights(float sigma)
+{
+    std::vector<float> weights(2 * MaxBlurRadius + 1);
+    weights.resize(CalcGaussWeights(sigma, weights.data()));
+
+    return weights;
+}
+
+int Ssao::CalcGaussWeights(float sigma, float* weights)
 {
     float twoSigma2 = 2.0f*sigma*sigma;
 
@@ -48,8 +56,7 @@ std::vector<float> Ssao::CalcGaussWeights(float sigma)
 
     assert(blurRadius <= MaxBlurRadius);
 
-    std::vector<float> weights;
-    weights.resize(2 * blurRadius + 1);
+    int weightCount = 2 * blurRadius + 1;
 
     float weightSum = 0.0f;
 
@@ -63,12 +70,12 @@ std::vector<float> Ssao::CalcGaussWeights(float sigma)
     }
 
     // Divide by the sum so all the weights add up to 1.0.
-    for(int i = 0; i < weights.size(); ++i)
+    for(int i = 0; i < weightCount; ++i)
     {
         weights[i] /= weightSum;
     }
 
-    return weights;
+    return weightCount;
 }
 
 ID3D12Resource* Ssao::NormalMap()
@@ -207,7 +214,7 @@ void Ssao::ComputeSsao(
     cmdList->OMSetRenderTargets(1, &mhAmbientMap0CpuRtv, true, nullptr);
 
     // Bind the constant buffer for this pass.
-    auto ssaoCBAddress = currFrame->SsaoCB->Resource()->GetGPUVirtualAddress();
+    auto ssaoCBAddress = currFrame->SsaoCB;
     cmdList->SetGraphicsRootConstantBufferView(0, ssaoCBAddress);
     cmdList->SetGraphicsRoot32BitConstant(1, 0, 0);
 
@@ -236,7 +243,7 @@ void Ssao::BlurAmbientMap(ID3D12GraphicsCommandList* cmdList, FrameResource* cur
 {
     cmdList->SetPipelineState(mBlurPso);
 
-    auto ssaoCBAddress = currFrame->SsaoCB->Resource()->GetGPUVirtualAddress();
+    auto ssaoCBAddress = currFrame->SsaoCB;
     cmdList->SetGraphicsRootConstantBufferView(0, ssaoCBAddress);
  
     for(int i = 0; i < blurCount; ++i)
@@ -33,6 +33,10 @@ public:
     void GetOffsetVectors(DirectX::XMFLOAT4 offsets[14]);
     std::vector<float> CalcGaussWeights(float sigma);
 
+    // Writes 2*radius+1 weights into 'weights', which must hold 2*MaxBlurRadius+1
+    // floats.  Returns the number of weights written.
+    int CalcGaussWeights(float sigma, float* weights);
+
 
 	ID3D12Resource* NormalMap();
 	ID3D12Resource* AmbientMap();
@@ -7,32 +7,170 @@ namespace myengine
 {
 	namespace audio
 	{
-		void Audio::LoadBnk(const std::string& bnk_path)
+		AKRESULT Audio::LoadBnk(const std::string& bnk_path)
 		{
+			ZoneScoped;
 			AkBankID bnk_id;
-			AK::SoundEngine::LoadBank(bnk_path.c_str(), bnk_id);
+			AKRESULT res = AK::SoundEngine::LoadBank(bnk_path.c_str(), bnk_id);
+			if (res != AK_Success)
+				std::cout << "LoadBank " << bnk_path << " failed: " << res << std::endl;
+			return res;
+		}
+
+		AKRESULT Audio::LoadBnk(AkBankID bnk_id)
+		{
+			ZoneScoped;
+			AKRESULT res = AK::SoundEngine::LoadBank(bnk_id);
+			if (res != AK_Success)
+				std::cout << "LoadBank " << bnk_id << " failed: " << res << std::endl;
+			return res;
+		}
+
+		AkPlayingID Audio::PostEvent(AkGameObjectID gameObj, AkUniqueID eventID)
+		{
+			return AK::SoundEngine::PostEvent(eventID, gameObj);
+		}
+
+		AkPlayingID Audio::PostEvent(AkGameObjectID gameObj, const std::string& eventPath)
+		{
+			return PostEvent(gameObj, InternAudioID(eventPath));
+		}
+
+		AkGameObjectID Audio::RegisterGameObject(const std::string& name)
+		{
+			AudioObjectHandle handle = RegisterAudioObject(name);
+			return m_objects.Get(handle)->GetID();
+		}
+
+		void Audio::UnregisterGameObject(AkGameObjectID gameObj)
+		{
+			UnregisterAudioObject(m_objects.Find(gameObj));
+		}
+
+		AudioObjectHandle Audio::RegisterAudioObject(const std::string& name)
+		{
+			const char* names[1] = { name.c_str() };
+			AudioObjectHandle handle;
+			RegisterAudioObjects(names, 1, &handle);
+			return handle;
+		}
+
+		void Audio::UnregisterAudioObject(AudioObjectHandle handle)
+		{
+			UnregisterAudioObjects(&handle, 1);
+		}
+
+		void Audio::RegisterAudioObjects(const char* const* names, AkUInt32 count, AudioObjectHandle* out_handles)
+		{
+			ZoneScoped;
+			m_objects.Allocate(count, out_handles);
+
+			for (AkUInt32 i = 0; i < count; ++i)
+			{
+				AkGameObjectID id = m_objects.Get(out_handles[i])->GetID();
+				if (names != nullptr)
+					AK::SoundEngine::RegisterGameObj(id, names[i]);
+				else
+					AK::SoundEngine::RegisterGameObj(id);
+			}
 		}
 
-		void Audio::PostEvent(AkGameObjectID gameObj, const std::string& eventPath)
+		void Audio::UnregisterAudioObjects(const AudioObjectHandle* handles, AkUInt32 count)
 		{
-			AK::SoundEngine::PostEvent(eventPath.c_str(), gameObj);
+			ZoneScoped;
+
+			// Unregister from Wwise before the slots (and their IDs) can be reused.
+			for (AkUInt32 i = 0; i < count; ++i)
+			{
+				if (AudioGameObject* object = m_objects.Get(handles[i]))
+					AK::SoundEngine::UnregisterGameObj(object->GetID());
+			}
+			m_objects.Free(handles, count);
+		}
+
+		void Audio::QueuePostEvent(AkGameObjectID gameObj, AkUniqueID eventID)
+		{
+			AudioCommand command;
+			command.type = AudioCommandType::PostEvent;
+			command.gameObj = gameObj;
+			command.eventID = eventID;
+			m_commands.Enqueue(command);
 		}
 
-		AkGameObjectID Audio::RegisterGameObject(std::string name)
+		void Audio::QueueSetPosition(AkGameObjectID gameObj, const AkSoundPosition& position)
 		{
-			AK::SoundEngine::RegisterGameObj(++start_id, name.c_str());
-			return start_id;
+			AudioCommand command;
+			command.type = AudioCommandType::SetPosition;
+			command.gameObj = gameObj;
+			command.position.position[0] = position.Position().X;
+			command.position.position[1] = position.Position().Y;
+			command.position.position[2] = position.Position().Z;
+			command.position.front[0] = position.OrientationFront().X;
+			command.position.front[1] = position.OrientationFront().Y;
+			command.position.front[2] = position.OrientationFront().Z;
+			command.position.top[0] = position.OrientationTop().X;
+			command.position.top[1] = position.OrientationTop().Y;
+			command.position.top[2] = position.OrientationTop().Z;
+			m_commands.Enqueue(command);
 		}
 
-		AudioGameObject* Audio::RegisterAudioObject(std::string name)
+		void Audio::QueueSetRTPC(AkGameObjectID gameObj, AkRtpcID rtpcID, AkRtpcValue value)
 		{
-			AKRESULT res = AK::SoundEngine::RegisterGameObj(start_id, name.c_str());
-			auto ret = new AudioGameObject(start_id);
-			++start_id;
-			return ret;
+			AudioCommand command;
+			command.type = AudioCommandType::SetRTPC;
+			command.gameObj = gameObj;
+			command.rtpc.id = rtpcID;
+			command.rtpc.value = value;
+			m_commands.Enqueue(command);
 		}
 
-		Audio::Audio()
+		void Audio::QueueSetSwitch(AkGameObjectID gameObj, AkSwitchGroupID switchGroup, AkSwitchStateID switchState)
+		{
+			AudioCommand command;
+			command.type = AudioCommandType::SetSwitch;
+			command.gameObj = gameObj;
+			command.switchState.group = switchGroup;
+			command.switchState.state = switchState;
+			m_commands.Enqueue(command);
+		}
+
+		void Audio::RenderAudio()
+		{
+			ZoneScoped;
+			m_banks.Update();
+			ResourceMonitorHistory.Update();
+	#if defined(AUDIO_POOLED_MEMORY)
+			PlotAudioMemoryStats();
+	#endif
+			if (m_audioThread.IsRunning())
+				return;
+
+			m_commands.Drain();
+			AK::SoundEngine::RenderAudio();
+		}
+
+		AKRESULT Audio::StartAudioThread(AkUInt32 ticksPerSecond)
+		{
+			if (!m_initialized)
+				return AK_Fail;
+
+			AudioThreadSettings settings;
+			settings.ticksPerSecond = ticksPerSecond;
+			AKRESULT res = m_audioThread.Start(settings, [this]() {
+				m_commands.Drain();
+				AK::SoundEngine::RenderAudio();
+			});
+			if (res != AK_Success)
+				std::cout << "Audio thread failed to start: " << res << std::endl;
+			return res;
+		}
+
+		void Audio::StopAudioThread()
+		{
+			m_audioThread.Stop();
+		}
+
+		Audio::Audio() : m_objects(FIRST_GAME_OBJECT_ID), m_banks(std::make_unique<AkBankLoader>())
 		{
 			m_pLowLevelIO = new CAkFilePackageLowLevelIODeferred();
 			AkOSChar error[100];
@@ -40,11 +178,16 @@ namespace myengine
 			bool ret = InitWwise(error, 100);
 			std::cout << "init wwise" << ret << std::endl;
 
+			m_initialized = ret;
 		}
 
 		void Audio::GetDefaultSettings()
 		{
 			AK::MemoryMgr::GetDefaultSettings(m_memSettings);
+	#if defined(AUDIO_POOLED_MEMORY)
+			if (!IsAudioMemoryInstalled() && InstallAudioMemory(m_memSettings) != AK_Success)
+				std::cout << "Audio memory pools could not be installed, using the default allocator" << std::endl;
+	#endif
 			AK::StreamMgr::GetDefaultSettings(m_stmSettings);
 			AK::StreamMgr::GetDefaultDeviceSettings(m_deviceSettings);
 
@@ -162,6 +305,7 @@ namespace myengine
 				return false;
 			}
 
+			bool commInitialized = false;
 	#if !defined AK_OPTIMIZED && !defined INTEGRATIONDEMO_DISABLECOMM
 			//
 			// Initialize communications (not in release build!)
@@ -173,8 +317,15 @@ namespace myengine
 			{
 				__AK_OSCHAR_SNPRINTF(in_szErrorBuffer, in_unErrorBufferCharCount, AKTEXT("AK::Comm::Init() returned AKRESULT %d. Communication between the Wwise authoring application and the game will not be possible."), res);
 			}
+			else
+			{
+				commInitialized = true;
+			}
 	#endif // AK_OPTIMIZED	
 
+			// Stream counts would share the stream manager's profiling session with the authoring tool.
+			ResourceMonitorHistory.SetStreamSampling(!commInitialized);
+
 			AkSpatialAudioInitSettings settings;
 
 			res = AK::SpatialAudio::Init(settings);
@@ -215,14 +366,7 @@ namespace myengine
 		//Menu* m_pMenu;	///< The menu system pointer.
 		void Audio::ResourceMonitorDataCallback(const AkResourceMonitorDataSummary* in_pdataSummary)
 		{
-			static int ResourceMonitorUpdateCooldown = 0;
-			if (ResourceMonitorUpdateCooldown <= 0)
-			{
-				Audio::ResourceDataSummary = *in_pdataSummary;
-				ResourceMonitorUpdateCooldown = DATA_SUMMARY_REFRESH_COOLDOWN;
-			}
-			else
-				ResourceMonitorUpdateCooldown--;
+			ResourceMonitorHistory.Record(*in_pdataSummary);
 		}
 
 		//The callback function called when the AK::Monitor does a localoutput
@@ -233,10 +377,9 @@ namespace myengine
 			AkPlayingID in_playingID,   ///< Related Playing ID if applicable, AK_INVALID_PLAYING_ID otherwise
 			AkGameObjectID in_gameObjID ///< Related Game Object ID if applicable, AK_INVALID_GAME_OBJECT otherwise
 		);;
-		static AkResourceMonitorDataSummary ResourceDataSummary;
 
 
-		AkResourceMonitorDataSummary Audio::ResourceDataSummary;
+		AudioResourceMonitor Audio::ResourceMonitorHistory;
 
 
 		void Audio::LocalErrorCallback(AK::Monitor::ErrorCode in_eErrorCode, const AkOSChar* in_pszError, AK::Monitor::ErrorLevel in_eErrorLevel, AkPlayingID in_playingID, AkGameObjectID in_gameObjID)
@@ -14,6 +14,13 @@
 #include "../Common/AkFilePackageLowLevelIO.h"
 #include "AkDefaultIOHookDeferred.h"
 #include "Platform.h"
+#include "audioid.h"
+#include "audiocommands.h"
+#include "gameobject.h"
+#include "bankmanager.h"
+#include "audiothread.h"
+#include "audiomonitor.h"
+#include "audiomemory.h"
 
 typedef CAkFilePackageLowLevelIO<CAkDefaultIOHookDeferred> CAkFilePackageLowLevelIODeferred;
 // layout is hard-coded to 1280*720 (16:9) for consistent layout on all platforms
@@ -25,7 +32,8 @@ static const AkReal32 MS_PER_FRAME = (1000 / (AkReal32)DESIRED_FPS);
 
 static const AkGameObjectID LISTENER_ID = 10000;
 
-#define DATA_SUMMARY_REFRESH_COOLDOWN 7; // Refresh cooldown affecting the refresh rate of the resource monitor data summary
+// Game objects registered through Audio get IDs from here up, one per pool slot.
+static const AkGameObjectID FIRST_GAME_OBJECT_ID = LISTENER_ID + 1;
 
 // Android devices show poor performance with more than 2 worker threads (and >2 is overkill for NX)
 #if defined(AK_SUPPORT_THREADS)
@@ -50,11 +58,8 @@ namespace myengine
 {
 	namespace audio
 	{
-		class AudioGameObject;
 		class Audio
 		{
-		private:
-			AkGameObjectID start_id = 100;
 		public:
 			static Audio& Instance()
 			{
@@ -62,18 +67,72 @@ namespace myengine
 				return audio;
 			}
 		public:
-			void LoadBnk(const std::string& bnk_path);
-
-			void PostEvent(AkGameObjectID gameObj, const std::string& eventPath);
-
-			AkGameObjectID RegisterGameObject(std::string name);
-
-			AudioGameObject* RegisterAudioObject(std::string name);
-
-			void RenderAudio()
-			{
-				AK::SoundEngine::RenderAudio();
-			}
+			// Blocking loads, for Init.bnk and other banks needed before the first
+			// frame.  Everything else should go through Banks().
+			AKRESULT LoadBnk(const std::string& bnk_path);
+
+			// Loads a bank by ID, e.g. LoadBnk("Reflect"_akid).  The low-level I/O
+			// resolves the ID through the file package LUT.
+			AKRESULT LoadBnk(AkBankID bnk_id);
+
+			// Asynchronous, reference-counted loading.  Updated by RenderAudio().
+			BankManager& Banks() { return m_banks; }
+
+			// Prefer the AkUniqueID overload with an ID hashed at compile time; the
+			// string overload interns the name on first use.
+			AkPlayingID PostEvent(AkGameObjectID gameObj, AkUniqueID eventID);
+
+			AkPlayingID PostEvent(AkGameObjectID gameObj, const std::string& eventPath);
+
+			// Registers a pooled game object and returns its ID.  Release it with
+			// UnregisterGameObject(); the ID may be reused afterwards.
+			AkGameObjectID RegisterGameObject(const std::string& name);
+			void UnregisterGameObject(AkGameObjectID gameObj);
+
+			AudioObjectHandle RegisterAudioObject(const std::string& name);
+			void UnregisterAudioObject(AudioObjectHandle handle);
+
+			// Bulk versions for spawning and despawning many objects at once: the pool
+			// is locked once per call.  names may be nullptr to register unnamed
+			// objects.  Wwise itself still gets one call per object.
+			void RegisterAudioObjects(const char* const* names, AkUInt32 count, AudioObjectHandle* out_handles);
+			void UnregisterAudioObjects(const AudioObjectHandle* handles, AkUInt32 count);
+
+			// nullptr once the object has been unregistered.
+			AudioGameObject* GetAudioObject(AudioObjectHandle handle) { return m_objects.Get(handle); }
+			AkUInt32 GetAudioObjectCount() { return m_objects.LiveCount(); }
+
+			// Deferred versions of the calls above and of the per-object setters.
+			// They may be called from any thread and are sent to the sound engine by
+			// the next RenderAudio(); see audiocommands.h for ordering and coalescing.
+			// Register game objects before queueing commands for them.
+			void QueuePostEvent(AkGameObjectID gameObj, AkUniqueID eventID);
+			void QueueSetPosition(AkGameObjectID gameObj, const AkSoundPosition& position);
+			void QueueSetRTPC(AkGameObjectID gameObj, AkRtpcID rtpcID, AkRtpcValue value);
+			void QueueSetSwitch(AkGameObjectID gameObj, AkSwitchGroupID switchGroup, AkSwitchStateID switchState);
+
+			const AudioCommandStats& GetCommandStats() const { return m_commands.GetStats(); }
+
+			// False if the sound engine failed to start; calls then go nowhere.
+			bool IsInitialized() const { return m_initialized; }
+
+			// Updates the bank manager, then (unless the audio thread is running)
+			// applies the queued commands and processes the frame.  Call from the main
+			// loop once per frame.
+			void RenderAudio();
+
+			// Moves command draining and AK::SoundEngine::RenderAudio() to a
+			// high-priority thread ticking at a fixed rate, so audio keeps its pace
+			// when a frame takes long on the CPU or GPU.  Bank updates and their
+			// callbacks stay on the thread calling RenderAudio().
+			AKRESULT StartAudioThread(AkUInt32 ticksPerSecond = DESIRED_FPS);
+			void StopAudioThread();
+			bool IsAudioThreadRunning() const { return m_audioThread.IsRunning(); }
+			AudioThreadStats GetAudioThreadStats() { return m_audioThread.GetStats(); }
+
+			// Every resource monitor summary of the last minute or so, with rolling
+			// percentiles and CSV/JSON dumps.
+			AudioResourceMonitor& ResourceMonitor() { return ResourceMonitorHistory; }
 		private:
 			Audio();
 
@@ -88,6 +147,14 @@ namespace myengine
 		private:
 			
 			int m_bnk_id;
+			bool m_initialized = false;
+
+			AudioCommandQueue m_commands;
+			AudioGameObjectPool m_objects;
+			BankManager m_banks;
+
+			// Last, so it stops before the members it uses are destroyed.
+			AudioUpdateThread m_audioThread;
 
 		private:
 			/// We're using the default Low-Level I/O implementation that's part
@@ -119,7 +186,8 @@ namespace myengine
 				AkPlayingID in_playingID,   ///< Related Playing ID if applicable, AK_INVALID_PLAYING_ID otherwise
 				AkGameObjectID in_gameObjID ///< Related Game Object ID if applicable, AK_INVALID_GAME_OBJECT otherwise
 			);;
-			static AkResourceMonitorDataSummary ResourceDataSummary;
+			// Static: the sound engine may call back before Instance() returns.
+			static AudioResourceMonitor ResourceMonitorHistory;
 
 		};
 
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <tracy/Tracy.hpp>
+#include <AK/SoundEngine/Common/AkSoundEngine.h>
+#include "audiocommands.h"
+
+namespace myengine
+{
+	namespace audio
+	{
+		namespace
+		{
+			std::atomic<AkUInt64> g_nextQueueID{ 1 };
+
+			// The ring the calling thread produces into.  Remembers the queue it
+			// belongs to so a second queue does not pick up the wrong ring.
+			thread_local AkUInt64 t_ringQueue = 0;
+			thread_local void* t_ring = nullptr;
+
+			// Coalescing key order: positions before RTPCs, then by game object and
+			// RTPC, then by enqueue order.
+			bool CoalesceLess(const AudioCommand& a, AkUInt32 ia, const AudioCommand& b, AkUInt32 ib)
+			{
+				if (a.type != b.type)
+					return a.type < b.type;
+				if (a.gameObj != b.gameObj)
+					return a.gameObj < b.gameObj;
+				if (a.type == AudioCommandType::SetRTPC && a.rtpc.id != b.rtpc.id)
+					return a.rtpc.id < b.rtpc.id;
+				return ia < ib;
+			}
+
+			bool SameTarget(const AudioCommand& a, const AudioCommand& b)
+			{
+				return a.type == b.type && a.gameObj == b.gameObj &&
+					(a.type != AudioCommandType::SetRTPC || a.rtpc.id == b.rtpc.id);
+			}
+
+			void Send(const AudioCommand& in_command)
+			{
+				switch (in_command.type)
+				{
+				case AudioCommandType::PostEvent:
+					AK::SoundEngine::PostEvent(in_command.eventID, in_command.gameObj);
+					break;
+				case AudioCommandType::SetPosition:
+				{
+					const auto& p = in_command.position;
+					AkSoundPosition position;
+					position.Set(p.position[0], p.position[1], p.position[2],
+						p.front[0], p.front[1], p.front[2],
+						p.top[0], p.top[1], p.top[2]);
+					AK::SoundEngine::SetPosition(in_command.gameObj, position);
+					break;
+				}
+				case AudioCommandType::SetRTPC:
+					AK::SoundEngine::SetRTPCValue(in_command.rtpc.id, in_command.rtpc.value, in_command.gameObj);
+					break;
+				case AudioCommandType::SetSwitch:
+					AK::SoundEngine::SetSwitch(in_command.switchState.group, in_command.switchState.state, in_command.gameObj);
+					break;
+				}
+			}
+		}
+
+		AudioCommandQueue::AudioCommandQueue()
+			: m_id(g_nextQueueID.fetch_add(1, std::memory_order_relaxed))
+		{
+		}
+
+		AudioCommandQueue::Ring* AudioCommandQueue::RingForThisThread()
+		{
+			if (t_ringQueue == m_id)
+				return static_cast<Ring*>(t_ring);
+
+			std::lock_guard<std::mutex> lock(m_registerLock);
+
+			// A thread that used another queue in between may already own a ring here.
+			std::thread::id self = std::this_thread::get_id();
+			AkUInt32 count = m_ringCount.load(std::memory_order_relaxed);
+			Ring* ring = nullptr;
+			for (AkUInt32 i = 0; i < count && ring == nullptr; ++i)
+			{
+				if (m_rings[i]->owner == self)
+					ring = m_rings[i].get();
+			}
+
+			if (ring == nullptr && count < MAX_PRODUCERS)
+			{
+				m_rings[count] = std::make_unique<Ring>();
+				m_rings[count]->owner = self;
+				ring = m_rings[count].get();
+				m_ringCount.store(count + 1, std::memory_order_release);
+			}
+
+			// With no ring left this thread always overflows.
+			t_ringQueue = m_id;
+			t_ring = ring;
+			return ring;
+		}
+
+		void AudioCommandQueue::Enqueue(const AudioCommand& in_command)
+		{
+			Ring* ring = RingForThisThread();
+			if (ring == nullptr)
+			{
+				std::lock_guard<std::mutex> lock(m_overflowLock);
+				m_overflow.push_back(in_command);
+				return;
+			}
+
+			Slot slot = { in_command, ring->nextSeq++ };
+
+			AkUInt32 tail = ring->tail.load(std::memory_order_relaxed);
+			AkUInt32 head = ring->head.load(std::memory_order_acquire);
+			if (tail - head < RING_CAPACITY)
+			{
+				ring->slots[tail & (RING_CAPACITY - 1)] = slot;
+				ring->tail.store(tail + 1, std::memory_order_release);
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(ring->spillLock);
+			ring->spill.push_back(slot);
+		}
+
+		void AudioCommandQueue::DrainRing(Ring& io_ring)
+		{
+			m_arrived.clear();
+			m_arrived.swap(io_ring.pending);
+
+			AkUInt32 head = io_ring.head.load(std::memory_order_relaxed);
+			AkUInt32 tail = io_ring.tail.load(std::memory_order_acquire);
+			for (; head != tail; ++head)
+				m_arrived.push_back(io_ring.slots[head & (RING_CAPACITY - 1)]);
+			io_ring.head.store(tail, std::memory_order_release);
+
+			{
+				std::lock_guard<std::mutex> lock(io_ring.spillLock);
+				m_spillBatch.swap(io_ring.spill);
+			}
+			m_stats.overflowed += m_spillBatch.size();
+			m_arrived.insert(m_arrived.end(), m_spillBatch.begin(), m_spillBatch.end());
+			m_spillBatch.clear();
+
+			// Only spilling can leave gaps, so this is usually already sorted.
+			auto bySeq = [](const Slot& a, const Slot& b) { return a.seq < b.seq; };
+			if (!std::is_sorted(m_arrived.begin(), m_arrived.end(), bySeq))
+				std::sort(m_arrived.begin(), m_arrived.end(), bySeq);
+
+			// Apply the run that continues where the last drain stopped; a command
+			// still on its way to the spill list holds back the ones after it.
+			size_t i = 0;
+			for (; i < m_arrived.size() && m_arrived[i].seq == io_ring.expectedSeq; ++i, ++io_ring.expectedSeq)
+				m_batch.push_back(m_arrived[i].command);
+			io_ring.pending.assign(m_arrived.begin() + i, m_arrived.end());
+		}
+
+		void AudioCommandQueue::Drain()
+		{
+			ZoneScoped;
+
+			m_batch.clear();
+
+			AkUInt32 ringCount = m_ringCount.load(std::memory_order_acquire);
+			for (AkUInt32 i = 0; i < ringCount; ++i)
+				DrainRing(*m_rings[i]);
+
+			{
+				std::lock_guard<std::mutex> lock(m_overflowLock);
+				m_overflowBatch.swap(m_overflow);
+			}
+			m_batch.insert(m_batch.end(), m_overflowBatch.begin(), m_overflowBatch.end());
+			m_stats.overflowed += m_overflowBatch.size();
+			m_overflowBatch.clear();
+
+			m_stats.drained += m_batch.size();
+			m_stats.producerThreads = ringCount;
+
+			Apply();
+		}
+
+		void AudioCommandQueue::Apply()
+		{
+			// Positions and RTPCs: keep the last update per target.
+			m_sorted.clear();
+			for (AkUInt32 i = 0; i < (AkUInt32)m_batch.size(); ++i)
+			{
+				AudioCommandType type = m_batch[i].type;
+				if (type == AudioCommandType::SetPosition || type == AudioCommandType::SetRTPC)
+					m_sorted.push_back(i);
+			}
+
+			std::sort(m_sorted.begin(), m_sorted.end(), [this](AkUInt32 a, AkUInt32 b) {
+				return CoalesceLess(m_batch[a], a, m_batch[b], b);
+			});
+
+			for (size_t i = 0; i < m_sorted.size(); ++i)
+			{
+				const AudioCommand& command = m_batch[m_sorted[i]];
+				if (i + 1 < m_sorted.size() && SameTarget(command, m_batch[m_sorted[i + 1]]))
+				{
+					++m_stats.coalesced;
+					continue;
+				}
+				Send(command);
+				++m_stats.applied;
+			}
+
+			// Events and switches, in enqueue order.
+			for (const AudioCommand& command : m_batch)
+			{
+				if (command.type == AudioCommandType::PostEvent || command.type == AudioCommandType::SetSwitch)
+				{
+					Send(command);
+					++m_stats.applied;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <AK/SoundEngine/Common/AkTypes.h>
+
+// Command buffer in front of AK::SoundEngine.
+//
+// Any thread may enqueue commands.  Each producer thread gets its own single-producer
+// ring the first time it enqueues, so the hot path is a couple of atomic loads and a
+// store; no lock is shared between producers.  Drain() runs on the thread that calls
+// Audio::RenderAudio() and applies everything in one batch:
+//   -position and RTPC updates are coalesced, only the last value per game object
+//    (and RTPC) is sent, and they are applied first;
+//   -events and switches follow, in the order each thread enqueued them.
+// Commands from different threads have no defined order relative to each other.
+// Nothing is dropped.  A command that does not fit in its thread's ring goes to the
+// ring's spill list, which takes a mutex; every command carries a per-thread
+// sequence number and the drain holds back anything that arrives out of order, so
+// spilling never reorders a thread's commands.  Threads beyond MAX_PRODUCERS share
+// one mutex-protected list.
+
+namespace myengine
+{
+	namespace audio
+	{
+		enum class AudioCommandType : AkUInt8
+		{
+			PostEvent,
+			SetPosition,
+			SetRTPC,
+			SetSwitch
+		};
+
+		struct AudioCommand
+		{
+			AudioCommandType type;
+			AkGameObjectID gameObj;
+			union
+			{
+				AkUniqueID eventID;
+				struct
+				{
+					AkReal64 position[3];
+					AkReal32 front[3];
+					AkReal32 top[3];
+				} position;
+				struct
+				{
+					AkRtpcID id;
+					AkRtpcValue value;
+				} rtpc;
+				struct
+				{
+					AkSwitchGroupID group;
+					AkSwitchStateID state;
+				} switchState;
+			};
+		};
+
+		struct AudioCommandStats
+		{
+			AkUInt64 drained = 0;		// taken from the rings and the overflow list
+			AkUInt64 applied = 0;		// sent to the sound engine
+			AkUInt64 coalesced = 0;		// position/RTPC updates superseded in the same drain
+			AkUInt64 overflowed = 0;	// went through a spill list or the shared list
+			AkUInt32 producerThreads = 0;
+		};
+
+		class AudioCommandQueue
+		{
+		public:
+			static const AkUInt32 RING_CAPACITY = 1024;	// commands per producer thread, power of two
+			static const AkUInt32 MAX_PRODUCERS = 64;
+
+			AudioCommandQueue();
+			AudioCommandQueue(const AudioCommandQueue&) = delete;
+			AudioCommandQueue& operator=(const AudioCommandQueue&) = delete;
+
+			// Thread safe.
+			void Enqueue(const AudioCommand& in_command);
+
+			// Applies all pending commands.  Call from one thread only, before
+			// AK::SoundEngine::RenderAudio().
+			void Drain();
+
+			// Read on the draining thread.
+			const AudioCommandStats& GetStats() const { return m_stats; }
+
+		private:
+			struct Slot
+			{
+				AudioCommand command;
+				AkUInt64 seq;
+			};
+
+			struct Ring
+			{
+				alignas(64) std::atomic<AkUInt32> head{ 0 };	// next slot to read, written by the consumer
+				alignas(64) std::atomic<AkUInt32> tail{ 0 };	// next slot to write, written by the producer
+				AkUInt64 nextSeq = 0;							// producer only
+				alignas(64) Slot slots[RING_CAPACITY];
+
+				std::mutex spillLock;
+				std::vector<Slot> spill;
+
+				// Consumer only: the next sequence number to apply, and what arrived
+				// ahead of it.
+				AkUInt64 expectedSeq = 0;
+				std::vector<Slot> pending;
+
+				std::thread::id owner;
+			};
+
+			Ring* RingForThisThread();
+			void DrainRing(Ring& io_ring);
+			void Apply();
+
+		private:
+			// Never reused, unlike the address of a destroyed queue.
+			const AkUInt64 m_id;
+
+			// Rings are only ever added; the first m_ringCount entries are published.
+			std::mutex m_registerLock;
+			std::unique_ptr<Ring> m_rings[MAX_PRODUCERS];
+			std::atomic<AkUInt32> m_ringCount{ 0 };
+
+			std::mutex m_overflowLock;
+			std::vector<AudioCommand> m_overflow;
+
+			// Draining thread only; kept between frames so steady state does not allocate.
+			std::vector<AudioCommand> m_batch;
+			std::vector<AudioCommand> m_overflowBatch;
+			std::vector<Slot> m_arrived;
+			std::vector<Slot> m_spillBatch;
+			std::vector<AkUInt32> m_sorted;
+			AudioCommandStats m_stats;
+		};
+	}
+}
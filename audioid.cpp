@@ -0,0 +1,71 @@
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include "audioid.h"
+
+namespace myengine
+{
+	namespace audio
+	{
+		namespace
+		{
+			// Names are stored once in m_names; both maps point into it.  std::deque
+			// never moves its elements, so the views stay valid as it grows.
+			class AudioNameCache
+			{
+			public:
+				AkUniqueID Intern(std::string_view in_name)
+				{
+					{
+						std::shared_lock<std::shared_mutex> lock(m_mutex);
+						auto it = m_ids.find(in_name);
+						if (it != m_ids.end())
+							return it->second;
+					}
+
+					AkUniqueID id = HashAudioName(in_name);
+
+					std::unique_lock<std::shared_mutex> lock(m_mutex);
+					auto it = m_ids.find(in_name);
+					if (it != m_ids.end())
+						return it->second;
+
+					const std::string& name = m_names.emplace_back(in_name);
+					m_ids.emplace(name, id);
+					m_names_by_id.emplace(id, name.c_str());
+					return id;
+				}
+
+				const char* Find(AkUniqueID in_id)
+				{
+					std::shared_lock<std::shared_mutex> lock(m_mutex);
+					auto it = m_names_by_id.find(in_id);
+					return it != m_names_by_id.end() ? it->second : nullptr;
+				}
+
+			private:
+				std::shared_mutex m_mutex;
+				std::deque<std::string> m_names;
+				std::unordered_map<std::string_view, AkUniqueID> m_ids;
+				std::unordered_map<AkUniqueID, const char*> m_names_by_id;
+			};
+
+			AudioNameCache& NameCache()
+			{
+				static AudioNameCache cache;
+				return cache;
+			}
+		}
+
+		AkUniqueID InternAudioID(std::string_view in_name)
+		{
+			return NameCache().Intern(in_name);
+		}
+
+		const char* FindInternedAudioName(AkUniqueID in_id)
+		{
+			return NameCache().Find(in_id);
+		}
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <AK/SoundEngine/Common/AkTypes.h>
+
+// Wwise IDs for events, banks, states, switches and game parameters are the 32-bit
+// FNV-1 hash of the lower-cased name (see AK::SoundEngine::GetIDFromString()).
+// Computing them here lets literal names hash at compile time, and lets gameplay
+// code post by ID without copying or hashing strings on every call:
+//
+//     constexpr AkUniqueID FOOTSTEP = "Play_Footstep"_akid;
+//     gameobject->PostEvent(FOOTSTEP);
+//
+// Names only known at run time go through InternAudioID(), which hashes each
+// distinct name once.
+
+namespace myengine
+{
+	namespace audio
+	{
+		static constexpr AkUInt32 FNV32_OFFSET_BASIS = 2166136261u;
+		static constexpr AkUInt32 FNV32_PRIME = 16777619u;
+
+		constexpr char ToLowerAscii(char c)
+		{
+			return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+		}
+
+		constexpr AkUniqueID HashAudioName(const char* in_pszName, std::size_t in_uLength)
+		{
+			AkUInt32 hash = FNV32_OFFSET_BASIS;
+			for (std::size_t i = 0; i < in_uLength; ++i)
+			{
+				hash *= FNV32_PRIME;
+				hash ^= (AkUInt32)(unsigned char)ToLowerAscii(in_pszName[i]);
+			}
+			return hash;
+		}
+
+		constexpr AkUniqueID HashAudioName(std::string_view in_name)
+		{
+			return HashAudioName(in_name.data(), in_name.size());
+		}
+
+		// A Wwise ID that can be built from a name at compile time.  Converts to
+		// AkUniqueID (and AkBankID) implicitly.
+		class AudioID
+		{
+		public:
+			constexpr AudioID() = default;
+			constexpr explicit AudioID(AkUniqueID in_id) : m_id(in_id) {}
+			constexpr explicit AudioID(std::string_view in_name) : m_id(HashAudioName(in_name)) {}
+
+			constexpr AkUniqueID Value() const { return m_id; }
+			constexpr operator AkUniqueID() const { return m_id; }
+
+			constexpr bool IsValid() const { return m_id != AK_INVALID_UNIQUE_ID; }
+
+		private:
+			AkUniqueID m_id = AK_INVALID_UNIQUE_ID;
+		};
+
+		// Returns the ID of a name known only at run time.  Each distinct name is
+		// hashed once; later calls are a shared-lock lookup.  Thread safe.
+		AkUniqueID InternAudioID(std::string_view in_name);
+
+		// The name an ID was interned from, or nullptr.  Meant for logging; the
+		// pointer stays valid for the life of the program.
+		const char* FindInternedAudioName(AkUniqueID in_id);
+
+		inline namespace literals
+		{
+			constexpr AkUniqueID operator""_akid(const char* in_pszName, std::size_t in_uLength)
+			{
+				return HashAudioName(in_pszName, in_uLength);
+			}
+		}
+
+		// Must agree with the IDs the Wwise authoring tool writes to Wwise_IDs.h.
+		static_assert("Init"_akid == 1355168291u, "_akid must match AK::SoundEngine::GetIDFromString()");
+		static_assert("INIT"_akid == "init"_akid, "_akid must be case-insensitive");
+	}
+}
@@ -0,0 +1,156 @@
+#include <cassert>
+#include <tracy/Tracy.hpp>
+#include "audiolod.h"
+
+using namespace DirectX;
+
+namespace myengine
+{
+	namespace audio
+	{
+		AudioLodManager::AudioLodManager(const AudioLodSettings& in_settings)
+			: m_settings(in_settings)
+		{
+		}
+
+		void AudioLodManager::Grow(AkUInt32 in_count)
+		{
+			if (in_count <= m_count)
+				return;
+
+			m_count = in_count;
+			size_t padded = (in_count + 3) & ~3u;
+			m_x.resize(padded, 0.0f);
+			m_y.resize(padded, 0.0f);
+			m_z.resize(padded, 0.0f);
+			m_invMaxDistanceSq.resize(padded, 0.0f);
+			m_distanceSq.resize(padded, 0.0f);
+			m_active.resize(padded, 0);
+			m_priority.resize(padded, 0);
+			m_distanceTier.resize(padded, (AkUInt8)AudioLodTier::Near);
+			m_tier.resize(padded, (AkUInt8)AudioLodTier::Near);
+			m_due.resize(padded, 1);
+		}
+
+		void AudioLodManager::SetEmitter(AkUInt32 in_emitter, AkReal32 in_maxDistance, AkUInt8 in_priority)
+		{
+			assert(in_maxDistance > 0.0f);
+			Grow(in_emitter + 1);
+
+			m_invMaxDistanceSq[in_emitter] = 1.0f / (in_maxDistance * in_maxDistance);
+			m_priority[in_emitter] = in_priority;
+			if (!m_active[in_emitter])
+			{
+				m_active[in_emitter] = 1;
+				m_distanceTier[in_emitter] = (AkUInt8)AudioLodTier::Near;
+				m_tier[in_emitter] = (AkUInt8)AudioLodTier::Near;
+				m_due[in_emitter] = 1;
+			}
+		}
+
+		void AudioLodManager::RemoveEmitter(AkUInt32 in_emitter)
+		{
+			assert(in_emitter < m_count && m_active[in_emitter]);
+			m_active[in_emitter] = 0;
+			m_invMaxDistanceSq[in_emitter] = 0.0f;
+			m_due[in_emitter] = 1;
+		}
+
+		void AudioLodManager::SetPosition(AkUInt32 in_emitter, const XMFLOAT3& in_pos)
+		{
+			assert(in_emitter < m_count);
+			m_x[in_emitter] = in_pos.x;
+			m_y[in_emitter] = in_pos.y;
+			m_z[in_emitter] = in_pos.z;
+		}
+
+		void AudioLodManager::Update(const XMFLOAT3& in_listener)
+		{
+			ZoneScoped;
+
+			// Squared distance relative to max distance, four emitters at a time.
+			// Unused slots have a zero scale and come out as 0.
+			XMVECTOR listenerX = XMVectorReplicate(in_listener.x);
+			XMVECTOR listenerY = XMVectorReplicate(in_listener.y);
+			XMVECTOR listenerZ = XMVectorReplicate(in_listener.z);
+			size_t padded = m_x.size();
+			for (size_t i = 0; i < padded; i += 4)
+			{
+				XMVECTOR dx = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_x[i])), listenerX);
+				XMVECTOR dy = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_y[i])), listenerY);
+				XMVECTOR dz = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_z[i])), listenerZ);
+				XMVECTOR distanceSq = XMVectorMultiply(dx, dx);
+				distanceSq = XMVectorMultiplyAdd(dy, dy, distanceSq);
+				distanceSq = XMVectorMultiplyAdd(dz, dz, distanceSq);
+				distanceSq = XMVectorMultiply(distanceSq, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_invMaxDistanceSq[i])));
+				XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&m_distanceSq[i]), distanceSq);
+			}
+
+			// Tier boundaries, squared: leaving a tier outwards takes boundary +
+			// hysteresis, coming back takes boundary - hysteresis.
+			const float boundaries[3] = { m_settings.midDistance, m_settings.farDistance, 1.0f };
+			float outward[3], inward[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				float outer = boundaries[k] + m_settings.hysteresis;
+				float inner = boundaries[k] > m_settings.hysteresis ? boundaries[k] - m_settings.hysteresis : 0.0f;
+				outward[k] = outer * outer;
+				inward[k] = inner * inner;
+			}
+
+			const AkUInt32 intervals[(int)AudioLodTier::Count] = {
+				1,
+				m_settings.midInterval > 0 ? m_settings.midInterval : 1,
+				m_settings.farInterval > 0 ? m_settings.farInterval : 1,
+				0
+			};
+
+			m_stats = AudioLodStats();
+			for (AkUInt32 i = 0; i < m_count; ++i)
+			{
+				if (!m_active[i])
+				{
+					m_due[i] = 1;
+					continue;
+				}
+
+				AkUInt32 current = m_distanceTier[i];
+				float distanceSq = m_distanceSq[i];
+				AkUInt32 distanceTier = 0;
+				for (AkUInt32 k = 0; k < 3; ++k)
+					distanceTier += distanceSq > (current <= k ? outward[k] : inward[k]) ? 1 : 0;
+				m_distanceTier[i] = (AkUInt8)distanceTier;
+
+				AkUInt32 tier = distanceTier;
+				if (tier != (AkUInt32)AudioLodTier::Inaudible)
+				{
+					if (m_priority[i] >= m_settings.highPriority && tier > (AkUInt32)AudioLodTier::Near)
+						--tier;
+					else if (m_priority[i] <= m_settings.lowPriority && tier < (AkUInt32)AudioLodTier::Far)
+						++tier;
+				}
+
+				bool due;
+				if (tier != m_tier[i])
+					due = true;
+				else if (intervals[tier] == 0)
+					due = false;
+				else
+					due = (m_frame + i) % intervals[tier] == 0;
+
+				m_tier[i] = (AkUInt8)tier;
+				m_due[i] = due ? 1 : 0;
+
+				++m_stats.emitters;
+				++m_stats.tiers[tier];
+				m_stats.due += due ? 1 : 0;
+			}
+			++m_frame;
+
+			TracyPlot("Audio LOD near", (int64_t)m_stats.tiers[(int)AudioLodTier::Near]);
+			TracyPlot("Audio LOD mid", (int64_t)m_stats.tiers[(int)AudioLodTier::Mid]);
+			TracyPlot("Audio LOD far", (int64_t)m_stats.tiers[(int)AudioLodTier::Far]);
+			TracyPlot("Audio LOD inaudible", (int64_t)m_stats.tiers[(int)AudioLodTier::Inaudible]);
+		}
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+#include <AK/SoundEngine/Common/AkTypes.h>
+
+// Level of detail for audio emitters.
+//
+// Each frame Update() measures every emitter's distance to the listener, relative
+// to the emitter's max distance (the radius of its attenuation curve), and puts it
+// in a tier:
+//   -Near:      position sent every frame;
+//   -Mid:       every midInterval frames;
+//   -Far:       every farInterval frames;
+//   -Inaudible: beyond max distance, not sent at all.
+// A boundary has to be crossed by more than hysteresis (again relative to max
+// distance) before the tier changes, so an emitter sitting on a boundary does not
+// flicker between rates.  High priority emitters are moved one tier closer, low
+// priority ones one tier farther; neither changes whether an emitter is inaudible.
+// Throttled emitters are spread over frames by index so the work stays even.
+//
+// An emitter is always due on the frame its tier changes: one entering Inaudible
+// gets its final position out of range, one leaving it is placed before it is heard.
+//
+// Emitters are identified by the caller's index, normally the AudioTransformSync
+// emitter index, and GetDueMask() is meant for AudioTransformSync::Submit().
+// Distances are computed four emitters at a time over separate x, y and z arrays.
+
+namespace myengine
+{
+	namespace audio
+	{
+		enum class AudioLodTier : AkUInt8
+		{
+			Near,
+			Mid,
+			Far,
+			Inaudible,
+			Count
+		};
+
+		struct AudioLodSettings
+		{
+			AkReal32 midDistance = 0.25f;		// fractions of max distance
+			AkReal32 farDistance = 0.6f;
+			AkReal32 hysteresis = 0.05f;
+			AkUInt32 midInterval = 2;			// frames between position updates
+			AkUInt32 farInterval = 4;
+			AkUInt8 highPriority = 75;			// at or above: one tier closer
+			AkUInt8 lowPriority = 25;			// at or below: one tier farther
+		};
+
+		struct AudioLodStats
+		{
+			AkUInt32 emitters = 0;
+			AkUInt32 tiers[(int)AudioLodTier::Count] = {};
+			AkUInt32 due = 0;		// emitters whose position may be sent this frame
+		};
+
+		class AudioLodManager
+		{
+		public:
+			explicit AudioLodManager(const AudioLodSettings& in_settings = AudioLodSettings());
+
+			void SetSettings(const AudioLodSettings& in_settings) { m_settings = in_settings; }
+
+			// Adds the emitter, or changes its parameters.  in_priority uses the Wwise
+			// range, 0 to 100.
+			void SetEmitter(AkUInt32 in_emitter, AkReal32 in_maxDistance, AkUInt8 in_priority = 50);
+			void RemoveEmitter(AkUInt32 in_emitter);
+
+			void SetPosition(AkUInt32 in_emitter, const DirectX::XMFLOAT3& in_pos);
+
+			// Assigns tiers and decides which emitters are due this frame.
+			void Update(const DirectX::XMFLOAT3& in_listener);
+
+			// One byte per index, nonzero when due.  Indices that were never given to
+			// SetEmitter() are always due.
+			const AkUInt8* GetDueMask() const { return m_due.data(); }
+			AkUInt32 GetDueMaskSize() const { return m_count; }
+
+			AudioLodTier GetTier(AkUInt32 in_emitter) const { return (AudioLodTier)m_tier[in_emitter]; }
+			const AudioLodStats& GetStats() const { return m_stats; }
+
+		private:
+			void Grow(AkUInt32 in_count);
+
+		private:
+			AudioLodSettings m_settings;
+			AkUInt32 m_count = 0;		// indices in use; arrays are padded to a multiple of 4
+			AkUInt64 m_frame = 0;
+
+			// Per emitter.
+			std::vector<float> m_x, m_y, m_z;
+			std::vector<float> m_invMaxDistanceSq;
+			std::vector<float> m_distanceSq;		// squared, relative to max distance
+			std::vector<AkUInt8> m_active;
+			std::vector<AkUInt8> m_priority;
+			std::vector<AkUInt8> m_distanceTier;	// before priority; keeps the hysteresis state
+			std::vector<AkUInt8> m_tier;
+			std::vector<AkUInt8> m_due;
+
+			AudioLodStats m_stats;
+		};
+	}
+}
@@ -0,0 +1,508 @@
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <tracy/Tracy.hpp>
+#include "audiomemory.h"
+
+namespace myengine
+{
+	namespace audio
+	{
+		namespace
+		{
+			const AkUInt32 SIZE_CLASSES = 9;			// payloads of 16, 32, ... 4096 bytes
+			const size_t MIN_CLASS_SIZE = 16;
+			const size_t MAX_CLASS_SIZE = MIN_CLASS_SIZE << (SIZE_CLASSES - 1);
+			const AkUInt32 MAX_CACHE_BLOCKS = 32;
+			const size_t HEADER_SIZE = 16;
+			const size_t ARENA_ALIGNMENT = 64;
+
+			const AkUInt8 FALLBACK_CLASS = 0xFF;
+			const AkUInt32 HEADER_MAGIC = 0xA0D10E11;
+
+			struct BlockHeader
+			{
+				AkUInt32 magic;
+				AkUInt32 size;			// bytes the caller may use
+				AkUInt32 offset;		// from the start of the allocation to the payload
+				AkUInt8 category;
+				AkUInt8 sizeClass;		// FALLBACK_CLASS when from the default allocator
+				AkUInt16 padding;
+			};
+			static_assert(sizeof(BlockHeader) == HEADER_SIZE, "payloads must stay 16-byte aligned");
+
+			struct FreeBlock
+			{
+				FreeBlock* next;
+			};
+
+			struct Category
+			{
+				std::mutex lock;
+				char* arenaCur = nullptr;
+				char* arenaEnd = nullptr;
+				FreeBlock* freeLists[SIZE_CLASSES] = {};
+
+				alignas(64) std::atomic<AkUInt64> used{ 0 };
+				std::atomic<AkUInt64> peak{ 0 };
+				std::atomic<AkUInt64> carved{ 0 };
+				std::atomic<AkUInt64> allocs{ 0 };
+				std::atomic<AkUInt64> frees{ 0 };
+				std::atomic<AkUInt64> fallbackUsed{ 0 };
+				std::atomic<AkUInt64> fallbackAllocs{ 0 };
+				std::atomic<AkUInt64> overBudget{ 0 };
+				AkUInt64 budget = 0;
+			};
+
+			struct ThreadCache
+			{
+				struct Bin
+				{
+					AkUInt32 count;
+					void* blocks[MAX_CACHE_BLOCKS];
+				};
+				Bin bins[AkMemID_NUM][SIZE_CLASSES];
+			};
+
+			// Everything the hooks need; they are plain function pointers.
+			struct PoolState
+			{
+				AkMemSettings defaults;
+				AudioMemorySettings settings;
+				char* arena = nullptr;
+				size_t arenaSize = 0;
+				Category categories[AkMemID_NUM];
+			};
+
+			PoolState* g_pools = nullptr;
+			thread_local ThreadCache* t_cache = nullptr;
+
+			// Unknown categories are counted with the integration's.
+			AkUInt32 CategoryOf(AkMemPoolId in_poolId)
+			{
+				AkUInt32 category = in_poolId & AkMemID_MASK;
+				return category < AkMemID_NUM ? category : AkMemID_Integration;
+			}
+
+			size_t BlockSize(AkUInt32 in_class)
+			{
+				return HEADER_SIZE + (MIN_CLASS_SIZE << in_class);
+			}
+
+			AkUInt32 SizeClass(size_t in_size)
+			{
+				AkUInt32 sizeClass = 0;
+				while ((MIN_CLASS_SIZE << sizeClass) < in_size)
+					++sizeClass;
+				return sizeClass;
+			}
+
+			void UpdatePeak(Category& io_category, AkUInt64 in_used)
+			{
+				AkUInt64 peak = io_category.peak.load(std::memory_order_relaxed);
+				while (in_used > peak && !io_category.peak.compare_exchange_weak(peak, in_used, std::memory_order_relaxed))
+				{
+				}
+			}
+
+			// Pops up to in_count blocks from the free list, then carves from the arena.
+			// Returns how many were written to out_blocks.  Takes the category lock.
+			AkUInt32 TakeBlocks(Category& io_category, AkUInt32 in_class, void** out_blocks, AkUInt32 in_count)
+			{
+				size_t blockSize = BlockSize(in_class);
+				AkUInt32 taken = 0;
+
+				std::lock_guard<std::mutex> lock(io_category.lock);
+				FreeBlock*& freeList = io_category.freeLists[in_class];
+				while (taken < in_count && freeList != nullptr)
+				{
+					out_blocks[taken++] = freeList;
+					freeList = freeList->next;
+				}
+				while (taken < in_count && (size_t)(io_category.arenaEnd - io_category.arenaCur) >= blockSize)
+				{
+					out_blocks[taken++] = io_category.arenaCur;
+					io_category.arenaCur += blockSize;
+					io_category.carved.fetch_add(blockSize, std::memory_order_relaxed);
+				}
+				return taken;
+			}
+
+			void ReturnBlocks(Category& io_category, AkUInt32 in_class, void* const* in_blocks, AkUInt32 in_count)
+			{
+				std::lock_guard<std::mutex> lock(io_category.lock);
+				FreeBlock*& freeList = io_category.freeLists[in_class];
+				for (AkUInt32 i = 0; i < in_count; ++i)
+				{
+					FreeBlock* block = static_cast<FreeBlock*>(in_blocks[i]);
+					block->next = freeList;
+					freeList = block;
+				}
+			}
+
+			void FlushCache(ThreadCache& io_cache)
+			{
+				for (AkUInt32 category = 0; category < AkMemID_NUM; ++category)
+				{
+					for (AkUInt32 sizeClass = 0; sizeClass < SIZE_CLASSES; ++sizeClass)
+					{
+						ThreadCache::Bin& bin = io_cache.bins[category][sizeClass];
+						if (bin.count == 0)
+							continue;
+						ReturnBlocks(g_pools->categories[category], sizeClass, bin.blocks, bin.count);
+						bin.count = 0;
+					}
+				}
+			}
+
+			void* AllocFallback(AkMemPoolId in_poolId, size_t in_size, AkUInt32 in_alignment)
+			{
+				AkUInt32 categoryIndex = CategoryOf(in_poolId);
+				Category& category = g_pools->categories[categoryIndex];
+
+				// The header goes right before the payload; pad so the payload keeps
+				// the requested alignment.
+				size_t offset = in_alignment > HEADER_SIZE ? in_alignment : HEADER_SIZE;
+				char* base = static_cast<char*>(::operator new(in_size + offset, std::align_val_t(offset), std::nothrow));
+				if (base == nullptr)
+					return nullptr;
+
+				char* payload = base + offset;
+				BlockHeader* header = reinterpret_cast<BlockHeader*>(payload - HEADER_SIZE);
+				header->magic = HEADER_MAGIC;
+				header->size = (AkUInt32)in_size;
+				header->offset = (AkUInt32)offset;
+				header->category = (AkUInt8)categoryIndex;
+				header->sizeClass = FALLBACK_CLASS;
+
+				category.fallbackUsed.fetch_add(in_size + offset, std::memory_order_relaxed);
+				category.fallbackAllocs.fetch_add(1, std::memory_order_relaxed);
+				return payload;
+			}
+
+			void* Alloc(AkMemPoolId in_poolId, size_t in_size, AkUInt32 in_alignment)
+			{
+				if (in_size == 0)
+					in_size = 1;
+
+				AkUInt32 categoryIndex = CategoryOf(in_poolId);
+				bool pooled = (in_poolId & AkMemType_Device) == 0 && (AkUInt32)(in_poolId & AkMemID_MASK) < AkMemID_NUM &&
+					in_alignment <= HEADER_SIZE && in_size <= MAX_CLASS_SIZE &&
+					g_pools->categories[categoryIndex].budget > 0;
+				if (!pooled)
+					return AllocFallback(in_poolId, in_size, in_alignment);
+
+				Category& category = g_pools->categories[categoryIndex];
+				AkUInt32 sizeClass = SizeClass(in_size);
+
+				void* block = nullptr;
+				if (t_cache != nullptr)
+				{
+					ThreadCache::Bin& bin = t_cache->bins[categoryIndex][sizeClass];
+					if (bin.count == 0)
+						bin.count = TakeBlocks(category, sizeClass, bin.blocks, (g_pools->settings.threadCacheBlocks + 1) / 2);
+					if (bin.count > 0)
+						block = bin.blocks[--bin.count];
+				}
+				else
+				{
+					TakeBlocks(category, sizeClass, &block, 1);
+				}
+
+				if (block == nullptr)
+				{
+					category.overBudget.fetch_add(1, std::memory_order_relaxed);
+					return g_pools->settings.strictBudgets ? nullptr : AllocFallback(in_poolId, in_size, in_alignment);
+				}
+
+				BlockHeader* header = static_cast<BlockHeader*>(block);
+				header->magic = HEADER_MAGIC;
+				header->size = (AkUInt32)(MIN_CLASS_SIZE << sizeClass);
+				header->offset = HEADER_SIZE;
+				header->category = (AkUInt8)categoryIndex;
+				header->sizeClass = (AkUInt8)sizeClass;
+
+				size_t blockSize = BlockSize(sizeClass);
+				UpdatePeak(category, category.used.fetch_add(blockSize, std::memory_order_relaxed) + blockSize);
+				category.allocs.fetch_add(1, std::memory_order_relaxed);
+				return static_cast<char*>(block) + HEADER_SIZE;
+			}
+
+			BlockHeader* HeaderOf(void* in_address)
+			{
+				BlockHeader* header = reinterpret_cast<BlockHeader*>(static_cast<char*>(in_address) - HEADER_SIZE);
+				assert(header->magic == HEADER_MAGIC && "not allocated by the audio memory pools");
+				return header;
+			}
+
+			void Free(AkMemPoolId in_poolId, void* in_address)
+			{
+				if (in_address == nullptr)
+					return;
+
+				BlockHeader* header = HeaderOf(in_address);
+				Category& category = g_pools->categories[header->category];
+				if (header->sizeClass == FALLBACK_CLASS)
+				{
+					category.fallbackUsed.fetch_sub(header->size + header->offset, std::memory_order_relaxed);
+					::operator delete(static_cast<char*>(in_address) - header->offset, std::align_val_t(header->offset));
+					return;
+				}
+
+				AkUInt32 sizeClass = header->sizeClass;
+				header->magic = 0;
+				category.used.fetch_sub(BlockSize(sizeClass), std::memory_order_relaxed);
+				category.frees.fetch_add(1, std::memory_order_relaxed);
+
+				void* block = header;
+				if (t_cache == nullptr)
+				{
+					ReturnBlocks(category, sizeClass, &block, 1);
+					return;
+				}
+
+				// Keep half of a full bin, so a thread alternating alloc and free at
+				// the boundary does not take the lock every time.
+				ThreadCache::Bin& bin = t_cache->bins[header->category][sizeClass];
+				AkUInt32 capacity = g_pools->settings.threadCacheBlocks;
+				if (bin.count >= capacity)
+				{
+					AkUInt32 keep = capacity / 2;
+					ReturnBlocks(category, sizeClass, bin.blocks + keep, bin.count - keep);
+					bin.count = keep;
+				}
+				bin.blocks[bin.count++] = block;
+			}
+
+			void* Realloc(AkMemPoolId in_poolId, void* in_address, size_t in_size, AkUInt32 in_alignment)
+			{
+				if (in_address == nullptr)
+					return Alloc(in_poolId, in_size, in_alignment);
+
+				BlockHeader* header = HeaderOf(in_address);
+				if (in_size <= header->size && (in_alignment <= 1 || ((size_t)in_address & (in_alignment - 1)) == 0) &&
+					(header->sizeClass != FALLBACK_CLASS || in_size == header->size))
+					return in_address;
+
+				void* moved = Alloc(in_poolId, in_size, in_alignment);
+				if (moved == nullptr)
+					return nullptr;
+				std::memcpy(moved, in_address, in_size < header->size ? in_size : header->size);
+				Free(in_poolId, in_address);
+				return moved;
+			}
+
+			void* HookMalloc(AkMemPoolId in_poolId, size_t in_size)
+			{
+				return Alloc(in_poolId, in_size, HEADER_SIZE);
+			}
+
+			void* HookMalign(AkMemPoolId in_poolId, size_t in_size, AkUInt32 in_alignment)
+			{
+				return Alloc(in_poolId, in_size, in_alignment);
+			}
+
+			void* HookRealloc(AkMemPoolId in_poolId, void* in_address, size_t in_size)
+			{
+				return Realloc(in_poolId, in_address, in_size, HEADER_SIZE);
+			}
+
+			void* HookReallocAligned(AkMemPoolId in_poolId, void* in_address, size_t in_size, AkUInt32 in_alignment)
+			{
+				return Realloc(in_poolId, in_address, in_size, in_alignment);
+			}
+
+			void HookFree(AkMemPoolId in_poolId, void* in_address)
+			{
+				Free(in_poolId, in_address);
+			}
+
+			size_t HookSizeOfMemory(AkMemPoolId, void* in_address)
+			{
+				return in_address != nullptr ? HeaderOf(in_address)->size : 0;
+			}
+
+			size_t HookTotalReservedMemorySize()
+			{
+				size_t reserved = g_pools->arenaSize;
+				for (const Category& category : g_pools->categories)
+					reserved += category.fallbackUsed.load(std::memory_order_relaxed);
+				return reserved;
+			}
+
+			// The captured thread hooks are null unless the integration set its own;
+			// null selects the built-in allocator, which the pools replace entirely.
+			void HookInitForThread()
+			{
+				if (g_pools->defaults.pfInitForThread != nullptr)
+					g_pools->defaults.pfInitForThread();
+				if (t_cache == nullptr)
+					t_cache = static_cast<ThreadCache*>(std::calloc(1, sizeof(ThreadCache)));
+			}
+
+			void HookTrimForThread()
+			{
+				if (t_cache != nullptr)
+					FlushCache(*t_cache);
+				if (g_pools->defaults.pfTrimForThread != nullptr)
+					g_pools->defaults.pfTrimForThread();
+			}
+
+			void HookTermForThread()
+			{
+				if (t_cache != nullptr)
+				{
+					FlushCache(*t_cache);
+					std::free(t_cache);
+					t_cache = nullptr;
+				}
+				if (g_pools->defaults.pfTermForThread != nullptr)
+					g_pools->defaults.pfTermForThread();
+			}
+
+			const char* CategoryPlotName(AkUInt32 in_category)
+			{
+				switch (in_category)
+				{
+				case AkMemID_Object: return "Audio mem Object (KB)";
+				case AkMemID_Event: return "Audio mem Event (KB)";
+				case AkMemID_Structure: return "Audio mem Structure (KB)";
+				case AkMemID_Media: return "Audio mem Media (KB)";
+				case AkMemID_GameObject: return "Audio mem GameObject (KB)";
+				case AkMemID_Processing: return "Audio mem Processing (KB)";
+				case AkMemID_ProcessingPlugin: return "Audio mem ProcessingPlugin (KB)";
+				case AkMemID_Streaming: return "Audio mem Streaming (KB)";
+				case AkMemID_StreamingIO: return "Audio mem StreamingIO (KB)";
+				case AkMemID_SpatialAudio: return "Audio mem SpatialAudio (KB)";
+				case AkMemID_SpatialAudioGeometry: return "Audio mem SpatialAudioGeometry (KB)";
+				case AkMemID_SpatialAudioPaths: return "Audio mem SpatialAudioPaths (KB)";
+				case AkMemID_GameSim: return "Audio mem GameSim (KB)";
+				case AkMemID_MonitorQueue: return "Audio mem MonitorQueue (KB)";
+				case AkMemID_Profiler: return "Audio mem Profiler (KB)";
+				case AkMemID_FilePackage: return "Audio mem FilePackage (KB)";
+				case AkMemID_SoundEngine: return "Audio mem SoundEngine (KB)";
+				case AkMemID_Integration: return "Audio mem Integration (KB)";
+				case AkMemID_JobMgr: return "Audio mem JobMgr (KB)";
+				default: return "Audio mem other (KB)";
+				}
+			}
+		}
+
+		AudioMemorySettings::AudioMemorySettings()
+		{
+			const size_t MB = 1024 * 1024;
+			for (size_t& categoryBudget : budget)
+				categoryBudget = 0;
+
+			// Media and streaming buffers are mostly larger than the largest size
+			// class; they stay on the default allocator.
+			budget[AkMemID_Object] = 4 * MB;
+			budget[AkMemID_Event] = 1 * MB;
+			budget[AkMemID_Structure] = 4 * MB;
+			budget[AkMemID_GameObject] = 2 * MB;
+			budget[AkMemID_Processing] = 8 * MB;
+			budget[AkMemID_ProcessingPlugin] = 4 * MB;
+			budget[AkMemID_SpatialAudio] = 2 * MB;
+			budget[AkMemID_SpatialAudioGeometry] = 2 * MB;
+			budget[AkMemID_SpatialAudioPaths] = 1 * MB;
+			budget[AkMemID_GameSim] = 1 * MB;
+			budget[AkMemID_MonitorQueue] = 1 * MB;
+			budget[AkMemID_Profiler] = 1 * MB;
+			budget[AkMemID_FilePackage] = 1 * MB;
+			budget[AkMemID_SoundEngine] = 2 * MB;
+			budget[AkMemID_Integration] = 1 * MB;
+			budget[AkMemID_JobMgr] = 1 * MB;
+		}
+
+		AKRESULT InstallAudioMemory(AkMemSettings& io_memSettings, const AudioMemorySettings& in_settings)
+		{
+			if (g_pools != nullptr || in_settings.threadCacheBlocks == 0 || in_settings.threadCacheBlocks > MAX_CACHE_BLOCKS)
+				return AK_InvalidParameter;
+
+			PoolState* pools = new PoolState();
+			pools->defaults = io_memSettings;
+			pools->settings = in_settings;
+
+			for (AkUInt32 i = 0; i < AkMemID_NUM; ++i)
+				pools->arenaSize += (in_settings.budget[i] + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+
+			if (pools->arenaSize > 0)
+			{
+				// One block for all arenas, from the OS heap since the memory manager is
+				// not initialized yet.  Touched once so the budget is committed now
+				// rather than on first use.
+				pools->arena = static_cast<char*>(::operator new(pools->arenaSize, std::align_val_t(ARENA_ALIGNMENT), std::nothrow));
+				if (pools->arena == nullptr)
+				{
+					delete pools;
+					return AK_InsufficientMemory;
+				}
+				std::memset(pools->arena, 0, pools->arenaSize);
+			}
+
+			char* cursor = pools->arena;
+			for (AkUInt32 i = 0; i < AkMemID_NUM; ++i)
+			{
+				Category& category = pools->categories[i];
+				category.budget = in_settings.budget[i];
+				category.arenaCur = cursor;
+				category.arenaEnd = cursor + category.budget;
+				cursor += (category.budget + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+			}
+
+			g_pools = pools;
+
+			io_memSettings.pfInitForThread = HookInitForThread;
+			io_memSettings.pfTermForThread = HookTermForThread;
+			io_memSettings.pfTrimForThread = HookTrimForThread;
+			io_memSettings.pfMalloc = HookMalloc;
+			io_memSettings.pfMalign = HookMalign;
+			io_memSettings.pfRealloc = HookRealloc;
+			io_memSettings.pfReallocAligned = HookReallocAligned;
+			io_memSettings.pfFree = HookFree;
+			io_memSettings.pfTotalReservedMemorySize = HookTotalReservedMemorySize;
+			io_memSettings.pfSizeOfMemory = HookSizeOfMemory;
+			return AK_Success;
+		}
+
+		bool IsAudioMemoryInstalled()
+		{
+			return g_pools != nullptr;
+		}
+
+		void GetAudioMemoryStats(AkUInt32 in_category, AudioMemoryCategoryStats& out_stats)
+		{
+			out_stats = AudioMemoryCategoryStats();
+			if (g_pools == nullptr || in_category >= AkMemID_NUM)
+				return;
+
+			const Category& category = g_pools->categories[in_category];
+			out_stats.budget = category.budget;
+			out_stats.carved = category.carved.load(std::memory_order_relaxed);
+			out_stats.used = category.used.load(std::memory_order_relaxed);
+			out_stats.peak = category.peak.load(std::memory_order_relaxed);
+			out_stats.allocs = category.allocs.load(std::memory_order_relaxed);
+			out_stats.frees = category.frees.load(std::memory_order_relaxed);
+			out_stats.fallbackUsed = category.fallbackUsed.load(std::memory_order_relaxed);
+			out_stats.fallbackAllocs = category.fallbackAllocs.load(std::memory_order_relaxed);
+			out_stats.overBudget = category.overBudget.load(std::memory_order_relaxed);
+		}
+
+		void PlotAudioMemoryStats()
+		{
+			if (g_pools == nullptr)
+				return;
+
+			for (AkUInt32 i = 0; i < AkMemID_NUM; ++i)
+			{
+				const Category& category = g_pools->categories[i];
+				if (category.budget == 0)
+					continue;
+				TracyPlot(CategoryPlotName(i), (int64_t)(category.used.load(std::memory_order_relaxed) / 1024));
+			}
+		}
+	}
+}
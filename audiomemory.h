@@ -0,0 +1,67 @@
+#pragma once
+#include <AK/SoundEngine/Common/AkTypes.h>
+#include <AK/SoundEngine/Common/AkMemoryMgr.h>
+
+// Pooled allocator for the Wwise memory manager.
+//
+// InstallAudioMemory() replaces the allocation hooks of an AkMemSettings obtained
+// from AK::MemoryMgr::GetDefaultSettings().  Every memory category (AkMemID) with a
+// budget gets its own arena, allocated once up front.  Small allocations are served
+// from power-of-two size classes carved out of that arena, so a category's footprint
+// never exceeds its budget and does not depend on the allocation pattern of the
+// others.
+//
+// Each thread that calls AK::MemoryMgr::InitForThread() (the sound engine's threads
+// and the job workers) gets a small cache of free blocks per category and size
+// class; most allocations and frees touch only that cache.  Blocks move between the
+// cache and the category in batches, under the category's lock.  TrimForThread()
+// and TermForThread() return cached blocks.
+//
+// Requests the pools cannot serve go to the aligned operator new: device memory,
+// alignment above 16, sizes above the largest class, categories without a budget,
+// and (unless strictBudgets) allocations once the arena is full.  The default
+// settings leave their hooks null to select the built-in allocator, so only thread
+// hooks the integration set itself are chained.  Every block, pooled or not, is
+// preceded by a 16-byte header.
+//
+// Stats are kept per category with relaxed atomics and can be read at any time.
+
+namespace myengine
+{
+	namespace audio
+	{
+		struct AudioMemorySettings
+		{
+			AudioMemorySettings();
+
+			size_t budget[AkMemID_NUM];		// arena bytes per category, 0 to use the default allocator
+			AkUInt32 threadCacheBlocks = 16;	// per thread, category and size class, at most 32
+			bool strictBudgets = false;			// fail instead of falling back when an arena is full
+		};
+
+		struct AudioMemoryCategoryStats
+		{
+			AkUInt64 budget = 0;
+			AkUInt64 carved = 0;			// arena bytes handed out as blocks so far
+			AkUInt64 used = 0;				// live pooled bytes, including headers and rounding
+			AkUInt64 peak = 0;
+			AkUInt64 allocs = 0;
+			AkUInt64 frees = 0;
+			AkUInt64 fallbackUsed = 0;		// live bytes from the default allocator
+			AkUInt64 fallbackAllocs = 0;
+			AkUInt64 overBudget = 0;		// allocations the full arena could not serve
+		};
+
+		// Call between AK::MemoryMgr::GetDefaultSettings() and AK::MemoryMgr::Init(),
+		// once per process.
+		AKRESULT InstallAudioMemory(AkMemSettings& io_memSettings, const AudioMemorySettings& in_settings = AudioMemorySettings());
+
+		bool IsAudioMemoryInstalled();
+
+		// Thread safe.  in_category is an AkMemID.
+		void GetAudioMemoryStats(AkUInt32 in_category, AudioMemoryCategoryStats& out_stats);
+
+		// Plots used bytes of every budgeted category to Tracy.
+		void PlotAudioMemoryStats();
+	}
+}
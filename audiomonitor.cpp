@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <tracy/Tracy.hpp>
+#include <AK/SoundEngine/Common/AkMemoryMgr.h>
+#include <AK/SoundEngine/Common/IAkStreamMgr.h>
+#include "audiomonitor.h"
+
+namespace myengine
+{
+	namespace audio
+	{
+		static_assert(std::is_trivially_copyable<AudioResourceSample>::value, "samples are copied word by word");
+		static_assert((AudioResourceMonitor::CAPACITY & (AudioResourceMonitor::CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+		namespace
+		{
+			// Opens a profiling session of the stream manager; see SetStreamSampling().
+			AkUInt32 CountStreams()
+			{
+#ifndef AK_OPTIMIZED
+				// The profiling interface is only compiled in non-optimized builds.
+				AK::IAkStreamMgr* streamMgr = AK::IAkStreamMgr::Get();
+				AK::IAkStreamMgrProfile* profile = streamMgr != nullptr ? streamMgr->GetStreamMgrProfile() : nullptr;
+				if (profile == nullptr)
+					return 0;
+
+				AkUInt32 streams = 0;
+				AkUInt32 devices = profile->GetNumDevices();
+				for (AkUInt32 i = 0; i < devices; ++i)
+				{
+					AK::IAkDeviceProfile* device = profile->GetDeviceProfile(i);
+					if (device == nullptr)
+						continue;
+					device->OnProfileStart();
+					streams += device->GetNumStreams();
+					device->OnProfileEnd();
+				}
+				return streams;
+#else
+				return 0;
+#endif
+			}
+
+			AudioPercentiles Percentiles(std::vector<AkReal32>& io_values)
+			{
+				AudioPercentiles result;
+				if (io_values.empty())
+					return result;
+
+				auto at = [&io_values](double in_fraction) {
+					size_t k = (size_t)(in_fraction * (io_values.size() - 1) + 0.5);
+					std::nth_element(io_values.begin(), io_values.begin() + k, io_values.end());
+					return io_values[k];
+				};
+				result.p50 = at(0.50);
+				result.p95 = at(0.95);
+				result.p99 = at(0.99);
+				result.max = *std::max_element(io_values.begin(), io_values.end());
+				return result;
+			}
+
+			void WriteJsonPercentiles(std::ofstream& out, const char* in_name, const AudioPercentiles& in_p, bool in_last)
+			{
+				out << "    \"" << in_name << "\": { \"p50\": " << in_p.p50 << ", \"p95\": " << in_p.p95
+					<< ", \"p99\": " << in_p.p99 << ", \"max\": " << in_p.max << " }" << (in_last ? "\n" : ",\n");
+			}
+		}
+
+		AudioResourceMonitor::AudioResourceMonitor()
+			: m_start(std::chrono::steady_clock::now())
+			, m_slots(new Slot[CAPACITY])
+		{
+		}
+
+		void AudioResourceMonitor::Record(const AkResourceMonitorDataSummary& in_summary)
+		{
+			ZoneScoped;
+
+			AK::MemoryMgr::GlobalStats memStats;
+			AK::MemoryMgr::GetGlobalStats(memStats);
+
+			AudioResourceSample sample = {};
+			sample.index = m_count.load(std::memory_order_relaxed);
+			sample.frame = m_frame.load(std::memory_order_relaxed);
+			sample.timeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+			sample.totalCPU = in_summary.totalCPU;
+			sample.pluginCPU = in_summary.pluginCPU;
+			sample.physicalVoices = in_summary.physicalVoices;
+			sample.virtualVoices = in_summary.virtualVoices;
+			sample.totalVoices = in_summary.totalVoices;
+			sample.activeEvents = in_summary.nbActiveEvents;
+			if (!m_streamSampling.load(std::memory_order_relaxed))
+				m_streams = 0;
+			else if (sample.index % STREAM_SAMPLE_INTERVAL == 0)
+				m_streams = CountStreams();
+			sample.streams = m_streams;
+			sample.memUsed = memStats.uUsed;
+			sample.memReserved = memStats.uReserved;
+			Push(sample);
+
+			TracyPlot("Audio CPU (%)", sample.totalCPU);
+			TracyPlot("Audio plugin CPU (%)", sample.pluginCPU);
+			TracyPlot("Audio voices (physical)", (int64_t)sample.physicalVoices);
+			TracyPlot("Audio voices (virtual)", (int64_t)sample.virtualVoices);
+			TracyPlot("Audio streams", (int64_t)sample.streams);
+			TracyPlot("Audio memory used (MB)", sample.memUsed / (1024.0 * 1024.0));
+		}
+
+		void AudioResourceMonitor::Push(const AudioResourceSample& in_sample)
+		{
+			AkUInt64 index = in_sample.index;
+			Slot& slot = m_slots[index & (CAPACITY - 1)];
+
+			AkUInt64 words[WORDS] = {};
+			std::memcpy(words, &in_sample, sizeof(in_sample));
+
+			slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			for (size_t w = 0; w < WORDS; ++w)
+				slot.words[w].store(words[w], std::memory_order_relaxed);
+			slot.seq.store(2 * index + 2, std::memory_order_release);
+
+			m_count.store(index + 1, std::memory_order_release);
+		}
+
+		bool AudioResourceMonitor::Read(AkUInt64 in_index, AudioResourceSample& out_sample) const
+		{
+			const Slot& slot = m_slots[in_index & (CAPACITY - 1)];
+
+			AkUInt64 before = slot.seq.load(std::memory_order_acquire);
+			if (before != 2 * in_index + 2)
+				return false;
+
+			AkUInt64 words[WORDS];
+			for (size_t w = 0; w < WORDS; ++w)
+				words[w] = slot.words[w].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (slot.seq.load(std::memory_order_relaxed) != before)
+				return false;
+
+			std::memcpy(&out_sample, words, sizeof(out_sample));
+			return true;
+		}
+
+		void AudioResourceMonitor::Snapshot(std::vector<AudioResourceSample>& out_samples, AkUInt32 in_maxSamples) const
+		{
+			out_samples.clear();
+
+			AkUInt64 count = m_count.load(std::memory_order_acquire);
+			AkUInt64 wanted = std::min<AkUInt64>(std::min<AkUInt64>(in_maxSamples, CAPACITY), count);
+			out_samples.reserve((size_t)wanted);
+
+			AudioResourceSample sample;
+			for (AkUInt64 i = count - wanted; i < count; ++i)
+			{
+				if (Read(i, sample))
+					out_samples.push_back(sample);
+			}
+		}
+
+		AudioResourceSample AudioResourceMonitor::Latest() const
+		{
+			AudioResourceSample sample = {};
+			AkUInt64 count = m_count.load(std::memory_order_acquire);
+			if (count > 0)
+				Read(count - 1, sample);
+			return sample;
+		}
+
+		AudioResourcePercentiles AudioResourceMonitor::ComputePercentiles(const std::vector<AudioResourceSample>& in_samples)
+		{
+			AudioResourcePercentiles result;
+			result.samples = (AkUInt32)in_samples.size();
+
+			std::vector<AkReal32> values(in_samples.size());
+			auto metric = [&](AudioPercentiles& out_metric, auto in_get) {
+				for (size_t i = 0; i < in_samples.size(); ++i)
+					values[i] = (AkReal32)in_get(in_samples[i]);
+				out_metric = Percentiles(values);
+			};
+			metric(result.totalCPU, [](const AudioResourceSample& s) { return s.totalCPU; });
+			metric(result.pluginCPU, [](const AudioResourceSample& s) { return s.pluginCPU; });
+			metric(result.physicalVoices, [](const AudioResourceSample& s) { return s.physicalVoices; });
+			metric(result.totalVoices, [](const AudioResourceSample& s) { return s.totalVoices; });
+			metric(result.streams, [](const AudioResourceSample& s) { return s.streams; });
+			metric(result.memUsedMB, [](const AudioResourceSample& s) { return s.memUsed / (1024.0 * 1024.0); });
+			return result;
+		}
+
+		void AudioResourceMonitor::Update()
+		{
+			ZoneScoped;
+			m_frame.fetch_add(1, std::memory_order_relaxed);
+
+			AkUInt64 count = GetSampleCount();
+			if (count == m_percentilesAt)
+				return;
+
+			m_percentilesAt = count;
+			Snapshot(m_scratch, m_window);
+			m_percentiles = ComputePercentiles(m_scratch);
+
+			TracyPlot("Audio CPU p95 (%)", m_percentiles.totalCPU.p95);
+			TracyPlot("Audio CPU p99 (%)", m_percentiles.totalCPU.p99);
+		}
+
+		bool AudioResourceMonitor::DumpCsv(const std::string& in_path) const
+		{
+			std::vector<AudioResourceSample> samples;
+			Snapshot(samples);
+
+			std::ofstream out(in_path);
+			if (!out)
+				return false;
+
+			out << "index,frame,time_ms,total_cpu,plugin_cpu,physical_voices,virtual_voices,total_voices,"
+				"active_events,streams,mem_used,mem_reserved\n";
+			for (const AudioResourceSample& s : samples)
+			{
+				out << s.index << ',' << s.frame << ',' << s.timeMs << ',' << s.totalCPU << ',' << s.pluginCPU << ','
+					<< s.physicalVoices << ',' << s.virtualVoices << ',' << s.totalVoices << ',' << s.activeEvents << ','
+					<< s.streams << ',' << s.memUsed << ',' << s.memReserved << '\n';
+			}
+			return (bool)out;
+		}
+
+		bool AudioResourceMonitor::DumpJson(const std::string& in_path) const
+		{
+			std::vector<AudioResourceSample> samples;
+			Snapshot(samples);
+			AudioResourcePercentiles percentiles = ComputePercentiles(samples);
+
+			std::ofstream out(in_path);
+			if (!out)
+				return false;
+
+			out << "{\n  \"percentiles\": {\n";
+			out << "    \"samples\": " << percentiles.samples << ",\n";
+			WriteJsonPercentiles(out, "total_cpu", percentiles.totalCPU, false);
+			WriteJsonPercentiles(out, "plugin_cpu", percentiles.pluginCPU, false);
+			WriteJsonPercentiles(out, "physical_voices", percentiles.physicalVoices, false);
+			WriteJsonPercentiles(out, "total_voices", percentiles.totalVoices, false);
+			WriteJsonPercentiles(out, "streams", percentiles.streams, false);
+			WriteJsonPercentiles(out, "mem_used_mb", percentiles.memUsedMB, true);
+			out << "  },\n  \"samples\": [\n";
+			for (size_t i = 0; i < samples.size(); ++i)
+			{
+				const AudioResourceSample& s = samples[i];
+				out << "    { \"index\": " << s.index << ", \"frame\": " << s.frame << ", \"time_ms\": " << s.timeMs
+					<< ", \"total_cpu\": " << s.totalCPU << ", \"plugin_cpu\": " << s.pluginCPU
+					<< ", \"physical_voices\": " << s.physicalVoices << ", \"virtual_voices\": " << s.virtualVoices
+					<< ", \"total_voices\": " << s.totalVoices << ", \"active_events\": " << s.activeEvents
+					<< ", \"streams\": " << s.streams << ", \"mem_used\": " << s.memUsed
+					<< ", \"mem_reserved\": " << s.memReserved << " }" << (i + 1 < samples.size() ? ",\n" : "\n");
+			}
+			out << "  ]\n}\n";
+			return (bool)out;
+		}
+	}
+}
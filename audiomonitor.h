@@ -0,0 +1,135 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <AK/SoundEngine/Common/AkTypes.h>
+#include <AK/SoundEngine/Common/AkCallback.h>
+
+// History of the sound engine's resource monitor.
+//
+// The sound engine reports a resource summary after every audio frame.  Record()
+// stores each one, with memory use, stream count and the current render frame, in a
+// fixed ring of the last CAPACITY samples, and plots the values to Tracy so audio
+// CPU spikes show up on the same timeline as frame hitches.
+//
+// The summary has no stream count.  Counting streams takes a profiling session of
+// the stream manager, the one the Wwise profiler uses over Comm, so it is off by
+// default; SetStreamSampling() enables it where Comm is not initialized, and then
+// streams are counted every STREAM_SAMPLE_INTERVAL samples only.
+//
+// The ring has a single writer (the thread that calls Record(), i.e. the sound
+// engine's) and any number of readers; neither side ever blocks.  Each slot carries
+// a sequence number that is odd while the slot is being written, and a reader
+// retries nothing: samples overwritten while it reads are left out.
+//
+// Update() runs on the main thread, counts render frames and refreshes the rolling
+// percentiles over the last window samples.  DumpCsv()/DumpJson() write the whole
+// history on demand.
+
+namespace myengine
+{
+	namespace audio
+	{
+		struct AudioResourceSample
+		{
+			AkUInt64 index;				// sample number since start
+			AkUInt64 frame;				// render frames (Update() calls) when recorded
+			AkReal64 timeMs;			// since the monitor was created
+			AkReal32 totalCPU;			// percent of an audio frame
+			AkReal32 pluginCPU;
+			AkUInt32 physicalVoices;
+			AkUInt32 virtualVoices;
+			AkUInt32 totalVoices;
+			AkUInt32 activeEvents;
+			AkUInt32 streams;			// as of the last count; 0 unless stream sampling is enabled
+			AkUInt32 padding;
+			AkUInt64 memUsed;			// bytes
+			AkUInt64 memReserved;
+		};
+
+		struct AudioPercentiles
+		{
+			AkReal32 p50 = 0.0f;
+			AkReal32 p95 = 0.0f;
+			AkReal32 p99 = 0.0f;
+			AkReal32 max = 0.0f;
+		};
+
+		struct AudioResourcePercentiles
+		{
+			AkUInt32 samples = 0;
+			AudioPercentiles totalCPU;
+			AudioPercentiles pluginCPU;
+			AudioPercentiles physicalVoices;
+			AudioPercentiles totalVoices;
+			AudioPercentiles streams;
+			AudioPercentiles memUsedMB;
+		};
+
+		class AudioResourceMonitor
+		{
+		public:
+			static const AkUInt32 CAPACITY = 4096;		// power of two; about 85 s at 1024 samples/48 kHz
+			static const AkUInt32 STREAM_SAMPLE_INTERVAL = 64;	// samples between stream counts, about 1.4 s
+
+			AudioResourceMonitor();
+			AudioResourceMonitor(const AudioResourceMonitor&) = delete;
+			AudioResourceMonitor& operator=(const AudioResourceMonitor&) = delete;
+
+			// From the resource monitor callback.  One writer thread only.
+			void Record(const AkResourceMonitorDataSummary& in_summary);
+
+			// Main thread, once per frame.
+			void Update();
+
+			// Only enable while Comm is not initialized: counting streams would start and
+			// stop the profiling session the authoring tool relies on.  Thread safe.
+			void SetStreamSampling(bool in_enabled) { m_streamSampling.store(in_enabled, std::memory_order_relaxed); }
+
+			// Samples the rolling percentiles are taken over.
+			void SetWindow(AkUInt32 in_samples) { m_window = in_samples; }
+
+			// As of the last Update().  Main thread.
+			const AudioResourcePercentiles& GetPercentiles() const { return m_percentiles; }
+
+			// Thread safe.  Copies up to in_maxSamples of the newest samples, oldest first.
+			void Snapshot(std::vector<AudioResourceSample>& out_samples, AkUInt32 in_maxSamples = CAPACITY) const;
+			AudioResourceSample Latest() const;
+			AkUInt64 GetSampleCount() const { return m_count.load(std::memory_order_acquire); }
+
+			static AudioResourcePercentiles ComputePercentiles(const std::vector<AudioResourceSample>& in_samples);
+
+			// Thread safe.  Return false if the file could not be written.
+			bool DumpCsv(const std::string& in_path) const;
+			bool DumpJson(const std::string& in_path) const;
+
+		private:
+			static const size_t WORDS = (sizeof(AudioResourceSample) + 7) / 8;
+
+			struct Slot
+			{
+				std::atomic<AkUInt64> seq{ 0 };		// 2 * index + 2 once written, odd while writing
+				std::atomic<AkUInt64> words[WORDS];
+			};
+
+			void Push(const AudioResourceSample& in_sample);
+			bool Read(AkUInt64 in_index, AudioResourceSample& out_sample) const;
+
+		private:
+			std::chrono::steady_clock::time_point m_start;
+			std::atomic<AkUInt64> m_frame{ 0 };
+			std::atomic<AkUInt64> m_count{ 0 };
+			std::unique_ptr<Slot[]> m_slots;
+			std::atomic<bool> m_streamSampling{ false };
+			AkUInt32 m_streams = 0;			// writer thread only
+
+			// Main thread only.
+			AkUInt32 m_window = 256;
+			AkUInt64 m_percentilesAt = 0;	// sample count when m_percentiles was computed
+			AudioResourcePercentiles m_percentiles;
+			std::vector<AudioResourceSample> m_scratch;
+		};
+	}
+}
@@ -0,0 +1,162 @@
+#include <tracy/Tracy.hpp>
+#include <AK/SoundEngine/Common/AkMemoryMgr.h>
+#include "audiothread.h"
+
+#if defined(AK_WIN)
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace myengine
+{
+	namespace audio
+	{
+		namespace
+		{
+			AkReal32 ElapsedMs(AkInt64 in_from, AkInt64 in_to)
+			{
+				return AKPLATFORM::Elapsed(in_to, in_from);
+			}
+		}
+
+		AudioUpdateThread::AudioUpdateThread()
+		{
+			AKPLATFORM::AkClearThread(&m_thread);
+		}
+
+		AudioUpdateThread::~AudioUpdateThread()
+		{
+			Stop();
+		}
+
+		AKRESULT AudioUpdateThread::Start(const AudioThreadSettings& in_settings, std::function<void()> in_tick)
+		{
+			if (m_running || in_settings.ticksPerSecond == 0)
+				return AK_Fail;
+
+			m_settings = in_settings;
+			m_tick = std::move(in_tick);
+			m_stop = false;
+			{
+				std::lock_guard<std::mutex> lock(m_statsLock);
+				m_stats = AudioThreadStats();
+			}
+
+			AKPLATFORM::UpdatePerformanceFrequency();
+
+#if defined(AK_WIN)
+			// Millisecond sleeps instead of the default 15.6 ms timer slice.
+			timeBeginPeriod(1);
+#endif
+
+			AkThreadProperties threadProps;
+			AKPLATFORM::AkGetDefaultHighPriorityThreadProperties(threadProps);
+			AKPLATFORM::AkCreateThread(ThreadFunc, this, threadProps, &m_thread, "myengine::audio::UpdateThread");
+			if (!AKPLATFORM::AkIsValidThread(&m_thread))
+			{
+#if defined(AK_WIN)
+				timeEndPeriod(1);
+#endif
+				return AK_Fail;
+			}
+
+			m_running = true;
+			return AK_Success;
+		}
+
+		void AudioUpdateThread::Stop()
+		{
+			if (!m_running)
+				return;
+
+			m_stop = true;
+			AKPLATFORM::AkWaitForSingleThread(&m_thread);
+			AKPLATFORM::AkCloseThread(&m_thread);
+			AKPLATFORM::AkClearThread(&m_thread);
+			m_running = false;
+
+#if defined(AK_WIN)
+			timeEndPeriod(1);
+#endif
+		}
+
+		AudioThreadStats AudioUpdateThread::GetStats()
+		{
+			std::lock_guard<std::mutex> lock(m_statsLock);
+			return m_stats;
+		}
+
+		AK_DECLARE_THREAD_ROUTINE(AudioUpdateThread::ThreadFunc)
+		{
+			AudioUpdateThread& self = *AK_GET_THREAD_ROUTINE_PARAMETER_PTR(AudioUpdateThread);
+
+			AK_INSTRUMENT_THREAD_START("myengine::audio::UpdateThread");
+			tracy::SetThreadName("Audio update");
+			AK::MemoryMgr::InitForThread();
+
+			self.Run();
+
+			AK::MemoryMgr::TermForThread();
+			AkExitThread(AK_RETURN_THREAD_OK);
+		}
+
+		void AudioUpdateThread::Run()
+		{
+			const AkReal64 countsPerMs = AK::g_fFreqRatio;
+			const AkInt64 period = (AkInt64)(countsPerMs * 1000.0 / m_settings.ticksPerSecond);
+			const AkInt64 spin = (AkInt64)(countsPerMs * m_settings.spinMs);
+
+			AkInt64 deadline;
+			AKPLATFORM::PerformanceCounter(&deadline);
+
+			while (!m_stop)
+			{
+				AkInt64 tickStart;
+				AKPLATFORM::PerformanceCounter(&tickStart);
+				{
+					ZoneScopedN("Audio tick");
+					m_tick();
+				}
+				AkInt64 tickEnd;
+				AKPLATFORM::PerformanceCounter(&tickEnd);
+
+				AkReal32 latenessMs = ElapsedMs(deadline, tickStart);
+				AkReal32 tickMs = ElapsedMs(tickStart, tickEnd);
+
+				deadline += period;
+				AkUInt64 skipped = 0;
+				if (tickEnd - deadline > period)
+				{
+					skipped = (AkUInt64)((tickEnd - deadline) / period);
+					deadline = tickEnd;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(m_statsLock);
+					++m_stats.ticks;
+					m_stats.skippedTicks += skipped;
+					m_stats.lastLatenessMs = latenessMs;
+					m_stats.maxLatenessMs = latenessMs > m_stats.maxLatenessMs ? latenessMs : m_stats.maxLatenessMs;
+					m_stats.lastTickMs = tickMs;
+					m_stats.maxTickMs = tickMs > m_stats.maxTickMs ? tickMs : m_stats.maxTickMs;
+				}
+				TracyPlot("Audio tick lateness (ms)", latenessMs);
+
+				// Sleep most of the way, then spin up to the deadline.
+				for (;;)
+				{
+					AkInt64 now;
+					AKPLATFORM::PerformanceCounter(&now);
+					AkInt64 remaining = deadline - now;
+					if (remaining <= 0 || m_stop)
+						break;
+
+					if (remaining > spin)
+						AKPLATFORM::AkSleep((AkUInt32)((remaining - spin) / countsPerMs));
+					else
+						AkSpinHint();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <AK/SoundEngine/Common/AkTypes.h>
+#include <AK/Tools/Common/AkPlatformFuncs.h>
+
+// A high-priority thread that calls a tick function at a fixed rate, independent of
+// the render loop.
+//
+// Each wait sleeps until spinMs before the deadline and spins for the rest, so
+// ticks land within a fraction of a millisecond of the schedule even with a coarse
+// OS sleep.  Deadlines are absolute (start + n * period), so lateness does not
+// accumulate.  If the thread falls more than one period behind (the tick itself
+// took too long, or the thread was starved) it skips the missed ticks and
+// restarts the schedule from now rather than running them back to back.
+
+namespace myengine
+{
+	namespace audio
+	{
+		struct AudioThreadSettings
+		{
+			AkUInt32 ticksPerSecond = 60;
+			AkReal32 spinMs = 2.0f;		// tail of each wait spent spinning instead of sleeping
+		};
+
+		struct AudioThreadStats
+		{
+			AkUInt64 ticks = 0;
+			AkUInt64 skippedTicks = 0;
+			AkReal32 lastLatenessMs = 0.0f;		// how late the last tick started
+			AkReal32 maxLatenessMs = 0.0f;
+			AkReal32 lastTickMs = 0.0f;			// duration of the last tick function call
+			AkReal32 maxTickMs = 0.0f;
+		};
+
+		class AudioUpdateThread
+		{
+		public:
+			AudioUpdateThread();
+			~AudioUpdateThread();
+
+			AudioUpdateThread(const AudioUpdateThread&) = delete;
+			AudioUpdateThread& operator=(const AudioUpdateThread&) = delete;
+
+			// Starts calling in_tick on a new thread.  Fails if already running.
+			AKRESULT Start(const AudioThreadSettings& in_settings, std::function<void()> in_tick);
+
+			// Waits for the current tick to finish.  No-op if not running.
+			void Stop();
+
+			bool IsRunning() const { return m_running; }
+
+			// Thread safe.
+			AudioThreadStats GetStats();
+
+		private:
+			static AK_DECLARE_THREAD_ROUTINE(ThreadFunc);
+			void Run();
+
+		private:
+			AkThread m_thread;
+			bool m_running = false;
+			std::atomic<bool> m_stop{ false };
+
+			AudioThreadSettings m_settings;
+			std::function<void()> m_tick;
+
+			std::mutex m_statsLock;
+			AudioThreadStats m_stats;
+		};
+	}
+}
@@ -0,0 +1,194 @@
+#include <cassert>
+#include <cmath>
+#include <tracy/Tracy.hpp>
+#include "audiotransformsync.h"
+
+using namespace DirectX;
+
+namespace myengine
+{
+	namespace audio
+	{
+		namespace
+		{
+			float DistanceSq(const XMFLOAT3& a, const XMFLOAT3& b)
+			{
+				float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+				return dx * dx + dy * dy + dz * dz;
+			}
+
+			XMFLOAT3 Normalize(const XMFLOAT3& v, const XMFLOAT3& fallback)
+			{
+				float lengthSq = v.x * v.x + v.y * v.y + v.z * v.z;
+				if (lengthSq < 1e-12f)
+					return fallback;
+				float inv = 1.0f / std::sqrt(lengthSq);
+				return XMFLOAT3(v.x * inv, v.y * inv, v.z * inv);
+			}
+		}
+
+		void AkAudioPositionSink::SetPosition(AkGameObjectID in_gameObj, const AkSoundPosition& in_position)
+		{
+			AK::SoundEngine::SetPosition(in_gameObj, in_position);
+		}
+
+		void AkAudioPositionSink::SetMultiplePositions(AkGameObjectID in_gameObj, const AkSoundPosition* in_positions,
+			AkUInt16 in_count, AK::SoundEngine::MultiPositionType in_type)
+		{
+			AK::SoundEngine::SetMultiplePositions(in_gameObj, in_positions, in_count, in_type);
+		}
+
+		AudioTransformSync::AudioTransformSync(const AudioTransformSyncSettings& in_settings)
+			: m_settings(in_settings)
+		{
+		}
+
+		AkUInt32 AudioTransformSync::AddEmitter(AkGameObjectID in_gameObj, AkUInt16 in_positionCount,
+			AK::SoundEngine::MultiPositionType in_type)
+		{
+			assert(in_positionCount > 0);
+
+			// Reuse a removed emitter with the same number of positions, so the
+			// position arrays never need compacting.
+			AkUInt32 index = INVALID_EMITTER;
+			for (size_t i = 0; i < m_freeEmitters.size(); ++i)
+			{
+				if (m_emitters[m_freeEmitters[i]].positionCount == in_positionCount)
+				{
+					index = m_freeEmitters[i];
+					m_freeEmitters[i] = m_freeEmitters.back();
+					m_freeEmitters.pop_back();
+					break;
+				}
+			}
+
+			if (index == INVALID_EMITTER)
+			{
+				index = (AkUInt32)m_emitters.size();
+
+				Emitter emitter;
+				emitter.firstPosition = (AkUInt32)m_pos.size();
+				emitter.positionCount = in_positionCount;
+				m_emitters.push_back(emitter);
+
+				size_t positionCount = m_pos.size() + in_positionCount;
+				const XMFLOAT3 zero(0.0f, 0.0f, 0.0f);
+				const XMFLOAT3 front(0.0f, 0.0f, 1.0f);
+				const XMFLOAT3 top(0.0f, 1.0f, 0.0f);
+				m_pos.resize(positionCount, zero);
+				m_front.resize(positionCount, front);
+				m_top.resize(positionCount, top);
+				m_sentPos.resize(positionCount, zero);
+				m_sentFront.resize(positionCount, front);
+				m_sentTop.resize(positionCount, top);
+			}
+
+			Emitter& emitter = m_emitters[index];
+			emitter.gameObj = in_gameObj;
+			emitter.type = in_type;
+			emitter.live = true;
+			emitter.sent = false;
+			return index;
+		}
+
+		void AudioTransformSync::RemoveEmitter(AkUInt32 in_emitter)
+		{
+			assert(in_emitter < m_emitters.size() && m_emitters[in_emitter].live);
+			m_emitters[in_emitter].live = false;
+			m_freeEmitters.push_back(in_emitter);
+		}
+
+		void AudioTransformSync::SetTransform(AkUInt32 in_emitter, AkUInt16 in_position, const XMFLOAT3& in_pos,
+			const XMFLOAT3& in_front, const XMFLOAT3& in_top)
+		{
+			const Emitter& emitter = m_emitters[in_emitter];
+			assert(emitter.live && in_position < emitter.positionCount);
+
+			// Wwise wants orthonormal vectors: normalize front, then remove its part
+			// from top.
+			XMFLOAT3 front = Normalize(in_front, XMFLOAT3(0.0f, 0.0f, 1.0f));
+			float d = in_top.x * front.x + in_top.y * front.y + in_top.z * front.z;
+			XMFLOAT3 top = Normalize(XMFLOAT3(in_top.x - d * front.x, in_top.y - d * front.y, in_top.z - d * front.z),
+				XMFLOAT3(0.0f, 1.0f, 0.0f));
+
+			AkUInt32 i = emitter.firstPosition + in_position;
+			m_pos[i] = in_pos;
+			m_front[i] = front;
+			m_top[i] = top;
+		}
+
+		void AudioTransformSync::SetTransform(AkUInt32 in_emitter, AkUInt16 in_position, const XMFLOAT4X4& in_world)
+		{
+			SetTransform(in_emitter, in_position,
+				XMFLOAT3(in_world._41, in_world._42, in_world._43),
+				XMFLOAT3(in_world._31, in_world._32, in_world._33),
+				XMFLOAT3(in_world._21, in_world._22, in_world._23));
+		}
+
+		bool AudioTransformSync::Changed(const Emitter& in_emitter) const
+		{
+			if (!in_emitter.sent)
+				return true;
+
+			float positionEpsilonSq = m_settings.positionEpsilon * m_settings.positionEpsilon;
+			float orientationEpsilonSq = m_settings.orientationEpsilon * m_settings.orientationEpsilon;
+
+			AkUInt32 end = in_emitter.firstPosition + in_emitter.positionCount;
+			for (AkUInt32 i = in_emitter.firstPosition; i < end; ++i)
+			{
+				if (DistanceSq(m_pos[i], m_sentPos[i]) > positionEpsilonSq ||
+					DistanceSq(m_front[i], m_sentFront[i]) > orientationEpsilonSq ||
+					DistanceSq(m_top[i], m_sentTop[i]) > orientationEpsilonSq)
+					return true;
+			}
+			return false;
+		}
+
+		void AudioTransformSync::Submit(IAudioPositionSink& io_sink, const AkUInt8* in_due, AkUInt32 in_dueCount)
+		{
+			ZoneScoped;
+
+			m_stats = AudioTransformSyncStats();
+
+			for (AkUInt32 index = 0; index < (AkUInt32)m_emitters.size(); ++index)
+			{
+				Emitter& emitter = m_emitters[index];
+				if (!emitter.live)
+					continue;
+
+				++m_stats.emitters;
+				if (emitter.sent && index < in_dueCount && in_due[index] == 0)
+				{
+					++m_stats.throttled;
+					continue;
+				}
+				if (!Changed(emitter))
+					continue;
+
+				m_scratch.resize(emitter.positionCount);
+				AkUInt32 first = emitter.firstPosition;
+				for (AkUInt16 p = 0; p < emitter.positionCount; ++p)
+				{
+					AkUInt32 i = first + p;
+					m_scratch[p].Set(m_pos[i].x, m_pos[i].y, m_pos[i].z,
+						m_front[i].x, m_front[i].y, m_front[i].z,
+						m_top[i].x, m_top[i].y, m_top[i].z);
+
+					m_sentPos[i] = m_pos[i];
+					m_sentFront[i] = m_front[i];
+					m_sentTop[i] = m_top[i];
+				}
+
+				if (emitter.positionCount == 1)
+					io_sink.SetPosition(emitter.gameObj, m_scratch[0]);
+				else
+					io_sink.SetMultiplePositions(emitter.gameObj, m_scratch.data(), emitter.positionCount, emitter.type);
+
+				emitter.sent = true;
+				++m_stats.sent;
+			}
+
+			TracyPlot("Audio emitters sent", (int64_t)m_stats.sent);
+		}
+	}
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+#include <AK/SoundEngine/Common/AkTypes.h>
+#include <AK/SoundEngine/Common/AkSoundEngine.h>
+
+// Pushes world transforms of audio emitters (and the listener) to the sound engine
+// once per frame.
+//
+// An emitter is one game object with one or more positions.  Several positions let
+// a group of sources share a game object (a crowd, a row of torches); they are sent
+// with a single SetMultiplePositions() call, which is much cheaper than a game
+// object per source.  Each frame the caller writes the current transforms with
+// SetTransform(); Submit() compares them with what was last sent and only emitters
+// that moved or turned beyond the thresholds are sent again.
+//
+// The sound engine is reached through IAudioPositionSink, so the stage runs without
+// Wwise (NullAudioPositionSink).
+
+namespace myengine
+{
+	namespace audio
+	{
+		class IAudioPositionSink
+		{
+		public:
+			virtual ~IAudioPositionSink() {}
+
+			virtual void SetPosition(AkGameObjectID in_gameObj, const AkSoundPosition& in_position) = 0;
+
+			virtual void SetMultiplePositions(AkGameObjectID in_gameObj, const AkSoundPosition* in_positions,
+				AkUInt16 in_count, AK::SoundEngine::MultiPositionType in_type) = 0;
+		};
+
+		// Forwards to AK::SoundEngine.
+		class AkAudioPositionSink : public IAudioPositionSink
+		{
+		public:
+			void SetPosition(AkGameObjectID in_gameObj, const AkSoundPosition& in_position) override;
+
+			void SetMultiplePositions(AkGameObjectID in_gameObj, const AkSoundPosition* in_positions,
+				AkUInt16 in_count, AK::SoundEngine::MultiPositionType in_type) override;
+		};
+
+		// Counts calls and drops them; used when the sound engine is not initialized.
+		class NullAudioPositionSink : public IAudioPositionSink
+		{
+		public:
+			void SetPosition(AkGameObjectID, const AkSoundPosition&) override { ++m_calls; }
+
+			void SetMultiplePositions(AkGameObjectID, const AkSoundPosition*, AkUInt16,
+				AK::SoundEngine::MultiPositionType) override { ++m_calls; }
+
+			AkUInt32 GetCallCount() const { return m_calls; }
+
+		private:
+			AkUInt32 m_calls = 0;
+		};
+
+		struct AudioTransformSyncSettings
+		{
+			float positionEpsilon = 0.01f;		// world units
+			float orientationEpsilon = 0.01f;	// length of the change of a unit front/top vector, about 0.6 degrees
+		};
+
+		struct AudioTransformSyncStats
+		{
+			AkUInt32 emitters = 0;		// live emitters tested by the last Submit()
+			AkUInt32 sent = 0;			// emitters sent by the last Submit(), one sink call each
+			AkUInt32 throttled = 0;		// emitters skipped because the due mask said so
+		};
+
+		class AudioTransformSync
+		{
+		public:
+			static const AkUInt32 INVALID_EMITTER = ~0u;
+
+			explicit AudioTransformSync(const AudioTransformSyncSettings& in_settings = AudioTransformSyncSettings());
+
+			void SetSettings(const AudioTransformSyncSettings& in_settings) { m_settings = in_settings; }
+
+			// Returns the emitter index, valid until RemoveEmitter().  The game object
+			// must already be registered.  Emitters are always sent on their first
+			// Submit().
+			AkUInt32 AddEmitter(AkGameObjectID in_gameObj, AkUInt16 in_positionCount = 1,
+				AK::SoundEngine::MultiPositionType in_type = AK::SoundEngine::MultiPositionType_MultiDirections);
+			void RemoveEmitter(AkUInt32 in_emitter);
+
+			// Position and orientation of one of the emitter's positions.  front and top
+			// need not be normalized or exactly orthogonal.
+			void SetTransform(AkUInt32 in_emitter, AkUInt16 in_position, const DirectX::XMFLOAT3& in_pos,
+				const DirectX::XMFLOAT3& in_front, const DirectX::XMFLOAT3& in_top);
+
+			// Takes position, front (+z) and top (+y) from a row-vector world matrix.
+			void SetTransform(AkUInt32 in_emitter, AkUInt16 in_position, const DirectX::XMFLOAT4X4& in_world);
+
+			// Sends every emitter that changed since it was last sent.  With a due mask
+			// (one byte per emitter index, see AudioLodManager), emitters whose byte is
+			// zero are skipped this time, unless they were never sent; indices past
+			// in_dueCount are always due.
+			void Submit(IAudioPositionSink& io_sink, const AkUInt8* in_due = nullptr, AkUInt32 in_dueCount = 0);
+
+			const AudioTransformSyncStats& GetStats() const { return m_stats; }
+
+		private:
+			struct Emitter
+			{
+				AkGameObjectID gameObj;
+				AkUInt32 firstPosition;
+				AkUInt16 positionCount;
+				AK::SoundEngine::MultiPositionType type;
+				bool live;
+				bool sent;		// false until the first Submit() after AddEmitter()
+			};
+
+			bool Changed(const Emitter& in_emitter) const;
+
+		private:
+			AudioTransformSyncSettings m_settings;
+
+			std::vector<Emitter> m_emitters;
+			std::vector<AkUInt32> m_freeEmitters;	// slots whose position ranges can be reused
+
+			// One entry per position, in emitter order: current and last sent.
+			std::vector<DirectX::XMFLOAT3> m_pos, m_front, m_top;
+			std::vector<DirectX::XMFLOAT3> m_sentPos, m_sentFront, m_sentTop;
+
+			std::vector<AkSoundPosition> m_scratch;
+			AudioTransformSyncStats m_stats;
+		};
+	}
+}
@@ -0,0 +1,356 @@
+#include <cassert>
+#include <memory>
+#include <tracy/Tracy.hpp>
+#include <AK/SoundEngine/Common/AkSoundEngine.h>
+#include "bankmanager.h"
+
+namespace myengine
+{
+	namespace audio
+	{
+		AKRESULT AkBankLoader::LoadBankAsync(const char* in_pszName, AkBankCallbackFunc in_pfnCallback,
+			void* in_pCookie, AkBankID& out_bankID)
+		{
+			return AK::SoundEngine::LoadBank(in_pszName, in_pfnCallback, in_pCookie, out_bankID);
+		}
+
+		AKRESULT AkBankLoader::UnloadBankAsync(const char* in_pszName, AkBankCallbackFunc in_pfnCallback,
+			void* in_pCookie)
+		{
+			return AK::SoundEngine::UnloadBank(in_pszName, nullptr, in_pfnCallback, in_pCookie);
+		}
+
+		BankManager::BankManager(std::unique_ptr<IBankLoader> in_loader)
+			: m_loader(std::move(in_loader))
+		{
+		}
+
+		BankManager::Bank& BankManager::GetBank(const std::string& in_bank)
+		{
+			Bank& bank = m_banks[in_bank];
+			if (bank.owner == nullptr)
+			{
+				bank.owner = this;
+				bank.name = in_bank;
+			}
+			return bank;
+		}
+
+		const BankManager::Bank* BankManager::FindBank(const std::string& in_bank) const
+		{
+			auto it = m_banks.find(in_bank);
+			return it != m_banks.end() ? &it->second : nullptr;
+		}
+
+		void BankManager::DeclareBank(const std::string& in_bank, const std::vector<std::string>& in_dependencies)
+		{
+			Bank& bank = GetBank(in_bank);
+			assert(!bank.holdsDependencies && "declare dependencies before acquiring the bank");
+			bank.dependencies = in_dependencies;
+		}
+
+		void BankManager::AcquireDependencies(Bank& io_bank)
+		{
+			if (io_bank.holdsDependencies)
+				return;
+
+			io_bank.holdsDependencies = true;
+			for (const std::string& dependency : io_bank.dependencies)
+				Acquire(dependency);
+		}
+
+		void BankManager::ReleaseDependencies(Bank& io_bank)
+		{
+			if (!io_bank.holdsDependencies)
+				return;
+
+			io_bank.holdsDependencies = false;
+			for (const std::string& dependency : io_bank.dependencies)
+				Release(dependency);
+		}
+
+		void BankManager::Acquire(const std::string& in_bank, BankCallback in_callback)
+		{
+			Bank& bank = GetBank(in_bank);
+			++bank.refs;
+			AcquireDependencies(bank);
+
+			switch (bank.state)
+			{
+			case BankState::PendingUnload:
+				bank.state = BankState::Loaded;
+				// fall through
+			case BankState::Loaded:
+				if (in_callback)
+				{
+					std::string name = bank.name;
+					m_ready.push_back([in_callback, name]() { in_callback(name, AK_Success); });
+				}
+				break;
+
+			case BankState::Failed:
+				if (bank.refs > 1)
+				{
+					if (in_callback)
+					{
+						std::string name = bank.name;
+						AKRESULT result = bank.result;
+						m_ready.push_back([in_callback, name, result]() { in_callback(name, result); });
+					}
+					break;
+				}
+
+				// Nobody held it since it failed; try again.
+				bank.state = BankState::Unloaded;
+				if (in_callback)
+					bank.waiters.push_back(in_callback);
+				break;
+
+			default:
+				// Unloaded, Loading or Unloading: Update() starts (or restarts) the load.
+				if (in_callback)
+					bank.waiters.push_back(in_callback);
+				break;
+			}
+		}
+
+		void BankManager::Release(const std::string& in_bank)
+		{
+			Bank& bank = GetBank(in_bank);
+			assert(bank.refs > 0);
+			if (bank.refs == 0 || --bank.refs > 0)
+				return;
+
+			switch (bank.state)
+			{
+			case BankState::Loaded:
+				bank.state = BankState::PendingUnload;
+				bank.unloadAt = Clock::now() + m_unloadDelay;
+				break;
+
+			case BankState::Unloaded:
+			case BankState::Failed:
+				// Never loaded, so nothing to wait for.
+				ReleaseDependencies(bank);
+				break;
+
+			default:
+				// Loading: handled when it completes.  Unloading: already on its way.
+				break;
+			}
+		}
+
+		void BankManager::SetPreloadList(const std::string& in_level, const std::vector<std::string>& in_banks)
+		{
+			m_levels[in_level] = in_banks;
+		}
+
+		void BankManager::PreloadLevel(const std::string& in_level, LevelCallback in_callback)
+		{
+			const std::vector<std::string>& banks = m_levels[in_level];
+
+			// Shared by the bank callbacks; the last one to finish reports the level.
+			struct Pending
+			{
+				size_t remaining;
+				AKRESULT result;
+			};
+			auto pending = std::make_shared<Pending>(Pending{ banks.size(), AK_Success });
+
+			if (banks.empty())
+			{
+				if (in_callback)
+					m_ready.push_back([in_callback, in_level]() { in_callback(in_level, AK_Success); });
+				return;
+			}
+
+			for (const std::string& bank : banks)
+			{
+				Acquire(bank, [pending, in_callback, in_level](const std::string&, AKRESULT in_result) {
+					if (in_result != AK_Success && pending->result == AK_Success)
+						pending->result = in_result;
+					if (--pending->remaining == 0 && in_callback)
+						in_callback(in_level, pending->result);
+				});
+			}
+		}
+
+		void BankManager::ReleaseLevel(const std::string& in_level)
+		{
+			auto it = m_levels.find(in_level);
+			if (it == m_levels.end())
+				return;
+
+			for (const std::string& bank : it->second)
+				Release(bank);
+		}
+
+		void BankManager::StartLoad(Bank& io_bank)
+		{
+			io_bank.state = BankState::Loading;
+			io_bank.requested = Clock::now();
+			++m_stats.loadsStarted;
+			++m_stats.loadsInFlight;
+
+			AKRESULT result = m_loader->LoadBankAsync(io_bank.name.c_str(), LoadCallback, &io_bank, io_bank.id);
+			if (result != AK_Success)
+			{
+				// The request was refused, so no callback will come.
+				std::lock_guard<std::mutex> lock(m_completionLock);
+				m_completions.push_back({ &io_bank, result, false });
+			}
+		}
+
+		void BankManager::StartUnload(Bank& io_bank)
+		{
+			io_bank.state = BankState::Unloading;
+
+			AKRESULT result = m_loader->UnloadBankAsync(io_bank.name.c_str(), UnloadCallback, &io_bank);
+			if (result != AK_Success)
+			{
+				std::lock_guard<std::mutex> lock(m_completionLock);
+				m_completions.push_back({ &io_bank, result, true });
+			}
+		}
+
+		void BankManager::Finish(Bank& io_bank, AKRESULT in_result)
+		{
+			io_bank.result = in_result;
+			io_bank.state = in_result == AK_Success ? BankState::Loaded : BankState::Failed;
+
+			std::string name = io_bank.name;
+			for (BankCallback& callback : io_bank.waiters)
+				m_ready.push_back([callback, name, in_result]() { callback(name, in_result); });
+			io_bank.waiters.clear();
+
+			if (io_bank.refs > 0)
+				return;
+
+			// Released while loading.
+			if (io_bank.state == BankState::Loaded)
+			{
+				io_bank.state = BankState::PendingUnload;
+				io_bank.unloadAt = Clock::now() + m_unloadDelay;
+			}
+			else
+			{
+				ReleaseDependencies(io_bank);
+			}
+		}
+
+		void BankManager::LoadCallback(AkUInt32, const void*, AKRESULT in_eLoadResult, void* in_pCookie)
+		{
+			Bank* bank = static_cast<Bank*>(in_pCookie);
+			std::lock_guard<std::mutex> lock(bank->owner->m_completionLock);
+			bank->owner->m_completions.push_back({ bank, in_eLoadResult, false });
+		}
+
+		void BankManager::UnloadCallback(AkUInt32, const void*, AKRESULT in_eLoadResult, void* in_pCookie)
+		{
+			Bank* bank = static_cast<Bank*>(in_pCookie);
+			std::lock_guard<std::mutex> lock(bank->owner->m_completionLock);
+			bank->owner->m_completions.push_back({ bank, in_eLoadResult, true });
+		}
+
+		void BankManager::Update()
+		{
+			ZoneScoped;
+			Clock::time_point now = Clock::now();
+
+			{
+				std::lock_guard<std::mutex> lock(m_completionLock);
+				m_completionBatch.swap(m_completions);
+			}
+
+			for (const Completion& completion : m_completionBatch)
+			{
+				Bank& bank = *completion.bank;
+				if (completion.unload)
+				{
+					// Even a failed unload leaves nothing usable behind.
+					bank.state = BankState::Unloaded;
+					bank.id = AK_INVALID_BANK_ID;
+					bank.loadMs = 0.0;
+					++m_stats.unloads;
+					if (bank.refs == 0)
+						ReleaseDependencies(bank);
+					continue;
+				}
+
+				--m_stats.loadsInFlight;
+				if (completion.result == AK_Success)
+				{
+					bank.loadMs = std::chrono::duration<double, std::milli>(now - bank.requested).count();
+					++m_stats.loadsSucceeded;
+					m_stats.totalLoadMs += bank.loadMs;
+					m_stats.maxLoadMs = bank.loadMs > m_stats.maxLoadMs ? bank.loadMs : m_stats.maxLoadMs;
+				}
+				else
+				{
+					++m_stats.loadsFailed;
+				}
+				Finish(bank, completion.result);
+			}
+			m_completionBatch.clear();
+
+			// Start loads whose dependencies are in, and unloads whose delay ran out.
+			// Starting a load never adds banks, so iterating the map is safe.
+			for (auto& entry : m_banks)
+			{
+				Bank& bank = entry.second;
+
+				if (bank.state == BankState::PendingUnload && now >= bank.unloadAt)
+				{
+					StartUnload(bank);
+					continue;
+				}
+
+				if (bank.state != BankState::Unloaded || bank.refs == 0)
+					continue;
+
+				bool ready = true;
+				AKRESULT dependencyResult = AK_Success;
+				for (const std::string& dependency : bank.dependencies)
+				{
+					const Bank* dep = FindBank(dependency);
+					BankState depState = dep != nullptr ? dep->state : BankState::Unloaded;
+					if (depState == BankState::Failed)
+						dependencyResult = dep->result;
+					else if (depState != BankState::Loaded)
+						ready = false;
+				}
+
+				if (dependencyResult != AK_Success)
+					Finish(bank, dependencyResult);
+				else if (ready)
+					StartLoad(bank);
+			}
+
+			TracyPlot("Banks loading", (int64_t)m_stats.loadsInFlight);
+
+			// Callbacks may acquire or release banks; those take effect next Update().
+			std::vector<std::function<void()>> ready;
+			ready.swap(m_ready);
+			for (auto& callback : ready)
+				callback();
+		}
+
+		BankState BankManager::GetState(const std::string& in_bank) const
+		{
+			const Bank* bank = FindBank(in_bank);
+			return bank != nullptr ? bank->state : BankState::Unloaded;
+		}
+
+		AkBankID BankManager::GetBankID(const std::string& in_bank) const
+		{
+			const Bank* bank = FindBank(in_bank);
+			return bank != nullptr && bank->state == BankState::Loaded ? bank->id : AK_INVALID_BANK_ID;
+		}
+
+		double BankManager::GetLoadMs(const std::string& in_bank) const
+		{
+			const Bank* bank = FindBank(in_bank);
+			return bank != nullptr ? bank->loadMs : 0.0;
+		}
+	}
+}
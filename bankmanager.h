@@ -0,0 +1,168 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <AK/SoundEngine/Common/AkTypes.h>
+#include <AK/SoundEngine/Common/AkCallback.h>
+
+// Asynchronous, reference-counted SoundBank loading.
+//
+//   -Acquire() takes a reference on a bank and starts loading it in the background
+//    if needed; the callback runs once the bank is loaded (or failed).  Release()
+//    drops the reference.  A bank nobody references is unloaded after
+//    unloadDelay, so a bank released and re-acquired across a level transition is
+//    not reloaded.
+//   -DeclareBank() lists the banks a bank needs (Init.bnk, shared media banks).
+//    They are acquired with it, loaded before it, and released only after it has
+//    been unloaded.
+//   -SetPreloadList()/PreloadLevel()/ReleaseLevel() acquire and release the banks
+//    of a level as a group.
+//
+// All members must be called from one thread, the one that calls Update().  The
+// sound engine reports completions on its bank thread; they are queued and
+// handled, and the callbacks run, in the next Update().
+
+namespace myengine
+{
+	namespace audio
+	{
+		// Issues the actual load and unload requests.  The callback may run on any
+		// thread, or before the call returns.
+		class IBankLoader
+		{
+		public:
+			virtual ~IBankLoader() {}
+
+			virtual AKRESULT LoadBankAsync(const char* in_pszName, AkBankCallbackFunc in_pfnCallback,
+				void* in_pCookie, AkBankID& out_bankID) = 0;
+
+			virtual AKRESULT UnloadBankAsync(const char* in_pszName, AkBankCallbackFunc in_pfnCallback,
+				void* in_pCookie) = 0;
+		};
+
+		// Forwards to AK::SoundEngine.
+		class AkBankLoader : public IBankLoader
+		{
+		public:
+			AKRESULT LoadBankAsync(const char* in_pszName, AkBankCallbackFunc in_pfnCallback,
+				void* in_pCookie, AkBankID& out_bankID) override;
+
+			AKRESULT UnloadBankAsync(const char* in_pszName, AkBankCallbackFunc in_pfnCallback,
+				void* in_pCookie) override;
+		};
+
+		enum class BankState
+		{
+			Unloaded,
+			Loading,
+			Loaded,
+			Failed,
+			PendingUnload,	// loaded, unreferenced, waiting for unloadDelay
+			Unloading
+		};
+
+		struct BankManagerStats
+		{
+			AkUInt32 loadsStarted = 0;
+			AkUInt32 loadsSucceeded = 0;
+			AkUInt32 loadsFailed = 0;
+			AkUInt32 unloads = 0;
+			AkUInt32 loadsInFlight = 0;
+			double totalLoadMs = 0.0;		// request to completion, successful loads
+			double maxLoadMs = 0.0;
+		};
+
+		class BankManager
+		{
+		public:
+			typedef std::function<void(const std::string& in_bank, AKRESULT in_result)> BankCallback;
+			typedef std::function<void(const std::string& in_level, AKRESULT in_result)> LevelCallback;
+
+			explicit BankManager(std::unique_ptr<IBankLoader> in_loader);
+			BankManager(const BankManager&) = delete;
+			BankManager& operator=(const BankManager&) = delete;
+
+			void SetUnloadDelay(std::chrono::milliseconds in_delay) { m_unloadDelay = in_delay; }
+
+			// Banks that must be loaded before in_bank.  Declare before acquiring.
+			void DeclareBank(const std::string& in_bank, const std::vector<std::string>& in_dependencies);
+
+			void Acquire(const std::string& in_bank, BankCallback in_callback = BankCallback());
+			void Release(const std::string& in_bank);
+
+			void SetPreloadList(const std::string& in_level, const std::vector<std::string>& in_banks);
+
+			// Acquires every bank of the level; the callback runs when all of them are
+			// loaded, with the first failure if any failed.
+			void PreloadLevel(const std::string& in_level, LevelCallback in_callback = LevelCallback());
+			void ReleaseLevel(const std::string& in_level);
+
+			// Handles completions, starts loads whose dependencies are ready, unloads
+			// banks whose delay expired, and runs callbacks.
+			void Update();
+
+			BankState GetState(const std::string& in_bank) const;
+			AkBankID GetBankID(const std::string& in_bank) const;
+			double GetLoadMs(const std::string& in_bank) const;	// 0 until loaded
+			const BankManagerStats& GetStats() const { return m_stats; }
+
+		private:
+			typedef std::chrono::steady_clock Clock;
+
+			struct Bank
+			{
+				BankManager* owner = nullptr;
+				std::string name;
+				std::vector<std::string> dependencies;
+				AkUInt32 refs = 0;
+				bool holdsDependencies = false;
+				BankState state = BankState::Unloaded;
+				AkBankID id = AK_INVALID_BANK_ID;
+				AKRESULT result = AK_Success;
+				Clock::time_point requested;
+				Clock::time_point unloadAt;
+				double loadMs = 0.0;
+				std::vector<BankCallback> waiters;
+			};
+
+			struct Completion
+			{
+				Bank* bank;
+				AKRESULT result;
+				bool unload;
+			};
+
+			Bank& GetBank(const std::string& in_bank);
+			const Bank* FindBank(const std::string& in_bank) const;
+			void AcquireDependencies(Bank& io_bank);
+			void ReleaseDependencies(Bank& io_bank);
+			void StartLoad(Bank& io_bank);
+			void StartUnload(Bank& io_bank);
+			void Finish(Bank& io_bank, AKRESULT in_result);
+
+			static void LoadCallback(AkUInt32 in_bankID, const void* in_pInMemoryBankPtr, AKRESULT in_eLoadResult, void* in_pCookie);
+			static void UnloadCallback(AkUInt32 in_bankID, const void* in_pInMemoryBankPtr, AKRESULT in_eLoadResult, void* in_pCookie);
+
+		private:
+			std::unique_ptr<IBankLoader> m_loader;
+			std::chrono::milliseconds m_unloadDelay{ 5000 };
+
+			// Entries are never erased: in-flight requests point at them.
+			std::unordered_map<std::string, Bank> m_banks;
+			std::unordered_map<std::string, std::vector<std::string>> m_levels;
+
+			std::mutex m_completionLock;
+			std::vector<Completion> m_completions;
+			std::vector<Completion> m_completionBatch;
+
+			// Callbacks to run at the end of Update(), so they never run re-entrantly.
+			std::vector<std::function<void()>> m_ready;
+
+			BankManagerStats m_stats;
+		};
+	}
+}
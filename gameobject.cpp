@@ -9,10 +9,117 @@ AudioGameObject::AudioGameObject(AkGameObjectID id): m_id(id)
 {
 }
 
-bool AudioGameObject::PostEvent(std::string eventPath)
+bool AudioGameObject::PostEvent(AkUniqueID event_id)
 {
-	AkPlayingID playing_id = AK::SoundEngine::PostEvent(eventPath.c_str(), m_id);
-	return true;
+	AkPlayingID playing_id = AK::SoundEngine::PostEvent(event_id, m_id);
+	return playing_id != AK_INVALID_PLAYING_ID;
+}
+
+bool AudioGameObject::PostEvent(const std::string& eventPath)
+{
+	return PostEvent(InternAudioID(eventPath));
+}
+
+AudioGameObjectPool::AudioGameObjectPool(AkGameObjectID first_id): m_first_id(first_id)
+{
+}
+
+void AudioGameObjectPool::Allocate(AkUInt32 count, AudioObjectHandle* out_handles)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	for (AkUInt32 i = 0; i < count; ++i)
+	{
+		AkUInt32 index;
+		if (!m_free.empty())
+		{
+			index = m_free.front();
+			m_free.pop_front();
+		}
+		else
+		{
+			index = m_slot_count++;
+			if (index / CHUNK_SIZE == m_chunks.size())
+				m_chunks.push_back(std::make_unique<Chunk>());
+		}
+
+		Slot& slot = SlotAt(index);
+		if (++slot.generation == 0)
+			slot.generation = 1;
+		slot.live = true;
+		slot.object = AudioGameObject(m_first_id + index);
+
+		out_handles[i].index = index;
+		out_handles[i].generation = slot.generation;
+	}
+	m_live_count += count;
+}
+
+AudioObjectHandle AudioGameObjectPool::Allocate()
+{
+	AudioObjectHandle handle;
+	Allocate(1, &handle);
+	return handle;
+}
+
+AkUInt32 AudioGameObjectPool::Free(const AudioObjectHandle* handles, AkUInt32 count)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	AkUInt32 freed = 0;
+	for (AkUInt32 i = 0; i < count; ++i)
+	{
+		Slot* slot = LiveSlot(handles[i]);
+		if (slot == nullptr)
+			continue;
+
+		slot->live = false;
+		slot->object = AudioGameObject();
+		m_free.push_back(handles[i].index);
+		++freed;
+	}
+	m_live_count -= freed;
+	return freed;
+}
+
+AudioGameObject* AudioGameObjectPool::Get(AudioObjectHandle handle)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	Slot* slot = LiveSlot(handle);
+	return slot != nullptr ? &slot->object : nullptr;
+}
+
+AudioObjectHandle AudioGameObjectPool::Find(AkGameObjectID id)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	AudioObjectHandle handle;
+	if (id < m_first_id || id - m_first_id >= m_slot_count)
+		return handle;
+
+	AkUInt32 index = (AkUInt32)(id - m_first_id);
+	const Slot& slot = SlotAt(index);
+	if (slot.live)
+	{
+		handle.index = index;
+		handle.generation = slot.generation;
+	}
+	return handle;
+}
+
+AkUInt32 AudioGameObjectPool::LiveCount()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_live_count;
+}
+
+AudioGameObjectPool::Slot* AudioGameObjectPool::LiveSlot(AudioObjectHandle handle)
+{
+	if (!handle.IsValid() || handle.index >= m_slot_count)
+		return nullptr;
+
+	Slot& slot = SlotAt(handle.index);
+	return (slot.live && slot.generation == handle.generation) ? &slot : nullptr;
 }
 
 }
@@ -1,5 +1,9 @@
-
+#pragma once
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <AK/SoundEngine/Common/AkTypes.h>
 
 #include <AK/SoundEngine/Common/AkMemoryMgr.h>		// Memory Manager
@@ -12,6 +16,7 @@
 #include <AK/SoundEngine/Common/AkCallback.h>    // Callback
 #include "../Common/AkFilePackageLowLevelIO.h"
 #include "AkDefaultIOHookDeferred.h"
+#include "audioid.h"
 
 namespace myengine
 {
@@ -20,13 +25,84 @@ namespace myengine
 		class AudioGameObject
 		{
 		public:
-			AudioGameObject(AkGameObjectID id);
+			AudioGameObject(AkGameObjectID id = AK_INVALID_GAME_OBJECT);
+
+			AkGameObjectID GetID() const { return m_id; }
+
+			bool PostEvent(AkUniqueID event_id);
 
-			bool PostEvent(std::string event_name);
+			// Interns the name on first use; prefer the ID overload on hot paths.
+			bool PostEvent(const std::string& event_name);
 
 		private:
 			AkGameObjectID m_id;
 		};
 
+		// Refers to a pooled AudioGameObject.  A handle goes stale when its object is
+		// unregistered, even if the slot (and its game object ID) is reused later.
+		struct AudioObjectHandle
+		{
+			AkUInt32 index = 0;
+			AkUInt32 generation = 0;	// 0 is never live
+
+			bool IsValid() const { return generation != 0; }
+			bool operator==(const AudioObjectHandle& other) const { return index == other.index && generation == other.generation; }
+			bool operator!=(const AudioObjectHandle& other) const { return !(*this == other); }
+		};
+
+		// Slot storage for AudioGameObjects.  Slot i always has game object ID
+		// first_id + i, so freeing a slot recycles its ID.  Freed slots are reused in
+		// FIFO order, which keeps a recycled ID idle for as long as possible.
+		// Objects live in fixed-size chunks, so pointers from Get() stay valid until
+		// the object is freed.  All members are thread safe.
+		class AudioGameObjectPool
+		{
+		public:
+			static const AkUInt32 CHUNK_SIZE = 256;
+
+			explicit AudioGameObjectPool(AkGameObjectID first_id);
+			AudioGameObjectPool(const AudioGameObjectPool&) = delete;
+			AudioGameObjectPool& operator=(const AudioGameObjectPool&) = delete;
+
+			// Reserves count slots under one lock.
+			void Allocate(AkUInt32 count, AudioObjectHandle* out_handles);
+			AudioObjectHandle Allocate();
+
+			// Stale and invalid handles are ignored.  Returns how many were freed.
+			AkUInt32 Free(const AudioObjectHandle* handles, AkUInt32 count);
+
+			// nullptr if the handle is stale.
+			AudioGameObject* Get(AudioObjectHandle handle);
+
+			// The live handle for a game object ID from this pool, or an invalid one.
+			AudioObjectHandle Find(AkGameObjectID id);
+
+			AkUInt32 LiveCount();
+
+		private:
+			struct Slot
+			{
+				AudioGameObject object;
+				AkUInt32 generation = 0;	// current generation if live, last one otherwise
+				bool live = false;
+			};
+
+			struct Chunk
+			{
+				Slot slots[CHUNK_SIZE];
+			};
+
+			Slot& SlotAt(AkUInt32 index) { return m_chunks[index / CHUNK_SIZE]->slots[index % CHUNK_SIZE]; }
+			Slot* LiveSlot(AudioObjectHandle handle);
+
+		private:
+			std::mutex m_lock;
+			const AkGameObjectID m_first_id;
+			std::vector<std::unique_ptr<Chunk>> m_chunks;
+			AkUInt32 m_slot_count = 0;
+			std::deque<AkUInt32> m_free;
+			AkUInt32 m_live_count = 0;
+		};
+
 	}
 }
\ No newline at end of file
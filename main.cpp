@@ -3,6 +3,7 @@
 //***************************************************************************************
 
 #include <iostream>
+#include <cstring>
 #include "Common/d3dApp.h"
 #include "Common/MathHelper.h"
 #include "Common/UploadBuffer.h"
@@ -185,7 +186,9 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
 
 	myengine::audio::Audio& instance = myengine::audio::Audio::Instance();
     instance.LoadBnk("Init.bnk");
-	instance.LoadBnk("Reflect.bnk");
+	instance.Banks().Acquire("Reflect.bnk");
+	if (strstr(cmdLine, "-audiothread") != nullptr)
+		instance.StartAudioThread();
 
     std::ofstream out("output.txt");
     auto old_buf = std::cout.rdbuf(out.rdbuf()); // 沢ض
@@ -200,12 +203,19 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
     {
         SkinnedMeshApp theApp(hInstance);
         if (!theApp.Initialize())
+        {
+            instance.StopAudioThread();
             return 0;
+        }
 
-        return theApp.Run();
+        // Stop rendering audio before the app (and its emitters) goes away.
+        int result = theApp.Run();
+        instance.StopAudioThread();
+        return result;
     }
     catch (DxException& e)
     {
+        instance.StopAudioThread();
         MessageBox(nullptr, e.ToString().c_str(), L"HR Failed", MB_OK);
         return 0;
     }
@@ -0,0 +1,224 @@
+#include <cstring>
+#include <limits.h>
+#include <vector>
+#include "Test.h"
+#include "AkPosixTestFile.h"
+#include "AkAsyncIoBackend.h"
+
+namespace
+{
+	const AkUInt32 FILE_SIZE = 256 * 1024 + 123;
+
+	// Both backends; io_uring is left out where the kernel or the sandbox
+	// does not allow it.
+	std::vector<CAkAsyncIoBackend*> CreateBackends()
+	{
+		std::vector<CAkAsyncIoBackend*> backends;
+		const AkAsyncIoBackendType types[] = { AkAsyncIoBackend_IoUring, AkAsyncIoBackend_ThreadPool };
+		for ( AkUInt32 i = 0; i < sizeof( types ) / sizeof( types[0] ); ++i )
+		{
+			AkAsyncIoSettings settings;
+			settings.uQueueDepth = 8;
+			settings.uNumThreads = 2;
+			settings.eType = types[i];
+			CAkAsyncIoBackend * pBackend = CAkAsyncIoBackend::Create( settings );
+			if ( pBackend )
+				backends.push_back( pBackend );
+		}
+		CHECK( !backends.empty() && strcmp( backends.back()->GetName(), "thread pool" ) == 0 );
+		return backends;
+	}
+
+	void DestroyBackends( std::vector<CAkAsyncIoBackend*> & io_backends )
+	{
+		for ( size_t i = 0; i < io_backends.size(); ++i )
+			CAkAsyncIoBackend::Destroy( io_backends[i] );
+		io_backends.clear();
+	}
+
+	AkAsyncIoRequest ReadRequest( const CAkTestFile & in_file, void * in_pBuffer, AkUInt64 in_uOffset, AkUInt32 in_uSize, AkTestCompletion & in_completion )
+	{
+		AkAsyncIoRequest request;
+		memset( &request, 0, sizeof( request ) );
+		request.fd = in_file.Fd();
+		request.pBuffer = in_pBuffer;
+		request.uOffset = in_uOffset;
+		request.uSize = in_uSize;
+		request.pfnCompletion = AkTestCompletion::OnComplete;
+		request.pCookie = &in_completion;
+		return request;
+	}
+
+	// Submits one request and waits for it. True if it completes once with
+	// in_eExpected.
+	bool Transfer( CAkAsyncIoBackend * in_pBackend, AkAsyncIoRequest & io_request, AkTestCompletion & in_completion, AKRESULT in_eExpected = AK_Success )
+	{
+		in_pBackend->Submit( &io_request, 1 );
+		return in_completion.Wait() == in_eExpected && in_completion.calls.load() == 1;
+	}
+
+	// Reads [in_uOffset, in_uOffset + in_uSize) into in_pBuffer and compares
+	// it with the file.
+	bool ReadMatches( CAkAsyncIoBackend * in_pBackend, const CAkTestFile & in_file, AkUInt8 * in_pBuffer, AkUInt64 in_uOffset, AkUInt32 in_uSize )
+	{
+		memset( in_pBuffer, 0xCD, in_uSize );
+		AkTestCompletion completion;
+		AkAsyncIoRequest request = ReadRequest( in_file, in_pBuffer, in_uOffset, in_uSize, completion );
+		return Transfer( in_pBackend, request, completion ) && memcmp( in_pBuffer, in_file.Data( in_uOffset ), in_uSize ) == 0;
+	}
+}
+
+TEST_CASE(AsyncIoBackend_ReadsMatchFile)
+{
+	CAkTestFile file( FILE_SIZE );
+	CHECK( file.IsValid() );
+	std::vector<CAkAsyncIoBackend*> backends = CreateBackends();
+	for ( size_t b = 0; b < backends.size(); ++b )
+	{
+		std::vector<AkUInt8> buffer( FILE_SIZE );
+		CHECK( ReadMatches( backends[b], file, &buffer[0], 0, FILE_SIZE ) );
+		CHECK( ReadMatches( backends[b], file, &buffer[0], 1000, 100000 ) );
+		CHECK( ReadMatches( backends[b], file, &buffer[0], FILE_SIZE - 1, 1 ) );
+
+		// A batch deeper than the queue.
+		const AkUInt32 NUM_READS = 20;
+		const AkUInt32 READ_SIZE = 4096;
+		AkTestCompletion completions[NUM_READS];
+		AkAsyncIoRequest requests[NUM_READS];
+		for ( AkUInt32 i = 0; i < NUM_READS; ++i )
+			requests[i] = ReadRequest( file, &buffer[i * READ_SIZE], (AkUInt64)( NUM_READS - 1 - i ) * READ_SIZE * 3, READ_SIZE, completions[i] );
+		backends[b]->Submit( requests, NUM_READS );
+		for ( AkUInt32 i = 0; i < NUM_READS; ++i )
+		{
+			CHECK( completions[i].Wait() == AK_Success );
+			CHECK( memcmp( &buffer[i * READ_SIZE], file.Data( requests[i].uOffset ), READ_SIZE ) == 0 );
+		}
+	}
+	DestroyBackends( backends );
+}
+
+TEST_CASE(AsyncIoBackend_RegisteredBufferAndFile)
+{
+	CAkTestFile file( FILE_SIZE );
+	CHECK( file.IsValid() );
+	std::vector<CAkAsyncIoBackend*> backends = CreateBackends();
+	for ( size_t b = 0; b < backends.size(); ++b )
+	{
+		// Transfers into the registered buffer, at its start and inside it,
+		// and into memory out of it.
+		std::vector<AkUInt8> registered( 128 * 1024 );
+		std::vector<AkUInt8> other( 8192 );
+		backends[b]->RegisterBuffer( &registered[0], registered.size() );
+		backends[b]->RegisterFile( file.Fd() );
+		CHECK( ReadMatches( backends[b], file, &registered[0], 0, (AkUInt32)registered.size() ) );
+		CHECK( ReadMatches( backends[b], file, &registered[4096], 77777, 50000 ) );
+		CHECK( ReadMatches( backends[b], file, &other[0], 5, (AkUInt32)other.size() ) );
+
+		// Straddling the end of the registered buffer.
+		std::vector<AkUInt8> straddle( registered.size() + 4096 );
+		backends[b]->RegisterBuffer( &straddle[0], registered.size() );
+		CHECK( ReadMatches( backends[b], file, &straddle[registered.size() - 100], 300, 4096 ) );
+
+		// And a file that is no longer registered.
+		backends[b]->UnregisterFile( file.Fd() );
+		CHECK( ReadMatches( backends[b], file, &straddle[0], 12345, 6789 ) );
+	}
+	DestroyBackends( backends );
+}
+
+TEST_CASE(AsyncIoBackend_ShortReadAtEndOfFile)
+{
+	CAkTestFile file( FILE_SIZE );
+	CHECK( file.IsValid() );
+	std::vector<CAkAsyncIoBackend*> backends = CreateBackends();
+	for ( size_t b = 0; b < backends.size(); ++b )
+	{
+		// The last transfer of a stream is rounded up past the end of the file.
+		const AkUInt32 uLeft = 100;
+		std::vector<AkUInt8> buffer( 4096, 0xCD );
+		AkTestCompletion completion;
+		AkAsyncIoRequest request = ReadRequest( file, &buffer[0], FILE_SIZE - uLeft, (AkUInt32)buffer.size(), completion );
+		request.uMinSize = uLeft;
+		CHECK( Transfer( backends[b], request, completion ) );
+		CHECK( memcmp( &buffer[0], file.Data( FILE_SIZE - uLeft ), uLeft ) == 0 );
+
+		// End of file before uMinSize, or without one, fails.
+		AkTestCompletion tooShort;
+		request = ReadRequest( file, &buffer[0], FILE_SIZE - uLeft, (AkUInt32)buffer.size(), tooShort );
+		request.uMinSize = uLeft + 1;
+		CHECK( Transfer( backends[b], request, tooShort, AK_Fail ) );
+
+		AkTestCompletion noMinimum;
+		request = ReadRequest( file, &buffer[0], FILE_SIZE - uLeft, (AkUInt32)buffer.size(), noMinimum );
+		CHECK( Transfer( backends[b], request, noMinimum, AK_Fail ) );
+
+		// Past the end of the file.
+		AkTestCompletion pastEnd;
+		request = ReadRequest( file, &buffer[0], FILE_SIZE + 10, 16, pastEnd );
+		request.uMinSize = 1;
+		CHECK( Transfer( backends[b], request, pastEnd, AK_Fail ) );
+
+		// A scatter read ending past the end of the file.
+		std::vector<AkUInt8> first( 60 ), second( 4000, 0xCD );
+		struct iovec iov[2] = { { &first[0], first.size() }, { &second[0], second.size() } };
+		AkTestCompletion scattered;
+		request = ReadRequest( file, NULL, FILE_SIZE - uLeft, (AkUInt32)( first.size() + second.size() ), scattered );
+		request.pIovecs = iov;
+		request.uNumIovecs = 2;
+		request.uMinSize = uLeft;
+		CHECK( Transfer( backends[b], request, scattered ) );
+		CHECK( memcmp( &first[0], file.Data( FILE_SIZE - uLeft ), first.size() ) == 0 );
+		CHECK( memcmp( &second[0], file.Data( FILE_SIZE - uLeft + first.size() ), uLeft - first.size() ) == 0 );
+	}
+	DestroyBackends( backends );
+}
+
+TEST_CASE(AsyncIoBackend_IovecListLongerThanIovMax)
+{
+	CAkTestFile file( FILE_SIZE );
+	CHECK( file.IsValid() );
+	std::vector<CAkAsyncIoBackend*> backends = CreateBackends();
+	for ( size_t b = 0; b < backends.size(); ++b )
+	{
+		// Pieces of different sizes, so that a list resumed at the wrong
+		// entry or offset shows.
+		const AkUInt32 uNumIov = IOV_MAX * 2 + 100;
+		std::vector<AkUInt32> sizes( uNumIov );
+		AkUInt32 uTotal = 0;
+		for ( AkUInt32 i = 0; i < uNumIov; ++i )
+		{
+			sizes[i] = 1 + ( i * 13 ) % 64;
+			uTotal += sizes[i];
+		}
+		CHECK( uTotal + 333 <= FILE_SIZE );
+
+		std::vector<AkUInt8> buffer( uTotal + uNumIov, 0xCD );	// A guard byte after each piece.
+		std::vector<struct iovec> iov( uNumIov );
+		AkUInt32 uPos = 0;
+		for ( AkUInt32 i = 0; i < uNumIov; ++i )
+		{
+			iov[i].iov_base = &buffer[uPos];
+			iov[i].iov_len = sizes[i];
+			uPos += sizes[i] + 1;
+		}
+
+		AkTestCompletion completion;
+		AkAsyncIoRequest request = ReadRequest( file, NULL, 333, uTotal, completion );
+		request.pIovecs = &iov[0];
+		request.uNumIovecs = uNumIov;
+		CHECK( Transfer( backends[b], request, completion ) );
+
+		AkUInt32 uMismatches = 0;
+		AkUInt64 uOffset = 333;
+		uPos = 0;
+		for ( AkUInt32 i = 0; i < uNumIov; ++i )
+		{
+			uMismatches += memcmp( &buffer[uPos], file.Data( uOffset ), sizes[i] ) == 0 ? 0 : 1;
+			uMismatches += buffer[uPos + sizes[i]] == 0xCD ? 0 : 1;
+			uOffset += sizes[i];
+			uPos += sizes[i] + 1;
+		}
+		CHECK( uMismatches == 0 );
+	}
+	DestroyBackends( backends );
+}
@@ -0,0 +1,267 @@
+#include <cstring>
+#include <vector>
+#include "Test.h"
+#include "AkPosixTestFile.h"
+#include "AkBatchReadOptimizer.h"
+
+namespace
+{
+	const AkUInt32 FILE_SIZE	= 64 * 1024;
+	const AkUInt32 MAX_GAP		= 4096;
+
+	// Reads of a batch, each with its buffer and completion.
+	struct Reads
+	{
+		std::vector<AkBatchRead>			reads;
+		std::vector<std::vector<AkUInt8> >	buffers;
+		std::vector<AkTestCompletion>		completions;
+
+		Reads( const CAkTestFile & in_file, const AkUInt64 * in_pRanges, AkUInt32 in_uNumReads )
+			: reads( in_uNumReads )
+			, buffers( in_uNumReads )
+			, completions( in_uNumReads )
+		{
+			for ( AkUInt32 i = 0; i < in_uNumReads; ++i )
+			{
+				buffers[i].assign( (size_t)in_pRanges[i * 2 + 1], 0xCD );
+				AkBatchRead & read = reads[i];
+				read.fd = in_file.Fd();
+				read.pBuffer = &buffers[i][0];
+				read.uOffset = in_pRanges[i * 2];
+				read.uSize = (AkUInt32)in_pRanges[i * 2 + 1];
+				read.uMinSize = 0;
+				read.pfnCompletion = AkTestCompletion::OnComplete;
+				read.pCookie = &completions[i];
+			}
+		}
+
+		AkUInt32 Size() const { return (AkUInt32)buffers.size(); }
+
+		// Every read completed once, with in_eExpected; on success, with the
+		// data of in_file (up to its end).
+		bool CompletedWith( AKRESULT in_eExpected, const CAkTestFile & in_file )
+		{
+			bool bOk = true;
+			for ( AkUInt32 i = 0; i < Size(); ++i )
+			{
+				bOk = bOk && completions[i].Wait() == in_eExpected && completions[i].calls.load() == 1;
+				if ( bOk && in_eExpected == AK_Success )
+				{
+					AkUInt64 uOffset = OffsetOf( i );
+					AkUInt64 uValid = AkMin( (AkUInt64)buffers[i].size(), in_file.Size() - uOffset );
+					bOk = memcmp( &buffers[i][0], in_file.Data( uOffset ), (size_t)uValid ) == 0;
+				}
+			}
+			return bOk;
+		}
+
+		// Submit() sorts the reads: look them up by buffer.
+		AkUInt64 OffsetOf( AkUInt32 in_uRead ) const
+		{
+			for ( size_t i = 0; i < reads.size(); ++i )
+			{
+				if ( reads[i].pBuffer == &buffers[in_uRead][0] )
+					return reads[i].uOffset;
+			}
+			return 0;
+		}
+	};
+
+	AkBatchReadSettings Settings()
+	{
+		AkBatchReadSettings settings;
+		settings.uMaxGap = MAX_GAP;
+		return settings;
+	}
+}
+
+TEST_CASE(BatchReadOptimizer_AdjacentAndOverlappingReadsMerge)
+{
+	CAkTestFile file( FILE_SIZE );
+	CHECK( file.IsValid() );
+	CAkRecordingBackend backend( file );
+	CAkBatchReadOptimizer optimizer;
+	CHECK( optimizer.Init( Settings() ) == AK_Success );
+
+	// Out of order: adjacent, overlapping the end of another, inside
+	// another, and the same range twice.
+	const AkUInt64 ranges[] = {
+		2500, 1500,
+		0, 1000,
+		1000, 2000,
+		3000, 500,
+		1000, 2000,
+	};
+	Reads reads( file, ranges, 5 );
+	optimizer.Submit( &backend, &reads.reads[0], reads.Size() );
+
+	CHECK( backend.requests.size() == 1 );
+	CHECK( backend.requests[0].uOffset == 0 && backend.requests[0].uSize == 4000 );
+	AkBatchReadStats stats;
+	optimizer.GetStats( stats );
+	CHECK( stats.uReads == 5 && stats.uTransfers == 1 && stats.uMergedReads == 5 );
+
+	// Each byte is read once; the overlapping parts are copied.
+	AkUInt64 uTransferred = 0;
+	for ( AkUInt32 i = 0; i < backend.requests[0].uNumIovecs; ++i )
+		uTransferred += backend.requests[0].pIovecs[i].iov_len;
+	CHECK( uTransferred == 4000 );
+
+	backend.Complete( 0, AK_Success );
+	CHECK( reads.CompletedWith( AK_Success, file ) );
+	optimizer.Term();
+}
+
+TEST_CASE(BatchReadOptimizer_DifferentFilesDoNotMerge)
+{
+	CAkTestFile file( FILE_SIZE );
+	CAkTestFile other( FILE_SIZE );
+	CHECK( file.IsValid() && other.IsValid() );
+	CAkRecordingBackend backend( file );	// Same contents.
+	CAkBatchReadOptimizer optimizer;
+	CHECK( optimizer.Init( Settings() ) == AK_Success );
+
+	const AkUInt64 ranges[] = {
+		0, 100,
+		100, 100,
+		200, 100,
+	};
+	Reads reads( file, ranges, 3 );
+	reads.reads[1].fd = other.Fd();
+	optimizer.Submit( &backend, &reads.reads[0], reads.Size() );
+
+	// The reads of the first file merge around the one of the other.
+	CHECK( backend.requests.size() == 2 );
+	AkUInt32 uMerged = 0;
+	for ( size_t i = 0; i < backend.requests.size(); ++i )
+	{
+		const AkAsyncIoRequest & request = backend.requests[i];
+		if ( request.fd == file.Fd() )
+		{
+			CHECK( request.uOffset == 0 && request.uSize == 300 && request.uNumIovecs == 3 );
+			++uMerged;
+		}
+		else
+		{
+			CHECK( request.fd == other.Fd() && request.uOffset == 100 && request.uSize == 100 && request.uNumIovecs == 0 );
+		}
+		backend.Complete( i, AK_Success );
+	}
+	CHECK( uMerged == 1 );
+	CHECK( reads.CompletedWith( AK_Success, file ) );
+	optimizer.Term();
+}
+
+TEST_CASE(BatchReadOptimizer_GapAtMergeLimit)
+{
+	CAkTestFile file( FILE_SIZE );
+	CHECK( file.IsValid() );
+	CAkBatchReadOptimizer optimizer;
+	CHECK( optimizer.Init( Settings() ) == AK_Success );
+
+	// A gap of uMaxGap bytes is read and dropped.
+	{
+		CAkRecordingBackend backend( file );
+		const AkUInt64 ranges[] = {
+			100, 100,
+			200 + MAX_GAP, 100,
+		};
+		Reads reads( file, ranges, 2 );
+		optimizer.Submit( &backend, &reads.reads[0], reads.Size() );
+		CHECK( backend.requests.size() == 1 );
+		CHECK( backend.requests[0].uOffset == 100 && backend.requests[0].uSize == 200 + MAX_GAP );
+		CHECK( backend.requests[0].uNumIovecs == 3 && backend.requests[0].pIovecs[1].iov_len == MAX_GAP );
+		backend.Complete( 0, AK_Success );
+		CHECK( reads.CompletedWith( AK_Success, file ) );
+	}
+
+	// One byte more and they are read apart.
+	{
+		CAkRecordingBackend backend( file );
+		const AkUInt64 ranges[] = {
+			100, 100,
+			200 + MAX_GAP + 1, 100,
+		};
+		Reads reads( file, ranges, 2 );
+		optimizer.Submit( &backend, &reads.reads[0], reads.Size() );
+		CHECK( backend.requests.size() == 2 );
+		for ( size_t i = 0; i < backend.requests.size(); ++i )
+		{
+			CHECK( backend.requests[i].uNumIovecs == 0 && backend.requests[i].uSize == 100 );
+			backend.Complete( i, AK_Success );
+		}
+		CHECK( reads.CompletedWith( AK_Success, file ) );
+	}
+
+	AkBatchReadStats stats;
+	optimizer.GetStats( stats );
+	CHECK( stats.uReads == 4 && stats.uTransfers == 3 && stats.uMergedReads == 2 );
+	optimizer.Term();
+}
+
+TEST_CASE(BatchReadOptimizer_FailedMergedReadFailsEveryRead)
+{
+	CAkTestFile file( FILE_SIZE );
+	CHECK( file.IsValid() );
+	CAkRecordingBackend backend( file );
+	CAkBatchReadOptimizer optimizer;
+	CHECK( optimizer.Init( Settings() ) == AK_Success );
+
+	const AkUInt64 ranges[] = {
+		0, 100,
+		50, 100,
+		1000, 100,
+		1100, 100,
+	};
+	Reads reads( file, ranges, 4 );
+	optimizer.Submit( &backend, &reads.reads[0], reads.Size() );
+	CHECK( backend.requests.size() == 1 );
+	backend.Complete( 0, AK_Fail );
+	CHECK( reads.CompletedWith( AK_Fail, file ) );
+	optimizer.Term();
+}
+
+TEST_CASE(BatchReadOptimizer_ShortMergedReadAtEndOfFile)
+{
+	CAkTestFile file( FILE_SIZE );
+	CHECK( file.IsValid() );
+	AkAsyncIoSettings ioSettings;
+	ioSettings.eType = AkAsyncIoBackend_ThreadPool;
+	ioSettings.uNumThreads = 2;
+	CAkAsyncIoBackend * pBackend = CAkAsyncIoBackend::Create( ioSettings );
+	CHECK( pBackend != NULL );
+	CAkBatchReadOptimizer optimizer;
+	CHECK( optimizer.Init( Settings() ) == AK_Success );
+
+	// The last read is rounded up past the end of the file: the merged
+	// transfer comes back short, which is enough for every read.
+	{
+		const AkUInt64 ranges[] = {
+			FILE_SIZE - 1000, 500,
+			FILE_SIZE - 300, 4096,
+		};
+		Reads reads( file, ranges, 2 );
+		reads.reads[1].uMinSize = 300;
+		optimizer.Submit( pBackend, &reads.reads[0], reads.Size() );
+		CHECK( reads.CompletedWith( AK_Success, file ) );
+	}
+
+	// Without a minimum size, the transfer fails, and so does every read.
+	{
+		const AkUInt64 ranges[] = {
+			FILE_SIZE - 1000, 500,
+			FILE_SIZE - 300, 4096,
+			FILE_SIZE - 600, 200,
+		};
+		Reads reads( file, ranges, 3 );
+		optimizer.Submit( pBackend, &reads.reads[0], reads.Size() );
+		CHECK( reads.CompletedWith( AK_Fail, file ) );
+	}
+
+	AkBatchReadStats stats;
+	optimizer.GetStats( stats );
+	CHECK( stats.uReads == 5 && stats.uTransfers == 2 && stats.uMergedReads == 5 );
+
+	CAkAsyncIoBackend::Destroy( pBackend );
+	optimizer.Term();
+}
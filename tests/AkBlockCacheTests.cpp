@@ -0,0 +1,218 @@
+#include <cstring>
+#include <vector>
+#include "Test.h"
+#include "AkPosixTestFile.h"
+#include "AkBlockCache.h"
+
+namespace
+{
+	const AkUInt32 BLOCK_SIZE = 4096;
+
+	AkBlockCacheSettings Settings( AkUInt32 in_uNumBlocks, AkUInt32 in_uReadAheadBlocks )
+	{
+		AkBlockCacheSettings settings;
+		settings.uMemorySize = in_uNumBlocks * BLOCK_SIZE;
+		settings.uBlockSize = BLOCK_SIZE;
+		settings.uReadAheadBlocks = in_uReadAheadBlocks;
+		return settings;
+	}
+
+	// A read as the deferred hook does it: through the cache, or submitted
+	// to the backend if the cache did not take it.
+	struct CacheRead
+	{
+		AkUInt64				uOffset;
+		std::vector<AkUInt8>	buffer;
+		AkTestCompletion		completion;
+		bool					bTaken;
+
+		CacheRead( CAkBlockCache & in_cache, CAkAsyncIoBackend * in_pBackend, const CAkTestFile & in_file, AkUInt64 in_uOffset, AkUInt32 in_uSize )
+			: uOffset( in_uOffset )
+			, buffer( in_uSize, 0xCD )
+		{
+			AkBatchRead read;
+			read.fd = in_file.Fd();
+			read.pBuffer = &buffer[0];
+			read.uOffset = in_uOffset;
+			read.uSize = in_uSize;
+			read.uMinSize = (AkUInt32)AkMin( (AkUInt64)in_uSize, in_file.Size() - in_uOffset );
+			read.pfnCompletion = AkTestCompletion::OnComplete;
+			read.pCookie = &completion;
+			bTaken = in_cache.Read( in_pBackend, read, in_file.Size() );
+			if ( !bTaken )
+			{
+				AkAsyncIoRequest request = {};
+				request.fd = read.fd;
+				request.pBuffer = read.pBuffer;
+				request.uOffset = read.uOffset;
+				request.uSize = read.uSize;
+				request.uMinSize = read.uMinSize;
+				request.pfnCompletion = read.pfnCompletion;
+				request.pCookie = read.pCookie;
+				in_pBackend->Submit( &request, 1 );
+			}
+		}
+
+		// Completed once, with the data of the file up to its end.
+		bool Matches( const CAkTestFile & in_file )
+		{
+			if ( completion.Wait() != AK_Success || completion.calls.load() != 1 )
+				return false;
+			AkUInt64 uValid = AkMin( (AkUInt64)buffer.size(), in_file.Size() - uOffset );
+			return memcmp( &buffer[0], in_file.Data( uOffset ), (size_t)uValid ) == 0;
+		}
+	};
+
+	// Reads blocks [in_uFirst, in_uFirst + in_uCount) one at a time, checking
+	// the data. Returns how many the cache took.
+	AkUInt32 ReadBlocks( CAkBlockCache & in_cache, CAkAsyncIoBackend * in_pBackend, const CAkTestFile & in_file, AkUInt32 in_uFirst, AkUInt32 in_uCount )
+	{
+		AkUInt32 uTaken = 0;
+		for ( AkUInt32 b = in_uFirst; b < in_uFirst + in_uCount; ++b )
+		{
+			CacheRead read( in_cache, in_pBackend, in_file, (AkUInt64)b * BLOCK_SIZE, BLOCK_SIZE );
+			CHECK( read.Matches( in_file ) );
+			uTaken += read.bTaken ? 1 : 0;
+		}
+		return uTaken;
+	}
+}
+
+TEST_CASE(BlockCache_SmallBudgetEvicts)
+{
+	// A working set of 8 blocks in a cache of 4, without read-ahead.
+	CAkTestFile file( 8 * BLOCK_SIZE );
+	CHECK( file.IsValid() );
+	CAkRecordingBackend backend( file, true );
+	CAkBlockCache cache;
+	CHECK( cache.Init( Settings( 4, 0 ) ) == AK_Success );
+	CHECK( cache.IsEnabled() );
+
+	AkBlockCacheStats stats;
+	CHECK( ReadBlocks( cache, &backend, file, 0, 8 ) == 0 );
+	cache.GetStats( stats );
+	CHECK( stats.uMisses == 8 && stats.uHits == 0 && stats.uEvictions == 4 );
+
+	// The last four are cached.
+	CHECK( ReadBlocks( cache, &backend, file, 4, 2 ) == 2 );
+	cache.GetStats( stats );
+	CHECK( stats.uMisses == 8 && stats.uHits == 2 && stats.uEvictions == 4 );
+
+	// Blocks used since the clock hand last passed get a second chance: the
+	// first unused one is replaced.
+	CHECK( ReadBlocks( cache, &backend, file, 0, 1 ) == 0 );
+	CHECK( ReadBlocks( cache, &backend, file, 4, 2 ) == 2 );
+	CHECK( ReadBlocks( cache, &backend, file, 6, 1 ) == 0 );
+	cache.GetStats( stats );
+	CHECK( stats.uMisses == 10 && stats.uHits == 4 && stats.uEvictions == 6 );
+	CHECK_NEAR( stats.GetHitRate(), 4.f / 14.f, 1e-6f );
+	CHECK( stats.uReadAheadBlocks == 0 );
+
+	// A pass over the working set replaces every block.
+	CHECK( ReadBlocks( cache, &backend, file, 0, 8 ) == 1 );
+	cache.GetStats( stats );
+	CHECK( stats.uMisses == 17 && stats.uEvictions == 13 );
+
+	// Reads across two cached blocks, and inside one.
+	CacheRead across( cache, &backend, file, 5 * BLOCK_SIZE - 100, 200 );
+	CHECK( across.bTaken && across.Matches( file ) );
+	CacheRead inside( cache, &backend, file, 6 * BLOCK_SIZE + 10, 300 );
+	CHECK( inside.bTaken && inside.Matches( file ) );
+
+	// Dropped blocks go back to storage.
+	cache.Invalidate( file.Fd() );
+	CHECK( ReadBlocks( cache, &backend, file, 4, 4 ) == 0 );
+	cache.Term();
+}
+
+TEST_CASE(BlockCache_ZeroBudgetPassesThrough)
+{
+	CAkTestFile file( 4 * BLOCK_SIZE );
+	CHECK( file.IsValid() );
+	CAkRecordingBackend backend( file, true );
+
+	// No memory, or less than a block: disabled.
+	const AkUInt32 sizes[] = { 0, BLOCK_SIZE - 1 };
+	for ( AkUInt32 s = 0; s < 2; ++s )
+	{
+		CAkBlockCache cache;
+		AkBlockCacheSettings settings = Settings( 0, 4 );
+		settings.uMemorySize = sizes[s];
+		CHECK( cache.Init( settings ) == AK_Success );
+		CHECK( !cache.IsEnabled() );
+
+		// Reads are left as they are and go to storage, twice.
+		size_t uSubmitted = backend.requests.size();
+		for ( AkUInt32 i = 0; i < 2; ++i )
+		{
+			CacheRead read( cache, &backend, file, 0, BLOCK_SIZE );
+			CHECK( !read.bTaken && read.Matches( file ) );
+			CHECK( backend.requests.back().pCookie == &read.completion );
+		}
+		CHECK( ReadBlocks( cache, &backend, file, 1, 3 ) == 0 );
+		CHECK( backend.requests.size() == uSubmitted + 5 );
+
+		AkBlockCacheStats stats;
+		cache.GetStats( stats );
+		CHECK( stats.uHits == 0 && stats.uMisses == 0 && stats.uReadAheadBlocks == 0 && stats.GetHitRate() == 0.f );
+		cache.Term();
+	}
+}
+
+TEST_CASE(BlockCache_ReadAheadMatchesFile)
+{
+	// Ten blocks and a part of one.
+	const AkUInt32 NUM_BLOCKS = 11;
+	CAkTestFile file( ( NUM_BLOCKS - 1 ) * BLOCK_SIZE + 500 );
+	CHECK( file.IsValid() );
+	CAkRecordingBackend backend( file );
+	CAkBlockCache cache;
+	CHECK( cache.Init( Settings( 16, 4 ) ) == AK_Success );
+
+	CacheRead first( cache, &backend, file, 0, BLOCK_SIZE );
+	CHECK( !first.bTaken && backend.requests.size() == 1 );
+	backend.CompleteAll();
+	CHECK( first.Matches( file ) );
+
+	// Sequential: the next four blocks are read ahead with one transfer,
+	// submitted by the cache before the read itself.
+	CacheRead second( cache, &backend, file, BLOCK_SIZE, BLOCK_SIZE );
+	CHECK( !second.bTaken && backend.requests.size() == 3 );
+	const AkAsyncIoRequest & readAhead = backend.requests[1];
+	CHECK( readAhead.uOffset == 2 * BLOCK_SIZE && readAhead.uSize == 4 * BLOCK_SIZE && readAhead.uNumIovecs == 4 );
+	backend.Complete( 2, AK_Success );
+	CHECK( second.Matches( file ) );
+
+	// The next read waits for the read-ahead, and reads further ahead.
+	CacheRead third( cache, &backend, file, 2 * BLOCK_SIZE, BLOCK_SIZE );
+	CHECK( third.bTaken && third.completion.calls.load() == 0 );
+	CHECK( backend.requests.size() == 4 && backend.requests[3].uOffset == 6 * BLOCK_SIZE );
+	backend.Complete( 1, AK_Success );
+	CHECK( third.Matches( file ) );
+	backend.CompleteAll();
+
+	// The rest comes from the cache, up to the last block, whose read is
+	// rounded up past the end of the file.
+	for ( AkUInt32 b = 3; b < NUM_BLOCKS; ++b )
+	{
+		CacheRead read( cache, &backend, file, (AkUInt64)b * BLOCK_SIZE, BLOCK_SIZE );
+		CHECK( read.bTaken );
+		backend.CompleteAll();
+		CHECK( read.Matches( file ) );
+	}
+	CHECK( backend.NumPending() == 0 );
+
+	AkBlockCacheStats stats;
+	cache.GetStats( stats );
+	CHECK( stats.uMisses == 2 && stats.uHits == NUM_BLOCKS - 2 && stats.uWaits == 1 );
+	CHECK( stats.uReadAheadBlocks == NUM_BLOCKS - 2 && stats.uEvictions == 0 );
+	CHECK_NEAR( stats.GetHitRate(), (AkReal32)( NUM_BLOCKS - 2 ) / NUM_BLOCKS, 1e-6f );
+
+	// Read ahead again from cached blocks: nothing to read.
+	CacheRead again( cache, &backend, file, 0, 2 * BLOCK_SIZE );
+	CHECK( again.bTaken && again.Matches( file ) );
+	CacheRead next( cache, &backend, file, 2 * BLOCK_SIZE, 2 * BLOCK_SIZE );
+	CHECK( next.bTaken && next.Matches( file ) );
+	CHECK( backend.NumPending() == 0 );
+	cache.Term();
+}
@@ -0,0 +1,159 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Test.h"
+#include "AkPosixTestFile.h"
+#include "AkDefaultIOHookDeferred.h"
+
+namespace
+{
+	const AkUInt32 FILE_SIZE = 100000 + 77;
+
+	void OnOpen( AkAsyncFileOpenData * in_pItem, AKRESULT in_eResult )
+	{
+		*(AKRESULT*)in_pItem->pCookie = in_eResult;
+	}
+
+	void OnTransfer( AkAsyncIOTransferInfo * in_pTransferInfo, AKRESULT in_eResult )
+	{
+		AkTestCompletion::OnComplete( in_pTransferInfo->pCookie, in_eResult );
+	}
+
+	// A direct I/O hook with its base path in the directory of in_file.
+	struct DirectIoHook
+	{
+		CAkDefaultIOHookDeferred	hook;
+		AkFileDesc *				pFileDesc;
+
+		explicit DirectIoHook( const CAkTestFile & in_file )
+			: pFileDesc( NULL )
+		{
+			AkDeviceSettings deviceSettings = AkDeviceSettings();
+			deviceSettings.uIOMemorySize = 256 * 1024;
+			deviceSettings.uIOMemoryAlignment = 16;
+			deviceSettings.uGranularity = 16 * 1024;
+			deviceSettings.uMaxConcurrentIO = 8;
+			hook.SetDirectIO( true );
+			CHECK( hook.Init( deviceSettings ) == AK_Success );
+			CHECK( hook.AddBasePath( in_file.Directory().c_str() ) == AK_Success );
+
+			AKRESULT eResult = AK_Fail;
+			std::string name = in_file.Name();
+			AkAsyncFileOpenData openData( AkFileOpenData( name.c_str() ) );
+			openData.pCallback = OnOpen;
+			openData.pCookie = &eResult;
+			AkAsyncFileOpenData * pOpenData = &openData;
+			hook.BatchOpen( 1, &pOpenData );
+			CHECK( eResult == AK_Success && openData.pFileDesc != NULL );
+			pFileDesc = openData.pFileDesc;
+		}
+
+		~DirectIoHook()
+		{
+			hook.Close( pFileDesc );
+			hook.Term();
+		}
+
+		bool IsDirect() const
+		{
+			int iFlags = fcntl( ((AkPosixFileDesc*)pFileDesc)->fd, F_GETFL );
+#if defined(O_DIRECT)
+			return iFlags >= 0 && ( iFlags & O_DIRECT ) != 0;
+#else
+			return false;
+#endif
+		}
+
+		// Reads in_uSize bytes at in_uPosition, as the Stream Manager would
+		// into in_pBuffer, and compares them with the file up to its end.
+		bool ReadMatches( const CAkTestFile & in_file, AkUInt64 in_uPosition, AkUInt32 in_uSize, AkUInt8 * in_pBuffer, AkUInt32 in_uBufferSize )
+		{
+			memset( in_pBuffer, 0xCD, in_uBufferSize );
+			AkTestCompletion completion;
+			AkAsyncIOTransferInfo transferInfo;
+			memset( &transferInfo, 0, sizeof( transferInfo ) );
+			transferInfo.uFilePosition = in_uPosition;
+			transferInfo.uBufferSize = in_uBufferSize;
+			transferInfo.uRequestedSize = in_uSize;
+			transferInfo.pBuffer = in_pBuffer;
+			transferInfo.pCallback = OnTransfer;
+			transferInfo.pCookie = &completion;
+
+			BatchIoTransferItem item;
+			item.pFileDesc = pFileDesc;
+			item.ioHeuristics.fDeadline = 0.f;
+			item.ioHeuristics.priority = AK_DEFAULT_PRIORITY;
+			item.pTransferInfo = &transferInfo;
+			hook.BatchRead( 1, &item );
+			if ( completion.Wait() != AK_Success || completion.calls.load() != 1 )
+				return false;
+
+			AkUInt64 uValid = AkMin( (AkUInt64)in_uSize, in_file.Size() - in_uPosition );
+			return memcmp( in_pBuffer, in_file.Data( in_uPosition ), (size_t)uValid ) == 0;
+		}
+	};
+
+	// Memory aligned like the Stream Manager's buffers.
+	struct AlignedBuffer
+	{
+		std::vector<AkUInt8>	memory;
+		AkUInt8 *				pData;
+
+		explicit AlignedBuffer( AkUInt32 in_uSize )
+			: memory( in_uSize + 4096 )
+		{
+			pData = &memory[0] + ( 4096 - (AkUIntPtr)&memory[0] % 4096 ) % 4096;
+		}
+	};
+}
+
+TEST_CASE(DefaultIOHookDeferred_DirectIoFallsBackOnTmpfs)
+{
+	// tmpfs refuses O_DIRECT, or on recent kernels accepts it without
+	// reporting an alignment: either way, files are read through the page
+	// cache without alignment.
+	CAkTestFile file( FILE_SIZE, "/dev/shm" );
+	CHECK( file.IsValid() );
+	DirectIoHook hook( file );
+	CHECK( hook.pFileDesc != NULL );
+	if ( !hook.pFileDesc )
+		return;
+
+	CHECK( hook.hook.GetBlockSize( *hook.pFileDesc ) == 1 );
+	CHECK( !hook.IsDirect() );
+	CHECK( hook.pFileDesc->iFileSize == FILE_SIZE );
+
+	std::vector<AkUInt8> buffer( FILE_SIZE + 100 );
+	CHECK( hook.ReadMatches( file, 0, FILE_SIZE, &buffer[1], FILE_SIZE ) );
+	CHECK( hook.ReadMatches( file, 1234, 777, &buffer[3], 777 ) );
+	CHECK( hook.ReadMatches( file, FILE_SIZE - 50, 90, &buffer[0], 90 ) );	// Past the end of the file.
+}
+
+TEST_CASE(DefaultIOHookDeferred_DirectIoReadsOnDisk)
+{
+	// Whatever /tmp is, the block size is one the Stream Manager can use,
+	// and reads succeed whether they are aligned or go through the bounce
+	// buffer.
+	CAkTestFile file( FILE_SIZE );
+	CHECK( file.IsValid() );
+	DirectIoHook hook( file );
+	CHECK( hook.pFileDesc != NULL );
+	if ( !hook.pFileDesc )
+		return;
+
+	AkUInt32 uBlockSize = hook.hook.GetBlockSize( *hook.pFileDesc );
+	CHECK( uBlockSize > 0 && ( uBlockSize & ( uBlockSize - 1 ) ) == 0 && uBlockSize <= 64 * 1024 );
+	CHECK( hook.IsDirect() == ( uBlockSize > 1 ) );
+
+	// Aligned, as the Stream Manager does with the block size, up to the
+	// last block that ends past the end of the file.
+	AkUInt32 uRounded = ( ( FILE_SIZE + uBlockSize - 1 ) / uBlockSize ) * uBlockSize;
+	AlignedBuffer aligned( uRounded );
+	CHECK( hook.ReadMatches( file, 0, uRounded, aligned.pData, uRounded ) );
+	AkUInt32 uLastBlock = uRounded - uBlockSize;
+	CHECK( hook.ReadMatches( file, uLastBlock, uBlockSize, aligned.pData, uBlockSize ) );
+
+	// Misaligned offset, size and buffer.
+	CHECK( hook.ReadMatches( file, 1234, 777, aligned.pData + 3, 777 ) );
+	CHECK( hook.ReadMatches( file, FILE_SIZE - 50, 90, aligned.pData + 1, 90 ) );
+}
@@ -0,0 +1,188 @@
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <vector>
+#include "Test.h"
+#include "AkFilePackageWriter.h"
+#include "AkFilePackageDecompressor.h"
+#include "AkFilePackageCompression.h"
+
+namespace
+{
+	typedef CAkFilePackageWriter Writer;
+
+	const AkFileID FILE_ID			= 42;
+	const AkUInt32 CHUNK_SIZE		= 4096;
+	const AkUInt32 NUM_CHUNKS		= 10;
+	const AkUInt32 FILE_SIZE		= CHUNK_SIZE * ( NUM_CHUNKS - 1 ) + 1234;
+	const AkUInt32 BLOCK_SIZE		= 2048;
+	const AkUInt32 RANDOM_CHUNK		= 5;	// Does not compress: stored as is.
+
+	// Text-like data that compresses, but for one chunk of noise.
+	std::vector<AkUInt8> FileData()
+	{
+		std::vector<AkUInt8> data( FILE_SIZE );
+		AkUInt32 uState = 12345;
+		for ( AkUInt32 i = 0; i < FILE_SIZE; ++i )
+		{
+			uState = uState * 1103515245 + 12345;
+			if ( i / CHUNK_SIZE == RANDOM_CHUNK )
+				data[i] = (AkUInt8)( uState >> 16 );
+			else
+				data[i] = (AkUInt8)( 'a' + ( i / 7 ) % 13 + ( ( uState >> 28 ) == 0 ? 1 : 0 ) );
+		}
+		return data;
+	}
+
+	// A package with the file, compressed by the AkFilePackageCompressor
+	// routine, and its LUT.
+	struct CompressedPackage
+	{
+		std::vector<AkUInt8>						original;
+		std::vector<AkUInt8>						data;
+		CAkFilePackageLUT							lut;
+		const CAkFilePackageLUT::AkCompressedFile *	pFile;
+
+		CompressedPackage()
+			: original( FileData() )
+			, pFile( NULL )
+		{
+			Writer writer;
+			writer.AddLanguage( AKTEXT("SFX"), 0 );
+			writer.AddFile( Writer::Table_StmFiles, FILE_ID, CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID, original, BLOCK_SIZE );
+			AkUInt32 uHeaderSize = 0;
+			std::vector<AkUInt8> package = writer.Write( uHeaderSize );
+
+			CAkFilePackageCompression::Stats stats;
+			CHECK( CAkFilePackageCompression::Compress( package, CHUNK_SIZE, AK_COMPRESSOR_DEFAULT_MIN_GAIN, data, stats ) == CAkFilePackageCompression::Result_Success );
+			CHECK( stats.uNumCompressed == 1 && stats.uDataSizeIn == FILE_SIZE );
+
+			AkUInt32 uNewHeaderSize = 0;
+			memcpy( &uNewHeaderSize, &data[sizeof( AkUInt32 )], sizeof( AkUInt32 ) );
+			CHECK( lut.Setup( &data[0], uNewHeaderSize + AKPK_HEADER_CHUNK_DEF_SIZE ) == AK_Success );
+
+			AkFileSystemFlags flags;
+			flags.uCompanyID = AKCOMPANYID_AUDIOKINETIC;
+			flags.uCodecID = AKCODECID_VORBIS;
+			const CAkFilePackageLUT::AkFileEntry<AkFileID> * pEntry = lut.LookupFile( FILE_ID, &flags );
+			CHECK( pEntry != NULL );
+			if ( pEntry )
+				pFile = lut.LookupCompressedFile( (AkUInt64)pEntry->uStartBlock * pEntry->uBlockSize );
+			CHECK( pFile != NULL );
+		}
+
+		// Stored size of a chunk; CHUNK_SIZE if it is stored as is.
+		AkUInt32 StoredSize( AkUInt32 in_uChunk ) const
+		{
+			const AkUInt32 * pOffsets = lut.GetChunkOffsets( *pFile );
+			return pOffsets[in_uChunk + 1] - pOffsets[in_uChunk];
+		}
+
+		// Overwrites the stored data of a chunk.
+		void Corrupt( AkUInt32 in_uChunk )
+		{
+			const AkUInt32 * pOffsets = lut.GetChunkOffsets( *pFile );
+			AkUInt8 * pChunk = &data[(size_t)( pFile->uDataOffset + pOffsets[in_uChunk] )];
+			memset( pChunk + 4, 0xFF, StoredSize( in_uChunk ) - 4 );
+		}
+	};
+
+	// A transfer of the Stream Manager, completed on a worker thread.
+	struct Transfer
+	{
+		AkAsyncIOTransferInfo	info;
+		std::vector<AkUInt8>	buffer;
+		std::promise<AKRESULT>	result;
+		std::atomic<int>		calls;
+
+		static void OnComplete( AkAsyncIOTransferInfo * in_pTransferInfo, AKRESULT in_eResult )
+		{
+			Transfer * pThis = (Transfer*)in_pTransferInfo->pCookie;
+			if ( pThis->calls.fetch_add( 1 ) == 0 )
+				pThis->result.set_value( in_eResult );
+		}
+
+		Transfer( const CompressedPackage & in_package, AkUInt32 in_uPosition, AkUInt32 in_uSize )
+			: buffer( in_uSize, 0xCD )
+			, calls( 0 )
+		{
+			memset( &info, 0, sizeof( info ) );
+			info.uFilePosition = in_package.pFile->uDataOffset + in_uPosition;
+			info.uBufferSize = in_uSize;
+			info.uRequestedSize = in_uSize;
+			info.pBuffer = &buffer[0];
+			info.pCallback = OnComplete;
+			info.pCookie = this;
+		}
+	};
+
+	// Reads [in_uPosition, in_uPosition + in_uSize) of the file from the
+	// mapped package. True if it completes once, with in_eExpected, and
+	// (on success) with the data of the file up to its end.
+	bool ReadMapped( CAkFilePackageDecompressor & io_decompressor, const CompressedPackage & in_package, AkUInt32 in_uPosition, AkUInt32 in_uSize, AKRESULT in_eExpected = AK_Success )
+	{
+		Transfer transfer( in_package, in_uPosition, in_uSize );
+		std::future<AKRESULT> result = transfer.result.get_future();
+		io_decompressor.DecompressMapped( in_package.lut, *in_package.pFile, &transfer.info, &in_package.data[0], in_package.data.size() );
+		if ( result.get() != in_eExpected || transfer.calls.load() != 1 )
+			return false;
+		if ( in_eExpected != AK_Success )
+			return true;
+
+		AkUInt32 uValid = AkMin( in_uSize, FILE_SIZE - in_uPosition );
+		return memcmp( &transfer.buffer[0], &in_package.original[in_uPosition], uValid ) == 0;
+	}
+}
+
+TEST_CASE(FilePackageDecompressor_MappedReadsMatchOriginal)
+{
+	CompressedPackage package;
+	CHECK( package.pFile && package.pFile->uChunkSize == CHUNK_SIZE );
+	CHECK( package.StoredSize( 0 ) < CHUNK_SIZE );
+	CHECK( package.StoredSize( RANDOM_CHUNK ) == CHUNK_SIZE );
+
+	CAkFilePackageDecompressor decompressor;
+	CHECK( decompressor.Init() == AK_Success );
+
+	// Whole file, whole chunks, and parts of chunks through the scratch buffer.
+	CHECK( ReadMapped( decompressor, package, 0, FILE_SIZE ) );
+	CHECK( ReadMapped( decompressor, package, 0, CHUNK_SIZE * 2 ) );
+	CHECK( ReadMapped( decompressor, package, CHUNK_SIZE + 100, CHUNK_SIZE * 2 - 100 ) );	// Starts mid-chunk.
+	CHECK( ReadMapped( decompressor, package, CHUNK_SIZE * 2, CHUNK_SIZE + 777 ) );		// Ends mid-chunk.
+	CHECK( ReadMapped( decompressor, package, 300, 500 ) );								// Inside a chunk.
+	CHECK( ReadMapped( decompressor, package, CHUNK_SIZE * RANDOM_CHUNK - 10, 20 ) );		// Across the stored chunk.
+
+	// The last transfer is rounded up to the block size, past the end of the file.
+	AkUInt32 uTail = CHUNK_SIZE * ( NUM_CHUNKS - 1 ) - BLOCK_SIZE;
+	AkUInt32 uRounded = ( ( FILE_SIZE - uTail + BLOCK_SIZE - 1 ) / BLOCK_SIZE ) * BLOCK_SIZE;
+	CHECK( uTail + uRounded > FILE_SIZE );
+	CHECK( ReadMapped( decompressor, package, uTail, uRounded ) );
+
+	decompressor.Term();
+}
+
+TEST_CASE(FilePackageDecompressor_CorruptChunkFails)
+{
+	CompressedPackage package;
+	CHECK( package.StoredSize( 3 ) < CHUNK_SIZE );
+	package.Corrupt( 3 );
+
+	CAkFilePackageDecompressor decompressor;
+	CHECK( decompressor.Init( 1 ) == AK_Success );
+	CHECK( ReadMapped( decompressor, package, CHUNK_SIZE * 3, CHUNK_SIZE, AK_Fail ) );
+	CHECK( ReadMapped( decompressor, package, CHUNK_SIZE * 3 + 10, 100, AK_Fail ) );
+	CHECK( ReadMapped( decompressor, package, 0, FILE_SIZE, AK_Fail ) );
+
+	// The other chunks still read.
+	CHECK( ReadMapped( decompressor, package, 0, CHUNK_SIZE * 3 ) );
+	CHECK( ReadMapped( decompressor, package, CHUNK_SIZE * 4, CHUNK_SIZE ) );
+
+	// Chunks past the end of the mapping fail without being read.
+	std::vector<AkUInt8> truncated( package.data.begin(), package.data.begin() + (size_t)package.pFile->uDataOffset + 10 );
+	Transfer transfer( package, 0, CHUNK_SIZE );
+	std::future<AKRESULT> result = transfer.result.get_future();
+	decompressor.DecompressMapped( package.lut, *package.pFile, &transfer.info, &truncated[0], truncated.size() );
+	CHECK( result.get() == AK_Fail && transfer.calls.load() == 1 );
+
+	decompressor.Term();
+}
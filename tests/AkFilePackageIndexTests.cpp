@@ -0,0 +1,217 @@
+#include <cstring>
+#include <vector>
+#include "Test.h"
+#include "AkFilePackageWriter.h"
+#include "AkFilePackage.h"
+
+namespace
+{
+	typedef CAkFilePackageWriter Writer;
+
+	const AkUInt32 NUM_PACKAGES	= 3;
+	const AkUInt32 NUM_IDS		= 200;
+	const AkFileID ID_BASE		= 1000;
+	const AkUInt64 EXTERNAL_BASE	= 0x200000000ULL;
+
+	class CAkTestPackage : public CAkFilePackage
+	{
+	public:
+		CAkTestPackage( AkUInt32 in_uPackageID, AkUInt32 in_uHeaderSize, void * in_pToRelease )
+			: CAkFilePackage( in_uPackageID, in_uHeaderSize, in_pToRelease ) {}
+	};
+
+	// Whether package in_uPackage has file in_uIndex of a table, in a language
+	// slot (0 is language-neutral). Most files are in two packages or more.
+	bool HasEntry( AkUInt32 in_uPackage, Writer::Table in_eTable, AkUInt32 in_uIndex, AkUInt32 in_uSlot )
+	{
+		AkUInt32 uHash = ( in_uIndex * 2654435761u ) ^ ( in_uPackage * 97 + in_eTable * 13 + in_uSlot * 7 );
+		return ( ( uHash >> 5 ) % 3 ) != 0;
+	}
+
+	AkUInt64 FileID( Writer::Table in_eTable, AkUInt32 in_uIndex )
+	{
+		return ( in_eTable == Writer::Table_Externals ? EXTERNAL_BASE : ID_BASE ) + in_uIndex * 8;
+	}
+
+	// Each package numbers its languages differently. The middle one has no
+	// sound bank table: its streamed files serve sound bank requests.
+	CAkTestPackage * CreatePackage( AkUInt32 in_uPackage )
+	{
+		Writer writer;
+		writer.AddLanguage( AKTEXT("English(US)"), 1 + in_uPackage );
+		writer.AddLanguage( AKTEXT("French(France)"), 10 + in_uPackage );
+		const AkUInt32 slotLanguages[] = { CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID, 1 + in_uPackage, 10 + in_uPackage };
+
+		for ( int t = 0; t < Writer::Table_Num; ++t )
+		{
+			Writer::Table eTable = (Writer::Table)t;
+			if ( eTable == Writer::Table_SoundBanks && in_uPackage == 1 )
+				continue;
+			for ( AkUInt32 i = 0; i < NUM_IDS; ++i )
+			{
+				for ( AkUInt32 s = 0; s < 3; ++s )
+				{
+					if ( HasEntry( in_uPackage, eTable, i, s ) )
+						writer.AddFile( eTable, FileID( eTable, i ), slotLanguages[s], std::vector<AkUInt8>( 4, (AkUInt8)in_uPackage ) );
+				}
+			}
+		}
+
+		AkUInt32 uHeaderSize = 0;
+		std::vector<AkUInt8> data = writer.Write( uHeaderSize );
+
+		const AkOSChar * names[] = { AKTEXT("First.pck"), AKTEXT("Second.pck"), AKTEXT("Third.pck") };
+		AkUInt32 uReservedHeaderSize = 0;
+		AkUInt8 * pHeader = NULL;
+		CAkTestPackage * pPackage = CAkFilePackage::Create<CAkTestPackage>( names[in_uPackage], uHeaderSize, AK_SIMD_ALIGNMENT, uReservedHeaderSize, pHeader );
+		CHECK( pPackage != NULL );
+		memcpy( pHeader, &data[0], uHeaderSize );
+		CHECK( pPackage->lut.Setup( pHeader, uHeaderSize ) == AK_Success );
+		CHECK( pPackage->lut.SetCurLanguage( AKTEXT("English(US)") ) == AK_Success );
+		return pPackage;
+	}
+
+	// Packages as CAkFilePackageLowLevelIO keeps them: the last one loaded
+	// at the front of the list, and the index kept up to date.
+	struct Packages
+	{
+		CAkTestPackage *	packages[NUM_PACKAGES];
+		ListFilePackages	list;
+		CAkFilePackageIndex	index;
+
+		Packages()
+		{
+			for ( AkUInt32 p = 0; p < NUM_PACKAGES; ++p )
+			{
+				packages[p] = CreatePackage( p );
+				list.AddFirst( packages[p] );
+				index.AddPackage( packages[p], list );
+			}
+		}
+
+		~Packages()
+		{
+			index.Term();
+			ListFilePackages::IteratorEx it = list.BeginEx();
+			while ( it != list.End() )
+			{
+				CAkFilePackage * pPackage = *it;
+				it = list.Erase( it );
+				pPackage->Release();
+			}
+		}
+
+		void Unload( AkUInt32 in_uPackage )
+		{
+			ListFilePackages::IteratorEx it = list.BeginEx();
+			while ( it != list.End() && *it != packages[in_uPackage] )
+				++it;
+			CHECK( it != list.End() );
+			it = list.Erase( it );
+			index.RemovePackage( packages[in_uPackage], list );
+			packages[in_uPackage]->Release();
+			packages[in_uPackage] = NULL;
+		}
+
+		void SetLanguage( const AkOSChar * in_pszLanguage )
+		{
+			for ( ListFilePackages::Iterator it = list.Begin(); it != list.End(); ++it )
+				(*it)->lut.SetCurLanguage( in_pszLanguage );
+			index.Rebuild( list );
+		}
+
+		// Brute force: the first package of the list that has the file.
+		CAkFilePackage * Scan( CAkFilePackageLUT::LookupClass in_eClass, AkUInt64 in_uID, bool in_bIsLanguageSpecific ) const
+		{
+			for ( ListFilePackages::Iterator it = list.Begin(); it != list.End(); ++it )
+			{
+				if ( (*it)->lut.HasFile( in_eClass, in_uID, in_bIsLanguageSpecific ) )
+					return *it;
+			}
+			return NULL;
+		}
+
+		// Compares Find() with Scan() for every file of every table, and a few
+		// that are in no package. Counts the files that a package loaded
+		// earlier also has in out_uShadowed.
+		AkUInt32 CompareWithScan( AkUInt32 & out_uShadowed ) const
+		{
+			std::vector<AkUInt64> ids;
+			for ( AkUInt32 i = 0; i < NUM_IDS; ++i )
+			{
+				ids.push_back( FileID( Writer::Table_StmFiles, i ) );
+				ids.push_back( FileID( Writer::Table_Externals, i ) );
+				ids.push_back( FileID( Writer::Table_StmFiles, i ) + 1 );
+			}
+			ids.push_back( 0 );
+			ids.push_back( 0xFFFFFFFFFFFFFFFFULL );
+
+			AkUInt32 uMismatches = 0;
+			out_uShadowed = 0;
+			for ( size_t i = 0; i < ids.size(); ++i )
+			{
+				for ( int c = 0; c < CAkFilePackageLUT::LookupClass_Num; ++c )
+				{
+					for ( int l = 0; l < 2; ++l )
+					{
+						CAkFilePackageLUT::LookupClass eClass = (CAkFilePackageLUT::LookupClass)c;
+						CAkFilePackage * pExpected = Scan( eClass, ids[i], l != 0 );
+						uMismatches += ( index.Find( eClass, ids[i], l != 0 ) == pExpected ) ? 0 : 1;
+
+						AkUInt32 uHaving = 0;
+						for ( ListFilePackages::Iterator it = list.Begin(); it != list.End(); ++it )
+							uHaving += (*it)->lut.HasFile( eClass, ids[i], l != 0 ) ? 1 : 0;
+						out_uShadowed += ( uHaving > 1 ) ? 1 : 0;
+					}
+				}
+			}
+			return uMismatches;
+		}
+	};
+}
+
+TEST_CASE(FilePackageIndex_LastLoadedWinsUntilUnloaded)
+{
+	Packages packages;
+	CHECK( packages.index.IsValid() );
+
+	AkUInt32 uShadowed = 0;
+	CHECK( packages.CompareWithScan( uShadowed ) == 0 );
+	CHECK( uShadowed > 0 );
+	CHECK( packages.index.Find( CAkFilePackageLUT::LookupClass_SoundBank, 0, false ) == NULL );
+
+	// The files of the middle package go back to the first one; those the
+	// last one has stay with it.
+	packages.Unload( 1 );
+	CHECK( packages.CompareWithScan( uShadowed ) == 0 );
+	CHECK( uShadowed > 0 );
+
+	// Everything goes back to the first package.
+	packages.Unload( 2 );
+	CHECK( packages.CompareWithScan( uShadowed ) == 0 );
+	CHECK( uShadowed == 0 );
+
+	packages.Unload( 0 );
+	CHECK( packages.index.Find( CAkFilePackageLUT::LookupClass_StmFile, FileID( Writer::Table_StmFiles, 0 ), false ) == NULL );
+}
+
+TEST_CASE(FilePackageIndex_LanguageChangeRebuilds)
+{
+	Packages packages;
+	AkUInt32 uShadowed = 0;
+
+	packages.SetLanguage( AKTEXT("French(France)") );
+	CHECK( packages.index.IsValid() );
+	CHECK( packages.CompareWithScan( uShadowed ) == 0 );
+
+	// Removing packages after the rebuild restores the French winners.
+	packages.Unload( 1 );
+	CHECK( packages.CompareWithScan( uShadowed ) == 0 );
+	packages.Unload( 2 );
+	CHECK( packages.CompareWithScan( uShadowed ) == 0 );
+
+	// Back to English, with the first package only.
+	packages.SetLanguage( AKTEXT("English(US)") );
+	CHECK( packages.CompareWithScan( uShadowed ) == 0 );
+	CHECK( uShadowed == 0 );
+}
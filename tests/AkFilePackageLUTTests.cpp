@@ -0,0 +1,234 @@
+#include <vector>
+#include "Test.h"
+#include "AkFilePackageWriter.h"
+#include "AkFilePackageLUT.h"
+
+namespace
+{
+	typedef CAkFilePackageWriter Writer;
+
+	const AkUInt32 LANG_ENGLISH		= 1;
+	const AkUInt32 LANG_FRENCH		= 2;
+	const AkUInt32 LANG_JAPANESE	= 3;
+
+	// Small deterministic generator, so failures reproduce.
+	struct Random
+	{
+		AkUInt64 uState;
+		explicit Random( AkUInt64 in_uSeed ) : uState( in_uSeed ) {}
+		AkUInt32 Next()
+		{
+			uState = uState * 6364136223846793005ULL + 1442695040888963407ULL;
+			return (AkUInt32)( uState >> 33 );
+		}
+	};
+
+	// A package as the test sees it: the writer that made it, and its LUT.
+	struct Package
+	{
+		Writer					writer;
+		std::vector<AkUInt8>	data;
+		CAkFilePackageLUT		lut;
+
+		void Load()
+		{
+			AkUInt32 uHeaderSize = 0;
+			data = writer.Write( uHeaderSize );
+			CHECK( lut.Setup( &data[0], uHeaderSize ) == AK_Success );
+		}
+	};
+
+	// Adds in_uCount files to a table, each in a random subset of the
+	// languages and the language-neutral slot, with a 4-byte payload
+	// naming the entry.
+	void AddFiles( Writer & io_writer, Writer::Table in_eTable, AkUInt32 in_uCount, AkUInt64 in_uIDBase, Random & io_random, std::vector<AkUInt64> & io_ids )
+	{
+		const AkUInt32 languages[] = { CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID, LANG_ENGLISH, LANG_FRENCH, LANG_JAPANESE };
+		for ( AkUInt32 i = 0; i < in_uCount; ++i )
+		{
+			// Spread the IDs so that they share hash slots and low bits.
+			AkUInt64 uID = in_uIDBase + ( (AkUInt64)( io_random.Next() & 0x0FFFFFFF ) << 3 );
+			io_ids.push_back( uID );
+			AkUInt32 uMask = 1 + io_random.Next() % 15;
+			for ( AkUInt32 l = 0; l < 4; ++l )
+			{
+				if ( uMask & ( 1 << l ) )
+				{
+					std::vector<AkUInt8> payload( 4 );
+					payload[0] = (AkUInt8)in_eTable;
+					payload[1] = (AkUInt8)l;
+					payload[2] = (AkUInt8)i;
+					payload[3] = (AkUInt8)( i >> 8 );
+					io_writer.AddFile( in_eTable, uID, languages[l], payload, 1 + ( l & 1 ) * 15 );
+				}
+			}
+		}
+	}
+
+	// Brute force: the file a request must find, scanning the writer's files
+	// of the table the request goes to.
+	const Writer::File * Scan( const Writer & in_writer, CAkFilePackageLUT::LookupClass in_eClass, AkUInt64 in_uID, bool in_bIsLanguageSpecific, AkUInt32 in_uCurLanguageID )
+	{
+		Writer::Table eTable = Writer::Table_Externals;
+		if ( in_eClass != CAkFilePackageLUT::LookupClass_External )
+		{
+			if ( in_uID > 0xFFFFFFFF )
+				return NULL;
+			bool bHasBanks = false;
+			for ( size_t i = 0; i < in_writer.Files().size(); ++i )
+				bHasBanks = bHasBanks || in_writer.Files()[i].eTable == Writer::Table_SoundBanks;
+			eTable = ( in_eClass == CAkFilePackageLUT::LookupClass_SoundBank && bHasBanks ) ? Writer::Table_SoundBanks : Writer::Table_StmFiles;
+		}
+
+		AkUInt32 uLanguageID = in_bIsLanguageSpecific ? in_uCurLanguageID : CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID;
+		for ( size_t i = 0; i < in_writer.Files().size(); ++i )
+		{
+			const Writer::File & file = in_writer.Files()[i];
+			if ( file.eTable == eTable && file.uID == in_uID && file.uLanguageID == uLanguageID )
+				return &file;
+		}
+		return NULL;
+	}
+
+	template <class T_FILEID>
+	bool SameFile( const CAkFilePackageLUT::AkFileEntry<T_FILEID> * in_pEntry, const Writer::File * in_pFile )
+	{
+		if ( !in_pEntry || !in_pFile )
+			return in_pEntry == NULL && in_pFile == NULL;
+		return in_pEntry->fileID == (T_FILEID)in_pFile->uID
+			&& in_pEntry->uLanguageID == in_pFile->uLanguageID
+			&& in_pEntry->uBlockSize == in_pFile->uBlockSize
+			&& in_pEntry->uFileSize == in_pFile->data.size()
+			&& (AkUInt64)in_pEntry->uStartBlock * in_pEntry->uBlockSize == in_pFile->uOffset;
+	}
+
+	// Checks HasFile() and LookupFile() against Scan() for every ID in
+	// in_ids, in every class, with both language flags. Returns the number
+	// of mismatches.
+	AkUInt32 CompareWithScan( Package & io_package, const std::vector<AkUInt64> & in_ids, AkUInt32 in_uCurLanguageID )
+	{
+		AkUInt32 uMismatches = 0;
+		for ( size_t i = 0; i < in_ids.size(); ++i )
+		{
+			for ( int c = 0; c < CAkFilePackageLUT::LookupClass_Num; ++c )
+			{
+				for ( int l = 0; l < 2; ++l )
+				{
+					CAkFilePackageLUT::LookupClass eClass = (CAkFilePackageLUT::LookupClass)c;
+					bool bIsLanguageSpecific = l != 0;
+					const Writer::File * pExpected = Scan( io_package.writer, eClass, in_ids[i], bIsLanguageSpecific, in_uCurLanguageID );
+
+					bool bSame = io_package.lut.HasFile( eClass, in_ids[i], bIsLanguageSpecific ) == ( pExpected != NULL );
+
+					AkFileSystemFlags flags;
+					flags.bIsLanguageSpecific = bIsLanguageSpecific;
+					if ( eClass == CAkFilePackageLUT::LookupClass_External )
+					{
+						flags.uCompanyID = AKCOMPANYID_AUDIOKINETIC_EXTERNAL;
+						bSame = bSame && SameFile( io_package.lut.LookupFile( in_ids[i], &flags ), pExpected );
+					}
+					else if ( in_ids[i] <= 0xFFFFFFFF )
+					{
+						flags.uCompanyID = AKCOMPANYID_AUDIOKINETIC;
+						flags.uCodecID = ( eClass == CAkFilePackageLUT::LookupClass_SoundBank ) ? AKCODECID_BANK : AKCODECID_VORBIS;
+						bSame = bSame && SameFile( io_package.lut.LookupFile( (AkFileID)in_ids[i], &flags ), pExpected );
+					}
+					uMismatches += bSame ? 0 : 1;
+				}
+			}
+		}
+		return uMismatches;
+	}
+
+	// IDs of every table, the 32-bit truncation of each 64-bit one, and a few
+	// that are in no table.
+	std::vector<AkUInt64> Queries( const std::vector<AkUInt64> & in_ids )
+	{
+		std::vector<AkUInt64> queries = in_ids;
+		for ( size_t i = 0; i < in_ids.size(); ++i )
+		{
+			queries.push_back( in_ids[i] & 0xFFFFFFFF );
+			queries.push_back( in_ids[i] + 1 );
+		}
+		queries.push_back( 0 );
+		queries.push_back( 0xFFFFFFFF );
+		queries.push_back( 0xFFFFFFFFFFFFFFFFULL );
+		return queries;
+	}
+}
+
+TEST_CASE(FilePackageLUT_MatchesScanAcrossLanguages)
+{
+	Package package;
+	package.writer.AddLanguage( AKTEXT("English(US)"), LANG_ENGLISH );
+	package.writer.AddLanguage( AKTEXT("French(France)"), LANG_FRENCH );
+	package.writer.AddLanguage( AKTEXT("Japanese"), LANG_JAPANESE );
+
+	Random random( 1 );
+	std::vector<AkUInt64> ids;
+	AddFiles( package.writer, Writer::Table_SoundBanks, 300, 0, random, ids );
+	AddFiles( package.writer, Writer::Table_StmFiles, 200, 1, random, ids );
+	// External IDs are 64-bit; some share their low 32 bits with a sound bank.
+	AddFiles( package.writer, Writer::Table_Externals, 150, 0x100000000ULL, random, ids );
+	package.writer.AddFile( Writer::Table_Externals, ids[0] | 0x500000000ULL, CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID, std::vector<AkUInt8>( 8, 0xAB ) );
+	ids.push_back( ids[0] | 0x500000000ULL );
+	package.Load();
+
+	std::vector<AkUInt64> queries = Queries( ids );
+
+	// No current language: language-specific requests find the neutral entries.
+	CHECK( CompareWithScan( package, queries, CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID ) == 0 );
+
+	// Names are matched whatever their case.
+	CHECK( package.lut.SetCurLanguage( AKTEXT("French(France)") ) == AK_Success );
+	CHECK( CompareWithScan( package, queries, LANG_FRENCH ) == 0 );
+	CHECK( package.lut.SetCurLanguage( AKTEXT("japanese") ) == AK_Success );
+	CHECK( CompareWithScan( package, queries, LANG_JAPANESE ) == 0 );
+
+	// An unknown language leaves none current.
+	CHECK( package.lut.SetCurLanguage( AKTEXT("Klingon") ) == AK_InvalidLanguage );
+	CHECK( CompareWithScan( package, queries, CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID ) == 0 );
+	CHECK( package.lut.SetCurLanguage( AKTEXT("English(US)") ) == AK_Success );
+	CHECK( CompareWithScan( package, queries, LANG_ENGLISH ) == 0 );
+	CHECK( package.lut.SetCurLanguage( NULL ) == AK_Success );
+	CHECK( CompareWithScan( package, queries, CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID ) == 0 );
+}
+
+TEST_CASE(FilePackageLUT_EmptySoundBankTableFallsThroughToStreamedFiles)
+{
+	Package package;
+	package.writer.AddLanguage( AKTEXT("English(US)"), LANG_ENGLISH );
+	package.writer.AddLanguage( AKTEXT("French(France)"), LANG_FRENCH );
+
+	Random random( 2 );
+	std::vector<AkUInt64> ids;
+	AddFiles( package.writer, Writer::Table_StmFiles, 100, 0, random, ids );
+	AddFiles( package.writer, Writer::Table_Externals, 20, 0x700000000ULL, random, ids );
+	package.Load();
+
+	// Sound bank requests find streamed files.
+	AkUInt32 uNeutral = 0;
+	for ( size_t i = 0; i < ids.size(); ++i )
+		uNeutral += package.lut.HasFile( CAkFilePackageLUT::LookupClass_SoundBank, ids[i], false ) ? 1 : 0;
+	CHECK( uNeutral > 0 );
+
+	std::vector<AkUInt64> queries = Queries( ids );
+	CHECK( CompareWithScan( package, queries, CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID ) == 0 );
+	CHECK( package.lut.SetCurLanguage( AKTEXT("French(France)") ) == AK_Success );
+	CHECK( CompareWithScan( package, queries, LANG_FRENCH ) == 0 );
+}
+
+TEST_CASE(FilePackageLUT_SingleLanguagePackageAcceptsAnyLanguage)
+{
+	// A package with a single language string only holds SFX: any language
+	// is accepted, and language-specific requests find the neutral entries.
+	Package package;
+	package.writer.AddLanguage( AKTEXT("SFX"), 0 );
+	Random random( 3 );
+	std::vector<AkUInt64> ids;
+	AddFiles( package.writer, Writer::Table_SoundBanks, 10, 0, random, ids );
+	package.Load();
+
+	CHECK( package.lut.SetCurLanguage( AKTEXT("Klingon") ) == AK_Success );
+	CHECK( CompareWithScan( package, Queries( ids ), CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID ) == 0 );
+}
@@ -0,0 +1,201 @@
+//////////////////////////////////////////////////////////////////////
+//
+// AkFilePackageWriter.h
+//
+// Builds file packages in memory, laid out like those of the
+// AkFilePackager utility app: header chunk, language map, the sound
+// bank, streamed file and external source LUTs, then the data of each
+// file, aligned on its block size. Only meant for tests.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "AkFilePackageLUT.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class CAkFilePackageWriter
+{
+public:
+	enum Table
+	{
+		Table_SoundBanks,
+		Table_StmFiles,
+		Table_Externals,
+		Table_Num
+	};
+
+	struct File
+	{
+		Table					eTable;
+		AkUInt64				uID;
+		AkUInt32				uLanguageID;	// CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID if not language-specific.
+		AkUInt32				uBlockSize;
+		std::vector<AkUInt8>	data;
+		AkUInt64				uOffset;		// Set by Write().
+	};
+
+	// Language names are stored lower case, like the packager does.
+	void AddLanguage( const AkOSChar * in_pszName, AkUInt32 in_uLanguageID )
+	{
+		Language language;
+		for ( ; *in_pszName; ++in_pszName )
+		{
+			AkOSChar c = *in_pszName;
+			language.name.push_back( ( c >= 'A' && c <= 'Z' ) ? (AkOSChar)( c - 'A' + 'a' ) : c );
+		}
+		language.uID = in_uLanguageID;
+		m_languages.push_back( language );
+	}
+
+	void AddFile(
+		Table						in_eTable,
+		AkUInt64					in_uID,
+		AkUInt32					in_uLanguageID,
+		const std::vector<AkUInt8> &	in_data,
+		AkUInt32					in_uBlockSize = 1
+		)
+	{
+		File file = { in_eTable, in_uID, in_uLanguageID, in_uBlockSize, in_data, 0 };
+		m_files.push_back( file );
+	}
+
+	const std::vector<File> & Files() const { return m_files; }
+
+	// Returns the package. out_uHeaderSize is the size to pass to
+	// CAkFilePackageLUT::Setup(), header chunk included.
+	std::vector<AkUInt8> Write( AkUInt32 & out_uHeaderSize )
+	{
+		std::vector<AkUInt8> langMap = WriteLanguageMap();
+		std::vector<AkUInt8> luts[Table_Num];
+
+		// Header chunk, then the sizes of the maps and LUTs.
+		AkUInt32 uHeaderSize = 7 * sizeof( AkUInt32 ) + (AkUInt32)langMap.size();
+		for ( int i = 0; i < Table_Num; ++i )
+			uHeaderSize += sizeof( AkUInt32 ) + (AkUInt32)CountFiles( (Table)i ) * EntrySize( (Table)i );
+
+		// Files are laid out in the order they were added.
+		AkUInt64 uPos = uHeaderSize;
+		for ( size_t i = 0; i < m_files.size(); ++i )
+		{
+			File & file = m_files[i];
+			uPos = ( uPos + file.uBlockSize - 1 ) / file.uBlockSize * file.uBlockSize;
+			file.uOffset = uPos;
+			uPos += file.data.size();
+		}
+		for ( int i = 0; i < Table_Num; ++i )
+			luts[i] = WriteLUT( (Table)i );
+
+		std::vector<AkUInt8> package;
+		Append( package, AKPK_FILE_FORMAT_TAG );
+		Append( package, uHeaderSize - AKPK_HEADER_CHUNK_DEF_SIZE );
+		Append( package, (AkUInt32)AKPK_CURRENT_VERSION );
+		Append( package, (AkUInt32)langMap.size() );
+		for ( int i = 0; i < Table_Num; ++i )
+			Append( package, (AkUInt32)luts[i].size() );
+		package.insert( package.end(), langMap.begin(), langMap.end() );
+		for ( int i = 0; i < Table_Num; ++i )
+			package.insert( package.end(), luts[i].begin(), luts[i].end() );
+
+		package.resize( (size_t)uPos, 0 );
+		for ( size_t i = 0; i < m_files.size(); ++i )
+		{
+			if ( !m_files[i].data.empty() )
+				memcpy( &package[ (size_t)m_files[i].uOffset ], &m_files[i].data[0], m_files[i].data.size() );
+		}
+
+		out_uHeaderSize = uHeaderSize;
+		return package;
+	}
+
+private:
+	struct Language
+	{
+		std::basic_string<AkOSChar>	name;
+		AkUInt32					uID;
+	};
+
+	template <class T>
+	static void Append( std::vector<AkUInt8> & io_data, T in_value )
+	{
+		const AkUInt8 * pBytes = (const AkUInt8*)&in_value;
+		io_data.insert( io_data.end(), pBytes, pBytes + sizeof( T ) );
+	}
+
+	static AkUInt32 EntrySize( Table in_eTable )
+	{
+		return in_eTable == Table_Externals
+			? sizeof( CAkFilePackageLUT::AkFileEntry<AkUInt64> )
+			: sizeof( CAkFilePackageLUT::AkFileEntry<AkFileID> );
+	}
+
+	size_t CountFiles( Table in_eTable ) const
+	{
+		size_t uCount = 0;
+		for ( size_t i = 0; i < m_files.size(); ++i )
+			uCount += ( m_files[i].eTable == in_eTable ) ? 1 : 0;
+		return uCount;
+	}
+
+	// Strings sorted, offsets from the start of the map, padded to 4 bytes.
+	std::vector<AkUInt8> WriteLanguageMap() const
+	{
+		std::vector<Language> languages = m_languages;
+		std::sort( languages.begin(), languages.end(), []( const Language & a, const Language & b ) { return a.name < b.name; } );
+
+		std::vector<AkUInt8> map;
+		Append( map, (AkUInt32)languages.size() );
+		AkUInt32 uOffset = (AkUInt32)( sizeof( AkUInt32 ) + languages.size() * 2 * sizeof( AkUInt32 ) );
+		for ( size_t i = 0; i < languages.size(); ++i )
+		{
+			Append( map, uOffset );
+			Append( map, languages[i].uID );
+			uOffset += (AkUInt32)( ( languages[i].name.size() + 1 ) * sizeof( AkOSChar ) );
+		}
+		for ( size_t i = 0; i < languages.size(); ++i )
+		{
+			const AkUInt8 * pName = (const AkUInt8*)languages[i].name.c_str();
+			map.insert( map.end(), pName, pName + ( languages[i].name.size() + 1 ) * sizeof( AkOSChar ) );
+		}
+		while ( map.size() % 4 )
+			map.push_back( 0 );
+		return map;
+	}
+
+	// Entries sorted by ID, then language.
+	std::vector<AkUInt8> WriteLUT( Table in_eTable ) const
+	{
+		std::vector<const File*> files;
+		for ( size_t i = 0; i < m_files.size(); ++i )
+		{
+			if ( m_files[i].eTable == in_eTable )
+				files.push_back( &m_files[i] );
+		}
+		std::sort( files.begin(), files.end(), []( const File * a, const File * b ) {
+			return a->uID < b->uID || ( a->uID == b->uID && a->uLanguageID < b->uLanguageID );
+		} );
+
+		std::vector<AkUInt8> lut;
+		Append( lut, (AkUInt32)files.size() );
+		for ( size_t i = 0; i < files.size(); ++i )
+		{
+			const File & file = *files[i];
+			if ( in_eTable == Table_Externals )
+				Append( lut, file.uID );
+			else
+				Append( lut, (AkFileID)file.uID );
+			Append( lut, file.uBlockSize );
+			Append( lut, (AkUInt32)file.data.size() );
+			Append( lut, (AkUInt32)( file.uOffset / file.uBlockSize ) );
+			Append( lut, file.uLanguageID );
+		}
+		return lut;
+	}
+
+	std::vector<Language>	m_languages;
+	std::vector<File>		m_files;
+};
@@ -0,0 +1,274 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "Test.h"
+#include "AkPosixTestFile.h"
+#include "AkFilePackageWriter.h"
+#include "AkFilePackageCompression.h"
+#include "AkMappedFilePackage.h"
+
+namespace
+{
+	typedef CAkFilePackageWriter Writer;
+
+	const AkUInt32 BLOCK_SIZE = 2048;
+
+	const std::vector<AkUInt8> * g_pNextPackage = NULL;
+
+	// A mapped package whose "mapping" is a copy of g_pNextPackage, in a
+	// block of exactly its size: reads past the end of the mapping are
+	// caught by the address sanitizer. The package has no file descriptor,
+	// so it never reaches the base hook.
+	class CAkTestMappedPackage : public CAkMappedPackage
+	{
+	public:
+		// Only loaded mapped.
+		static CAkTestMappedPackage * Create( AkFilePackageReader &, const AkOSChar *, AkUInt32, AkUInt32 &, AkUInt8 *& )
+		{
+			return NULL;
+		}
+
+		static CAkTestMappedPackage * CreateMapped( AkFilePackageReader &, const AkOSChar * in_pszPackageName )
+		{
+			const std::vector<AkUInt8> & package = *g_pNextPackage;
+			if ( package.size() < AKPK_HEADER_CHUNK_DEF_SIZE )
+				return NULL;
+			AkUInt8 * pMapped = (AkUInt8*)malloc( package.size() );
+			memcpy( pMapped, &package[0], package.size() );
+
+			AkUInt32 uHeaderSize = ((const AkUInt32*)pMapped)[1] + AKPK_HEADER_CHUNK_DEF_SIZE;
+			CAkTestMappedPackage * pPackage = CAkFilePackage::CreateInPlace<CAkTestMappedPackage>( in_pszPackageName, uHeaderSize );
+			pPackage->m_pMapped = pMapped;
+			pPackage->m_uMappedSize = package.size();
+			return pPackage;
+		}
+
+		CAkTestMappedPackage( AkUInt32 in_uPackageID, AkUInt32 in_uHeaderSize, void * in_pToRelease )
+			: CAkMappedPackage( in_uPackageID, in_uHeaderSize, in_pToRelease )
+		{}
+
+		AkFileDesc * GetFileDesc() { return NULL; }
+
+		virtual void Destroy() override
+		{
+			free( m_pMapped );
+			m_pMapped = NULL;
+			CAkMappedPackage::Destroy();
+		}
+	};
+
+	class CAkTestMappedIO : public CAkFilePackageLowLevelIO<CAkDefaultIOHookDeferred, CAkTestMappedPackage>
+	{
+	public:
+		CAkTestMappedIO()
+		{
+			AkDeviceSettings deviceSettings = AkDeviceSettings();
+			deviceSettings.uIOMemorySize = 64 * 1024;
+			deviceSettings.uIOMemoryAlignment = 16;
+			deviceSettings.uGranularity = 16 * 1024;
+			deviceSettings.uMaxConcurrentIO = 8;
+			CHECK( Init( deviceSettings ) == AK_Success );
+		}
+
+		~CAkTestMappedIO()
+		{
+			Term();
+		}
+
+		// Like LoadFilePackageMapped(), with in_package as the package file.
+		AKRESULT LoadMapped( const std::vector<AkUInt8> & in_package )
+		{
+			g_pNextPackage = &in_package;
+			AkFilePackageReader reader;
+			CAkTestMappedPackage * pPackage = NULL;
+			AKRESULT eResult = _LoadMappedFilePackage( AKTEXT("Test.pck"), reader, pPackage );
+			g_pNextPackage = NULL;
+			if ( eResult == AK_Success )
+			{
+				m_packages.AddFirst( pPackage );
+				m_index.AddPackage( pPackage, m_packages );
+			}
+			return eResult;
+		}
+
+		// A streamed file of the packages; NULL if none has it.
+		AkFileDesc * OpenStreamedFile( AkFileID in_fileID )
+		{
+			AkFileSystemFlags flags;
+			flags.uCompanyID = AKCOMPANYID_AUDIOKINETIC;
+			flags.uCodecID = AKCODECID_VORBIS;
+			AkAsyncFileOpenData openData( AkFileOpenData( in_fileID, &flags ) );
+			AkFileDesc * pFileDesc = NULL;
+			return Open( openData, pFileDesc ) == AK_Success ? pFileDesc : NULL;
+		}
+
+		// Reads in_uSize bytes at in_uPosition in the file, as the Stream
+		// Manager would, into in_pBuffer.
+		AKRESULT Read( AkFileDesc * in_pFileDesc, AkUInt32 in_uPosition, AkUInt32 in_uSize, AkUInt8 * in_pBuffer )
+		{
+			AkTestCompletion completion;
+			AkAsyncIOTransferInfo transferInfo;
+			memset( &transferInfo, 0, sizeof( transferInfo ) );
+			transferInfo.uFilePosition = (AkUInt64)in_pFileDesc->uSector * GetBlockSize( *in_pFileDesc ) + in_uPosition;
+			transferInfo.uBufferSize = in_uSize;
+			transferInfo.uRequestedSize = in_uSize;
+			transferInfo.pBuffer = in_pBuffer;
+			transferInfo.pCallback = OnTransfer;
+			transferInfo.pCookie = &completion;
+
+			BatchIoTransferItem item;
+			item.pFileDesc = in_pFileDesc;
+			item.ioHeuristics.fDeadline = 1000.f;
+			item.ioHeuristics.priority = AK_DEFAULT_PRIORITY;
+			item.pTransferInfo = &transferInfo;
+			BatchRead( 1, &item );
+			AKRESULT eResult = completion.Wait();
+			return completion.calls.load() == 1 ? eResult : AK_Cancelled;
+		}
+
+	private:
+		static void OnTransfer( AkAsyncIOTransferInfo * in_pTransferInfo, AKRESULT in_eResult )
+		{
+			AkTestCompletion::OnComplete( in_pTransferInfo->pCookie, in_eResult );
+		}
+	};
+
+	std::vector<AkUInt8> FileData( AkUInt32 in_uSize, AkUInt32 in_uSeed )
+	{
+		std::vector<AkUInt8> data( in_uSize );
+		for ( AkUInt32 i = 0; i < in_uSize; ++i )
+			data[i] = CAkTestFile::Byte( i + in_uSeed );
+		return data;
+	}
+
+	std::vector<AkUInt8> Package( Writer & in_writer )
+	{
+		in_writer.AddLanguage( AKTEXT("SFX"), 0 );
+		in_writer.AddLanguage( AKTEXT("English(US)"), 1 );
+		AkUInt32 uHeaderSize = 0;
+		return in_writer.Write( uHeaderSize );
+	}
+
+	// Data of file in_uFile of a package built by in_writer.
+	const AkUInt8 * FileInPackage( const std::vector<AkUInt8> & in_package, const Writer & in_writer, size_t in_uFile )
+	{
+		return &in_package[(size_t)in_writer.Files()[in_uFile].uOffset];
+	}
+}
+
+TEST_CASE(MappedFilePackage_LastTransferPastEndOfMapping)
+{
+	// The last file ends the package, in the middle of a block.
+	const AkUInt32 FIRST_SIZE = BLOCK_SIZE * 3 + 100;
+	const AkUInt32 LAST_SIZE = BLOCK_SIZE * 2 + 300;
+	Writer writer;
+	writer.AddFile( Writer::Table_StmFiles, 1, CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID, FileData( FIRST_SIZE, 0 ), BLOCK_SIZE );
+	writer.AddFile( Writer::Table_StmFiles, 2, CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID, FileData( LAST_SIZE, 77 ), BLOCK_SIZE );
+	std::vector<AkUInt8> package = Package( writer );
+	CHECK( writer.Files()[1].uOffset + LAST_SIZE == package.size() );
+
+	CAkTestMappedIO io;
+	CHECK( io.LoadMapped( package ) == AK_Success );
+	AkFileDesc * pFirst = io.OpenStreamedFile( 1 );
+	AkFileDesc * pLast = io.OpenStreamedFile( 2 );
+	CHECK( pFirst && pLast );
+	if ( !pFirst || !pLast )
+		return;
+
+	// The last block, rounded up to the block size: only the bytes up to the
+	// end of the mapping are copied.
+	std::vector<AkUInt8> buffer( BLOCK_SIZE, 0xCD );
+	CHECK( io.Read( pLast, BLOCK_SIZE * 2, BLOCK_SIZE, &buffer[0] ) == AK_Success );
+	CHECK( memcmp( &buffer[0], FileInPackage( package, writer, 1 ) + BLOCK_SIZE * 2, 300 ) == 0 );
+	CHECK( buffer[300] == 0xCD && buffer[BLOCK_SIZE - 1] == 0xCD );
+
+	// The whole file at once, rounded up.
+	std::vector<AkUInt8> whole( BLOCK_SIZE * 3, 0xCD );
+	CHECK( io.Read( pLast, 0, BLOCK_SIZE * 3, &whole[0] ) == AK_Success );
+	CHECK( memcmp( &whole[0], FileInPackage( package, writer, 1 ), LAST_SIZE ) == 0 );
+
+	// The last block of another file ends inside the mapping.
+	CHECK( io.Read( pFirst, BLOCK_SIZE * 3, BLOCK_SIZE, &buffer[0] ) == AK_Success );
+	CHECK( memcmp( &buffer[0], FileInPackage( package, writer, 0 ) + BLOCK_SIZE * 3, 100 ) == 0 );
+
+	// Past the end of the file.
+	CHECK( io.Read( pLast, BLOCK_SIZE * 3, BLOCK_SIZE, &buffer[0] ) == AK_Fail );
+
+	io.Close( pFirst );
+	io.Close( pLast );
+}
+
+TEST_CASE(MappedFilePackage_HeaderLargerThanMapping)
+{
+	Writer writer;
+	writer.AddFile( Writer::Table_StmFiles, 1, CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID, FileData( 1000, 0 ), BLOCK_SIZE );
+	std::vector<AkUInt8> package = Package( writer );
+	AkUInt32 * pHeaderSize = (AkUInt32*)&package[sizeof( AkUInt32 )];
+	const AkUInt32 uHeaderSize = *pHeaderSize;
+
+	// One byte past the end of the mapping, and a size that wraps around
+	// in 32 bits once the header chunk is added.
+	const AkUInt32 sizes[] = { (AkUInt32)package.size() - AKPK_HEADER_CHUNK_DEF_SIZE + 1, 0xFFFFFFFF, 0xFFFFFFFF - AKPK_HEADER_CHUNK_DEF_SIZE + 1 };
+	CAkTestMappedIO io;
+	for ( AkUInt32 i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); ++i )
+	{
+		*pHeaderSize = sizes[i];
+		CHECK( io.LoadMapped( package ) == AK_Fail );
+	}
+
+	// The header chunk alone, without a header.
+	std::vector<AkUInt8> truncated( package.begin(), package.begin() + AKPK_HEADER_CHUNK_DEF_SIZE );
+	*(AkUInt32*)&truncated[sizeof( AkUInt32 )] = 1;
+	CHECK( io.LoadMapped( truncated ) == AK_Fail );
+
+	// Up to the end of the mapping.
+	*pHeaderSize = uHeaderSize;
+	CHECK( io.LoadMapped( package ) == AK_Success );
+	AkFileDesc * pFile = io.OpenStreamedFile( 1 );
+	CHECK( pFile != NULL );
+	io.Close( pFile );
+}
+
+TEST_CASE(MappedFilePackage_NoMappedDataForCompressedFiles)
+{
+	// Text-like data compresses, noise does not and is stored as is.
+	const AkUInt32 FILE_SIZE = 20000;
+	std::vector<AkUInt8> text( FILE_SIZE ), noise( FILE_SIZE );
+	AkUInt32 uState = 12345;
+	for ( AkUInt32 i = 0; i < FILE_SIZE; ++i )
+	{
+		uState = uState * 1103515245 + 12345;
+		text[i] = (AkUInt8)( 'a' + ( i / 7 ) % 13 );
+		noise[i] = (AkUInt8)( uState >> 16 );
+	}
+	Writer writer;
+	writer.AddFile( Writer::Table_StmFiles, 1, CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID, text, BLOCK_SIZE );
+	writer.AddFile( Writer::Table_StmFiles, 2, CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID, noise, BLOCK_SIZE );
+	std::vector<AkUInt8> package;
+	CAkFilePackageCompression::Stats stats;
+	CHECK( CAkFilePackageCompression::Compress( Package( writer ), 4096, AK_COMPRESSOR_DEFAULT_MIN_GAIN, package, stats ) == CAkFilePackageCompression::Result_Success );
+	CHECK( stats.uNumCompressed == 1 );
+
+	CAkTestMappedIO io;
+	CHECK( io.LoadMapped( package ) == AK_Success );
+	AkFileDesc * pCompressed = io.OpenStreamedFile( 1 );
+	AkFileDesc * pStored = io.OpenStreamedFile( 2 );
+	CHECK( pCompressed && pStored );
+	if ( !pCompressed || !pStored )
+		return;
+
+	// The data of the compressed file is not in the mapping as is.
+	CHECK( io.GetMappedData( pCompressed ) == NULL );
+	const AkUInt8 * pData = (const AkUInt8*)io.GetMappedData( pStored );
+	CHECK( pData != NULL && memcmp( pData, &noise[0], FILE_SIZE ) == 0 );
+
+	// Both read the same.
+	std::vector<AkUInt8> buffer( FILE_SIZE + BLOCK_SIZE, 0xCD );
+	CHECK( io.Read( pCompressed, 0, FILE_SIZE, &buffer[0] ) == AK_Success );
+	CHECK( memcmp( &buffer[0], &text[0], FILE_SIZE ) == 0 );
+	CHECK( io.Read( pStored, 0, FILE_SIZE, &buffer[0] ) == AK_Success );
+	CHECK( memcmp( &buffer[0], &noise[0], FILE_SIZE ) == 0 );
+
+	io.Close( pCompressed );
+	io.Close( pStored );
+}
@@ -0,0 +1,220 @@
+#include <set>
+#include <string>
+#include <vector>
+#include "Test.h"
+#include "AkMultipleFileLocation.h"
+
+namespace
+{
+	typedef std::basic_string<AkOSChar> OsString;
+
+	OsString Path( const AkOSChar * in_pszDirectory, const AkOSChar * in_pszName )
+	{
+		return OsString( in_pszDirectory ) + AK_PATH_SEPARATOR + in_pszName;
+	}
+
+	// A file location over an in-memory file system, which remembers the
+	// paths it was asked to open.
+	class CAkTestFileLocation : public CAkMultipleFileLocation
+	{
+	public:
+		std::set<OsString>		directories;	// With a trailing separator.
+		std::set<OsString>		files;
+		std::vector<OsString>	opened;
+
+		~CAkTestFileLocation() { Term(); }
+
+		void AddDirectory( const AkOSChar * in_pszDirectory )
+		{
+			directories.insert( OsString( in_pszDirectory ) + AK_PATH_SEPARATOR );
+		}
+
+		void AddFile( const AkOSChar * in_pszDirectory, const AkOSChar * in_pszName )
+		{
+			files.insert( Path( in_pszDirectory, in_pszName ) );
+		}
+
+		// Opens a file by name, without flags: the path is the base path and
+		// the name. out_path is the one that opened.
+		AKRESULT Open( const AkOSChar * in_pszName, AkOpenMode in_eOpenMode, OsString & out_path )
+		{
+			opened.clear();
+			AkFileOpenData openData;
+			openData.pszFileName = in_pszName;
+			openData.eOpenMode = in_eOpenMode;
+			AkFileDesc fileDesc;
+			AKRESULT eResult = CAkMultipleFileLocation::Open( openData, false, fileDesc );
+			out_path = ( eResult == AK_Success && !opened.empty() ) ? opened.back() : OsString();
+			return eResult;
+		}
+
+	protected:
+		virtual AKRESULT PlatformOpenFile( const AkOSChar* in_pszFullFilePath, AkOpenMode in_eOpenMode, bool, AkFileDesc & out_fileDesc )
+		{
+			opened.push_back( in_pszFullFilePath );
+			if ( in_eOpenMode == AK_OpenModeRead && files.find( in_pszFullFilePath ) == files.end() )
+				return AK_FileNotFound;
+			files.insert( in_pszFullFilePath );
+			out_fileDesc.iFileSize = 1;
+			return AK_Success;
+		}
+
+		virtual AKRESULT PlatformCheckDirectoryExists( const AkOSChar* in_pszBasePath )
+		{
+			OsString directory( in_pszBasePath );
+			if ( directory.empty() || directory[directory.size() - 1] != AK_PATH_SEPARATOR[0] )
+				directory += AK_PATH_SEPARATOR;
+			return directories.find( directory ) != directories.end() ? AK_Success : AK_PathNotFound;
+		}
+
+		// Files and subdirectories directly under in_pszDirectory.
+		virtual AKRESULT PlatformListDirectory( const AkOSChar* in_pszDirectory, AkDirectoryEntryFunc in_pfnEntry, void* in_pCookie )
+		{
+			OsString directory( in_pszDirectory );
+			bool bExists = directories.find( directory ) != directories.end();
+			std::set<OsString> subdirectories;
+			for ( std::set<OsString>::const_iterator it = files.begin(); it != files.end(); ++it )
+			{
+				if ( it->compare( 0, directory.size(), directory ) != 0 )
+					continue;
+				bExists = true;
+				OsString name = it->substr( directory.size() );
+				size_t uSeparator = name.find( AK_PATH_SEPARATOR[0] );
+				if ( uSeparator == OsString::npos )
+					in_pfnEntry( in_pCookie, name.c_str(), false );
+				else
+					subdirectories.insert( name.substr( 0, uSeparator ) );
+			}
+			for ( std::set<OsString>::const_iterator it = subdirectories.begin(); it != subdirectories.end(); ++it )
+				in_pfnEntry( in_pCookie, it->c_str(), true );
+			return bExists ? AK_Success : AK_PathNotFound;
+		}
+	};
+}
+
+TEST_CASE(MultipleFileLocation_NewestBasePathWins)
+{
+	CAkTestFileLocation location;
+	location.AddDirectory( AKTEXT("Base") );
+	location.AddDirectory( AKTEXT("Patch") );
+	location.AddFile( AKTEXT("Base"), AKTEXT("a.wem") );
+	location.AddFile( AKTEXT("Base"), AKTEXT("b.wem") );
+	location.AddFile( AKTEXT("Patch"), AKTEXT("a.wem") );
+	CHECK( location.AddBasePath( AKTEXT("Base") ) == AK_Success );
+	CHECK( location.AddBasePath( AKTEXT("Patch") ) == AK_Success );
+
+	OsString path;
+	CHECK( location.Open( AKTEXT("a.wem"), AK_OpenModeRead, path ) == AK_Success );
+	CHECK( path == Path( AKTEXT("Patch"), AKTEXT("a.wem") ) );
+	CHECK( location.opened.size() == 1 );
+
+	// The index skips the newer path, which does not have the file.
+	CHECK( location.Open( AKTEXT("b.wem"), AK_OpenModeRead, path ) == AK_Success );
+	CHECK( path == Path( AKTEXT("Base"), AKTEXT("b.wem") ) );
+	CHECK( location.opened.size() == 1 );
+
+	// Found again where it was found before.
+	CHECK( location.Open( AKTEXT("b.wem"), AK_OpenModeRead, path ) == AK_Success );
+	CHECK( location.opened.size() == 1 );
+
+	// No path has it: nothing is probed.
+	CHECK( location.Open( AKTEXT("c.wem"), AK_OpenModeRead, path ) == AK_FileNotFound );
+	CHECK( location.opened.empty() );
+}
+
+TEST_CASE(MultipleFileLocation_AddingBasePathClearsCache)
+{
+	CAkTestFileLocation location;
+	location.AddDirectory( AKTEXT("Base") );
+	location.AddFile( AKTEXT("Base"), AKTEXT("a.wem") );
+	CHECK( location.AddBasePath( AKTEXT("Base") ) == AK_Success );
+
+	OsString path;
+	CHECK( location.Open( AKTEXT("a.wem"), AK_OpenModeRead, path ) == AK_Success );
+	CHECK( path == Path( AKTEXT("Base"), AKTEXT("a.wem") ) );
+
+	location.AddDirectory( AKTEXT("DLC") );
+	location.AddFile( AKTEXT("DLC"), AKTEXT("a.wem") );
+	CHECK( location.AddBasePath( AKTEXT("DLC") ) == AK_Success );
+	CHECK( location.Open( AKTEXT("a.wem"), AK_OpenModeRead, path ) == AK_Success );
+	CHECK( path == Path( AKTEXT("DLC"), AKTEXT("a.wem") ) );
+
+	location.AddDirectory( AKTEXT("Mod") );
+	location.AddFile( AKTEXT("Mod"), AKTEXT("a.wem") );
+	CHECK( location.SetBasePath( AKTEXT("Mod") ) == AK_Success );
+	CHECK( location.Open( AKTEXT("a.wem"), AK_OpenModeRead, path ) == AK_Success );
+	CHECK( path == Path( AKTEXT("Mod"), AKTEXT("a.wem") ) );
+}
+
+TEST_CASE(MultipleFileLocation_NewFilesNeedRefresh)
+{
+	CAkTestFileLocation location;
+	location.AddDirectory( AKTEXT("Base") );
+	location.AddFile( AKTEXT("Base"), AKTEXT("a.wem") );
+	CHECK( location.AddBasePath( AKTEXT("Base") ) == AK_Success );
+
+	// Downloaded after the base path was indexed, one in a subfolder.
+	OsString subfolderFile = OsString( AKTEXT("Sub") ) + AK_PATH_SEPARATOR + AKTEXT("c.wem");
+	location.AddFile( AKTEXT("Base"), AKTEXT("b.wem") );
+	location.AddFile( AKTEXT("Base"), subfolderFile.c_str() );
+
+	OsString path;
+	CHECK( location.Open( AKTEXT("b.wem"), AK_OpenModeRead, path ) == AK_FileNotFound );
+	CHECK( location.Open( subfolderFile.c_str(), AK_OpenModeRead, path ) == AK_FileNotFound );
+	CHECK( location.opened.empty() );
+
+	location.RefreshDirectoryIndex();
+	CHECK( location.Open( AKTEXT("b.wem"), AK_OpenModeRead, path ) == AK_Success );
+	CHECK( path == Path( AKTEXT("Base"), AKTEXT("b.wem") ) );
+	CHECK( location.Open( subfolderFile.c_str(), AK_OpenModeRead, path ) == AK_Success );
+	CHECK( path == Path( AKTEXT("Base"), subfolderFile.c_str() ) );
+	CHECK( location.Open( AKTEXT("a.wem"), AK_OpenModeRead, path ) == AK_Success );
+}
+
+TEST_CASE(MultipleFileLocation_WriteAddsToIndex)
+{
+	CAkTestFileLocation location;
+	location.AddDirectory( AKTEXT("Base") );
+	location.AddDirectory( AKTEXT("Save") );
+	CHECK( location.AddBasePath( AKTEXT("Base") ) == AK_Success );
+	CHECK( location.AddBasePath( AKTEXT("Save") ) == AK_Success );
+
+	// Writes go to the newest path, and are not resolved through the index.
+	OsString path;
+	CHECK( location.Open( AKTEXT("capture.dat"), AK_OpenModeWrite, path ) == AK_Success );
+	CHECK( path == Path( AKTEXT("Save"), AKTEXT("capture.dat") ) );
+
+	// Readable without a refresh.
+	CHECK( location.Open( AKTEXT("capture.dat"), AK_OpenModeRead, path ) == AK_Success );
+	CHECK( path == Path( AKTEXT("Save"), AKTEXT("capture.dat") ) );
+	CHECK( location.opened.size() == 1 );
+}
+
+TEST_CASE(MultipleFileLocation_DeletedFileSearchedAgain)
+{
+	CAkTestFileLocation location;
+	location.AddDirectory( AKTEXT("Base") );
+	location.AddDirectory( AKTEXT("Patch") );
+	location.AddFile( AKTEXT("Base"), AKTEXT("a.wem") );
+	location.AddFile( AKTEXT("Patch"), AKTEXT("a.wem") );
+	CHECK( location.AddBasePath( AKTEXT("Base") ) == AK_Success );
+	CHECK( location.AddBasePath( AKTEXT("Patch") ) == AK_Success );
+
+	OsString path;
+	CHECK( location.Open( AKTEXT("a.wem"), AK_OpenModeRead, path ) == AK_Success );
+	CHECK( path == Path( AKTEXT("Patch"), AKTEXT("a.wem") ) );
+
+	// The remembered location fails, then every path is searched.
+	location.files.erase( Path( AKTEXT("Patch"), AKTEXT("a.wem") ) );
+	CHECK( location.Open( AKTEXT("a.wem"), AK_OpenModeRead, path ) == AK_Success );
+	CHECK( path == Path( AKTEXT("Base"), AKTEXT("a.wem") ) );
+	CHECK( location.opened.size() == 3 );
+
+	// And the new location is remembered.
+	CHECK( location.Open( AKTEXT("a.wem"), AK_OpenModeRead, path ) == AK_Success );
+	CHECK( path == Path( AKTEXT("Base"), AKTEXT("a.wem") ) );
+	CHECK( location.opened.size() == 1 );
+
+	location.files.erase( Path( AKTEXT("Base"), AKTEXT("a.wem") ) );
+	CHECK( location.Open( AKTEXT("a.wem"), AK_OpenModeRead, path ) == AK_FileNotFound );
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+// Helpers of the POSIX low-level I/O tests: a temporary file with known
+// contents, the completion of one asynchronous transfer, and a backend that
+// the test completes.
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <AK/SoundEngine/Common/AkTypes.h>
+#include "AkAsyncIoBackend.h"
+
+// A file of in_uSize bytes, byte i being Byte( i ), open for reading.
+// Removed when the object is destroyed.
+class CAkTestFile
+{
+public:
+	explicit CAkTestFile( AkUInt32 in_uSize, const char * in_pszDirectory = "/tmp" )
+		: m_data( in_uSize )
+		, m_fd( -1 )
+	{
+		for ( AkUInt32 i = 0; i < in_uSize; ++i )
+			m_data[i] = Byte( i );
+		Write( in_pszDirectory, m_data );
+	}
+
+	// A file with the given contents.
+	CAkTestFile( const std::vector<AkUInt8> & in_data, const char * in_pszDirectory = "/tmp" )
+		: m_data( in_data )
+		, m_fd( -1 )
+	{
+		Write( in_pszDirectory, m_data );
+	}
+
+	~CAkTestFile()
+	{
+		if ( m_fd >= 0 )
+			close( m_fd );
+		if ( !m_path.empty() )
+			unlink( m_path.c_str() );
+	}
+
+	static AkUInt8 Byte( AkUInt64 in_uOffset ) { return (AkUInt8)( in_uOffset * 7 + ( in_uOffset >> 8 ) ); }
+
+	bool IsValid() const { return m_fd >= 0; }
+	int Fd() const { return m_fd; }
+	AkUInt32 Size() const { return (AkUInt32)m_data.size(); }
+	const AkUInt8 * Data( AkUInt64 in_uOffset = 0 ) const { return &m_data[(size_t)in_uOffset]; }
+	const std::string & Path() const { return m_path; }
+
+	// The directory and the file name, apart.
+	std::string Directory() const { return m_path.substr( 0, m_path.rfind( '/' ) ); }
+	std::string Name() const { return m_path.substr( m_path.rfind( '/' ) + 1 ); }
+
+private:
+	void Write( const char * in_pszDirectory, const std::vector<AkUInt8> & in_data )
+	{
+		std::string path = std::string( in_pszDirectory ) + "/AkPosixTestXXXXXX";
+		std::vector<char> name( path.begin(), path.end() );
+		name.push_back( 0 );
+		int fd = mkstemp( &name[0] );
+		if ( fd < 0 )
+			return;
+		m_path = &name[0];
+		size_t uWritten = 0;
+		while ( uWritten < in_data.size() )
+		{
+			ssize_t iResult = write( fd, &in_data[uWritten], in_data.size() - uWritten );
+			if ( iResult <= 0 )
+				break;
+			uWritten += (size_t)iResult;
+		}
+		close( fd );
+		if ( uWritten == in_data.size() )
+			m_fd = open( m_path.c_str(), O_RDONLY );
+	}
+
+	std::vector<AkUInt8>	m_data;
+	std::string				m_path;
+	int						m_fd;
+};
+
+// Completion of one transfer, called on the backend's threads.
+struct AkTestCompletion
+{
+	std::promise<AKRESULT>	result;
+	std::atomic<int>		calls;
+
+	AkTestCompletion() : calls( 0 ) {}
+
+	static void OnComplete( void * in_pCookie, AKRESULT in_eResult )
+	{
+		AkTestCompletion * pThis = (AkTestCompletion*)in_pCookie;
+		if ( pThis->calls.fetch_add( 1 ) == 0 )
+			pThis->result.set_value( in_eResult );
+	}
+
+	// Waits for the first call. AK_Cancelled if there was none in time, so
+	// that a transfer lost by the code under test fails the test instead of
+	// hanging it.
+	AKRESULT Wait()
+	{
+		std::future<AKRESULT> future = result.get_future();
+		if ( future.wait_for( std::chrono::seconds( 10 ) ) != std::future_status::ready )
+			return AK_Cancelled;
+		return future.get();
+	}
+};
+
+// A backend that keeps the transfers until the test completes them, filling
+// them from a test file. Immediate ones complete within Submit().
+class CAkRecordingBackend : public CAkAsyncIoBackend
+{
+public:
+	explicit CAkRecordingBackend( const CAkTestFile & in_file, bool in_bImmediate = false )
+		: m_file( in_file )
+		, m_bImmediate( in_bImmediate )
+	{}
+
+	std::vector<AkAsyncIoRequest>	requests;
+	std::vector<bool>				completed;
+
+	virtual void Term() override {}
+	virtual void Submit( const AkAsyncIoRequest * in_pRequests, AkUInt32 in_uNumRequests ) override
+	{
+		for ( AkUInt32 i = 0; i < in_uNumRequests; ++i )
+		{
+			requests.push_back( in_pRequests[i] );
+			completed.push_back( false );
+			if ( m_bImmediate )
+				Complete( requests.size() - 1, AK_Success );
+		}
+	}
+	virtual const char * GetName() const override { return "recording"; }
+
+	// Completes transfer in_uIndex. On success, with the data of the file;
+	// it fails like a read would if the file ends before its minimum size.
+	void Complete( size_t in_uIndex, AKRESULT in_eResult )
+	{
+		AkAsyncIoRequest request = requests[in_uIndex];
+		completed[in_uIndex] = true;
+		if ( in_eResult == AK_Success )
+		{
+			struct iovec single = { request.pBuffer, request.uSize };
+			struct iovec * pIov = request.uNumIovecs ? request.pIovecs : &single;
+			AkUInt32 uNumIov = request.uNumIovecs ? request.uNumIovecs : 1;
+			AkUInt64 uOffset = request.uOffset;
+			for ( AkUInt32 i = 0; i < uNumIov && uOffset < m_file.Size(); ++i )
+			{
+				size_t uSize = (size_t)AkMin( (AkUInt64)pIov[i].iov_len, m_file.Size() - uOffset );
+				memcpy( pIov[i].iov_base, m_file.Data( uOffset ), uSize );
+				uOffset += uSize;
+			}
+			AkUInt32 uNeeded = request.uMinSize ? request.uMinSize : request.uSize;
+			if ( uOffset - request.uOffset < uNeeded )
+				in_eResult = AK_Fail;
+		}
+		request.pfnCompletion( request.pCookie, in_eResult );
+	}
+
+	// Completes every transfer not completed yet, in order.
+	void CompleteAll()
+	{
+		for ( size_t i = 0; i < requests.size(); ++i )
+		{
+			if ( !completed[i] )
+				Complete( i, AK_Success );
+		}
+	}
+
+	size_t NumPending() const
+	{
+		size_t uPending = 0;
+		for ( size_t i = 0; i < completed.size(); ++i )
+			uPending += completed[i] ? 0 : 1;
+		return uPending;
+	}
+
+protected:
+	virtual AKRESULT Init( const AkAsyncIoSettings & ) override { return AK_Success; }
+
+private:
+	const CAkTestFile &	m_file;
+	bool				m_bImmediate;
+};
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <AK/SoundEngine/Common/AkSoundEngine.h>
+#include <AK/SoundEngine/Common/IAkStreamMgr.h>
+#include <AK/SoundEngine/Common/AkStreamMgrModule.h>
+#include "AkSoundEngineStubs.h"
+#include "audioid.h"
+
+namespace
+{
+	std::mutex g_lock;
+	akstubs::PostedEvent g_lastEvent;
+	AkUInt32 g_eventCount = 0;
+	AkPlayingID g_nextPlayingID = 1;
+	AK::MemoryMgr::GlobalStats g_memoryStats = {};
+	bool g_recording = false;
+	std::vector<akstubs::SoundEngineCall> g_calls;
+	const AkOSChar* g_language = AKTEXT("English(US)");
+
+	// With g_lock held.
+	void Record(akstubs::SoundEngineCall::Type in_type, AkGameObjectID in_gameObj, AkUInt32 in_id, AkReal64 in_value)
+	{
+		if (g_recording)
+			g_calls.push_back({ in_type, in_gameObj, in_id, in_value });
+	}
+
+	// Every block starts with where it was allocated from and its size, so that any
+	// of AK::MemoryMgr's free and realloc entry points can take any block.
+	struct BlockHeader
+	{
+		void* start;
+		size_t size;
+	};
+
+	void* Allocate(size_t in_size, size_t in_alignment)
+	{
+		size_t alignment = std::max(in_alignment, (size_t)AK_SIMD_ALIGNMENT);
+		char* start = static_cast<char*>(std::malloc(sizeof(BlockHeader) + alignment + in_size));
+		if (!start)
+			return nullptr;
+		uintptr_t address = ((uintptr_t)(start + sizeof(BlockHeader)) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		BlockHeader* header = reinterpret_cast<BlockHeader*>(address) - 1;
+		header->start = start;
+		header->size = in_size;
+		return reinterpret_cast<void*>(address);
+	}
+
+	void Release(void* in_pBlock)
+	{
+		if (in_pBlock)
+			std::free((static_cast<BlockHeader*>(in_pBlock) - 1)->start);
+	}
+
+	void* Reallocate(void* in_pBlock, size_t in_size, size_t in_alignment)
+	{
+		void* block = Allocate(in_size, in_alignment);
+		if (block && in_pBlock)
+		{
+			std::memcpy(block, in_pBlock, std::min(in_size, (static_cast<BlockHeader*>(in_pBlock) - 1)->size));
+			Release(in_pBlock);
+		}
+		return block;
+	}
+}
+
+// No stream manager: stream counts come out as 0.
+AK::IAkStreamMgr* AK::IAkStreamMgr::m_pStreamMgr = nullptr;
+
+namespace akstubs
+{
+	PostedEvent LastPostedEvent()
+	{
+		std::lock_guard<std::mutex> lock(g_lock);
+		return g_lastEvent;
+	}
+
+	AkUInt32 PostedEventCount()
+	{
+		std::lock_guard<std::mutex> lock(g_lock);
+		return g_eventCount;
+	}
+
+	void BeginRecording()
+	{
+		std::lock_guard<std::mutex> lock(g_lock);
+		g_calls.clear();
+		g_recording = true;
+	}
+
+	std::vector<SoundEngineCall> EndRecording()
+	{
+		std::lock_guard<std::mutex> lock(g_lock);
+		g_recording = false;
+		std::vector<SoundEngineCall> calls;
+		calls.swap(g_calls);
+		return calls;
+	}
+
+	void SetMemoryStats(const AK::MemoryMgr::GlobalStats& in_stats)
+	{
+		std::lock_guard<std::mutex> lock(g_lock);
+		g_memoryStats = in_stats;
+	}
+
+	void SetCurrentLanguage(const AkOSChar* in_pszLanguage)
+	{
+		std::lock_guard<std::mutex> lock(g_lock);
+		g_language = in_pszLanguage;
+	}
+}
+
+AkPlayingID AK::SoundEngine::PostEvent(AkUniqueID in_eventID, AkGameObjectID in_gameObjectID, AkUInt32,
+	AkCallbackFunc, void*, AkUInt32, AkExternalSourceInfo*, AkPlayingID)
+{
+	std::lock_guard<std::mutex> lock(g_lock);
+	g_lastEvent.eventID = in_eventID;
+	g_lastEvent.gameObj = in_gameObjectID;
+	++g_eventCount;
+	Record(akstubs::SoundEngineCall::PostEvent, in_gameObjectID, in_eventID, 0.0);
+	return g_nextPlayingID++;
+}
+
+AKRESULT AK::SoundEngine::SetPosition(AkGameObjectID in_gameObjectID, const AkSoundPosition& in_position, AkSetPositionFlags)
+{
+	std::lock_guard<std::mutex> lock(g_lock);
+	Record(akstubs::SoundEngineCall::SetPosition, in_gameObjectID, 0, in_position.Position().X);
+	return AK_Success;
+}
+
+AKRESULT AK::SoundEngine::SetMultiplePositions(AkGameObjectID, const AkSoundPosition*, AkUInt16,
+	MultiPositionType, AkSetPositionFlags)
+{
+	return AK_Success;
+}
+
+AKRESULT AK::SoundEngine::SetRTPCValue(AkRtpcID in_rtpcID, AkRtpcValue in_value, AkGameObjectID in_gameObjectID,
+	AkTimeMs, AkCurveInterpolation, bool)
+{
+	std::lock_guard<std::mutex> lock(g_lock);
+	Record(akstubs::SoundEngineCall::SetRTPCValue, in_gameObjectID, in_rtpcID, in_value);
+	return AK_Success;
+}
+
+AKRESULT AK::SoundEngine::SetSwitch(AkSwitchGroupID in_switchGroup, AkSwitchStateID in_switchState, AkGameObjectID in_gameObjectID)
+{
+	std::lock_guard<std::mutex> lock(g_lock);
+	Record(akstubs::SoundEngineCall::SetSwitch, in_gameObjectID, in_switchGroup, in_switchState);
+	return AK_Success;
+}
+
+// Bank tests go through their own IBankLoader.
+AKRESULT AK::SoundEngine::LoadBank(const char*, AkBankCallbackFunc, void*, AkBankID& out_bankID, AkBankType)
+{
+	out_bankID = AK_INVALID_BANK_ID;
+	return AK_Fail;
+}
+
+AKRESULT AK::SoundEngine::UnloadBank(const char*, const void*, AkBankCallbackFunc, void*, AkBankType)
+{
+	return AK_Fail;
+}
+
+void AK::MemoryMgr::GetGlobalStats(GlobalStats& out_stats)
+{
+	std::lock_guard<std::mutex> lock(g_lock);
+	out_stats = g_memoryStats;
+}
+
+void* AK::MemoryMgr::Malloc(AkMemPoolId, size_t in_uSize)
+{
+	return Allocate(in_uSize, 0);
+}
+
+void* AK::MemoryMgr::Malign(AkMemPoolId, size_t in_uSize, AkUInt32 in_uAlignment)
+{
+	return Allocate(in_uSize, in_uAlignment);
+}
+
+void* AK::MemoryMgr::Realloc(AkMemPoolId, void* in_pAlloc, size_t in_uSize)
+{
+	return Reallocate(in_pAlloc, in_uSize, 0);
+}
+
+void* AK::MemoryMgr::ReallocAligned(AkMemPoolId, void* in_pAlloc, size_t in_uSize, AkUInt32 in_uAlignment)
+{
+	return Reallocate(in_pAlloc, in_uSize, in_uAlignment);
+}
+
+void AK::MemoryMgr::Free(AkMemPoolId, void* in_pMemAddress)
+{
+	Release(in_pMemAddress);
+}
+
+void AK::MemoryMgr::Falign(AkMemPoolId, void* in_pMemAddress)
+{
+	Release(in_pMemAddress);
+}
+
+AkUInt32 AK::SoundEngine::GetIDFromString(const char* in_pszString)
+{
+	return myengine::audio::HashAudioName(in_pszString, std::strlen(in_pszString));
+}
+
+#ifdef AK_SUPPORT_WCHAR
+AkUInt32 AK::SoundEngine::GetIDFromString(const wchar_t* in_pszString)
+{
+	// Names are ASCII.
+	std::string name;
+	for (; *in_pszString; ++in_pszString)
+		name.push_back((char)*in_pszString);
+	return myengine::audio::HashAudioName(name);
+}
+#endif
+
+const AkOSChar* AK::StreamMgr::GetCurrentLanguage()
+{
+	std::lock_guard<std::mutex> lock(g_lock);
+	return g_language;
+}
+
+// The POSIX low-level I/O tests create their device and set the resolver,
+// but never go through a Stream Manager.
+namespace
+{
+	AK::StreamMgr::IAkFileLocationResolver* g_pFileLocationResolver = nullptr;
+	AkDeviceID g_nextDeviceID = 0;
+}
+
+AK::StreamMgr::IAkFileLocationResolver* AK::StreamMgr::GetFileLocationResolver()
+{
+	std::lock_guard<std::mutex> lock(g_lock);
+	return g_pFileLocationResolver;
+}
+
+void AK::StreamMgr::SetFileLocationResolver(IAkFileLocationResolver* in_pResolver)
+{
+	std::lock_guard<std::mutex> lock(g_lock);
+	g_pFileLocationResolver = in_pResolver;
+}
+
+AKRESULT AK::StreamMgr::CreateDevice(const AkDeviceSettings&, IAkLowLevelIOHook*, AkDeviceID& out_idDevice)
+{
+	std::lock_guard<std::mutex> lock(g_lock);
+	out_idDevice = g_nextDeviceID++;
+	return AK_Success;
+}
+
+AKRESULT AK::StreamMgr::DestroyDevice(AkDeviceID)
+{
+	return AK_Success;
+}
+
+AKRESULT AK::StreamMgr::AddLanguageChangeObserver(AkLanguageChangeHandler, void*)
+{
+	return AK_Success;
+}
+
+void AK::StreamMgr::RemoveLanguageChangeObserver(void*)
+{
+}
+
+AKRESULT AK::Monitor::PostString(const char*, ErrorLevel, AkPlayingID, AkGameObjectID, AkUniqueID, bool)
+{
+	return AK_Success;
+}
+
+#if defined(AK_ENABLE_ASSERTS)
+// Normally set by the sound engine's init settings.  None: the samples' failure
+// paths under test assert on purpose.
+AkAssertHook g_pAssertHook = nullptr;
+#endif
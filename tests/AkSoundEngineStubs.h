@@ -0,0 +1,50 @@
+#pragma once
+#include <AK/SoundEngine/Common/AkTypes.h>
+#include <AK/SoundEngine/Common/AkMemoryMgr.h>
+#include <vector>
+
+// The few AK::SoundEngine entry points the tested audio code calls are defined in
+// AkSoundEngineStubs.cpp instead of linking the sound engine.  They record what was
+// posted and otherwise do nothing; position tests use their own IAudioPositionSink.
+// Between BeginRecording() and EndRecording() every call is also logged in order.
+// The memory manager entry points allocate from the heap, and the stream manager
+// only reports the current language, for the SoundEngine/Common samples.
+
+namespace akstubs
+{
+	struct PostedEvent
+	{
+		AkUniqueID eventID = AK_INVALID_UNIQUE_ID;
+		AkGameObjectID gameObj = AK_INVALID_GAME_OBJECT;
+	};
+
+	// The most recent PostEvent() call and the number of calls so far.
+	PostedEvent LastPostedEvent();
+	AkUInt32 PostedEventCount();
+
+	struct SoundEngineCall
+	{
+		enum Type
+		{
+			PostEvent,
+			SetPosition,
+			SetRTPCValue,
+			SetSwitch
+		};
+
+		Type type;
+		AkGameObjectID gameObj;
+		AkUInt32 id;		// event, RTPC or switch group
+		AkReal64 value;		// RTPC value, switch state or position X
+	};
+
+	void BeginRecording();
+	std::vector<SoundEngineCall> EndRecording();
+
+	// What AK::MemoryMgr::GetGlobalStats() reports.  All zero until set.
+	void SetMemoryStats(const AK::MemoryMgr::GlobalStats& in_stats);
+
+	// What AK::StreamMgr::GetCurrentLanguage() returns: AKTEXT("English(US)") until
+	// set.  The string is not copied.
+	void SetCurrentLanguage(const AkOSChar* in_pszLanguage);
+}
@@ -0,0 +1,197 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "Test.h"
+#include "AkSoundEngineStubs.h"
+#include "audiocommands.h"
+
+using namespace myengine::audio;
+
+namespace
+{
+	typedef akstubs::SoundEngineCall Call;
+
+	AudioCommand Event(AkGameObjectID in_gameObj, AkUniqueID in_eventID)
+	{
+		AudioCommand command = {};
+		command.type = AudioCommandType::PostEvent;
+		command.gameObj = in_gameObj;
+		command.eventID = in_eventID;
+		return command;
+	}
+
+	AudioCommand Position(AkGameObjectID in_gameObj, AkReal64 in_x)
+	{
+		AudioCommand command = {};
+		command.type = AudioCommandType::SetPosition;
+		command.gameObj = in_gameObj;
+		command.position.position[0] = in_x;
+		command.position.front[2] = 1.0f;
+		command.position.top[1] = 1.0f;
+		return command;
+	}
+
+	AudioCommand Rtpc(AkGameObjectID in_gameObj, AkRtpcID in_id, AkRtpcValue in_value)
+	{
+		AudioCommand command = {};
+		command.type = AudioCommandType::SetRTPC;
+		command.gameObj = in_gameObj;
+		command.rtpc.id = in_id;
+		command.rtpc.value = in_value;
+		return command;
+	}
+
+	AudioCommand Switch(AkGameObjectID in_gameObj, AkSwitchGroupID in_group, AkSwitchStateID in_state)
+	{
+		AudioCommand command = {};
+		command.type = AudioCommandType::SetSwitch;
+		command.gameObj = in_gameObj;
+		command.switchState.group = in_group;
+		command.switchState.state = in_state;
+		return command;
+	}
+
+	std::vector<Call> Drain(AudioCommandQueue& queue)
+	{
+		akstubs::BeginRecording();
+		queue.Drain();
+		return akstubs::EndRecording();
+	}
+
+	bool Is(const Call& in_call, Call::Type in_type, AkGameObjectID in_gameObj, AkUInt32 in_id, AkReal64 in_value = 0.0)
+	{
+		return in_call.type == in_type && in_call.gameObj == in_gameObj && in_call.id == in_id && in_call.value == in_value;
+	}
+}
+
+TEST_CASE(AudioCommands_SpillKeepsThreadOrder)
+{
+	AudioCommandQueue queue;
+	const AkUInt32 count = AudioCommandQueue::RING_CAPACITY + 500;
+	for (AkUInt32 i = 0; i < count; ++i)
+		queue.Enqueue(Event(1, i));
+
+	auto calls = Drain(queue);
+	CHECK(calls.size() == count);
+	bool ordered = true;
+	for (AkUInt32 i = 0; i < calls.size(); ++i)
+		ordered = ordered && Is(calls[i], Call::PostEvent, 1, i);
+	CHECK(ordered);
+	CHECK(queue.GetStats().overflowed == 500);
+	CHECK(queue.GetStats().drained == count && queue.GetStats().applied == count);
+
+	// The ring is usable again, and a second spill continues the sequence.
+	for (AkUInt32 i = 0; i < count; ++i)
+		queue.Enqueue(Event(1, count + i));
+	calls = Drain(queue);
+	CHECK(calls.size() == count);
+	ordered = true;
+	for (AkUInt32 i = 0; i < calls.size(); ++i)
+		ordered = ordered && Is(calls[i], Call::PostEvent, 1, count + i);
+	CHECK(ordered);
+	CHECK(queue.GetStats().overflowed == 1000);
+	CHECK(Drain(queue).empty());
+}
+
+TEST_CASE(AudioCommands_LastUpdateWinsAndGoesFirst)
+{
+	AudioCommandQueue queue;
+	queue.Enqueue(Position(1, 1.0));
+	queue.Enqueue(Event(1, 100));
+	queue.Enqueue(Rtpc(1, 5, 0.25f));
+	queue.Enqueue(Position(2, 7.0));
+	queue.Enqueue(Switch(1, 30, 31));
+	queue.Enqueue(Position(1, 2.0));
+	queue.Enqueue(Rtpc(1, 5, 0.5f));
+	queue.Enqueue(Rtpc(1, 6, 0.75f));
+	queue.Enqueue(Rtpc(2, 5, 1.0f));
+	queue.Enqueue(Event(2, 101));
+
+	auto calls = Drain(queue);
+	CHECK(calls.size() == 8);
+	if (calls.size() == 8)
+	{
+		CHECK(Is(calls[0], Call::SetPosition, 1, 0, 2.0));
+		CHECK(Is(calls[1], Call::SetPosition, 2, 0, 7.0));
+		CHECK(Is(calls[2], Call::SetRTPCValue, 1, 5, 0.5));
+		CHECK(Is(calls[3], Call::SetRTPCValue, 1, 6, 0.75));
+		CHECK(Is(calls[4], Call::SetRTPCValue, 2, 5, 1.0));
+		CHECK(Is(calls[5], Call::PostEvent, 1, 100));
+		CHECK(Is(calls[6], Call::SetSwitch, 1, 30, 31.0));
+		CHECK(Is(calls[7], Call::PostEvent, 2, 101));
+	}
+
+	const AudioCommandStats& stats = queue.GetStats();
+	CHECK(stats.drained == 10);
+	CHECK(stats.applied == 8);
+	CHECK(stats.coalesced == 2);
+	CHECK(stats.overflowed == 0);
+}
+
+TEST_CASE(AudioCommands_ProducersDrainExactlyOnce)
+{
+	AudioCommandQueue queue;
+	const AkUInt32 THREADS = 8;
+	const AkUInt32 PER_THREAD = 5000;
+
+	std::vector<Call> calls;
+	akstubs::BeginRecording();
+
+	std::atomic<AkUInt32> running{ THREADS };
+	std::vector<std::thread> threads;
+	for (AkUInt32 t = 0; t < THREADS; ++t)
+	{
+		threads.emplace_back([&queue, &running, t, PER_THREAD]
+		{
+			for (AkUInt32 i = 0; i < PER_THREAD; ++i)
+				queue.Enqueue(Event(t, i));
+			running.fetch_sub(1);
+		});
+	}
+
+	// Drain while the producers run, so rings fill, spill and get emptied under them.
+	while (running.load() > 0)
+	{
+		queue.Drain();
+		std::this_thread::yield();
+	}
+	for (auto& thread : threads)
+		thread.join();
+	queue.Drain();
+	calls = akstubs::EndRecording();
+
+	CHECK(calls.size() == THREADS * PER_THREAD);
+	std::vector<AkUInt32> next(THREADS, 0);
+	bool ordered = true;
+	for (const Call& call : calls)
+	{
+		AkGameObjectID t = call.gameObj;
+		ordered = ordered && t < THREADS && call.id == next[t];
+		if (t < THREADS)
+			++next[t];
+	}
+	CHECK(ordered);
+	for (AkUInt32 t = 0; t < THREADS; ++t)
+		CHECK(next[t] == PER_THREAD);
+
+	const AudioCommandStats& stats = queue.GetStats();
+	CHECK(stats.drained == THREADS * PER_THREAD);
+	CHECK(stats.applied == THREADS * PER_THREAD);
+	CHECK(stats.producerThreads == THREADS);
+}
+
+TEST_CASE(AudioCommands_QueuesDoNotShareRings)
+{
+	// Both queues live at the same stack address; the second must not find the
+	// first one's ring.
+	auto enqueueAndDrain = [](AkUniqueID in_eventID)
+	{
+		AudioCommandQueue queue;
+		queue.Enqueue(Event(1, in_eventID));
+		return Drain(queue);
+	};
+
+	CHECK(enqueueAndDrain(1).size() == 1);
+	auto calls = enqueueAndDrain(2);
+	CHECK(calls.size() == 1 && Is(calls[0], Call::PostEvent, 1, 2));
+}
@@ -0,0 +1,157 @@
+#include <vector>
+#include "Test.h"
+#include "audiolod.h"
+
+using namespace DirectX;
+using namespace myengine::audio;
+
+namespace
+{
+	// Default settings with a max distance of 100: boundaries at 25, 60 and 100,
+	// each widened by 5 either side.
+	const AkReal32 MAX_DISTANCE = 100.0f;
+	const XMFLOAT3 LISTENER(0.0f, 0.0f, 0.0f);
+
+	AudioLodTier MoveTo(AudioLodManager& lod, AkUInt32 in_emitter, float in_distance)
+	{
+		lod.SetPosition(in_emitter, XMFLOAT3(0.0f, 0.0f, in_distance));
+		lod.Update(LISTENER);
+		return lod.GetTier(in_emitter);
+	}
+
+	bool IsDue(const AudioLodManager& lod, AkUInt32 in_emitter)
+	{
+		return lod.GetDueMask()[in_emitter] != 0;
+	}
+}
+
+TEST_CASE(AudioLod_HysteresisAtBoundaries)
+{
+	AudioLodManager lod;
+	lod.SetEmitter(0, MAX_DISTANCE);
+
+	CHECK(MoveTo(lod, 0, 27.0f) == AudioLodTier::Near);
+	CHECK(MoveTo(lod, 0, 31.0f) == AudioLodTier::Mid);
+	CHECK(MoveTo(lod, 0, 22.0f) == AudioLodTier::Mid);
+	CHECK(MoveTo(lod, 0, 19.0f) == AudioLodTier::Near);
+
+	CHECK(MoveTo(lod, 0, 64.0f) == AudioLodTier::Mid);
+	CHECK(MoveTo(lod, 0, 66.0f) == AudioLodTier::Far);
+	CHECK(MoveTo(lod, 0, 104.0f) == AudioLodTier::Far);
+	CHECK(MoveTo(lod, 0, 106.0f) == AudioLodTier::Inaudible);
+	CHECK(MoveTo(lod, 0, 96.0f) == AudioLodTier::Inaudible);
+	CHECK(MoveTo(lod, 0, 94.0f) == AudioLodTier::Far);
+
+	// Jumping across several boundaries lands in the right tier at once.
+	CHECK(MoveTo(lod, 0, 5.0f) == AudioLodTier::Near);
+	CHECK(MoveTo(lod, 0, 200.0f) == AudioLodTier::Inaudible);
+}
+
+TEST_CASE(AudioLod_PriorityShiftsOneTier)
+{
+	AudioLodManager lod;
+	const AkUInt8 HIGH = 80;
+	const AkUInt8 LOW = 20;
+	lod.SetEmitter(0, MAX_DISTANCE, HIGH);
+	lod.SetEmitter(1, MAX_DISTANCE, LOW);
+	lod.SetEmitter(2, MAX_DISTANCE);
+
+	const float distances[] = { 10.0f, 40.0f, 80.0f, 150.0f };
+	const AudioLodTier high[] = { AudioLodTier::Near, AudioLodTier::Near, AudioLodTier::Mid, AudioLodTier::Inaudible };
+	const AudioLodTier low[] = { AudioLodTier::Mid, AudioLodTier::Far, AudioLodTier::Far, AudioLodTier::Inaudible };
+	const AudioLodTier normal[] = { AudioLodTier::Near, AudioLodTier::Mid, AudioLodTier::Far, AudioLodTier::Inaudible };
+	for (int d = 0; d < 4; ++d)
+	{
+		for (AkUInt32 e = 0; e < 3; ++e)
+			lod.SetPosition(e, XMFLOAT3(distances[d], 0.0f, 0.0f));
+		lod.Update(LISTENER);
+		CHECK(lod.GetTier(0) == high[d]);
+		CHECK(lod.GetTier(1) == low[d]);
+		CHECK(lod.GetTier(2) == normal[d]);
+	}
+
+	// A low priority emitter in range is never pushed out of it.
+	lod.SetEmitter(1, MAX_DISTANCE, 0);
+	CHECK(MoveTo(lod, 1, 90.0f) == AudioLodTier::Far);
+}
+
+TEST_CASE(AudioLod_DueOnTierChange)
+{
+	AudioLodManager lod;
+	lod.SetEmitter(0, MAX_DISTANCE);
+
+	// Frame 0 enters Far, frame 1 is off its 4-frame cadence.
+	MoveTo(lod, 0, 80.0f);
+	CHECK(IsDue(lod, 0));
+	MoveTo(lod, 0, 80.0f);
+	CHECK(!IsDue(lod, 0));
+
+	// Going out of range sends the last position, then nothing.
+	CHECK(MoveTo(lod, 0, 150.0f) == AudioLodTier::Inaudible);
+	CHECK(IsDue(lod, 0));
+	for (int frame = 0; frame < 4; ++frame)
+	{
+		MoveTo(lod, 0, 150.0f);
+		CHECK(!IsDue(lod, 0));
+	}
+
+	// Coming back is due at once, whatever the frame.
+	CHECK(MoveTo(lod, 0, 80.0f) == AudioLodTier::Far);
+	CHECK(IsDue(lod, 0));
+	CHECK(lod.GetStats().due == 1);
+}
+
+TEST_CASE(AudioLod_ThrottledEmittersSpreadOverFrames)
+{
+	AudioLodManager lod;
+	const AkUInt32 COUNT = 8;
+	for (AkUInt32 e = 0; e < COUNT; ++e)
+	{
+		lod.SetEmitter(e, MAX_DISTANCE);
+		lod.SetPosition(e, XMFLOAT3(0.0f, 0.0f, e < 4 ? 40.0f : 80.0f));
+	}
+
+	// First frame: every tier changed, all due.
+	lod.Update(LISTENER);
+	CHECK(lod.GetStats().due == COUNT);
+	CHECK(lod.GetStats().tiers[(int)AudioLodTier::Mid] == 4);
+	CHECK(lod.GetStats().tiers[(int)AudioLodTier::Far] == 4);
+
+	// Then each Mid emitter every 2 frames and each Far one every 4, staggered by
+	// index, so the same number go out every frame.
+	std::vector<AkUInt32> sent(COUNT, 0);
+	for (AkUInt64 frame = 1; frame <= 8; ++frame)
+	{
+		lod.Update(LISTENER);
+		CHECK(lod.GetStats().due == 3);
+		for (AkUInt32 e = 0; e < COUNT; ++e)
+		{
+			AkUInt32 interval = e < 4 ? 2 : 4;
+			CHECK(IsDue(lod, e) == ((frame + e) % interval == 0));
+			sent[e] += IsDue(lod, e) ? 1 : 0;
+		}
+	}
+	for (AkUInt32 e = 0; e < COUNT; ++e)
+		CHECK(sent[e] == (e < 4 ? 4u : 2u));
+}
+
+TEST_CASE(AudioLod_UnknownIndicesAreDue)
+{
+	AudioLodManager lod;
+	lod.SetEmitter(5, MAX_DISTANCE);
+	lod.SetPosition(5, XMFLOAT3(0.0f, 0.0f, 80.0f));
+	lod.Update(LISTENER);
+	lod.Update(LISTENER);
+
+	CHECK(lod.GetDueMaskSize() == 6);
+	for (AkUInt32 e = 0; e < 5; ++e)
+		CHECK(IsDue(lod, e));
+	CHECK(!IsDue(lod, 5));
+	CHECK(lod.GetStats().emitters == 1);
+
+	// A removed emitter goes back to always due.
+	lod.RemoveEmitter(5);
+	lod.Update(LISTENER);
+	CHECK(IsDue(lod, 5));
+	CHECK(lod.GetStats().emitters == 0);
+}
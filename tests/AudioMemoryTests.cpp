@@ -0,0 +1,220 @@
+#include <cstring>
+#include <future>
+#include <thread>
+#include "Test.h"
+#include "audiomemory.h"
+
+using namespace myengine::audio;
+
+namespace
+{
+	// Budgets, in blocks of the smallest class (16 bytes plus the header): Event
+	// holds 2, GameObject 4.  Object is roomy; everything else has no arena.
+	const size_t SMALL_BLOCK = 32;
+
+	AkMemSettings Install()
+	{
+		AudioMemorySettings settings;
+		for (size_t& budget : settings.budget)
+			budget = 0;
+		settings.budget[AkMemID_Object] = 64 * 1024;
+		settings.budget[AkMemID_Event] = 2 * SMALL_BLOCK;
+		settings.budget[AkMemID_GameObject] = 4 * SMALL_BLOCK;
+		settings.threadCacheBlocks = 4;
+		settings.strictBudgets = true;
+
+		AkMemSettings memSettings = {};
+		InstallAudioMemory(memSettings, settings);
+		return memSettings;
+	}
+
+	// The pools can only be installed once per process, so every test shares them.
+	const AkMemSettings& Hooks()
+	{
+		static const AkMemSettings memSettings = Install();
+		return memSettings;
+	}
+
+	AudioMemoryCategoryStats Stats(AkUInt32 in_category)
+	{
+		AudioMemoryCategoryStats stats;
+		GetAudioMemoryStats(in_category, stats);
+		return stats;
+	}
+
+	bool IsAligned(const void* in_address, size_t in_alignment)
+	{
+		return ((size_t)in_address & (in_alignment - 1)) == 0;
+	}
+}
+
+TEST_CASE(AudioMemory_RoutesToSizeClasses)
+{
+	const AkMemSettings& hooks = Hooks();
+	CHECK(IsAudioMemoryInstalled());
+	AkMemSettings again = {};
+	CHECK(InstallAudioMemory(again, AudioMemorySettings()) == AK_InvalidParameter);
+	CHECK(again.pfMalloc == nullptr);
+
+	AudioMemoryCategoryStats before = Stats(AkMemID_Object);
+	const size_t sizes[] = { 1, 16, 17, 100, 4096 };
+	const size_t classes[] = { 16, 16, 32, 128, 4096 };
+	void* blocks[5];
+	size_t pooled = 0;
+	for (int i = 0; i < 5; ++i)
+	{
+		blocks[i] = hooks.pfMalloc(AkMemID_Object, sizes[i]);
+		CHECK(blocks[i] != nullptr && IsAligned(blocks[i], 16));
+		CHECK(hooks.pfSizeOfMemory(AkMemID_Object, blocks[i]) == classes[i]);
+		pooled += 16 + classes[i];
+	}
+
+	AudioMemoryCategoryStats during = Stats(AkMemID_Object);
+	CHECK(during.allocs - before.allocs == 5);
+	CHECK(during.used - before.used == pooled);
+	CHECK(during.fallbackAllocs == before.fallbackAllocs);
+
+	// Past the largest class.
+	void* large = hooks.pfMalloc(AkMemID_Object, 4097);
+	CHECK(hooks.pfSizeOfMemory(AkMemID_Object, large) == 4097);
+	CHECK(Stats(AkMemID_Object).fallbackAllocs - before.fallbackAllocs == 1);
+
+	hooks.pfFree(AkMemID_Object, large);
+	for (void* block : blocks)
+		hooks.pfFree(AkMemID_Object, block);
+	AudioMemoryCategoryStats after = Stats(AkMemID_Object);
+	CHECK(after.used == before.used);
+	CHECK(after.fallbackUsed == before.fallbackUsed);
+	CHECK(after.frees - before.frees == 5);
+}
+
+TEST_CASE(AudioMemory_FallsBackForAlignmentDeviceAndUnbudgeted)
+{
+	const AkMemSettings& hooks = Hooks();
+	AudioMemoryCategoryStats object = Stats(AkMemID_Object);
+	AudioMemoryCategoryStats media = Stats(AkMemID_Media);
+
+	void* aligned16 = hooks.pfMalign(AkMemID_Object, 64, 16);
+	void* aligned64 = hooks.pfMalign(AkMemID_Object, 64, 64);
+	void* aligned256 = hooks.pfMalign(AkMemID_Object, 10, 256);
+	void* device = hooks.pfMalloc(AkMemID_Object | AkMemType_Device, 64);
+	void* unbudgeted = hooks.pfMalloc(AkMemID_Media, 64);
+	CHECK(IsAligned(aligned64, 64) && IsAligned(aligned256, 256));
+	CHECK(Stats(AkMemID_Object).allocs - object.allocs == 1);
+	CHECK(Stats(AkMemID_Object).fallbackAllocs - object.fallbackAllocs == 3);
+	CHECK(Stats(AkMemID_Media).fallbackAllocs - media.fallbackAllocs == 1);
+
+	// The whole payload is usable.
+	std::memset(aligned256, 0x5A, 10);
+	std::memset(device, 0x5A, 64);
+
+	hooks.pfFree(AkMemID_Object, aligned16);
+	hooks.pfFree(AkMemID_Object, aligned64);
+	hooks.pfFree(AkMemID_Object, aligned256);
+	hooks.pfFree(AkMemID_Object | AkMemType_Device, device);
+	hooks.pfFree(AkMemID_Media, unbudgeted);
+	CHECK(Stats(AkMemID_Object).fallbackUsed == object.fallbackUsed);
+	CHECK(Stats(AkMemID_Media).fallbackUsed == media.fallbackUsed);
+}
+
+TEST_CASE(AudioMemory_StrictBudgetReturnsNull)
+{
+	// This thread has no cache: blocks go straight back to the category.
+	const AkMemSettings& hooks = Hooks();
+	AudioMemoryCategoryStats before = Stats(AkMemID_Event);
+
+	void* a = hooks.pfMalloc(AkMemID_Event, 16);
+	void* b = hooks.pfMalloc(AkMemID_Event, 8);
+	CHECK(a != nullptr && b != nullptr);
+	CHECK(hooks.pfMalloc(AkMemID_Event, 16) == nullptr);
+	CHECK(hooks.pfMalloc(AkMemID_Event, 32) == nullptr);
+	CHECK(Stats(AkMemID_Event).overBudget - before.overBudget == 2);
+	CHECK(Stats(AkMemID_Event).carved == 2 * SMALL_BLOCK);
+
+	hooks.pfFree(AkMemID_Event, a);
+	void* c = hooks.pfMalloc(AkMemID_Event, 16);
+	CHECK(c == a);
+	hooks.pfFree(AkMemID_Event, b);
+	hooks.pfFree(AkMemID_Event, c);
+	CHECK(Stats(AkMemID_Event).used == before.used);
+	CHECK(Stats(AkMemID_Event).peak == 2 * SMALL_BLOCK);
+}
+
+TEST_CASE(AudioMemory_ReallocKeepsContents)
+{
+	const AkMemSettings& hooks = Hooks();
+
+	unsigned char pattern[64];
+	for (int i = 0; i < 64; ++i)
+		pattern[i] = (unsigned char)(i * 3 + 1);
+
+	char* block = static_cast<char*>(hooks.pfMalloc(AkMemID_Object, 24));
+	std::memcpy(block, pattern, 24);
+
+	// Still fits its 32-byte class.
+	CHECK(hooks.pfRealloc(AkMemID_Object, block, 30) == block);
+
+	char* grown = static_cast<char*>(hooks.pfRealloc(AkMemID_Object, block, 100));
+	CHECK(grown != block);
+	CHECK(hooks.pfSizeOfMemory(AkMemID_Object, grown) == 128);
+	CHECK(std::memcmp(grown, pattern, 24) == 0);
+	std::memcpy(grown, pattern, 64);
+
+	// To the default allocator and back.
+	char* large = static_cast<char*>(hooks.pfRealloc(AkMemID_Object, grown, 5000));
+	CHECK(hooks.pfSizeOfMemory(AkMemID_Object, large) == 5000);
+	CHECK(std::memcmp(large, pattern, 64) == 0);
+	char* small = static_cast<char*>(hooks.pfRealloc(AkMemID_Object, large, 64));
+	CHECK(hooks.pfSizeOfMemory(AkMemID_Object, small) == 64);
+	CHECK(std::memcmp(small, pattern, 64) == 0);
+
+	// A wider alignment than the block has moves it.
+	char* aligned = static_cast<char*>(hooks.pfReallocAligned(AkMemID_Object, small, 64, 128));
+	CHECK(IsAligned(aligned, 128));
+	CHECK(std::memcmp(aligned, pattern, 64) == 0);
+	hooks.pfFree(AkMemID_Object, aligned);
+
+	void* fresh = hooks.pfRealloc(AkMemID_Object, nullptr, 16);
+	CHECK(fresh != nullptr);
+	hooks.pfFree(AkMemID_Object, fresh);
+}
+
+TEST_CASE(AudioMemory_TermForThreadFlushesCache)
+{
+	const AkMemSettings& hooks = Hooks();
+	AudioMemoryCategoryStats before = Stats(AkMemID_GameObject);
+
+	std::promise<void> cached;
+	std::promise<void> checked;
+	std::thread worker([&hooks, &cached, &checked]
+	{
+		hooks.pfInitForThread();
+		void* blocks[4];
+		for (void*& block : blocks)
+			block = hooks.pfMalloc(AkMemID_GameObject, 16);
+		for (void* block : blocks)
+			hooks.pfFree(AkMemID_GameObject, block);
+
+		cached.set_value();
+		checked.get_future().wait();
+		hooks.pfTermForThread();
+	});
+
+	// The whole budget sits in the worker's cache.
+	cached.get_future().wait();
+	CHECK(Stats(AkMemID_GameObject).carved == 4 * SMALL_BLOCK);
+	CHECK(hooks.pfMalloc(AkMemID_GameObject, 16) == nullptr);
+	checked.set_value();
+	worker.join();
+
+	void* blocks[4];
+	for (void*& block : blocks)
+	{
+		block = hooks.pfMalloc(AkMemID_GameObject, 16);
+		CHECK(block != nullptr);
+	}
+	for (void* block : blocks)
+		hooks.pfFree(AkMemID_GameObject, block);
+	CHECK(Stats(AkMemID_GameObject).overBudget - before.overBudget == 1);
+	CHECK(Stats(AkMemID_GameObject).used == before.used);
+}
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <vector>
+#include "Test.h"
+#include "AkSoundEngineStubs.h"
+#include "audiomonitor.h"
+
+using namespace myengine::audio;
+
+namespace
+{
+	// Distinct, unordered CPU values so percentiles depend on the window taken.
+	AkReal32 CpuAt(AkUInt32 in_index)
+	{
+		return (AkReal32)((in_index * 7919u) % 10007u) / 100.0f;
+	}
+
+	void RecordSamples(AudioResourceMonitor& monitor, AkUInt32 in_first, AkUInt32 in_count)
+	{
+		for (AkUInt32 i = in_first; i < in_first + in_count; ++i)
+		{
+			AkResourceMonitorDataSummary summary = {};
+			summary.totalCPU = CpuAt(i);
+			summary.pluginCPU = CpuAt(i) / 2.0f;
+			summary.physicalVoices = i % 97;
+			summary.totalVoices = i % 97 + 3;
+			monitor.Record(summary);
+		}
+	}
+
+	// Same nearest-rank rule as the monitor, over a fully sorted copy.
+	AudioPercentiles Reference(std::vector<AkReal32> in_values)
+	{
+		std::sort(in_values.begin(), in_values.end());
+		auto at = [&in_values](double in_fraction) {
+			return in_values[(size_t)(in_fraction * (in_values.size() - 1) + 0.5)];
+		};
+		AudioPercentiles result;
+		result.p50 = at(0.50);
+		result.p95 = at(0.95);
+		result.p99 = at(0.99);
+		result.max = in_values.back();
+		return result;
+	}
+
+	bool SamePercentiles(const AudioPercentiles& a, const AudioPercentiles& b)
+	{
+		return a.p50 == b.p50 && a.p95 == b.p95 && a.p99 == b.p99 && a.max == b.max;
+	}
+
+	std::vector<AkReal32> CpuRange(AkUInt32 in_first, AkUInt32 in_count)
+	{
+		std::vector<AkReal32> values;
+		for (AkUInt32 i = in_first; i < in_first + in_count; ++i)
+			values.push_back(CpuAt(i));
+		return values;
+	}
+}
+
+TEST_CASE(AudioMonitor_SnapshotKeepsNewestInOrder)
+{
+	AudioResourceMonitor monitor;
+	const AkUInt32 total = AudioResourceMonitor::CAPACITY + 1000;
+	RecordSamples(monitor, 0, total);
+	CHECK(monitor.GetSampleCount() == total);
+
+	std::vector<AudioResourceSample> samples;
+	monitor.Snapshot(samples);
+	CHECK(samples.size() == AudioResourceMonitor::CAPACITY);
+	bool ordered = true;
+	for (size_t i = 0; i < samples.size(); ++i)
+	{
+		AkUInt64 index = total - AudioResourceMonitor::CAPACITY + i;
+		ordered = ordered && samples[i].index == index && samples[i].totalCPU == CpuAt((AkUInt32)index);
+	}
+	CHECK(ordered);
+
+	monitor.Snapshot(samples, 10);
+	CHECK(samples.size() == 10);
+	CHECK(samples.front().index == total - 10 && samples.back().index == total - 1);
+	CHECK(monitor.Latest().index == total - 1);
+}
+
+TEST_CASE(AudioMonitor_PercentilesMatchSortedReference)
+{
+	AudioResourceMonitor monitor;
+	const AkUInt32 total = AudioResourceMonitor::CAPACITY + 123;
+	RecordSamples(monitor, 0, total);
+
+	std::vector<AudioResourceSample> samples;
+	monitor.Snapshot(samples);
+	AudioResourcePercentiles all = AudioResourceMonitor::ComputePercentiles(samples);
+	CHECK(all.samples == AudioResourceMonitor::CAPACITY);
+	CHECK(SamePercentiles(all.totalCPU, Reference(CpuRange(total - AudioResourceMonitor::CAPACITY, AudioResourceMonitor::CAPACITY))));
+
+	std::vector<AkReal32> voices;
+	for (const AudioResourceSample& sample : samples)
+		voices.push_back((AkReal32)sample.physicalVoices);
+	CHECK(SamePercentiles(all.physicalVoices, Reference(voices)));
+	CHECK(all.physicalVoices.max == 96.0f);
+}
+
+TEST_CASE(AudioMonitor_UpdateUsesRollingWindow)
+{
+	AudioResourceMonitor monitor;
+	monitor.SetWindow(100);
+	RecordSamples(monitor, 0, 5000);
+	monitor.Update();
+
+	const AudioResourcePercentiles& rolling = monitor.GetPercentiles();
+	CHECK(rolling.samples == 100);
+	CHECK(SamePercentiles(rolling.totalCPU, Reference(CpuRange(4900, 100))));
+
+	// New samples move the window; no new samples leave it alone.
+	RecordSamples(monitor, 5000, 50);
+	monitor.Update();
+	CHECK(SamePercentiles(monitor.GetPercentiles().totalCPU, Reference(CpuRange(4950, 100))));
+	monitor.Update();
+	CHECK(monitor.GetPercentiles().samples == 100);
+
+	// Each Update() is one render frame.
+	RecordSamples(monitor, 5050, 1);
+	CHECK(monitor.Latest().frame == 3);
+}
+
+TEST_CASE(AudioMonitor_RecordsMemoryStats)
+{
+	AK::MemoryMgr::GlobalStats stats = {};
+	stats.uUsed = 3 * 1024 * 1024;
+	stats.uReserved = 8 * 1024 * 1024;
+	akstubs::SetMemoryStats(stats);
+
+	AudioResourceMonitor monitor;
+	RecordSamples(monitor, 0, 4);
+	CHECK(monitor.Latest().memUsed == stats.uUsed);
+	CHECK(monitor.Latest().memReserved == stats.uReserved);
+	CHECK(monitor.Latest().streams == 0);
+
+	std::vector<AudioResourceSample> samples;
+	monitor.Snapshot(samples);
+	CHECK(AudioResourceMonitor::ComputePercentiles(samples).memUsedMB.p50 == 3.0f);
+
+	akstubs::SetMemoryStats(AK::MemoryMgr::GlobalStats());
+}
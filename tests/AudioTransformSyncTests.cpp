@@ -0,0 +1,218 @@
+#include <vector>
+#include "Test.h"
+#include "audiotransformsync.h"
+
+using namespace DirectX;
+using namespace myengine::audio;
+
+namespace
+{
+	// Remembers every call, with the transforms that were sent.
+	class RecordingSink : public IAudioPositionSink
+	{
+	public:
+		struct Call
+		{
+			AkGameObjectID gameObj;
+			bool multiple;
+			AK::SoundEngine::MultiPositionType type;
+			std::vector<AkSoundPosition> positions;
+		};
+
+		void SetPosition(AkGameObjectID in_gameObj, const AkSoundPosition& in_position) override
+		{
+			calls.push_back({ in_gameObj, false, AK::SoundEngine::MultiPositionType_SingleSource, { in_position } });
+		}
+
+		void SetMultiplePositions(AkGameObjectID in_gameObj, const AkSoundPosition* in_positions,
+			AkUInt16 in_count, AK::SoundEngine::MultiPositionType in_type) override
+		{
+			calls.push_back({ in_gameObj, true, in_type, std::vector<AkSoundPosition>(in_positions, in_positions + in_count) });
+		}
+
+		std::vector<Call> calls;
+	};
+
+	const XMFLOAT3 FRONT(0.0f, 0.0f, 1.0f);
+	const XMFLOAT3 TOP(0.0f, 1.0f, 0.0f);
+
+	void SetPosition(AudioTransformSync& sync, AkUInt32 in_emitter, float x, float y, float z, AkUInt16 in_position = 0)
+	{
+		sync.SetTransform(in_emitter, in_position, XMFLOAT3(x, y, z), FRONT, TOP);
+	}
+
+	// Calls made by one Submit().
+	std::vector<RecordingSink::Call> Submit(AudioTransformSync& sync, const AkUInt8* in_due = nullptr, AkUInt32 in_dueCount = 0)
+	{
+		RecordingSink sink;
+		sync.Submit(sink, in_due, in_dueCount);
+		return sink.calls;
+	}
+}
+
+TEST_CASE(AudioTransformSync_SendsEveryEmitterOnce)
+{
+	AudioTransformSync sync;
+	AkUInt32 single = sync.AddEmitter(10);
+	AkUInt32 crowd = sync.AddEmitter(11, 3, AK::SoundEngine::MultiPositionType_MultiSources);
+	SetPosition(sync, single, 1.0f, 2.0f, 3.0f);
+	for (AkUInt16 p = 0; p < 3; ++p)
+		SetPosition(sync, crowd, (float)p, 0.0f, 0.0f, p);
+
+	auto calls = Submit(sync);
+	CHECK(calls.size() == 2);
+	CHECK(calls[0].gameObj == 10 && !calls[0].multiple);
+	CHECK(calls[0].positions[0].Position().X == 1.0 && calls[0].positions[0].Position().Z == 3.0);
+	CHECK(calls[1].gameObj == 11 && calls[1].multiple);
+	CHECK(calls[1].type == AK::SoundEngine::MultiPositionType_MultiSources);
+	CHECK(calls[1].positions.size() == 3 && calls[1].positions[2].Position().X == 2.0);
+	CHECK(sync.GetStats().emitters == 2 && sync.GetStats().sent == 2);
+
+	// Nothing moved.
+	CHECK(Submit(sync).empty());
+	CHECK(sync.GetStats().sent == 0);
+}
+
+TEST_CASE(AudioTransformSync_SkipsMovesBelowEpsilon)
+{
+	AudioTransformSyncSettings settings;
+	settings.positionEpsilon = 0.1f;
+	AudioTransformSync sync(settings);
+	AkUInt32 emitter = sync.AddEmitter(1);
+	SetPosition(sync, emitter, 0.0f, 0.0f, 0.0f);
+	Submit(sync);
+
+	// Small steps are compared with what was last sent, so they add up.
+	SetPosition(sync, emitter, 0.06f, 0.0f, 0.0f);
+	CHECK(Submit(sync).empty());
+	SetPosition(sync, emitter, 0.12f, 0.0f, 0.0f);
+	auto calls = Submit(sync);
+	CHECK(calls.size() == 1);
+	CHECK_NEAR(calls[0].positions[0].Position().X, 0.12, 1e-6);
+
+	SetPosition(sync, emitter, 0.12f, 0.05f, 0.0f);
+	CHECK(Submit(sync).empty());
+}
+
+TEST_CASE(AudioTransformSync_OrientationIsOrthonormalized)
+{
+	AudioTransformSync sync;
+	AkUInt32 emitter = sync.AddEmitter(1);
+
+	// Neither normalized nor orthogonal.
+	sync.SetTransform(emitter, 0, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 4.0f), XMFLOAT3(0.0f, 2.0f, 1.0f));
+	auto calls = Submit(sync);
+	CHECK(calls.size() == 1);
+	const AkVector& front = calls[0].positions[0].OrientationFront();
+	const AkVector& top = calls[0].positions[0].OrientationTop();
+	CHECK_NEAR(front.Z, 1.0f, 1e-6f);
+	CHECK_NEAR(top.Y, 1.0f, 1e-6f);
+	CHECK_NEAR(top.Z, 0.0f, 1e-6f);
+
+	// Turning past the threshold sends again; a tiny turn does not.
+	sync.SetTransform(emitter, 0, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.001f, 0.0f, 1.0f), TOP);
+	CHECK(Submit(sync).empty());
+	sync.SetTransform(emitter, 0, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.1f, 0.0f, 1.0f), TOP);
+	CHECK(Submit(sync).size() == 1);
+}
+
+TEST_CASE(AudioTransformSync_ReadsWorldMatrix)
+{
+	AudioTransformSync sync;
+	AkUInt32 emitter = sync.AddEmitter(1);
+
+	// Turned 90 degrees about y and moved: +z goes to +x.
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixRotationY(0.5f * XM_PI) * XMMatrixTranslation(5.0f, 6.0f, 7.0f));
+	sync.SetTransform(emitter, 0, world);
+
+	auto calls = Submit(sync);
+	CHECK(calls.size() == 1);
+	const AkSoundPosition& position = calls[0].positions[0];
+	CHECK_NEAR(position.Position().X, 5.0, 1e-5);
+	CHECK_NEAR(position.Position().Y, 6.0, 1e-5);
+	CHECK_NEAR(position.Position().Z, 7.0, 1e-5);
+	CHECK_NEAR(position.OrientationFront().X, 1.0f, 1e-5f);
+	CHECK_NEAR(position.OrientationTop().Y, 1.0f, 1e-5f);
+}
+
+TEST_CASE(AudioTransformSync_MultiPositionSendsAllInOneCall)
+{
+	AudioTransformSync sync;
+	AkUInt32 crowd = sync.AddEmitter(7, 4);
+	for (AkUInt16 p = 0; p < 4; ++p)
+		SetPosition(sync, crowd, 0.0f, 0.0f, (float)p, p);
+	Submit(sync);
+
+	// One member moving resends the whole group with a single call.
+	SetPosition(sync, crowd, 1.0f, 0.0f, 2.0f, 2);
+	auto calls = Submit(sync);
+	CHECK(calls.size() == 1);
+	CHECK(calls[0].multiple && calls[0].positions.size() == 4);
+	CHECK(calls[0].type == AK::SoundEngine::MultiPositionType_MultiDirections);
+	CHECK(calls[0].positions[2].Position().X == 1.0);
+	CHECK(calls[0].positions[3].Position().Z == 3.0);
+}
+
+TEST_CASE(AudioTransformSync_DueMaskThrottles)
+{
+	AudioTransformSync sync;
+	AkUInt32 a = sync.AddEmitter(1);
+	AkUInt32 b = sync.AddEmitter(2);
+	AkUInt32 c = sync.AddEmitter(3);
+
+	// Never-sent emitters go out even when they are not due.
+	AkUInt8 due[2] = { 0, 0 };
+	CHECK(Submit(sync, due, 2).size() == 3);
+
+	SetPosition(sync, a, 1.0f, 0.0f, 0.0f);
+	SetPosition(sync, b, 1.0f, 0.0f, 0.0f);
+	SetPosition(sync, c, 1.0f, 0.0f, 0.0f);
+
+	// a is skipped, b is due, c is past the end of the mask.
+	due[1] = 1;
+	auto calls = Submit(sync, due, 2);
+	CHECK(calls.size() == 2);
+	CHECK(calls[0].gameObj == 2 && calls[1].gameObj == 3);
+	CHECK(sync.GetStats().throttled == 1);
+
+	// The skipped move is still pending once a is due.
+	due[0] = 1;
+	calls = Submit(sync, due, 2);
+	CHECK(calls.size() == 1 && calls[0].gameObj == 1);
+}
+
+TEST_CASE(AudioTransformSync_RemovedEmitterSlotIsReused)
+{
+	AudioTransformSync sync;
+	AkUInt32 a = sync.AddEmitter(1);
+	AkUInt32 b = sync.AddEmitter(2, 2);
+	Submit(sync);
+
+	sync.RemoveEmitter(a);
+	CHECK(Submit(sync).empty());
+	CHECK(sync.GetStats().emitters == 1);
+
+	// Same position count: the slot comes back and is sent on its first Submit().
+	AkUInt32 c = sync.AddEmitter(3);
+	CHECK(c == a);
+	SetPosition(sync, c, 4.0f, 0.0f, 0.0f);
+	auto calls = Submit(sync);
+	CHECK(calls.size() == 1 && calls[0].gameObj == 3);
+
+	// A different count gets a new slot.
+	sync.RemoveEmitter(b);
+	CHECK(sync.AddEmitter(4, 3) != b);
+}
+
+TEST_CASE(AudioTransformSync_NullSinkCountsCalls)
+{
+	AudioTransformSync sync;
+	sync.AddEmitter(1);
+	sync.AddEmitter(2, 2);
+
+	NullAudioPositionSink sink;
+	sync.Submit(sink);
+	sync.Submit(sink);
+	CHECK(sink.GetCallCount() == 2);
+}
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "Test.h"
+#include "bankmanager.h"
+
+using namespace myengine::audio;
+
+namespace
+{
+	// Keeps every request until the test completes it.
+	class FakeBankLoader : public IBankLoader
+	{
+	public:
+		struct Request
+		{
+			std::string name;
+			bool unload;
+			AkBankCallbackFunc callback;
+			void* cookie;
+		};
+
+		AKRESULT LoadBankAsync(const char* in_pszName, AkBankCallbackFunc in_pfnCallback,
+			void* in_pCookie, AkBankID& out_bankID) override
+		{
+			log.push_back(std::string("load ") + in_pszName);
+			out_bankID = (AkBankID)log.size();
+			if (refuse == in_pszName)
+				return AK_Fail;
+			pending.push_back({ in_pszName, false, in_pfnCallback, in_pCookie });
+			return AK_Success;
+		}
+
+		AKRESULT UnloadBankAsync(const char* in_pszName, AkBankCallbackFunc in_pfnCallback,
+			void* in_pCookie) override
+		{
+			log.push_back(std::string("unload ") + in_pszName);
+			pending.push_back({ in_pszName, true, in_pfnCallback, in_pCookie });
+			return AK_Success;
+		}
+
+		// Completes the oldest request for the bank, as the bank thread would.
+		bool Complete(const std::string& in_name, AKRESULT in_result = AK_Success)
+		{
+			auto it = std::find_if(pending.begin(), pending.end(), [&in_name](const Request& r) { return r.name == in_name; });
+			if (it == pending.end())
+				return false;
+			Request request = *it;
+			pending.erase(it);
+			request.callback(0, nullptr, in_result, request.cookie);
+			return true;
+		}
+
+		size_t Count(const std::string& in_entry) const
+		{
+			return (size_t)std::count(log.begin(), log.end(), in_entry);
+		}
+
+		size_t IndexOf(const std::string& in_entry) const
+		{
+			return (size_t)(std::find(log.begin(), log.end(), in_entry) - log.begin());
+		}
+
+		std::vector<std::string> log;
+		std::vector<Request> pending;
+		std::string refuse;
+	};
+
+	struct Fixture
+	{
+		Fixture()
+			: loader(new FakeBankLoader())
+			, banks(std::unique_ptr<IBankLoader>(loader))
+		{
+		}
+
+		FakeBankLoader* loader;
+		BankManager banks;
+	};
+
+	struct Result
+	{
+		int calls = 0;
+		AKRESULT result = AK_Success;
+
+		BankManager::BankCallback Callback()
+		{
+			return [this](const std::string&, AKRESULT in_result) { ++calls; result = in_result; };
+		}
+	};
+}
+
+TEST_CASE(BankManager_DependenciesLoadFirst)
+{
+	Fixture f;
+	f.banks.DeclareBank("Level1", { "Init", "Shared" });
+	Result level;
+	f.banks.Acquire("Level1", level.Callback());
+
+	f.banks.Update();
+	CHECK(f.loader->Count("load Init") == 1 && f.loader->Count("load Shared") == 1);
+	CHECK(f.loader->Count("load Level1") == 0);
+	CHECK(f.banks.GetState("Level1") == BankState::Unloaded);
+
+	// One dependency is not enough.
+	f.loader->Complete("Init");
+	f.banks.Update();
+	CHECK(f.loader->Count("load Level1") == 0);
+
+	f.loader->Complete("Shared");
+	f.banks.Update();
+	CHECK(f.loader->Count("load Level1") == 1);
+	CHECK(f.banks.GetState("Level1") == BankState::Loading);
+	CHECK(level.calls == 0);
+
+	f.loader->Complete("Level1");
+	f.banks.Update();
+	CHECK(level.calls == 1 && level.result == AK_Success);
+	CHECK(f.banks.GetState("Level1") == BankState::Loaded);
+	CHECK(f.banks.GetBankID("Level1") == (AkBankID)(f.loader->IndexOf("load Level1") + 1));
+	CHECK(f.banks.GetStats().loadsSucceeded == 3 && f.banks.GetStats().loadsInFlight == 0);
+}
+
+TEST_CASE(BankManager_ReleaseWhileLoadingUnloadsAfterwards)
+{
+	Fixture f;
+	f.banks.SetUnloadDelay(std::chrono::milliseconds(0));
+	f.banks.DeclareBank("A", { "Init" });
+	f.banks.Acquire("A");
+	f.banks.Update();
+	f.loader->Complete("Init");
+	f.banks.Update();
+	CHECK(f.banks.GetState("A") == BankState::Loading);
+
+	f.banks.Release("A");
+	CHECK(f.banks.GetState("A") == BankState::Loading);
+
+	f.loader->Complete("A");
+	f.banks.Update();
+	CHECK(f.banks.GetState("A") == BankState::PendingUnload);
+	CHECK(f.banks.GetState("Init") == BankState::Loaded);
+
+	f.banks.Update();
+	CHECK(f.banks.GetState("A") == BankState::Unloading);
+	CHECK(f.loader->Count("unload A") == 1);
+
+	// Its dependency is released only once it is gone.
+	f.loader->Complete("A");
+	f.banks.Update();
+	CHECK(f.banks.GetState("A") == BankState::Unloaded);
+	CHECK(f.banks.GetState("Init") == BankState::PendingUnload);
+	f.banks.Update();
+	CHECK(f.loader->Count("unload Init") == 1);
+}
+
+TEST_CASE(BankManager_ReacquireWithinDelayKeepsBank)
+{
+	Fixture f;
+	f.banks.SetUnloadDelay(std::chrono::hours(1));
+	f.banks.Acquire("A");
+	f.banks.Update();
+	f.loader->Complete("A");
+	f.banks.Update();
+
+	f.banks.Release("A");
+	f.banks.Update();
+	CHECK(f.banks.GetState("A") == BankState::PendingUnload);
+	CHECK(f.banks.GetBankID("A") == AK_INVALID_BANK_ID);
+
+	Result again;
+	f.banks.Acquire("A", again.Callback());
+	CHECK(f.banks.GetState("A") == BankState::Loaded);
+	f.banks.Update();
+	CHECK(again.calls == 1 && again.result == AK_Success);
+	CHECK(f.loader->Count("load A") == 1);
+	CHECK(f.loader->Count("unload A") == 0);
+}
+
+TEST_CASE(BankManager_FailedDependencyFailsDependent)
+{
+	Fixture f;
+	f.banks.DeclareBank("Level", { "Dep" });
+	Result level;
+	f.banks.Acquire("Level", level.Callback());
+	f.banks.Update();
+
+	f.loader->Complete("Dep", AK_FileNotFound);
+	f.banks.Update();
+	CHECK(f.banks.GetState("Dep") == BankState::Failed);
+	CHECK(f.banks.GetState("Level") == BankState::Failed);
+	CHECK(level.calls == 1 && level.result == AK_FileNotFound);
+	CHECK(f.loader->Count("load Level") == 0);
+
+	// A refused request fails the same way, without a callback from the loader.
+	f.loader->refuse = "Refused";
+	Result refused;
+	f.banks.Acquire("Refused", refused.Callback());
+	f.banks.Update();
+	f.banks.Update();
+	CHECK(refused.calls == 1 && refused.result == AK_Fail);
+	CHECK(f.banks.GetStats().loadsFailed == 2 && f.banks.GetStats().loadsInFlight == 0);
+}
+
+TEST_CASE(BankManager_PreloadLevelReportsFirstFailureOnce)
+{
+	Fixture f;
+	f.banks.SetPreloadList("L", { "A", "B", "C" });
+	int calls = 0;
+	AKRESULT result = AK_Success;
+	f.banks.PreloadLevel("L", [&calls, &result](const std::string& in_level, AKRESULT in_result) {
+		calls += in_level == "L" ? 1 : 100;
+		result = in_result;
+	});
+	f.banks.Update();
+	CHECK(f.loader->pending.size() == 3);
+
+	f.loader->Complete("B", AK_FileNotFound);
+	f.loader->Complete("A");
+	f.banks.Update();
+	CHECK(calls == 0);
+
+	f.loader->Complete("C", AK_Fail);
+	f.banks.Update();
+	CHECK(calls == 1 && result == AK_FileNotFound);
+	f.banks.Update();
+	CHECK(calls == 1);
+
+	// An empty level reports success right away.
+	int emptyCalls = 0;
+	f.banks.PreloadLevel("Empty", [&emptyCalls](const std::string&, AKRESULT in_result) { emptyCalls += in_result == AK_Success ? 1 : 100; });
+	f.banks.Update();
+	CHECK(emptyCalls == 1);
+
+	f.banks.SetUnloadDelay(std::chrono::milliseconds(0));
+	f.banks.ReleaseLevel("L");
+	CHECK(f.banks.GetState("A") == BankState::PendingUnload);
+	CHECK(f.banks.GetState("B") == BankState::Failed);
+}
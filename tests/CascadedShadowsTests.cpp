@@ -0,0 +1,171 @@
+//***************************************************************************************
+// CascadedShadowsTests.cpp
+//***************************************************************************************
+
+#include "Test.h"
+#include "CascadedShadows.h"
+
+using namespace DirectX;
+
+namespace
+{
+    const XMFLOAT3 LightDir = { 0.57735f, -0.57735f, 0.57735f };
+
+    CascadeCameraDesc MakeCamera(float x, float y, float z, float yaw)
+    {
+        CascadeCameraDesc camera;
+        XMStoreFloat4x4(&camera.InvView, XMMatrixRotationY(yaw) * XMMatrixTranslation(x, y, z));
+        camera.FovY = 0.25f * XM_PI;
+        camera.Aspect = 16.0f / 9.0f;
+        camera.NearZ = 1.0f;
+        camera.FarZ = 1000.0f;
+        return camera;
+    }
+
+    BoundingSphere MakeSceneBounds()
+    {
+        BoundingSphere scene;
+        scene.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        scene.Radius = 200.0f;
+        return scene;
+    }
+
+    // World-space corners of the camera frustum between two view depths.
+    void SliceCorners(const CascadeCameraDesc& camera, float sliceNear, float sliceFar, XMVECTOR* corners)
+    {
+        XMMATRIX invView = XMLoadFloat4x4(&camera.InvView);
+        float tanHalfFovY = std::tan(0.5f * camera.FovY);
+        const float depths[2] = { sliceNear, sliceFar };
+        for(int i = 0; i < 8; ++i)
+        {
+            float d = depths[i / 4];
+            float x = (i & 1 ? 1.0f : -1.0f) * d * tanHalfFovY * camera.Aspect;
+            float y = (i & 2 ? 1.0f : -1.0f) * d * tanHalfFovY;
+            corners[i] = XMVector3TransformCoord(XMVectorSet(x, y, d, 1.0f), invView);
+        }
+    }
+}
+
+TEST_CASE(CascadedShadows_SplitsBlendUniformAndLog)
+{
+    float splits[MaxShadowCascades + 1];
+
+    ComputeCascadeSplits(1.0f, 101.0f, 4, 0.0f, splits);
+    for(uint32_t i = 0; i <= 4; ++i)
+        CHECK_NEAR(splits[i], 1.0f + 25.0f*i, 1e-3f);
+
+    ComputeCascadeSplits(1.0f, 81.0f, 4, 1.0f, splits);
+    for(uint32_t i = 0; i < 4; ++i)
+        CHECK_NEAR(splits[i + 1] / splits[i], 3.0f, 1e-3f);
+
+    // The practical scheme lies between the two and stays increasing.
+    float uniform[MaxShadowCascades + 1], logarithmic[MaxShadowCascades + 1];
+    ComputeCascadeSplits(1.0f, 150.0f, 4, 0.0f, uniform);
+    ComputeCascadeSplits(1.0f, 150.0f, 4, 1.0f, logarithmic);
+    ComputeCascadeSplits(1.0f, 150.0f, 4, 0.75f, splits);
+    CHECK(splits[0] == 1.0f && splits[4] == 150.0f);
+    for(uint32_t i = 1; i < 4; ++i)
+    {
+        CHECK(splits[i] > splits[i - 1]);
+        CHECK(splits[i] > logarithmic[i] && splits[i] < uniform[i]);
+    }
+}
+
+TEST_CASE(CascadedShadows_SlicesEndAtShadowDistance)
+{
+    CascadeSettings settings;
+    ShadowCascade cascades[MaxShadowCascades];
+    ComputeShadowCascades(MakeCamera(0.0f, 2.0f, 0.0f, 0.0f), LightDir, MakeSceneBounds(), settings, cascades);
+
+    CHECK(cascades[0].SplitNear == 1.0f);
+    for(uint32_t i = 1; i < settings.CascadeCount; ++i)
+        CHECK(cascades[i].SplitNear == cascades[i - 1].SplitFar);
+    CHECK(cascades[settings.CascadeCount - 1].SplitFar == settings.MaxShadowDistance);
+}
+
+TEST_CASE(CascadedShadows_CascadesContainTheirSlices)
+{
+    CascadeSettings settings;
+    CascadeCameraDesc camera = MakeCamera(10.0f, 2.0f, -30.0f, 0.6f);
+    BoundingSphere scene = MakeSceneBounds();
+    ShadowCascade cascades[MaxShadowCascades];
+    ComputeShadowCascades(camera, LightDir, scene, settings, cascades);
+
+    for(uint32_t i = 0; i < settings.CascadeCount; ++i)
+    {
+        const ShadowCascade& cascade = cascades[i];
+        XMMATRIX shadowTransform = XMLoadFloat4x4(&cascade.ShadowTransform);
+        XMVECTOR center = XMLoadFloat3(&cascade.ReceiverBounds.Center);
+
+        XMVECTOR corners[8];
+        SliceCorners(camera, cascade.SplitNear, cascade.SplitFar, corners);
+        for(int c = 0; c < 8; ++c)
+        {
+            float distance = XMVectorGetX(XMVector3Length(corners[c] - center));
+            CHECK(distance <= cascade.ReceiverBounds.Radius + 1e-3f);
+
+            XMFLOAT3 uvz;
+            XMStoreFloat3(&uvz, XMVector3TransformCoord(corners[c], shadowTransform));
+            CHECK(uvz.x >= 0.0f && uvz.x <= 1.0f);
+            CHECK(uvz.y >= 0.0f && uvz.y <= 1.0f);
+            CHECK(uvz.z >= 0.0f && uvz.z <= 1.0f);
+        }
+
+        // Casters anywhere in the scene between the light and the slice are in depth range.
+        XMVECTOR towardLight = -1.0f * XMVector3Normalize(XMLoadFloat3(&LightDir));
+        XMVECTOR sceneTop = XMVectorMultiplyAdd(XMVectorReplicate(scene.Radius), towardLight,
+            XMLoadFloat3(&scene.Center));
+        XMFLOAT3 topUvz;
+        XMStoreFloat3(&topUvz, XMVector3TransformCoord(sceneTop, shadowTransform));
+        CHECK(topUvz.z >= -1e-4f);
+    }
+}
+
+TEST_CASE(CascadedShadows_FitIsStableAsCameraMoves)
+{
+    CascadeSettings settings;
+    BoundingSphere scene = MakeSceneBounds();
+    ShadowCascade a[MaxShadowCascades];
+    ShadowCascade b[MaxShadowCascades];
+
+    // Turning the camera does not change the texel size.
+    ComputeShadowCascades(MakeCamera(0.0f, 2.0f, 0.0f, 0.0f), LightDir, scene, settings, a);
+    ComputeShadowCascades(MakeCamera(0.0f, 2.0f, 0.0f, 1.3f), LightDir, scene, settings, b);
+    for(uint32_t i = 0; i < settings.CascadeCount; ++i)
+        CHECK(a[i].ReceiverBounds.Radius == b[i].ReceiverBounds.Radius);
+
+    // Moving it shifts each projection by whole texels only.
+    ComputeShadowCascades(MakeCamera(0.37f, 2.0f, 0.81f, 0.0f), LightDir, scene, settings, b);
+    for(uint32_t i = 0; i < settings.CascadeCount; ++i)
+    {
+        float texelSize = 2.0f * a[i].ReceiverBounds.Radius / (float)settings.Resolution;
+        float dx = (b[i].LightCenterLS.x - a[i].LightCenterLS.x) / texelSize;
+        float dy = (b[i].LightCenterLS.y - a[i].LightCenterLS.y) / texelSize;
+        CHECK_NEAR(dx, std::round(dx), 1e-2f);
+        CHECK_NEAR(dy, std::round(dy), 1e-2f);
+    }
+}
+
+TEST_CASE(CascadedShadows_SetDepthRangeKeepsFootprint)
+{
+    CascadeSettings settings;
+    ShadowCascade cascades[MaxShadowCascades];
+    ComputeShadowCascades(MakeCamera(0.0f, 2.0f, 0.0f, 0.0f), LightDir, MakeSceneBounds(), settings, cascades);
+
+    ShadowCascade cascade = cascades[1];
+    float nearZ = cascade.LightNearZ + 10.0f;
+    float farZ = cascade.LightFarZ + 5.0f;
+    SetCascadeDepthRange(cascade, nearZ, farZ);
+
+    CHECK(cascade.LightNearZ == nearZ && cascade.LightFarZ == farZ);
+    CHECK(cascade.LightCenterLS.x == cascades[1].LightCenterLS.x);
+    CHECK(cascade.LightCenterLS.y == cascades[1].LightCenterLS.y);
+
+    // The eye sits on the new near plane.
+    XMFLOAT3 eyeLS;
+    XMStoreFloat3(&eyeLS, XMVector3TransformCoord(XMLoadFloat3(&cascade.LightPosW),
+        XMLoadFloat4x4(&cascade.LightView)));
+    CHECK_NEAR(eyeLS.z, nearZ, 1e-3f);
+    CHECK_NEAR(eyeLS.x, cascade.LightCenterLS.x, 1e-3f);
+    CHECK_NEAR(eyeLS.y, cascade.LightCenterLS.y, 1e-3f);
+}
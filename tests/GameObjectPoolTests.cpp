@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <set>
+#include <thread>
+#include <vector>
+#include "Test.h"
+#include "AkSoundEngineStubs.h"
+#include "gameobject.h"
+
+using namespace myengine::audio;
+
+namespace
+{
+	const AkGameObjectID FIRST_ID = 1000;
+}
+
+TEST_CASE(GameObjectPool_SlotsMapToIDs)
+{
+	AudioGameObjectPool pool(FIRST_ID);
+
+	AudioObjectHandle handles[3];
+	pool.Allocate(3, handles);
+	CHECK(pool.LiveCount() == 3);
+
+	for (AkUInt32 i = 0; i < 3; ++i)
+	{
+		CHECK(handles[i].IsValid());
+		CHECK(pool.Get(handles[i])->GetID() == FIRST_ID + i);
+		CHECK(pool.Find(FIRST_ID + i) == handles[i]);
+	}
+
+	CHECK(!pool.Find(FIRST_ID - 1).IsValid());
+	CHECK(!pool.Find(FIRST_ID + 3).IsValid());
+	CHECK(pool.Get(AudioObjectHandle()) == nullptr);
+}
+
+TEST_CASE(GameObjectPool_RecyclesIDsInFifoOrder)
+{
+	AudioGameObjectPool pool(FIRST_ID);
+
+	AudioObjectHandle handles[4];
+	pool.Allocate(4, handles);
+
+	// Free 2 then 0; they come back in that order, with the same IDs.
+	CHECK(pool.Free(&handles[2], 1) == 1);
+	CHECK(pool.Free(&handles[0], 1) == 1);
+	CHECK(pool.LiveCount() == 2);
+	CHECK(!pool.Find(FIRST_ID + 2).IsValid());
+
+	AudioObjectHandle first = pool.Allocate();
+	AudioObjectHandle second = pool.Allocate();
+	AudioObjectHandle third = pool.Allocate();
+	CHECK(pool.Get(first)->GetID() == FIRST_ID + 2);
+	CHECK(pool.Get(second)->GetID() == FIRST_ID + 0);
+	CHECK(pool.Get(third)->GetID() == FIRST_ID + 4);
+
+	// The old handles stay stale even though their slots are live again.
+	CHECK(first.index == handles[2].index && first != handles[2]);
+	CHECK(pool.Get(handles[2]) == nullptr);
+	CHECK(pool.Get(handles[0]) == nullptr);
+	CHECK(pool.Find(FIRST_ID + 2) == first);
+	CHECK(pool.LiveCount() == 5);
+}
+
+TEST_CASE(GameObjectPool_FreeIgnoresStaleHandles)
+{
+	AudioGameObjectPool pool(FIRST_ID);
+
+	AudioObjectHandle handles[2];
+	pool.Allocate(2, handles);
+
+	AudioObjectHandle batch[4] = { handles[0], handles[0], AudioObjectHandle(), handles[1] };
+	CHECK(pool.Free(batch, 4) == 2);
+	CHECK(pool.LiveCount() == 0);
+	CHECK(pool.Free(handles, 2) == 0);
+
+	AudioObjectHandle bogus;
+	bogus.index = 77;
+	bogus.generation = 1;
+	CHECK(pool.Get(bogus) == nullptr);
+	CHECK(pool.Free(&bogus, 1) == 0);
+}
+
+TEST_CASE(GameObjectPool_PointersSurviveGrowth)
+{
+	AudioGameObjectPool pool(FIRST_ID);
+
+	AudioObjectHandle first = pool.Allocate();
+	AudioGameObject* object = pool.Get(first);
+
+	std::vector<AudioObjectHandle> more(3 * AudioGameObjectPool::CHUNK_SIZE);
+	pool.Allocate((AkUInt32)more.size(), more.data());
+
+	CHECK(pool.Get(first) == object);
+	CHECK(object->GetID() == FIRST_ID);
+	CHECK(pool.Get(more.back())->GetID() == FIRST_ID + more.size());
+	CHECK(pool.LiveCount() == 1 + more.size());
+}
+
+TEST_CASE(GameObjectPool_ConcurrentAllocateAndFree)
+{
+	AudioGameObjectPool pool(FIRST_ID);
+	const AkUInt32 THREADS = 4;
+	const AkUInt32 ROUNDS = 200;
+	const AkUInt32 BATCH = 16;
+
+	// Each thread keeps the handles of its last round alive.
+	std::vector<std::vector<AudioObjectHandle>> kept(THREADS);
+	std::vector<std::thread> threads;
+	for (AkUInt32 t = 0; t < THREADS; ++t)
+	{
+		threads.emplace_back([&pool, &kept, t, ROUNDS, BATCH]
+		{
+			std::vector<AudioObjectHandle> handles(BATCH);
+			for (AkUInt32 round = 0; round < ROUNDS; ++round)
+			{
+				pool.Allocate(BATCH, handles.data());
+				if (round + 1 < ROUNDS)
+					pool.Free(handles.data(), BATCH);
+			}
+			kept[t] = handles;
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	CHECK(pool.LiveCount() == THREADS * BATCH);
+
+	std::set<AkGameObjectID> ids;
+	for (const auto& handles : kept)
+	{
+		for (const AudioObjectHandle& handle : handles)
+		{
+			AudioGameObject* object = pool.Get(handle);
+			CHECK(object != nullptr);
+			if (object != nullptr)
+				ids.insert(object->GetID());
+		}
+	}
+	CHECK(ids.size() == THREADS * BATCH);
+}
+
+TEST_CASE(GameObjectPool_RecycledObjectPostsWithItsID)
+{
+	AudioGameObjectPool pool(FIRST_ID);
+
+	AudioObjectHandle a = pool.Allocate();
+	pool.Allocate();
+	pool.Free(&a, 1);
+	AudioObjectHandle b = pool.Allocate();
+
+	constexpr AkUniqueID FOOTSTEP = "Play_Footstep"_akid;
+	AkUInt32 before = akstubs::PostedEventCount();
+	CHECK(pool.Get(b)->PostEvent(FOOTSTEP));
+	CHECK(akstubs::PostedEventCount() == before + 1);
+	CHECK(akstubs::LastPostedEvent().eventID == FOOTSTEP);
+	CHECK(akstubs::LastPostedEvent().gameObj == FIRST_ID);
+
+	CHECK(pool.Get(b)->PostEvent(std::string("play_footstep")));
+	CHECK(akstubs::LastPostedEvent().eventID == FOOTSTEP);
+}
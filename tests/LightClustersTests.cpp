@@ -0,0 +1,294 @@
+//***************************************************************************************
+// LightClustersTests.cpp
+//***************************************************************************************
+
+#include "Test.h"
+#include "LightClusters.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+using namespace DirectX;
+
+namespace
+{
+    ClusterGridDesc MakeGrid()
+    {
+        ClusterGridDesc grid;
+        grid.TilesX = 8;
+        grid.TilesY = 5;
+        grid.SlicesZ = 12;
+        grid.NearZ = 1.0f;
+        grid.FarZ = 200.0f;
+        return grid;
+    }
+
+    // Lights scattered around the camera, including some behind it and outside the
+    // frustum.
+    std::vector<ClusterLight> MakeLights(uint32_t count, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> xy(-80.0f, 80.0f);
+        std::uniform_real_distribution<float> z(-20.0f, 220.0f);
+        std::uniform_real_distribution<float> radius(0.5f, 12.0f);
+
+        std::vector<ClusterLight> lights(count);
+        for(ClusterLight& light : lights)
+            light = MakePointClusterLight(XMFLOAT3(xy(rng), xy(rng), z(rng)), radius(rng));
+        return lights;
+    }
+
+    // Light indices per cluster, sorted, from a builder's output.
+    std::vector<std::vector<uint32_t>> Lists(const LightClusterBuilder& builder)
+    {
+        const auto& ranges = builder.GetClusterRanges();
+        const auto& indices = builder.GetLightIndices();
+
+        std::vector<std::vector<uint32_t>> lists(ranges.size());
+        for(size_t c = 0; c < ranges.size(); ++c)
+        {
+            lists[c].assign(indices.begin() + ranges[c].Offset,
+                indices.begin() + ranges[c].Offset + ranges[c].Count);
+            std::sort(lists[c].begin(), lists[c].end());
+        }
+        return lists;
+    }
+
+    // Tests every light against every froxel AABB.  Lights are in view space already.
+    std::vector<std::vector<uint32_t>> BruteForceLists(const ClusterGridDesc& grid,
+        const std::vector<ClusterLight>& lights)
+    {
+        float tanY = std::tan(0.5f * grid.FovY);
+        float tanX = tanY * grid.Aspect;
+
+        std::vector<std::vector<uint32_t>> lists(grid.TilesX * grid.TilesY * grid.SlicesZ);
+        for(uint32_t z = 0; z < grid.SlicesZ; ++z)
+        {
+            float zn = grid.NearZ * std::pow(grid.FarZ / grid.NearZ, (float)z / grid.SlicesZ);
+            float zf = grid.NearZ * std::pow(grid.FarZ / grid.NearZ, (float)(z + 1) / grid.SlicesZ);
+            for(uint32_t y = 0; y < grid.TilesY; ++y)
+            {
+                float top = (1.0f - 2.0f * y / grid.TilesY) * tanY;
+                float bottom = (1.0f - 2.0f * (y + 1) / grid.TilesY) * tanY;
+                for(uint32_t x = 0; x < grid.TilesX; ++x)
+                {
+                    float left = (-1.0f + 2.0f * x / grid.TilesX) * tanX;
+                    float right = (-1.0f + 2.0f * (x + 1) / grid.TilesX) * tanX;
+                    float minX = std::min(left * zn, left * zf), maxX = std::max(right * zn, right * zf);
+                    float minY = std::min(bottom * zn, bottom * zf), maxY = std::max(top * zn, top * zf);
+
+                    for(uint32_t i = 0; i < (uint32_t)lights.size(); ++i)
+                    {
+                        const ClusterLight& light = lights[i];
+                        float dx = std::max({ 0.0f, minX - light.Center.x, light.Center.x - maxX });
+                        float dy = std::max({ 0.0f, minY - light.Center.y, light.Center.y - maxY });
+                        float dz = std::max({ 0.0f, zn - light.Center.z, light.Center.z - zf });
+                        if(dx*dx + dy*dy + dz*dz <= light.Radius * light.Radius)
+                            lists[(z * grid.TilesY + y) * grid.TilesX + x].push_back(i);
+                    }
+                }
+            }
+        }
+        return lists;
+    }
+}
+
+TEST_CASE(LightClusters_SliceFromDepthIsExponential)
+{
+    LightClusterBuilder builder;
+    builder.SetGrid(MakeGrid());
+
+    CHECK(builder.SliceFromDepth(0.1f) == 0);
+    CHECK(builder.SliceFromDepth(1.5f) == 0);
+    CHECK(builder.SliceFromDepth(199.0f) == 11);
+    CHECK(builder.SliceFromDepth(5000.0f) == 11);
+
+    // Slice z starts at NearZ * (FarZ/NearZ)^(z/SlicesZ).
+    float start = std::pow(200.0f, 5.0f / 12.0f);
+    CHECK(builder.SliceFromDepth(start * 1.01f) == 5);
+    CHECK(builder.SliceFromDepth(start * 0.99f) == 4);
+}
+
+TEST_CASE(LightClusters_PointLightLandsInItsCluster)
+{
+    LightClusterBuilder builder;
+    builder.SetGrid(MakeGrid());
+
+    // One small light straight ahead and one behind the camera.
+    ClusterLight lights[2] =
+    {
+        MakePointClusterLight(XMFLOAT3(0.0f, 0.0f, 50.0f), 0.1f),
+        MakePointClusterLight(XMFLOAT3(0.0f, 0.0f, -50.0f), 10.0f),
+    };
+    builder.Build(lights, 2, XMMatrixIdentity());
+
+    CHECK(builder.GetStats().LightCount == 2);
+    CHECK(builder.GetStats().VisibleLightCount == 1);
+
+    // The screen center sits on the corner of four tiles (8x5 grid: x 3..4, row 2).
+    uint32_t slice = builder.SliceFromDepth(50.0f);
+    const auto& ranges = builder.GetClusterRanges();
+    const auto& indices = builder.GetLightIndices();
+    uint32_t hits = 0;
+    for(uint32_t c = 0; c < builder.ClusterCount(); ++c)
+    {
+        for(uint32_t k = 0; k < ranges[c].Count; ++k)
+            CHECK(indices[ranges[c].Offset + k] == 0);
+        hits += ranges[c].Count;
+    }
+    CHECK(hits >= 1 && hits <= 2);
+    CHECK(ranges[builder.ClusterIndex(3, 2, slice)].Count + ranges[builder.ClusterIndex(4, 2, slice)].Count == hits);
+}
+
+TEST_CASE(LightClusters_HitsStayWithinClusterBounds)
+{
+    ClusterGridDesc grid = MakeGrid();
+    LightClusterBuilder builder;
+    builder.SetGrid(grid);
+
+    std::vector<ClusterLight> lights = MakeLights(3000, 7);
+    builder.Build(lights.data(), (uint32_t)lights.size(), XMMatrixIdentity());
+
+    // The froxel AABBs are conservative, so the builder may drop some of their hits
+    // but must never report a light outside them.
+    auto bounds = BruteForceLists(grid, lights);
+    auto actual = Lists(builder);
+    CHECK(actual.size() == bounds.size());
+
+    bool subset = true;
+    for(size_t c = 0; c < bounds.size(); ++c)
+        subset = subset && std::includes(bounds[c].begin(), bounds[c].end(), actual[c].begin(), actual[c].end());
+    CHECK(subset);
+    CHECK(builder.GetStats().IndexCount == builder.GetLightIndices().size());
+}
+
+TEST_CASE(LightClusters_CoversEveryLitPoint)
+{
+    ClusterGridDesc grid = MakeGrid();
+    LightClusterBuilder builder;
+    builder.SetGrid(grid);
+
+    std::vector<ClusterLight> lights = MakeLights(3000, 5);
+    builder.Build(lights.data(), (uint32_t)lights.size(), XMMatrixIdentity());
+    auto actual = Lists(builder);
+
+    float tanY = std::tan(0.5f * grid.FovY);
+    float tanX = tanY * grid.Aspect;
+
+    // Points inside each light that are in the frustum must find the light in the
+    // cluster they fall in.
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    uint32_t tested = 0;
+    uint32_t missed = 0;
+    for(uint32_t i = 0; i < (uint32_t)lights.size(); ++i)
+    {
+        const ClusterLight& light = lights[i];
+        for(int sample = 0; sample < 32; ++sample)
+        {
+            float ox = unit(rng), oy = unit(rng), oz = unit(rng);
+            if(ox*ox + oy*oy + oz*oz > 1.0f)
+                continue;
+
+            float x = light.Center.x + ox*light.Radius;
+            float y = light.Center.y + oy*light.Radius;
+            float z = light.Center.z + oz*light.Radius;
+            if(z <= grid.NearZ || z >= grid.FarZ)
+                continue;
+
+            float u = x / (z * tanX);
+            float v = y / (z * tanY);
+            if(std::fabs(u) >= 1.0f || std::fabs(v) >= 1.0f)
+                continue;
+
+            uint32_t tileX = std::min((uint32_t)(0.5f * (u + 1.0f) * grid.TilesX), grid.TilesX - 1);
+            uint32_t tileY = std::min((uint32_t)(0.5f * (1.0f - v) * grid.TilesY), grid.TilesY - 1);
+            const auto& list = actual[builder.ClusterIndex(tileX, tileY, builder.SliceFromDepth(z))];
+
+            ++tested;
+            if(!std::binary_search(list.begin(), list.end(), i))
+                ++missed;
+        }
+    }
+    CHECK(tested > 1000);
+    CHECK(missed == 0);
+}
+
+TEST_CASE(LightClusters_ViewTransformIsApplied)
+{
+    ClusterGridDesc grid = MakeGrid();
+    LightClusterBuilder moved;
+    LightClusterBuilder reference;
+    moved.SetGrid(grid);
+    reference.SetGrid(grid);
+
+    // Moving the lights and the camera together changes nothing.
+    std::vector<ClusterLight> lights = MakeLights(500, 11);
+    std::vector<ClusterLight> shifted = lights;
+    for(ClusterLight& light : shifted)
+        light.Center.x += 30.0f;
+
+    reference.Build(lights.data(), (uint32_t)lights.size(), XMMatrixIdentity());
+    moved.Build(shifted.data(), (uint32_t)shifted.size(), XMMatrixTranslation(-30.0f, 0.0f, 0.0f));
+    CHECK(Lists(moved) == Lists(reference));
+}
+
+TEST_CASE(LightClusters_SlicesBuildOnSeveralThreads)
+{
+    ClusterGridDesc grid = MakeGrid();
+    LightClusterBuilder serial;
+    LightClusterBuilder threaded;
+    serial.SetGrid(grid);
+    threaded.SetGrid(grid);
+
+    std::vector<ClusterLight> lights = MakeLights(2000, 3);
+    serial.Build(lights.data(), (uint32_t)lights.size(), XMMatrixIdentity());
+
+    // Run twice so the second build reuses the lists of the first.
+    for(int pass = 0; pass < 2; ++pass)
+    {
+        threaded.BeginBuild(lights.data(), (uint32_t)lights.size(), XMMatrixIdentity());
+        std::thread worker([&threaded]{ threaded.AssignSlices(0, 5); });
+        threaded.AssignSlices(5, 12);
+        worker.join();
+        threaded.FinishBuild();
+
+        CHECK(threaded.GetLightIndices() == serial.GetLightIndices());
+        CHECK(threaded.GetStats().MaxLightsPerCluster == serial.GetStats().MaxLightsPerCluster);
+        const auto& a = threaded.GetClusterRanges();
+        const auto& b = serial.GetClusterRanges();
+        bool same = a.size() == b.size();
+        for(size_t c = 0; same && c < a.size(); ++c)
+            same = a[c].Offset == b[c].Offset && a[c].Count == b[c].Count;
+        CHECK(same);
+    }
+}
+
+TEST_CASE(LightClusters_SpotSphereHoldsTheCone)
+{
+    XMFLOAT3 apex(1.0f, 2.0f, 3.0f);
+    XMFLOAT3 dir(0.0f, 0.0f, 1.0f);
+    const float range = 10.0f;
+
+    const float cosAngles[] = { 0.95f, 0.8f, 0.5f, 0.1f, -0.2f };
+    for(float cosHalfAngle : cosAngles)
+    {
+        ClusterLight light = MakeSpotClusterLight(apex, dir, range, cosHalfAngle);
+        XMVECTOR center = XMLoadFloat3(&light.Center);
+
+        // The apex and the rim of the cap at full range.
+        float sinHalfAngle = std::sqrt(1.0f - cosHalfAngle*cosHalfAngle);
+        XMVECTOR points[3] =
+        {
+            XMLoadFloat3(&apex),
+            XMVectorSet(apex.x + range*sinHalfAngle, apex.y, apex.z + range*cosHalfAngle, 0.0f),
+            XMVectorSet(apex.x, apex.y + range, apex.z, 0.0f),
+        };
+        uint32_t pointCount = cosHalfAngle <= 0.0f ? 3 : 2;
+        for(uint32_t i = 0; i < pointCount; ++i)
+            CHECK(XMVectorGetX(XMVector3Length(points[i] - center)) <= light.Radius + 1e-4f);
+
+        CHECK(light.Radius <= range + 1e-4f);
+    }
+}
@@ -0,0 +1,120 @@
+//***************************************************************************************
+// LinearAllocatorTests.cpp
+//***************************************************************************************
+
+#include "Test.h"
+#include "LinearAllocator.h"
+
+#include <cstring>
+
+namespace
+{
+    bool IsAligned(const void* p, size_t alignment)
+    {
+        return (reinterpret_cast<uintptr_t>(p) & (alignment - 1)) == 0;
+    }
+}
+
+TEST_CASE(LinearAllocator_BumpsWithAlignment)
+{
+    LinearAllocator alloc(256);
+
+    auto a = static_cast<uint8_t*>(alloc.Allocate(3, 1));
+    auto b = static_cast<uint8_t*>(alloc.Allocate(8, 16));
+    auto c = static_cast<uint8_t*>(alloc.Allocate(4, 64));
+    CHECK(IsAligned(b, 16) && IsAligned(c, 64));
+    CHECK(b == a + 16);
+    CHECK(c == a + 64);
+    CHECK(alloc.GetStats().BytesUsed == 68);
+
+    double* d = alloc.AllocateArray<double>(2);
+    CHECK(IsAligned(d, alignof(double)));
+    CHECK(reinterpret_cast<uint8_t*>(d) == a + 72);
+    CHECK(alloc.GetStats().OverflowCount == 0);
+}
+
+TEST_CASE(LinearAllocator_OverflowKeepsAlignment)
+{
+    LinearAllocator alloc(64);
+
+    void* inArena = alloc.Allocate(48);
+    void* spilled = alloc.Allocate(32, 32);
+    CHECK(IsAligned(spilled, 32));
+    CHECK(spilled != inArena);
+
+    // Wider than the arena base alignment goes to the heap even when there is room.
+    LinearAllocator roomy(4096);
+    void* wide = roomy.Allocate(16, 256);
+    CHECK(IsAligned(wide, 256));
+    CHECK(roomy.GetStats().BytesUsed == 0);
+    CHECK(roomy.GetStats().OverflowCount == 1);
+    CHECK(roomy.GetStats().OverflowBytes == 16);
+
+    // Overflow memory must be writable over its full size.
+    std::memset(spilled, 0xAB, 32);
+    std::memset(wide, 0xAB, 16);
+}
+
+TEST_CASE(LinearAllocator_ResetFreesOverflow)
+{
+    LinearAllocator alloc(128);
+
+    alloc.Allocate(100);
+    alloc.Allocate(64);
+    alloc.Allocate(32);
+    LinearAllocatorStats stats = alloc.GetStats();
+    CHECK(stats.BytesUsed == 100);
+    CHECK(stats.OverflowBytes == 96);
+    CHECK(stats.OverflowCount == 2);
+    CHECK(stats.HighWaterMark == 196);
+
+    alloc.Reset();
+    stats = alloc.GetStats();
+    CHECK(stats.BytesUsed == 0);
+    CHECK(stats.OverflowBytes == 0);
+    CHECK(stats.OverflowCount == 0);
+    CHECK(stats.TotalOverflowCount == 2);
+    CHECK(stats.HighWaterMark == 196);
+
+    // The arena is reused from the start.
+    void* first = alloc.Allocate(8);
+    alloc.Reset();
+    CHECK(alloc.Allocate(8) == first);
+}
+
+TEST_CASE(LinearAllocator_HighWaterMarkKeepsPeak)
+{
+    LinearAllocator alloc(1024);
+
+    alloc.Allocate(600, 1);
+    alloc.Reset();
+    alloc.Allocate(100, 1);
+    CHECK(alloc.GetStats().HighWaterMark == 600);
+    alloc.Reset();
+
+    alloc.Allocate(1000, 1);
+    alloc.Allocate(200, 1);
+    CHECK(alloc.GetStats().HighWaterMark == 1200);
+    alloc.Reset();
+    CHECK(alloc.GetStats().HighWaterMark == 1200);
+    CHECK(alloc.GetStats().TotalOverflowCount == 1);
+}
+
+TEST_CASE(LinearAllocator_FrameVectorGrowsPastCapacity)
+{
+    LinearAllocator alloc(256);
+
+    FrameVector<uint32_t> values{ LinearStlAllocator<uint32_t>(alloc) };
+    for(uint32_t i = 0; i < 1000; ++i)
+        values.push_back(i);
+
+    CHECK(values.size() == 1000);
+    bool intact = true;
+    for(uint32_t i = 0; i < 1000; ++i)
+        intact = intact && values[i] == i;
+    CHECK(intact);
+
+    // Old buffers are never handed back, so growth spills to the heap.
+    CHECK(alloc.GetStats().OverflowCount > 0);
+    CHECK(alloc.GetStats().BytesUsed <= alloc.GetStats().Capacity);
+}
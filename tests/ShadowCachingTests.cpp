@@ -0,0 +1,248 @@
+//***************************************************************************************
+// ShadowCachingTests.cpp
+//***************************************************************************************
+
+#include "Test.h"
+#include "ShadowCaching.h"
+
+using namespace DirectX;
+
+namespace
+{
+    const XMFLOAT3 LightDir = { 0.57735f, -0.57735f, 0.57735f };
+    const uint32_t AllCascades = (1u << MaxShadowCascades) - 1;
+
+    struct Scene
+    {
+        CascadeCameraDesc Camera;
+        BoundingSphere Bounds;
+        CascadeSettings Settings;
+
+        Scene()
+        {
+            XMStoreFloat4x4(&Camera.InvView, XMMatrixTranslation(0.0f, 2.0f, 0.0f));
+            Camera.FovY = 0.25f * XM_PI;
+            Camera.Aspect = 16.0f / 9.0f;
+            Camera.NearZ = 1.0f;
+            Camera.FarZ = 1000.0f;
+
+            Bounds.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+            Bounds.Radius = 200.0f;
+        }
+
+        void Fit(const XMFLOAT3& lightDir, ShadowCascade* cascades)const
+        {
+            ComputeShadowCascades(Camera, lightDir, Bounds, Settings, cascades);
+        }
+    };
+
+    BoundingBox MakeBox(FXMVECTOR center, float extent)
+    {
+        BoundingBox box;
+        XMStoreFloat3(&box.Center, center);
+        box.Extents = XMFLOAT3(extent, extent, extent);
+        return box;
+    }
+
+    // A small box 'along' units from the cascade's receiver center along the light,
+    // and 'across' units sideways.
+    BoundingBox BoxNearReceivers(const ShadowCascade& cascade, float along, float across)
+    {
+        XMVECTOR dir = XMVector3Normalize(XMLoadFloat3(&LightDir));
+        XMVECTOR side = XMVector3Normalize(XMVector3Cross(dir, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+        XMVECTOR center = XMLoadFloat3(&cascade.ReceiverBounds.Center);
+        center = center + along*dir + across*side;
+        return MakeBox(center, 0.5f);
+    }
+
+    // Cascades the box can shadow.
+    uint32_t TouchedCascades(const ShadowCascade* cascades, const BoundingBox& box)
+    {
+        uint32_t mask = 0;
+        for(uint32_t i = 0; i < MaxShadowCascades; ++i)
+        {
+            float z;
+            if(ShadowReceiverVolume(cascades[i]).Intersects(box, &z))
+                mask |= 1u << i;
+        }
+        return mask;
+    }
+
+    // Runs one frame of the tracker the way SkinnedMeshApp does.
+    uint32_t Frame(ShadowCacheTracker& tracker, const Scene& scene, const XMFLOAT3& lightDir,
+        const std::vector<ShadowCasterState>& casters, ShadowCascade* cascades)
+    {
+        scene.Fit(tracker.SelectLightDirection(lightDir), cascades);
+        return tracker.Update(cascades, scene.Settings.CascadeCount, casters.data(), (uint32_t)casters.size());
+    }
+}
+
+TEST_CASE(ShadowCaching_ReceiverVolumeExtendsTowardLight)
+{
+    Scene scene;
+    ShadowCascade cascades[MaxShadowCascades];
+    scene.Fit(LightDir, cascades);
+    const ShadowCascade& cascade = cascades[1];
+    float radius = cascade.ReceiverBounds.Radius;
+
+    ShadowReceiverVolume volume(cascade);
+    float nearZ = 0.0f;
+
+    // Far up toward the light, outside the cascade's own sphere.
+    CHECK(volume.Intersects(BoxNearReceivers(cascade, -(radius + 50.0f), 0.0f), &nearZ));
+    CHECK(nearZ < cascade.LightFarZ - 2.0f*radius);
+
+    // Behind the receivers, or beside the sweep.
+    CHECK(!volume.Intersects(BoxNearReceivers(cascade, radius + 5.0f, 0.0f), &nearZ));
+    CHECK(!volume.Intersects(BoxNearReceivers(cascade, -10.0f, radius + 5.0f), &nearZ));
+}
+
+TEST_CASE(ShadowCaching_CullKeepsCastersThatCanShadow)
+{
+    Scene scene;
+    ShadowCascade cascades[MaxShadowCascades];
+    scene.Fit(LightDir, cascades);
+    const ShadowCascade& cascade = cascades[0];
+    float radius = cascade.ReceiverBounds.Radius;
+
+    BoundingBox boxes[4] =
+    {
+        BoxNearReceivers(cascade, radius + 5.0f, 0.0f),
+        BoxNearReceivers(cascade, -30.0f, 0.0f),
+        BoxNearReceivers(cascade, 0.0f, radius + 5.0f),
+        BoxNearReceivers(cascade, 0.0f, 0.0f),
+    };
+    uint32_t visible[4];
+    float casterNearZ = 0.0f;
+    uint32_t count = CullShadowCastersExtruded(cascade, 4,
+        [&boxes](uint32_t i) -> const BoundingBox& { return boxes[i]; }, visible, &casterNearZ);
+
+    CHECK(count == 2);
+    CHECK(visible[0] == 1 && visible[1] == 3);
+
+    // The nearest survivor is the one up toward the light.
+    float z;
+    ShadowReceiverVolume(cascade).Intersects(boxes[1], &z);
+    CHECK(casterNearZ == z);
+
+    count = CullShadowCastersExtruded(cascade, 1,
+        [&boxes](uint32_t) -> const BoundingBox& { return boxes[0]; }, visible, &casterNearZ);
+    CHECK(count == 0);
+    CHECK(casterNearZ == FLT_MAX);
+}
+
+TEST_CASE(ShadowCaching_StaticSceneIsRenderedOnce)
+{
+    Scene scene;
+    ShadowCacheTracker tracker;
+    ShadowCascade cascades[MaxShadowCascades];
+    std::vector<ShadowCasterState> casters(1);
+    casters[0].Bounds = MakeBox(XMVectorSet(0.0f, 1.0f, 20.0f, 1.0f), 1.0f);
+
+    CHECK(Frame(tracker, scene, LightDir, casters, cascades) == AllCascades);
+
+    // Re-rendered cascades get extra depth so small moves do not invalidate them.
+    ShadowCascade fitted[MaxShadowCascades];
+    scene.Fit(LightDir, fitted);
+    for(uint32_t i = 0; i < MaxShadowCascades; ++i)
+    {
+        float slack = tracker.GetSettings().DepthSlack * fitted[i].ReceiverBounds.Radius;
+        CHECK_NEAR(cascades[i].LightNearZ, fitted[i].LightNearZ - slack, 1e-3f);
+        CHECK_NEAR(cascades[i].LightFarZ, fitted[i].LightFarZ + slack, 1e-3f);
+    }
+
+    for(int frame = 0; frame < 5; ++frame)
+        CHECK(Frame(tracker, scene, LightDir, casters, cascades) == 0);
+
+    CHECK(tracker.GetStats().CascadesRendered == MaxShadowCascades);
+    CHECK(tracker.GetStats().CascadesReused == 5*MaxShadowCascades);
+
+    tracker.Invalidate();
+    CHECK(Frame(tracker, scene, LightDir, casters, cascades) == AllCascades);
+}
+
+TEST_CASE(ShadowCaching_LightTurnsPastThreshold)
+{
+    Scene scene;
+    ShadowCacheTracker tracker;
+    ShadowCascade cascades[MaxShadowCascades];
+    std::vector<ShadowCasterState> casters;
+
+    Frame(tracker, scene, LightDir, casters, cascades);
+
+    // Turning the light by less than the threshold keeps the cached direction.
+    float small = 0.5f * tracker.GetSettings().LightAngleThreshold;
+    XMFLOAT3 turned;
+    XMStoreFloat3(&turned, XMVector3TransformCoord(XMLoadFloat3(&LightDir), XMMatrixRotationY(small)));
+    XMFLOAT3 selected = tracker.SelectLightDirection(turned);
+    CHECK_NEAR(selected.x, LightDir.x, 1e-4f);
+    CHECK_NEAR(selected.z, LightDir.z, 1e-4f);
+    CHECK(Frame(tracker, scene, turned, casters, cascades) == 0);
+
+    float large = 2.0f * tracker.GetSettings().LightAngleThreshold;
+    XMStoreFloat3(&turned, XMVector3TransformCoord(XMLoadFloat3(&LightDir), XMMatrixRotationY(large)));
+    CHECK(Frame(tracker, scene, turned, casters, cascades) == AllCascades);
+}
+
+TEST_CASE(ShadowCaching_MovedCasterDirtiesOnlyItsCascades)
+{
+    Scene scene;
+    ShadowCacheTracker tracker;
+    ShadowCascade cascades[MaxShadowCascades];
+
+    ShadowCascade fitted[MaxShadowCascades];
+    scene.Fit(LightDir, fitted);
+    const ShadowCascade& far = fitted[MaxShadowCascades - 1];
+
+    std::vector<ShadowCasterState> casters(2);
+    casters[0].Bounds = BoxNearReceivers(far, -5.0f, 0.0f);
+    casters[1].Bounds = MakeBox(XMVectorSet(0.0f, 1.0f, 3.0f, 1.0f), 0.5f);
+    Frame(tracker, scene, LightDir, casters, cascades);
+
+    // Below the threshold nothing happens.
+    casters[0].Bounds.Center.y += 0.5f * tracker.GetSettings().CasterMoveThreshold;
+    CHECK(Frame(tracker, scene, LightDir, casters, cascades) == 0);
+
+    // A real move dirties the cascades the caster left and the ones it entered.
+    BoundingBox before = casters[0].Bounds;
+    casters[0].Bounds.Center.y += 1.0f;
+    uint32_t expected = TouchedCascades(fitted, before) | TouchedCascades(fitted, casters[0].Bounds);
+    CHECK(expected != 0 && expected != AllCascades);
+    CHECK(Frame(tracker, scene, LightDir, casters, cascades) == expected);
+    CHECK(Frame(tracker, scene, LightDir, casters, cascades) == 0);
+
+    // Animated casters re-render what they touch every frame.
+    casters[1].Animated = true;
+    uint32_t animated = TouchedCascades(fitted, casters[1].Bounds);
+    CHECK(animated != 0);
+    CHECK(Frame(tracker, scene, LightDir, casters, cascades) == animated);
+    CHECK(Frame(tracker, scene, LightDir, casters, cascades) == animated);
+
+    // Adding or removing casters starts over.
+    casters.pop_back();
+    CHECK(Frame(tracker, scene, LightDir, casters, cascades) == AllCascades);
+}
+
+TEST_CASE(ShadowCaching_CameraMoveRefitsFootprint)
+{
+    Scene scene;
+    ShadowCacheTracker tracker;
+    ShadowCascade cascades[MaxShadowCascades];
+    std::vector<ShadowCasterState> casters;
+
+    Frame(tracker, scene, LightDir, casters, cascades);
+
+    // Moving far enough shifts every cascade's footprint.
+    XMStoreFloat4x4(&scene.Camera.InvView, XMMatrixTranslation(40.0f, 2.0f, 0.0f));
+    CHECK(Frame(tracker, scene, LightDir, casters, cascades) == AllCascades);
+
+    // The cascades handed back match a fresh fit apart from the widened depth.
+    ShadowCascade fitted[MaxShadowCascades];
+    scene.Fit(LightDir, fitted);
+    for(uint32_t i = 0; i < MaxShadowCascades; ++i)
+    {
+        CHECK(cascades[i].LightCenterLS.x == fitted[i].LightCenterLS.x);
+        CHECK(cascades[i].LightCenterLS.y == fitted[i].LightCenterLS.y);
+        CHECK(cascades[i].LightNearZ < fitted[i].LightNearZ);
+    }
+}
@@ -0,0 +1,137 @@
+//***************************************************************************************
+// TaskGraphTests.cpp
+//***************************************************************************************
+
+#include "Test.h"
+#include "TaskGraph.h"
+
+#include <atomic>
+#include <stdexcept>
+
+namespace
+{
+    // Diamond a -> (b, c) -> d.  Each task records the step at which it ran, and checks
+    // that its dependencies had already finished.
+    struct Diamond
+    {
+        std::atomic<uint32_t> Step{ 0 };
+        std::atomic<uint32_t> Order[4];
+        std::atomic<bool> Violation{ false };
+
+        void Build(TaskGraph& tasks)
+        {
+            auto a = tasks.AddTask("A", [this]{ Mark(0, {}); });
+            auto b = tasks.AddTask("B", [this]{ Mark(1, { 0 }); }, { a });
+            auto c = tasks.AddTask("C", [this]{ Mark(2, { 0 }); }, { a });
+            tasks.AddTask("D", [this]{ Mark(3, { 1, 2 }); }, { b, c });
+        }
+
+        void Reset()
+        {
+            Step = 0;
+            for(auto& order : Order)
+                order = UINT32_MAX;
+            Violation = false;
+        }
+
+        void Mark(uint32_t task, std::initializer_list<uint32_t> dependencies)
+        {
+            for(uint32_t dependency : dependencies)
+            {
+                if(Order[dependency] == UINT32_MAX)
+                    Violation = true;
+            }
+            Order[task] = Step++;
+        }
+    };
+}
+
+TEST_CASE(TaskGraph_RunsDependenciesFirst)
+{
+    TaskGraph tasks(4);
+    Diamond diamond;
+    diamond.Build(tasks);
+
+    // The graph is built once and run every frame.
+    for(int frame = 0; frame < 200; ++frame)
+    {
+        diamond.Reset();
+        tasks.Run();
+
+        CHECK(!diamond.Violation);
+        CHECK(diamond.Step == 4);
+        CHECK(diamond.Order[0] == 0);
+        CHECK(diamond.Order[3] == 3);
+    }
+}
+
+TEST_CASE(TaskGraph_SingleThreadedKeepsInsertionOrder)
+{
+    TaskGraph tasks(2);
+    tasks.SetSingleThreaded(true);
+
+    Diamond diamond;
+    diamond.Build(tasks);
+    diamond.Reset();
+    tasks.Run();
+
+    CHECK(!diamond.Violation);
+    for(uint32_t i = 0; i < 4; ++i)
+        CHECK(diamond.Order[i] == i);
+}
+
+TEST_CASE(TaskGraph_ParallelForCoversRangeOnce)
+{
+    const uint32_t count = 1000;
+    std::atomic<uint32_t> hits[count];
+    for(auto& hit : hits)
+        hit = 0;
+
+    TaskGraph tasks(3);
+    std::atomic<bool> ranBeforeLoop{ false };
+    std::atomic<bool> loopRanEarly{ false };
+    auto first = tasks.AddTask("First", [&]{ ranBeforeLoop = true; });
+    auto batches = tasks.AddParallelFor("Loop", count, 7, [&](uint32_t begin, uint32_t end)
+    {
+        if(!ranBeforeLoop)
+            loopRanEarly = true;
+        for(uint32_t i = begin; i < end; ++i)
+            ++hits[i];
+    }, { first });
+
+    std::atomic<bool> lastSawAll{ false };
+    tasks.AddTask("Last", [&]
+    {
+        bool all = true;
+        for(auto& hit : hits)
+            all = all && hit == 1;
+        lastSawAll = all;
+    }, batches);
+
+    CHECK(batches.size() == 7);
+    tasks.Run();
+
+    CHECK(!loopRanEarly);
+    CHECK(lastSawAll);
+}
+
+TEST_CASE(TaskGraph_RethrowsFirstErrorAfterDraining)
+{
+    TaskGraph tasks(2);
+    std::atomic<bool> dependentRan{ false };
+    auto failing = tasks.AddTask("Failing", []{ throw std::runtime_error("task failed"); });
+    tasks.AddTask("Dependent", [&]{ dependentRan = true; }, { failing });
+
+    bool caught = false;
+    try
+    {
+        tasks.Run();
+    }
+    catch(const std::runtime_error&)
+    {
+        caught = true;
+    }
+
+    CHECK(caught);
+    CHECK(dependentRan);
+}
@@ -0,0 +1,23 @@
+//***************************************************************************************
+// Test.h
+//
+// Minimal registry for the CPU-side unit tests.  TEST_CASE defines a function and
+// registers it before main() runs; CHECK records a failure and keeps going.
+//***************************************************************************************
+
+#pragma once
+
+#include <cmath>
+
+void RegisterTest(const char* name, void (*fn)());
+void ReportFailure(const char* file, int line, const char* expr);
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static const bool name##Registered = (RegisterTest(#name, name), true); \
+    static void name()
+
+#define CHECK(expr) \
+    do { if(!(expr)) ReportFailure(__FILE__, __LINE__, #expr); } while(false)
+
+#define CHECK_NEAR(a, b, eps) CHECK(std::fabs((a) - (b)) <= (eps))
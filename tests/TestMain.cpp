@@ -0,0 +1,64 @@
+//***************************************************************************************
+// TestMain.cpp
+//
+// Runs every registered test, or only those whose name contains argv[1].
+//***************************************************************************************
+
+#include "Test.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    struct TestEntry
+    {
+        const char* Name;
+        void (*Fn)();
+    };
+
+    std::vector<TestEntry>& Tests()
+    {
+        static std::vector<TestEntry> tests;
+        return tests;
+    }
+
+    int gFailures = 0;
+}
+
+void RegisterTest(const char* name, void (*fn)())
+{
+    Tests().push_back({ name, fn });
+}
+
+void ReportFailure(const char* file, int line, const char* expr)
+{
+    std::fprintf(stderr, "%s(%d): CHECK(%s) failed\n", file, line, expr);
+    ++gFailures;
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    int run = 0;
+    int failed = 0;
+    for(const TestEntry& test : Tests())
+    {
+        if(filter != nullptr && std::strstr(test.Name, filter) == nullptr)
+            continue;
+
+        int failuresBefore = gFailures;
+        test.Fn();
+        ++run;
+
+        bool passed = gFailures == failuresBefore;
+        if(!passed)
+            ++failed;
+        std::printf("[%s] %s\n", passed ? "PASS" : "FAIL", test.Name);
+    }
+
+    std::printf("%d of %d tests passed\n", run - failed, run);
+    return failed == 0 ? 0 : 1;
+}
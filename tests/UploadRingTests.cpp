@@ -0,0 +1,109 @@
+//***************************************************************************************
+// UploadRingTests.cpp
+//***************************************************************************************
+
+#include "Test.h"
+#include "UploadRing.h"
+
+namespace
+{
+    const uint64_t RingSize = 1024;
+    const uint64_t GpuBase = 0x100000000ull;
+
+    std::unique_ptr<UploadRing> MakeRing()
+    {
+        return std::make_unique<UploadRing>(std::make_unique<CpuUploadRingBacking>(RingSize, GpuBase));
+    }
+}
+
+TEST_CASE(UploadRing_AlignsAllocations)
+{
+    auto ring = MakeRing();
+
+    UploadAllocation a = ring->Allocate(16);
+    UploadAllocation b = ring->Allocate(16);
+    CHECK(a.IsValid() && b.IsValid());
+    CHECK(a.Offset == 0);
+    CHECK(b.Offset == UploadRing::ConstantBufferAlignment);
+    CHECK(b.CpuAddress == ring->Backing()->MappedData() + b.Offset);
+    CHECK(b.GpuAddress == GpuBase + b.Offset);
+
+    UploadAllocation c = ring->Allocate(8, 64);
+    CHECK(c.Offset == b.Offset + 64);
+}
+
+TEST_CASE(UploadRing_FailsWhenFull)
+{
+    auto ring = MakeRing();
+
+    CHECK(!ring->Allocate(0).IsValid());
+    CHECK(!ring->Allocate(RingSize + 1).IsValid());
+    CHECK(ring->Allocate(RingSize).IsValid());
+    CHECK(!ring->Allocate(1).IsValid());
+    CHECK(ring->GetStats().FailedAllocations == 3);
+}
+
+TEST_CASE(UploadRing_WrapsWithoutStraddlingTheEnd)
+{
+    auto ring = MakeRing();
+
+    CHECK(ring->Allocate(512).Offset == 0);
+    ring->FinishFrame(1);
+    CHECK(ring->Allocate(256).Offset == 512);
+    ring->FinishFrame(2);
+
+    // Only 256 bytes are left before the end and frame 1 still holds the start.
+    CHECK(!ring->Allocate(512).IsValid());
+
+    ring->Retire(1);
+
+    // The block does not fit at the end, so it goes to the start of the ring.
+    UploadAllocation wrapped = ring->Allocate(512);
+    CHECK(wrapped.IsValid());
+    CHECK(wrapped.Offset == 0);
+
+    // The skipped tail counts as in flight until this frame retires.
+    CHECK(ring->GetStats().BytesInFlight == RingSize);
+    CHECK(!ring->Allocate(1).IsValid());
+}
+
+TEST_CASE(UploadRing_ReusesMemoryOnceFencePasses)
+{
+    auto ring = MakeRing();
+
+    CHECK(ring->Allocate(RingSize/2).IsValid());
+    ring->FinishFrame(5);
+    CHECK(ring->Allocate(RingSize/2).IsValid());
+    ring->FinishFrame(6);
+    CHECK(!ring->Allocate(256).IsValid());
+
+    // An older fence does not free anything.
+    ring->Retire(4);
+    CHECK(!ring->Allocate(256).IsValid());
+
+    ring->Retire(5);
+    CHECK(ring->GetStats().BytesInFlight == RingSize/2);
+    UploadAllocation reused = ring->Allocate(RingSize/2);
+    CHECK(reused.IsValid());
+    CHECK(reused.Offset == 0);
+    ring->FinishFrame(7);
+
+    // Once everything has retired the ring starts over at offset 0.
+    ring->Retire(7);
+    CHECK(ring->GetStats().BytesInFlight == 0);
+    CHECK(ring->Allocate(RingSize).Offset == 0);
+    CHECK(ring->GetStats().HighWaterMark == RingSize);
+}
+
+TEST_CASE(UploadRing_CopyToUploadUsesStride)
+{
+    auto ring = MakeRing();
+
+    UploadAllocation alloc = ring->AllocateArray<uint32_t>(4, 16);
+    CHECK(alloc.Size == 64);
+    for(uint32_t i = 0; i < 4; ++i)
+        CopyToUpload(alloc, i, i + 1, 16);
+
+    for(uint32_t i = 0; i < 4; ++i)
+        CHECK(*reinterpret_cast<uint32_t*>(alloc.CpuAddress + i*16) == i + 1);
+}